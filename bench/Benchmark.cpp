@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace bench {
+
+	// stores and loads through volatile happen as written, so the value has to be in memory by the time it's read back
+	static const volatile char* volatile sink = nullptr;
+
+	// not inline, so the compiler has to assume the bytes are read
+	void UseBytes(const volatile char* bytes) {
+		sink = bytes;
+		static_cast<void>(*sink);
+	}
+
+	static double TimeNs(const Suite::Body& body, uint64_t operations) {
+		auto begin = std::chrono::steady_clock::now();
+		body(operations);
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - begin).count();
+	}
+
+	Suite::Suite(std::string filter)
+		: filter(std::move(filter)) { }
+
+	bool Suite::Matches(const std::string& name) const {
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	bool Suite::Run(const std::string& name, const Body& body) {
+		if (!Matches(name)) {
+			return false;
+		}
+		// also warms up the caches and whatever the body loads lazily
+		uint64_t operations = 1;
+		while (TimeNs(body, operations) < kMinSampleMs * 1e6 && operations < (uint64_t(1) << 40)) {
+			operations *= 2;
+		}
+
+		std::vector<double> nsPerOperation(kSamples);
+		for (double& ns : nsPerOperation) {
+			ns = TimeNs(body, operations) / static_cast<double>(operations);
+		}
+		std::sort(nsPerOperation.begin(), nsPerOperation.end());
+
+		Result result{ name, operations, kSamples, nsPerOperation[kSamples / 2], nsPerOperation.front(), nsPerOperation.back() };
+		std::cout << std::left << std::setw(56) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(14) << result.medianNs << " ns/op  (min " << result.minNs << ", max " << result.maxNs << ")" << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+		results.push_back(std::move(result));
+		return true;
+	}
+
+	const std::vector<Result>& Suite::GetResults() const {
+		return results;
+	}
+
+	void Suite::Print() const {
+		std::cout << results.size() << " benchmarks, " << kSamples << " samples of at least " << kMinSampleMs << " ms each" << std::endl;
+	}
+
+	bool Suite::WriteJson(const std::string& path, std::string& error) const {
+		std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (!parent.empty()) {
+			std::error_code directoryError;
+			std::filesystem::create_directories(parent, directoryError);
+		}
+		std::ofstream stream(path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream.is_open()) {
+			error = "can't create " + path;
+			return false;
+		}
+
+		std::time_t now = std::time(nullptr);
+		std::tm local{ };
+#ifdef _WIN32
+		localtime_s(&local, &now);
+#else
+		localtime_r(&now, &local);
+#endif
+#ifdef NDEBUG
+		const char* configuration = "release";
+#else
+		const char* configuration = "debug";
+#endif
+		stream << "{\n\"date\":\"" << std::put_time(&local, "%Y-%m-%dT%H:%M:%S") << "\",\n\"configuration\":\"" << configuration
+			<< "\",\n\"unit\":\"ns\",\n\"benchmarks\":[";
+		stream << std::fixed << std::setprecision(3);
+		for (size_t i = 0; i < results.size(); i++) {
+			const Result& result = results[i];
+			stream << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << result.name << "\",\"operations\":" << result.operations
+				<< ",\"samples\":" << result.samples << ",\"median\":" << result.medianNs << ",\"min\":" << result.minNs
+				<< ",\"max\":" << result.maxNs << "}";
+		}
+		stream << "\n]}\n";
+		if (!stream) {
+			error = "can't write " + path;
+			return false;
+		}
+		return true;
+	}
+}
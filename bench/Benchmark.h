@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+	struct Result {
+		std::string name;
+		// operations timed in each sample
+		uint64_t operations = 0;
+		size_t samples = 0;
+		// per operation, over the samples
+		double medianNs = 0.0;
+		double minNs = 0.0;
+		double maxNs = 0.0;
+	};
+
+	// keeps the compiler from dropping a computation whose result isn't used otherwise
+	void UseBytes(const volatile char* bytes);
+	template <typename T>
+	inline void DoNotOptimize(const T& value) {
+		UseBytes(&reinterpret_cast<const volatile char&>(value));
+	}
+
+	/*
+	 * Times small pieces of engine code and writes the results as JSON, so
+	 * a later change can be compared against a baseline recorded on the
+	 * same machine.
+	 *
+	 * A benchmark is a function that runs its code a given number of times.
+	 * Run first doubles that number until one call takes kMinSampleMs, so
+	 * the clock's resolution doesn't matter, then takes kSamples samples of
+	 * that many operations. The median is what to compare; min and max show
+	 * how noisy the machine was.
+	 */
+	class Suite {
+	public:
+		static constexpr double kMinSampleMs = 20.0;
+		static const size_t kSamples = 15;
+
+		using Body = std::function<void(uint64_t operations)>;
+
+		// only benchmarks with filter in their name run; empty runs everything
+		explicit Suite(std::string filter);
+
+		// whether the filter lets a benchmark of that name run
+		bool Matches(const std::string& name) const;
+		// body runs its operation that many times; returns false if it was filtered out
+		bool Run(const std::string& name, const Body& body);
+
+		const std::vector<Result>& GetResults() const;
+		void Print() const;
+		bool WriteJson(const std::string& path, std::string& error) const;
+
+	private:
+		std::string filter;
+		std::vector<Result> results{ };
+	};
+}
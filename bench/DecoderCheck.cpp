@@ -0,0 +1,357 @@
+#include "DecoderCheck.h"
+#include "ReferenceStbImage.h"
+#include "../src/stb/stb_image.h"
+#include "../src/textures/Deflate.h"
+#include "../src/threading/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace bench {
+
+	struct PngFormat {
+		const char* name;
+		int colorType;
+		int bitDepth;
+		int samples;
+	};
+	// every combination the PNG spec allows
+	static const PngFormat kPngFormats[] = {
+		{ "gray", 0, 1, 1 }, { "gray", 0, 2, 1 }, { "gray", 0, 4, 1 }, { "gray", 0, 8, 1 }, { "gray", 0, 16, 1 },
+		{ "rgb", 2, 8, 3 }, { "rgb", 2, 16, 3 },
+		{ "palette", 3, 1, 1 }, { "palette", 3, 2, 1 }, { "palette", 3, 4, 1 }, { "palette", 3, 8, 1 },
+		{ "gray+alpha", 4, 8, 2 }, { "gray+alpha", 4, 16, 2 },
+		{ "rgba", 6, 8, 4 }, { "rgba", 6, 16, 4 },
+	};
+	// rows down to a single pixel and less than a byte, odd widths, and heights that aren't a multiple of Adam7's 8
+	static const int kPngSizes[][2] = { { 1, 1 }, { 3, 7 }, { 13, 9 }, { 36, 21 }, { 129, 67 } };
+	// Adam7's passes: the first pixel of each and the distance between its pixels
+	static const int kAdam7X[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	static const int kAdam7Y[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	static const int kAdam7StepX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	static const int kAdam7StepY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+	static const size_t kMaxStoredBlock = 65535;
+	// workers for the parallel decodes, fixed so they really run concurrently even on a machine with one core
+	static const unsigned int kDecodeThreads = 4;
+
+	struct Input {
+		std::string name;
+		std::vector<uint8_t> bytes;
+	};
+
+	struct Decoded {
+		bool loaded = false;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		std::vector<uint8_t> bytes;
+	};
+
+	static void WriteBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	static uint32_t Crc32(const uint8_t* data, size_t size) {
+		static const std::array<uint32_t, 256> table = [] {
+			std::array<uint32_t, 256> entries{ };
+			for (uint32_t n = 0; n < 256; n++) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				entries[n] = c;
+			}
+			return entries;
+		}();
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < size; i++) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	static void WriteChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* data, size_t size) {
+		WriteBigEndian32(png, static_cast<uint32_t>(size));
+		size_t start = png.size();
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), data, data + size);
+		WriteBigEndian32(png, Crc32(png.data() + start, png.size() - start));
+	}
+
+	// zlib with the data in stored blocks, which ZlibCompress never writes
+	static std::vector<uint8_t> ZlibStore(const uint8_t* data, size_t size) {
+		std::vector<uint8_t> out{ 0x78, 0x01 };
+		size_t position = 0;
+		do {
+			size_t length = std::min(size - position, kMaxStoredBlock);
+			out.push_back(position + length == size ? 1 : 0);
+			out.push_back(static_cast<uint8_t>(length));
+			out.push_back(static_cast<uint8_t>(length >> 8));
+			out.push_back(static_cast<uint8_t>(~length));
+			out.push_back(static_cast<uint8_t>(~length >> 8));
+			out.insert(out.end(), data + position, data + position + length);
+			position += length;
+		} while (position < size);
+
+		uint32_t a = 1;
+		uint32_t b = 0;
+		for (size_t i = 0; i < size; i++) {
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		WriteBigEndian32(out, (b << 16) | a);
+		return out;
+	}
+
+	static uint8_t Paeth(int a, int b, int c) {
+		int p = a + b - c;
+		int pa = std::abs(p - a);
+		int pb = std::abs(p - b);
+		int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc) {
+			return static_cast<uint8_t>(a);
+		}
+		return static_cast<uint8_t>(pb <= pc ? b : c);
+	}
+
+	// appends the rows of one pass (or the whole image), each with the next filter type in turn
+	static void AppendFilteredRows(std::vector<uint8_t>& out, int width, int height, int bitsPerPixel, int filter, uint32_t& seed) {
+		size_t rowBytes = (static_cast<size_t>(width) * bitsPerPixel + 7) / 8;
+		size_t bytesPerPixel = std::max(1, bitsPerPixel / 8);
+		std::vector<uint8_t> previous(rowBytes, 0);
+		std::vector<uint8_t> row(rowBytes);
+		for (int y = 0; y < height; y++) {
+			// a gradient with noise on it, so there's something for both the filters and the matcher to find
+			for (size_t i = 0; i < rowBytes; i++) {
+				seed = seed * 1664525u + 1013904223u;
+				row[i] = static_cast<uint8_t>(i * 3 + y * 5 + (seed >> 29));
+			}
+			int type = (filter + y) % 5;
+			out.push_back(static_cast<uint8_t>(type));
+			for (size_t i = 0; i < rowBytes; i++) {
+				int a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+				int b = previous[i];
+				int c = i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+				int predicted = 0;
+				switch (type) {
+				case 1: predicted = a; break;
+				case 2: predicted = b; break;
+				case 3: predicted = (a + b) / 2; break;
+				case 4: predicted = Paeth(a, b, c); break;
+				}
+				out.push_back(static_cast<uint8_t>(row[i] - predicted));
+			}
+			previous = row;
+		}
+	}
+
+	static std::vector<uint8_t> EncodePng(int width, int height, const PngFormat& format, bool interlaced, bool stored, bool transparent, uint32_t seed) {
+		int bitsPerPixel = format.samples * format.bitDepth;
+		std::vector<uint8_t> filtered;
+		if (interlaced) {
+			for (int pass = 0; pass < 7; pass++) {
+				int passWidth = (width - kAdam7X[pass] + kAdam7StepX[pass] - 1) / kAdam7StepX[pass];
+				int passHeight = (height - kAdam7Y[pass] + kAdam7StepY[pass] - 1) / kAdam7StepY[pass];
+				// a pass with no pixels has no rows either, not even filter bytes
+				if (passWidth > 0 && passHeight > 0) {
+					AppendFilteredRows(filtered, passWidth, passHeight, bitsPerPixel, static_cast<int>(seed % 5) + pass, seed);
+				}
+			}
+		}
+		else {
+			AppendFilteredRows(filtered, width, height, bitsPerPixel, static_cast<int>(seed % 5), seed);
+		}
+
+		std::vector<uint8_t> png{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		std::vector<uint8_t> header;
+		WriteBigEndian32(header, static_cast<uint32_t>(width));
+		WriteBigEndian32(header, static_cast<uint32_t>(height));
+		header.insert(header.end(), { static_cast<uint8_t>(format.bitDepth), static_cast<uint8_t>(format.colorType), 0, 0, static_cast<uint8_t>(interlaced ? 1 : 0) });
+		WriteChunk(png, "IHDR", header.data(), header.size());
+
+		std::vector<uint8_t> transparency;
+		if (format.colorType == 3) {
+			size_t entries = size_t(1) << format.bitDepth;
+			std::vector<uint8_t> palette(entries * 3);
+			for (size_t i = 0; i < palette.size(); i++) {
+				palette[i] = static_cast<uint8_t>(i * 37 + seed);
+			}
+			WriteChunk(png, "PLTE", palette.data(), palette.size());
+			// fewer alphas than entries, so the rest stay opaque
+			for (size_t i = 0; i < (entries + 1) / 2; i++) {
+				transparency.push_back(static_cast<uint8_t>(i * 91));
+			}
+		}
+		else if (format.colorType == 0 || format.colorType == 2) {
+			// a key colour that shows up in the image, given the gradient it's made of
+			uint16_t key = static_cast<uint16_t>(5 & ((1 << format.bitDepth) - 1));
+			for (int i = 0; i < (format.colorType == 0 ? 1 : 3); i++) {
+				transparency.push_back(static_cast<uint8_t>(key >> 8));
+				transparency.push_back(static_cast<uint8_t>(key));
+			}
+		}
+		if (transparent && !transparency.empty()) {
+			WriteChunk(png, "tRNS", transparency.data(), transparency.size());
+		}
+
+		std::vector<uint8_t> compressed = stored ? ZlibStore(filtered.data(), filtered.size()) : textures::ZlibCompress(filtered.data(), filtered.size());
+		// split over two IDATs, which the decoder has to join
+		size_t half = compressed.size() / 2;
+		WriteChunk(png, "IDAT", compressed.data(), half);
+		WriteChunk(png, "IDAT", compressed.data() + half, compressed.size() - half);
+		WriteChunk(png, "IEND", nullptr, 0);
+		return png;
+	}
+
+	static std::vector<Input> GeneratePngs() {
+		std::vector<Input> inputs;
+		uint32_t seed = 1;
+		for (const PngFormat& format : kPngFormats) {
+			for (const auto& size : kPngSizes) {
+				for (int variant = 0; variant < 4; variant++) {
+					bool interlaced = (variant & 1) != 0;
+					bool stored = (variant & 2) != 0;
+					bool transparent = (size[0] % 2) == 1 && format.colorType != 4 && format.colorType != 6;
+					std::string name = "generated " + std::string(format.name) + " " + std::to_string(format.bitDepth) + "-bit "
+						+ std::to_string(size[0]) + "x" + std::to_string(size[1])
+						+ (interlaced ? ", Adam7" : "") + (stored ? ", stored" : "") + (transparent ? ", tRNS" : "");
+					inputs.push_back({ name, EncodePng(size[0], size[1], format, interlaced, stored, transparent, seed++) });
+				}
+			}
+		}
+		return inputs;
+	}
+
+	// the same adapter TextureLoader installs with SetImageDecodePool
+	static void DecodeParallelFor(void* user, int count, void (*job)(void* jobUser, int index), void* jobUser) {
+		static_cast<ThreadPool*>(user)->ParallelFor(static_cast<size_t>(count), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				job(jobUser, static_cast<int>(i));
+			}
+		});
+	}
+
+	static Decoded Keep(void* pixels, int width, int height, int channels, int desiredChannels, size_t bytesPerSample) {
+		Decoded decoded{ };
+		if (pixels == nullptr) {
+			return decoded;
+		}
+		decoded.loaded = true;
+		decoded.width = width;
+		decoded.height = height;
+		decoded.channels = channels;
+		size_t size = static_cast<size_t>(width) * height * (desiredChannels != 0 ? desiredChannels : channels) * bytesPerSample;
+		const uint8_t* bytes = static_cast<const uint8_t*>(pixels);
+		decoded.bytes.assign(bytes, bytes + size);
+		return decoded;
+	}
+
+	static Decoded DecodeWithEngine(const Input& input, int desiredChannels, bool sixteenBit, bool flip) {
+		stbi_set_flip_vertically_on_load(flip);
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		int size = static_cast<int>(input.bytes.size());
+		void* pixels = sixteenBit
+			? static_cast<void*>(stbi_load_16_from_memory(input.bytes.data(), size, &width, &height, &channels, desiredChannels))
+			: static_cast<void*>(stbi_load_from_memory(input.bytes.data(), size, &width, &height, &channels, desiredChannels));
+		Decoded decoded = Keep(pixels, width, height, channels, desiredChannels, sixteenBit ? 2 : 1);
+		stbi_image_free(pixels);
+		return decoded;
+	}
+
+	static Decoded DecodeWithReference(const Input& input, int desiredChannels, bool sixteenBit, bool flip) {
+		reference_stb_image::SetFlipVerticallyOnLoad(flip);
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		void* pixels = sixteenBit
+			? static_cast<void*>(reference_stb_image::Load16(input.bytes.data(), input.bytes.size(), &width, &height, &channels, desiredChannels))
+			: static_cast<void*>(reference_stb_image::Load(input.bytes.data(), input.bytes.size(), &width, &height, &channels, desiredChannels));
+		Decoded decoded = Keep(pixels, width, height, channels, desiredChannels, sixteenBit ? 2 : 1);
+		reference_stb_image::Free(pixels);
+		return decoded;
+	}
+
+	// empty if they match
+	static std::string Compare(const Decoded& engine, const Decoded& reference) {
+		if (!engine.loaded && !reference.loaded) {
+			return "";
+		}
+		if (!engine.loaded) {
+			return std::string("only the reference decoder loads it, the engine's says ") + stbi_failure_reason();
+		}
+		if (!reference.loaded) {
+			return std::string("only the engine's decoder loads it, the reference says ") + reference_stb_image::GetFailureReason();
+		}
+		if (engine.width != reference.width || engine.height != reference.height || engine.channels != reference.channels) {
+			return "decoded to " + std::to_string(engine.width) + "x" + std::to_string(engine.height) + "x" + std::to_string(engine.channels)
+				+ ", the reference to " + std::to_string(reference.width) + "x" + std::to_string(reference.height) + "x" + std::to_string(reference.channels);
+		}
+		auto difference = std::mismatch(engine.bytes.begin(), engine.bytes.end(), reference.bytes.begin());
+		if (difference.first != engine.bytes.end()) {
+			return "first differs at byte " + std::to_string(difference.first - engine.bytes.begin()) + " of " + std::to_string(engine.bytes.size());
+		}
+		return "";
+	}
+
+	static std::vector<uint8_t> ReadWholeFile(const std::filesystem::path& path) {
+		std::ifstream stream(path, std::ios_base::in | std::ios_base::binary);
+		return std::vector<uint8_t>{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+	}
+
+	bool VerifyDecoders(const std::vector<std::filesystem::path>& files) {
+		std::vector<Input> inputs;
+		for (const std::filesystem::path& file : files) {
+			// the reference is built with only the formats the engine's decoders were changed for
+			if (file.extension() == ".png" || file.extension() == ".jpg" || file.extension() == ".jpeg") {
+				inputs.push_back({ file.string(), ReadWholeFile(file) });
+			}
+		}
+		std::vector<Input> generated = GeneratePngs();
+		inputs.insert(inputs.end(), generated.begin(), generated.end());
+
+		ThreadPool pool{ kDecodeThreads };
+		size_t decodes = 0;
+		size_t rejected = 0;
+		size_t mismatches = 0;
+		for (const Input& input : inputs) {
+			for (int sixteenBit = 0; sixteenBit < 2; sixteenBit++) {
+				for (int desiredChannels = 0; desiredChannels <= 4; desiredChannels++) {
+					for (int flip = 0; flip < 2; flip++) {
+						Decoded reference = DecodeWithReference(input, desiredChannels, sixteenBit, flip);
+						rejected += reference.loaded ? 0 : 1;
+						// the JPEG decoder splits its work differently when it has a pool, which must not change a byte
+						for (int parallel = 0; parallel < 2; parallel++) {
+							stbi_set_parallel_for(parallel ? DecodeParallelFor : nullptr, parallel ? &pool : nullptr);
+							Decoded engine = DecodeWithEngine(input, desiredChannels, sixteenBit, flip);
+							decodes++;
+							std::string difference = Compare(engine, reference);
+							if (!difference.empty()) {
+								mismatches++;
+								std::cerr << input.name << ", " << (sixteenBit ? 16 : 8) << "-bit, " << desiredChannels << " channels requested"
+									<< (flip ? ", flipped" : "") << (parallel ? ", parallel" : ", serial") << ": " << difference << std::endl;
+							}
+						}
+					}
+				}
+			}
+		}
+		stbi_set_parallel_for(nullptr, nullptr);
+		stbi_set_flip_vertically_on_load(false);
+		reference_stb_image::SetFlipVerticallyOnLoad(false);
+
+		// a generator that writes broken files would make every decode a match
+		std::cout << "Compared " << decodes << " decodes of " << inputs.size() << " images against the reference decoder, "
+			<< rejected << " rejected by the reference, " << mismatches << " mismatched" << std::endl;
+		return mismatches == 0;
+	}
+}
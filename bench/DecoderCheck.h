@@ -0,0 +1,18 @@
+#pragma once
+#include <filesystem>
+#include <vector>
+
+namespace bench {
+	/*
+	 * Checks that the engine's stb_image decodes to exactly the bytes the
+	 * unchanged upstream copy in ReferenceStbImage.h does. Every PNG and
+	 * JPEG in files is decoded, along with PNGs generated here that cover
+	 * each colour type and bit depth, every filter type, odd widths, Adam7
+	 * and both compressed and stored zlib data. Each one is loaded at every
+	 * channel count, 8- and 16-bit, flipped and not, by the engine's decoder
+	 * both serially and with its JPEG work spread over a thread pool;
+	 * when both decoders reject a file that counts as a match too.
+	 * Prints each mismatch and returns false if there was any.
+	 */
+	bool VerifyDecoders(const std::vector<std::filesystem::path>& files);
+}
@@ -0,0 +1,204 @@
+#include "Benchmark.h"
+#include "DecoderCheck.h"
+#include "../src/entities/Camera.h"
+#include "../src/entities/Transform.h"
+#include "../src/input-handling/UserInputs.h"
+#include "../src/math/mathutil.h"
+#include "../src/shader-loader/ShaderLoader.h"
+#include "../src/stb/stb_image.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// microbenchmarks of engine code that runs every frame or on every load; run from the directory with resources/ in it
+//   --out=<path>       where the JSON goes, engine_bench.json by default
+//   --filter=<text>    only benchmarks with text in their name
+//   --verify-decoders  instead of benchmarking, check stb_image's output against the upstream copy in bench/reference
+
+static const char* const kShaderDirectory = "resources/shaders";
+static const char* const kTextureDirectory = "resources/textures";
+// JPEGs with the subsampling, progressive and restart interval variants the textures don't have
+static const char* const kDecoderInputDirectory = "bench/decoder-inputs";
+// inputs of clip and wrap, from well below to well above their ranges
+static const size_t kAngleCount = 1024;
+
+// sorted, so benchmarks come in the same order on every machine
+static std::vector<std::filesystem::path> ListFiles(const char* directory) {
+	std::vector<std::filesystem::path> files{ };
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.is_regular_file()) {
+			files.push_back(entry.path());
+		}
+	}
+	if (error) {
+		std::cerr << "Can't list " << directory << ": " << error.message() << std::endl;
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+static void BenchTransform(bench::Suite& suite) {
+	suite.Run("Transform rebuild, rotation", [](uint64_t operations) {
+		Transform transform{ glm::vec3{ 1.0f, 2.0f, 3.0f }, glm::vec3{ 0.5f }, glm::vec3{ 0.0f } };
+		for (uint64_t i = 0; i < operations; i++) {
+			transform.setAngles(glm::vec3{ static_cast<float>(i % 360), 30.0f, 15.0f });
+			bench::DoNotOptimize(transform.getTransformMatrix());
+		}
+	});
+	suite.Run("Transform rebuild, position", [](uint64_t operations) {
+		Transform transform{ glm::vec3{ 1.0f, 2.0f, 3.0f }, glm::vec3{ 0.5f }, glm::vec3{ 0.0f, 30.0f, 15.0f } };
+		for (uint64_t i = 0; i < operations; i++) {
+			transform.setPosition(glm::vec3{ static_cast<float>(i % 360), 2.0f, 3.0f });
+			bench::DoNotOptimize(transform.getTransformMatrix());
+		}
+	});
+}
+
+static void BenchCamera(bench::Suite& suite) {
+	suite.Run("Camera::GetViewMatrix, rebuilt", [](uint64_t operations) {
+		Camera camera{ glm::vec3{ 0.0f, 0.0f, 3.0f }, glm::vec3{ 0.0f } };
+		for (uint64_t i = 0; i < operations; i++) {
+			camera.setAngles(glm::vec3{ -20.0f, -static_cast<float>(i % 360), 0.0f });
+			bench::DoNotOptimize(camera.GetViewMatrix());
+		}
+	});
+	suite.Run("Camera::GetViewMatrix, cached", [](uint64_t operations) {
+		Camera camera{ glm::vec3{ 0.0f, 0.0f, 3.0f }, glm::vec3{ -20.0f, -45.0f, 0.0f } };
+		for (uint64_t i = 0; i < operations; i++) {
+			bench::DoNotOptimize(camera.GetViewMatrix());
+		}
+	});
+}
+
+static void BenchMath(bench::Suite& suite) {
+	std::vector<float> angles(kAngleCount);
+	for (size_t i = 0; i < kAngleCount; i++) {
+		angles[i] = -720.0f + 1440.0f * static_cast<float>(i) / static_cast<float>(kAngleCount);
+	}
+	// an operation is one value, so the numbers compare with the other benchmarks
+	suite.Run("clip", [&angles](uint64_t operations) {
+		for (uint64_t i = 0; i < operations; i++) {
+			bench::DoNotOptimize(clip(angles[i % kAngleCount], -89.0f, 89.0f));
+		}
+	});
+	suite.Run("wrap", [&angles](uint64_t operations) {
+		for (uint64_t i = 0; i < operations; i++) {
+			bench::DoNotOptimize(wrap(angles[i % kAngleCount], 0.0f, 360.0f));
+		}
+	});
+}
+
+static void BenchInput(bench::Suite& suite) {
+	// what PollInput does every frame, with every key going down and up again so the status changes too
+	std::string name = "KeyInput::set_normalized_value, all " + std::to_string(user_input::key_inputs.size()) + " keys";
+	suite.Run(name, [](uint64_t operations) {
+		for (uint64_t i = 0; i < operations; i++) {
+			float value = static_cast<float>(i & 1);
+			for (basic_input::KeyInput* key : user_input::key_inputs) {
+				key->set_normalized_value(value);
+			}
+		}
+		bench::DoNotOptimize(user_input::key_inputs.front()->get_normalized_value());
+	});
+}
+
+static void BenchShaderSources(bench::Suite& suite) {
+	// loose files, the resource pack isn't mounted
+	for (const std::filesystem::path& file : ListFiles(kShaderDirectory)) {
+		std::string path = file.generic_string();
+		suite.Run("ShaderLoader::ReadShaderSource " + file.filename().string(), [&path](uint64_t operations) {
+			for (uint64_t i = 0; i < operations; i++) {
+				std::string source = ShaderLoader::ReadShaderSource(path);
+				bench::DoNotOptimize(source.size());
+			}
+		});
+	}
+}
+
+static bool LoadTexture(const std::string& path) {
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+	if (pixels == nullptr) {
+		return false;
+	}
+	bench::DoNotOptimize(pixels[0]);
+	stbi_image_free(pixels);
+	return true;
+}
+
+// false if a texture doesn't load, whose benchmark is skipped then
+static bool BenchTextureDecode(bench::Suite& suite) {
+	// like the loader does it
+	stbi_set_flip_vertically_on_load(true);
+	bool loaded = true;
+	for (const std::filesystem::path& file : ListFiles(kTextureDirectory)) {
+		std::string name = "stbi_load " + file.filename().string();
+		if (!suite.Matches(name)) {
+			continue;
+		}
+		// once up front, as a body that fails right away would only stop growing at 2^40 operations
+		std::string path = file.string();
+		if (!LoadTexture(path)) {
+			std::cerr << "Failed to load " << path << ", skipping its benchmark: " << stbi_failure_reason() << std::endl;
+			loaded = false;
+			continue;
+		}
+		suite.Run(name, [&path](uint64_t operations) {
+			for (uint64_t i = 0; i < operations; i++) {
+				bench::DoNotOptimize(LoadTexture(path));
+			}
+		});
+	}
+	return loaded;
+}
+
+int main(int argc, char** argv) {
+	std::string outPath = "engine_bench.json";
+	std::string filter;
+	bool verifyDecoders = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.rfind("--out=", 0) == 0) {
+			outPath = arg.substr(arg.find('=') + 1);
+		}
+		else if (arg.rfind("--filter=", 0) == 0) {
+			filter = arg.substr(arg.find('=') + 1);
+		}
+		else if (arg == "--verify-decoders") {
+			verifyDecoders = true;
+		}
+		else {
+			std::cerr << "Unknown argument " << arg << std::endl;
+			return -1;
+		}
+	}
+
+	if (verifyDecoders) {
+		std::vector<std::filesystem::path> files = ListFiles(kTextureDirectory);
+		std::vector<std::filesystem::path> decoderInputs = ListFiles(kDecoderInputDirectory);
+		files.insert(files.end(), decoderInputs.begin(), decoderInputs.end());
+		return bench::VerifyDecoders(files) ? 0 : -1;
+	}
+
+	bench::Suite suite{ filter };
+	BenchTransform(suite);
+	BenchCamera(suite);
+	BenchMath(suite);
+	BenchInput(suite);
+	BenchShaderSources(suite);
+	bool texturesLoaded = BenchTextureDecode(suite);
+	suite.Print();
+
+	std::string error;
+	if (!suite.WriteJson(outPath, error)) {
+		std::cerr << "Failed to write benchmark results: " << error << std::endl;
+		return -1;
+	}
+	std::cout << "Wrote " << outPath << std::endl;
+	return texturesLoaded ? 0 : -1;
+}
@@ -0,0 +1,31 @@
+#include "ReferenceStbImage.h"
+#define STB_IMAGE_STATIC
+// only the formats that are compared, read from memory
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_NO_STDIO
+#define STB_IMAGE_IMPLEMENTATION
+#include "reference/stb_image.h"
+
+namespace reference_stb_image {
+
+	uint8_t* Load(const uint8_t* bytes, size_t size, int* width, int* height, int* channels, int desiredChannels) {
+		return stbi_load_from_memory(bytes, static_cast<int>(size), width, height, channels, desiredChannels);
+	}
+
+	uint16_t* Load16(const uint8_t* bytes, size_t size, int* width, int* height, int* channels, int desiredChannels) {
+		return stbi_load_16_from_memory(bytes, static_cast<int>(size), width, height, channels, desiredChannels);
+	}
+
+	void Free(void* pixels) {
+		stbi_image_free(pixels);
+	}
+
+	void SetFlipVerticallyOnLoad(bool flip) {
+		stbi_set_flip_vertically_on_load(flip ? 1 : 0);
+	}
+
+	const char* GetFailureReason() {
+		return stbi_failure_reason();
+	}
+}
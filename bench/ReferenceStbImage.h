@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace reference_stb_image {
+	/*
+	 * bench/reference/stb_image.h is stb_image v2.29 exactly as the engine's
+	 * copy in src/stb started out, before its PNG and JPEG decoders were
+	 * reworked. It's compiled into its own translation unit with everything
+	 * static, so both can be linked into one program and their output
+	 * compared. Don't change it; it's only useful as long as it's upstream's.
+	 */
+	// like stbi_load_from_memory and stbi_load_16_from_memory; null on failure
+	uint8_t* Load(const uint8_t* bytes, size_t size, int* width, int* height, int* channels, int desiredChannels);
+	uint16_t* Load16(const uint8_t* bytes, size_t size, int* width, int* height, int* channels, int desiredChannels);
+	void Free(void* pixels);
+	void SetFlipVerticallyOnLoad(bool flip);
+	const char* GetFailureReason();
+}
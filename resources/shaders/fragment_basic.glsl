@@ -9,6 +9,11 @@ in vec2 texCoord;
 
 out vec4 FragColor;
 
+const float kAlphaCutoff = 0.5f;
+const float kFogStart = 2.0f;
+const float kFogEnd = 10.0f;
+const vec3 kFogColor = vec3(0.2f, 0.3f, 0.3f);
+
 void main() {
 	// FragColor = vec4(1.0f, 0.5f * (sin(time) + 1.0f), 0.2f, 1.0f);
 	vec2 scaledCoord = 2.0f * texCoord;
@@ -18,7 +23,23 @@ void main() {
 	// FragColor = texture(texture0, texCoord);
 	// FragColor = mix(texture(texture0, texCoord), texture(texture1, texCoord), 0.2f);
 	vec4 texSample0 = texture(texture0, scaledCoord);
+#ifdef TEXTURE_MIX
 	vec4 texSample1 = texture(texture1, vec2(scaledCoord.x, scaledCoord.y));
 	// FragColor = mix(texSample0, texSample1, percent * texSample1.w) * timeColor;
 	FragColor = mix(texSample0, texSample1, percent * texSample1.w);
+#else
+	// nothing to mix in at percent 0, so the second texture isn't sampled at all
+	FragColor = texSample0;
+#endif
+#ifdef ALPHA_TEST
+	if (FragColor.a < kAlphaCutoff) {
+		discard;
+	}
+#endif
+#ifdef FOG
+	// view space distance, fading into the clear color
+	float viewDistance = gl_FragCoord.z / gl_FragCoord.w;
+	float fog = clamp((viewDistance - kFogStart) / (kFogEnd - kFogStart), 0.0f, 1.0f);
+	FragColor.rgb = mix(FragColor.rgb, kFogColor, fog);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,5 @@
+#pragma once
+uniform mat4 transform;
+uniform mat4 modelMatrix;
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
\ No newline at end of file
@@ -1,25 +1,61 @@
 #include "Application.h"
 #include <iostream>
 #include "shader-loader/ShaderLoader.h"
+#include "shader-loader/ProgramCache.h"
+#include "shader-loader/ShaderPreprocessor.h"
+#include "shader-loader/ShaderReloader.h"
+#include "shader-loader/ShaderVariants.h"
+#include "shader-loader/UniformTable.h"
 #include <vector>
 #include "stb/stb_image.h"
 #include "math/mathutil.h"
 #include "input-handling/UserInputs.h"
 #include "entities/Camera.h"
 #include <imgui/imgui.h>
+#ifndef HEADLESS_ONLY
 #include <imgui/backends/imgui_impl_glfw.h>
+#endif
 #include <imgui/backends/imgui_impl_opengl3.h>
 #include "gui/InfoOverlay.h"
-#include "misc/Printable.h"
+#include "gui/WatchRegistry.h"
+#include "gl/GLExtensions.h"
+#include "gl/GLCallStats.h"
+#include "gl/HeadlessContext.h"
+#include "render/PipelineState.h"
+#include "scene/StressScene.h"
+#include "profiling/Profiler.h"
+#include "profiling/GpuTimer.h"
+#include "profiling/FrameLog.h"
+#include "profiling/FrameTimes.h"
+#include "profiling/MemoryTags.h"
+#include "textures/TextureLoader.h"
+#include "textures/TextureStreamer.h"
+#include "threading/ThreadPool.h"
+#include "vfs/AsyncReader.h"
+#include "vfs/FileSystem.h"
+#include <algorithm>
+#include <filesystem>
 
 const int kDefaultWindowWidth = 800;
 const int kDefaultWindowHeight = 600;
+// --headless without --frames
+const size_t kDefaultHeadlessFrames = 600;
+// headless frames all take this long, so they play out the same however fast they render
+const double kHeadlessFrameSeconds = 1.0 / 60.0;
 
 int windowWidth = kDefaultWindowWidth;
 int windowHeight = kDefaultWindowHeight;
 
+// built with --write-pack; mounted over the loose files when it's there
+static const std::string kResourcePack = "resources.pak";
+
 static std::string vertShaderPath = "resources/shaders/vertex_basic.glsl";
 static std::string fragShaderPath = "resources/shaders/fragment_basic.glsl";
+// feature defines of the basic shader, bit i of a variant selects kShaderFeatures[i]
+static const std::vector<std::string> kShaderFeatures{ "TEXTURE_MIX", "ALPHA_TEST", "FOG" };
+const ShaderVariants::Features kFeatureTextureMix = 1 << 0;
+const ShaderVariants::Features kFeatureAlphaTest = 1 << 1;
+const ShaderVariants::Features kFeatureFog = 1 << 2;
 
 static float percent = 0.0f;
 
@@ -80,13 +116,35 @@ double mouseY = 0.0;
 
 // GUI stuff
 static bool* is_overlay_visible = &user_input::show_debug_overlay;
-
-// debug overlay props
-static std::vector<Printable*> propsToPrint{ };
-static auto infoMouse = GUI::Debug::LabeledVec2<double>{ "Mouse", "x", &mouseX, "y", &mouseY};
-static auto infoCamRot = GUI::Debug::LabeledVec2<float>("Cam rot", "x", &camPitch, "y", &camYaw);
-static auto infoCamPos = GUI::Debug::LabeledVec3<float>("Cam pos", "x", "y", "z", cam.getPositionPointer());
-//static auto infoCamPos = GUI::Debug::NamedValueItemReference<double>{ "Cam pos", &mouseY };
+static bool* is_profiler_visible = &user_input::show_profiler;
+static bool* is_gl_calls_visible = &user_input::show_gl_calls;
+static bool* is_stress_scene_visible = &user_input::show_stress_scene;
+
+// debug overlay props, watched through pointers and formatted by the overlay
+static GUI::Debug::WatchRegistry watches{ };
+static size_t residentTexels = 0;
+static size_t requestedTexels = 0;
+static size_t residentTextureKiB = 0;
+static size_t textureBudgetKiB = 0;
+static size_t uniformCallsIssued = 0;
+static size_t uniformCallsSkipped = 0;
+static size_t pipelineBindsApplied = 0;
+static size_t pipelineBindsRedundant = 0;
+static double gpuClearMs = 0.0;
+static double gpuSceneMs = 0.0;
+static double gpuImGuiMs = 0.0;
+// while GL calls are instrumented
+static size_t glCalls = 0;
+static size_t glDrawCalls = 0;
+static size_t glUploadKiB = 0;
+// of the stress scene, 0 while there is none
+static size_t stressUpdated = 0;
+static size_t stressVisible = 0;
+static size_t stressMaterialRuns = 0;
+// per memory tag and then in total, filled in after every frame
+static size_t frameAllocations[profiling::kMemoryTagCount + 1]{ };
+static size_t frameAllocatedBytes[profiling::kMemoryTagCount + 1]{ };
+static size_t liveKiB[profiling::kMemoryTagCount + 1]{ };
 //std::cout << "cam rotation: " << camYaw << " " << camPitch << "                         " << std::endl;
 //std::cout << "cam position: " << camPos.x << ", " << camPos.y << ", " << camPos.z << "                           " << std::endl;
 //std::cout << "forward_: " << forward_.x << ", " << forward_.y << ", " << forward_.z << "                           " << std::endl;
@@ -110,6 +168,8 @@ glm::mat4 UpdateProjectionMatrix(bool perspective) {
 	}
 }
 
+// everything that needs a window; a HEADLESS_ONLY build has no GLFW to link against
+#ifndef HEADLESS_ONLY
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 	if (width == 0 || height == 0) {
 		std::cout << "Ignoring " << width << "x" << height << " resize" << std::endl;
@@ -130,6 +190,8 @@ void window_iconify_callback(GLFWwindow* window, int iconified) {
 	}
 }
 
+#endif
+
 void UpdateTransformMatrix() {
 	// due to the nature of matrix multiplication, the first transformation we want must come last
 	// we want to first scale by 0.5, then rotate 90 degrees CCW, then translate
@@ -145,6 +207,7 @@ void UpdateModelMatrix() {
 }
 
 void UpdateViewMatrix() {
+	PROFILE_SCOPE("UpdateViewMatrix");
 	if (cursor_locked) {
 		camPitch = clip(static_cast<float>(camPitch + (mouseY * m_pitch * sensitivity)), pitch_min, pitch_max);
 		camYaw = wrap(static_cast<float>(camYaw + (mouseX * m_yaw * sensitivity)), 0.0f, 360.0f);
@@ -170,8 +233,22 @@ void UpdateViewMatrix() {
 
 }
 
+// a full circle around the cube over frameCount frames, going up and down twice on the way
+void FollowCameraPath(size_t frame, size_t frameCount) {
+	float t = static_cast<float>(frame) / static_cast<float>(std::max<size_t>(frameCount, 1));
+	float angle = glm::two_pi<float>() * t;
+	float distance = 1.5f + 0.3f * std::cos(2.0f * angle);
+	glm::vec3 offset{ distance * std::sin(angle), 0.4f * std::sin(2.0f * angle), distance * std::cos(angle) };
+	cam.setPosition(translation + offset);
+	// the camera looks against its forward, so forward points from the cube to the camera
+	camYaw = -glm::degrees(angle);
+	camPitch = glm::degrees(std::asin(offset.y / glm::length(offset)));
+}
+
+#ifndef HEADLESS_ONLY
 // todo: figure out how to not be forced to pass a window pointer everywhere
 void PollInput(GLFWwindow* window) {
+	PROFILE_SCOPE("PollInput");
 	// keys
 	for (int i = 0; i < user_input::key_inputs.size(); i++) {
 		float key_value = static_cast<float>(glfwGetKey(window, user_input::key_inputs[i]->keycode));
@@ -192,15 +269,6 @@ void ProcessInput(GLFWwindow* window) {
 		glfwSetWindowShouldClose(window, true);
 	}
 
-	if (user_input::wireframe_enabled) {
-		// built-in wireframe mode
-		// NOTE: must use GL_FRONT_AND_BACK in core profile
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	}
-	else {
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-	}
-
 	if (user_input::perspective_enabled != use_perspective) {
 		use_perspective = user_input::perspective_enabled;
 		projectionMatrix = UpdateProjectionMatrix(use_perspective);
@@ -247,56 +315,281 @@ void ToggleCursorLock(GLFWwindow* window, bool locked) {
 		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 	}
 }
+#endif
+
+// the overlay shows the latest GPU pass times whichever frame they're from, the frame log files them under the frame that issued the passes
+struct GpuPassCounter {
+	const char* counter;
+	const char* pass;
+};
+static const GpuPassCounter kGpuPassCounters[] = { { "GPU clear ms", "GPU clear" }, { "GPU scene ms", "GPU scene" }, { "GPU ImGui ms", "GPU ImGui" } };
 
-void DrawTriangle(unsigned int vao, unsigned int triCount) {
-	glBindVertexArray(vao);
-	//glDrawElements(GL_TRIANGLES, triCount, GL_UNSIGNED_INT, 0);
-	glDrawArrays(GL_TRIANGLES, 0, triCount);
-	glBindVertexArray(NULL);
+void RecordGpuPasses(profiling::FrameLog& frameLog, const profiling::GpuTimer& gpuTimer) {
+	if (gpuTimer.GetPasses().empty()) {
+		return;
+	}
+	for (const GpuPassCounter& gpuPass : kGpuPassCounters) {
+		frameLog.RecordLate(gpuTimer.GetPassesFrameIndex(), gpuPass.counter, gpuTimer.GetPassMs(gpuPass.pass));
+	}
 }
 
-int main() {
-	std::cout << "Creating window..." << std::endl;
+int main(int argc, char** argv) {
+	PROFILE_THREAD("main");
+	textures::TextureLoadOptions textureOptions{ };
+	bool streamTextures = true;
+	size_t textureBudgetBytes = 64 * 1024 * 1024;
+	bool useShaderCache = true;
+	bool reloadShaders = true;
+	bool useShaderPipelines = true;
+	bool mountResourcePack = true;
+	size_t captureFrames = 0;
+	std::string statsOutPath;
+	// frames after which any allocation ends the run, 0 to never check
+	size_t allocationFreeAfterFrame = 0;
+	// no window at all: a surfaceless EGL or OSMesa context rendering into a framebuffer of its own, so it needs no GPU or display
+	bool headless = false;
+	// --headless tries each of them in turn, --headless=egl and --headless=osmesa just the one
+	std::vector<gl_headless::Backend> headlessBackends{ gl_headless::Backend::EGL, gl_headless::Backend::OSMesa };
+	// frames after which the run ends, 0 to run until the window is closed
+	size_t frameLimit = 0;
+	std::string timingsOutPath;
+	// generated at startup with --stress-objects, or later from its window
+	scene::StressSceneOptions stressOptions{ };
+	bool generateStressScene = false;
+	textures::SetImageDecodePool(&ThreadPool::Shared());
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--texture-report") {
+			textures::PrintCompressionReport("resources/textures", &ThreadPool::Shared());
+			return 0;
+		}
+		else if (arg == "--ktx2-report") {
+			textures::PrintKtx2Report("resources/textures", &ThreadPool::Shared());
+			return 0;
+		}
+		else if (arg == "--jpeg-report") {
+			textures::PrintJpegDecodeReport("resources/textures");
+			return 0;
+		}
+		else if (arg.rfind("--write-pack=", 0) == 0) {
+			std::vector<std::string> files{ };
+			for (const auto& entry : std::filesystem::recursive_directory_iterator("resources")) {
+				if (entry.is_regular_file()) {
+					files.push_back(vfs::FileSystem::NormalizePath(entry.path().string()));
+				}
+			}
+			std::sort(files.begin(), files.end());
+			std::string error;
+			if (!vfs::WritePack(arg.substr(arg.find('=') + 1), files, 6, error)) {
+				std::cerr << "Failed to write pack: " << error << std::endl;
+				return -1;
+			}
+			return 0;
+		}
+		else if (arg.rfind("--pack-report=", 0) == 0) {
+			vfs::PrintPackReport(arg.substr(arg.find('=') + 1), &ThreadPool::Shared());
+			return 0;
+		}
+		else if (arg == "--io-report" || arg.rfind("--io-report=", 0) == 0) {
+			size_t fileCount = arg.find('=') != std::string::npos ? std::stoul(arg.substr(arg.find('=') + 1)) : 3000;
+			vfs::PrintAsyncReadReport(fileCount, &ThreadPool::Shared());
+			return 0;
+		}
+		else if (arg == "--no-pack") {
+			mountResourcePack = false;
+		}
+		else if (arg == "--uncompressed-textures") {
+			textureOptions.compress = false;
+		}
+		else if (arg == "--texture-quality=fast") {
+			textureOptions.quality = textures::CompressionQuality::Fast;
+		}
+		else if (arg == "--texture-quality=high") {
+			textureOptions.quality = textures::CompressionQuality::High;
+		}
+		else if (arg == "--no-texture-streaming") {
+			streamTextures = false;
+		}
+		else if (arg == "--no-shader-cache") {
+			useShaderCache = false;
+		}
+		else if (arg == "--no-shader-reload") {
+			reloadShaders = false;
+		}
+		else if (arg == "--no-shader-pipelines") {
+			useShaderPipelines = false;
+		}
+		else if (arg.rfind("--capture-frames=", 0) == 0) {
+			captureFrames = std::stoul(arg.substr(arg.find('=') + 1));
+		}
+		else if (arg == "--gl-calls") {
+			user_input::show_gl_calls = true;
+		}
+		else if (arg.rfind("--stats-out=", 0) == 0) {
+			statsOutPath = arg.substr(arg.find('=') + 1);
+		}
+		else if (arg == "--fail-on-frame-alloc") {
+			allocationFreeAfterFrame = 120;
+		}
+		else if (arg.rfind("--fail-on-frame-alloc=", 0) == 0) {
+			allocationFreeAfterFrame = std::stoul(arg.substr(arg.find('=') + 1));
+		}
+		else if (arg == "--headless") {
+			headless = true;
+		}
+		else if (arg == "--headless=egl") {
+			headless = true;
+			headlessBackends = { gl_headless::Backend::EGL };
+		}
+		else if (arg == "--headless=osmesa") {
+			headless = true;
+			headlessBackends = { gl_headless::Backend::OSMesa };
+		}
+		else if (arg.rfind("--frames=", 0) == 0) {
+			frameLimit = std::stoul(arg.substr(arg.find('=') + 1));
+		}
+		else if (arg.rfind("--timings-out=", 0) == 0) {
+			timingsOutPath = arg.substr(arg.find('=') + 1);
+		}
+		else if (arg.rfind("--stress-objects=", 0) == 0) {
+			stressOptions.objectCount = std::stoul(arg.substr(arg.find('=') + 1));
+			generateStressScene = true;
+		}
+		else if (arg.rfind("--stress-seed=", 0) == 0) {
+			stressOptions.seed = static_cast<uint32_t>(std::stoul(arg.substr(arg.find('=') + 1)));
+		}
+		else if (arg.rfind("--texture-budget-mb=", 0) == 0) {
+			textureBudgetBytes = std::stoul(arg.substr(arg.find('=') + 1)) * 1024 * 1024;
+		}
+	}
 
-	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	//glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // Needed for MacOS
+#ifdef HEADLESS_ONLY
+	if (!headless) {
+		std::cout << "Built without GLFW, running headless" << std::endl;
+		headless = true;
+	}
+#endif
+	if (headless) {
+		// every run has to draw the same frames: all textures in from the start, and the shaders as they were then
+		streamTextures = false;
+		reloadShaders = false;
+		if (frameLimit == 0) {
+			frameLimit = kDefaultHeadlessFrames;
+		}
+	}
 
-	GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, "learnOpenGL", NULL, NULL);
-	if (window == NULL) {
-		std::cout << "Failed to generate GLFW window!" << std::endl;
-		glfwTerminate();
-		return -1;
+	std::error_code packError;
+	if (mountResourcePack && std::filesystem::is_regular_file(kResourcePack, packError)) {
+		vfs::FileSystem::Shared().Mount(kResourcePack);
 	}
 
-	glfwMakeContextCurrent(window);
+	// a headless run never touches GLFW, so it works without a display server
+	GLFWwindow* window = NULL;
+	GLADloadproc loader = nullptr;
+	if (headless) {
+		std::cout << "Creating headless context..." << std::endl;
+		std::string errors;
+		bool created = false;
+		for (gl_headless::Backend backend : headlessBackends) {
+			std::string error;
+			if (gl_headless::CreateContext(backend, windowWidth, windowHeight, error)) {
+				std::cout << "Rendering headless through " << gl_headless::GetBackendName(backend) << std::endl;
+				created = true;
+				break;
+			}
+			errors += "\n  " + error;
+		}
+		if (!created) {
+			std::cout << "Failed to create a headless context:" << errors << std::endl;
+			return -1;
+		}
+		loader = gl_headless::GetLoader();
+	}
+#ifndef HEADLESS_ONLY
+	else {
+		std::cout << "Creating window..." << std::endl;
+
+		glfwInit();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		//glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // Needed for MacOS
+
+		window = glfwCreateWindow(windowWidth, windowHeight, "learnOpenGL", NULL, NULL);
+		if (window == NULL) {
+			std::cout << "Failed to generate GLFW window!" << std::endl;
+			glfwTerminate();
+			return -1;
+		}
 
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		glfwMakeContextCurrent(window);
+		loader = (GLADloadproc)glfwGetProcAddress;
+	}
+#endif
+
+	if (!gladLoadGLLoader(loader)) {
 		std::cout << "Failed to initialize GLAD!" << std::endl;
 		return -1;
 	}
+	gl_ext::Init(loader);
 
 	glViewport(0, 0, windowWidth, windowHeight);
 
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetWindowIconifyCallback(window, window_iconify_callback);
-
-	if (glfwRawMouseMotionSupported()) {
-		glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
-		std::cout << "Raw input is supported, enabling" << std::endl;
+	// a headless context has no default framebuffer worth drawing to, so headless frames go to one of their own
+	unsigned int offscreenFramebuffer = 0;
+	unsigned int offscreenRenderbuffers[2]{ };
+	if (headless) {
+		glGenRenderbuffers(2, offscreenRenderbuffers);
+		glBindRenderbuffer(GL_RENDERBUFFER, offscreenRenderbuffers[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, windowWidth, windowHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, offscreenRenderbuffers[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, windowWidth, windowHeight);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glGenFramebuffers(1, &offscreenFramebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenRenderbuffers[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenRenderbuffers[1]);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			std::cout << "Failed to create the offscreen framebuffer!" << std::endl;
+			gl_headless::DestroyContext();
+			return -1;
+		}
 	}
+#ifndef HEADLESS_ONLY
+	else {
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetWindowIconifyCallback(window, window_iconify_callback);
+
+		if (glfwRawMouseMotionSupported()) {
+			glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+			std::cout << "Raw input is supported, enabling" << std::endl;
+		}
 
-	ToggleCursorLock(window, cursor_locked);
+		ToggleCursorLock(window, cursor_locked);
+	}
+#endif
 
 	// imgui init
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGuiIO& io = ImGui::GetIO();
 	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-	ImGui_ImplGlfw_InitForOpenGL(window, true);
-	ImGui_ImplOpenGL3_Init();
+	if (headless) {
+		// window positions from an earlier interactive run would change what gets drawn
+		io.IniFilename = nullptr;
+		// there's no platform backend to set these each frame
+		io.DisplaySize = ImVec2(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+		io.DeltaTime = static_cast<float>(kHeadlessFrameSeconds);
+	}
+#ifndef HEADLESS_ONLY
+	else {
+		ImGui_ImplGlfw_InitForOpenGL(window, true);
+	}
+#endif
+	if (!ImGui_ImplOpenGL3_Init()) {
+		std::cout << "Failed to initialize the ImGui OpenGL backend!" << std::endl;
+		return -1;
+	}
 
 	// temporary vertices for a vertically stretched cube
 	float vertices[] = {
@@ -344,72 +637,50 @@ int main() {
 	};
 
 	/* Textures */
-	std::vector<unsigned int> textures{};
+	std::vector<unsigned int> textureIds{};
 	stbi_set_flip_vertically_on_load(true);
-	// Load image data
-	for (int i = 0; i < 2; i++) {
-		int width;
-		int height;
-		int nrChannels;
-		unsigned char* textureData;
-		GLint internalFormat;
-		GLenum format;
-		switch (i) {
-		case 0:
-			internalFormat = GL_RGB;
-			format = GL_RGB;
-			textureData = stbi_load("resources/textures/container.jpg", &width, &height, &nrChannels, 0);
-			break;
-		case 1:
-			internalFormat = GL_RGBA;
-			format = GL_RGBA;
-			textureData = stbi_load("resources/textures/awesomeface.png", &width, &height, &nrChannels, 0);
-			break;
-		default:
-			internalFormat = GL_RGB;
-			format = GL_RGB;
-			textureData = stbi_load("resources/textures/bricktile.png", &width, &height, &nrChannels, 0);
-			break;
+	const char* texturePaths[] = {
+		"resources/textures/container.jpg",
+		"resources/textures/awesomeface.png"
+	};
+	// streaming needs block compressed mips, so the uncompressed path always loads up front
+	streamTextures = streamTextures && textureOptions.compress;
+	auto textureStreamer = std::make_unique<textures::TextureStreamer>(textureBudgetBytes);
+	std::vector<textures::TextureStreamer::Handle> streamedTextures{ };
+	size_t textureBytes = 0;
+	for (const char* path : texturePaths) {
+		MEMORY_TAG(profiling::MemoryTag::Assets);
+		if (streamTextures) {
+			streamedTextures.push_back(textureStreamer->Request(path, textureOptions));
+			textureIds.push_back(textureStreamer->GetTextureId(streamedTextures.back()));
+			continue;
 		}
-
-		if (textureData) {
-			textures.push_back(0);
-			glGenTextures(1, &textures[i]);
-			glBindTexture(GL_TEXTURE_2D, textures[i]);
-
-			// texture wrapping
-			//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-			// texture filtering
-			//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			// for using with mipmaps, which are ALWAYS smaller than base texture
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			// Generate texture
-			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, textureData);
-			glGenerateMipmap(GL_TEXTURE_2D);
+		textures::LoadedTexture texture = textures::LoadTexture(path, textureOptions);
+		if (texture.id) {
+			textureIds.push_back(texture.id);
+			textureBytes += texture.gpuBytes;
+			std::cout << "Loaded " << path << " (" << texture.width << "x" << texture.height << ", "
+				<< (texture.compressed ? "block compressed" : "uncompressed") << ", " << texture.gpuBytes / 1024 << " KiB)" << std::endl;
 		}
 		else {
 			std::cerr << "Failed to load image!" << std::endl;
 		}
-
-		// Free image data
-		stbi_image_free(textureData);
-
 	}
 
 	std::cout << "Generated textures with ids: ";
-	size_t textureCount = textures.size();
+	size_t textureCount = textureIds.size();
 	for (int i = 0; i < textureCount; i++) {
-		std::cout << textures[i];
+		std::cout << textureIds[i];
 		if (i + 1 != textureCount) {
 			std::cout << ", ";
 		}
 	}
-	std::cout << std::endl;
+	if (streamTextures) {
+		std::cout << " streaming within a " << textureBudgetBytes / 1024 << " KiB budget" << std::endl;
+	}
+	else {
+		std::cout << " using " << textureBytes / 1024 << " KiB" << std::endl;
+	}
 
 
 	// get into habit of drawing CCW
@@ -424,12 +695,6 @@ int main() {
 	// Element buffer object
 	//unsigned int EBO;
 	//glGenBuffers(1, &EBO);
-	// Vertex array(attribute) object
-	unsigned int VAO;
-	glGenVertexArrays(1, &VAO);
-
-	// bind VAO to start tracking state
-	glBindVertexArray(VAO);
 
 	// bind VBO and copy vertices array to buffer
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -441,7 +706,7 @@ int main() {
 	//glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	//glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-	/* Set vertex attributes pointers.
+	/* Describe the vertex attributes, the pipeline cache turns this into a VAO.
 	Attribute (0) (x, y, z) has (3) non-normalized(GL_FALSE) (GL_FLOAT) elements.
 	It starts at (0) byte offset, and repeats every (8 * sizeof(float)) bytes.
 
@@ -451,53 +716,177 @@ int main() {
 	Attribute (2) (u, v) has (2) non-normalized(GL_FALSE) (FL_FLOAT) elements.
 	It starts at (6 * sizeof(float)) byte offset, and repeats every (8 * sizeof(float)) bytes.
 	*/
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	// enable attribute 0 (x, y, z)
-	glEnableVertexAttribArray(0);
-	// enable attribute 1 (r, g, b)
-	glEnableVertexAttribArray(1);
-	// enable attribute 2 (u, v)
-	glEnableVertexAttribArray(2);
-
-	// unbind VAO to stop tracking state
-	glBindVertexArray(NULL);
-
-	// note: shaders are not part of VAO state
-
-	// parse and prepare shader code
-	ShaderLoader::ShaderSources shaderSources = ShaderLoader::ParseShaderSources(vertShaderPath, fragShaderPath);
-
-	// compile, link, and validate shader program
-	unsigned int shaderProgram = ShaderLoader::CreateShaderProgram(shaderSources.vertShaderSrc, shaderSources.fragShaderSrc);
-	glUseProgram(shaderProgram);
-
-	unsigned int timeUniformLocation = glGetUniformLocation(shaderProgram, "time");
-	unsigned int percentUniformLocation = glGetUniformLocation(shaderProgram, "percent");
-	unsigned int texture0UniformLocation = glGetUniformLocation(shaderProgram, "texture0");
-	unsigned int texture1UniformLocation = glGetUniformLocation(shaderProgram, "texture1");
-	unsigned int transformUniformLocation = glGetUniformLocation(shaderProgram, "transform");
-	unsigned int modelMatrixUniformLocation = glGetUniformLocation(shaderProgram, "modelMatrix");
-	unsigned int viewMatrixUniformLocation = glGetUniformLocation(shaderProgram, "viewMatrix");
-	unsigned int projMatrixUniformLocation = glGetUniformLocation(shaderProgram, "projMatrix");
-	glUniform1i(texture0UniformLocation, 0);
-	glUniform1i(texture1UniformLocation, 1);
+	render::VertexLayout cubeLayout{ 8 * sizeof(float) };
+	// attribute 0 (x, y, z)
+	cubeLayout.attributes.push_back({ 0, 3, GL_FLOAT, false, 0 });
+	// attribute 1 (r, g, b)
+	cubeLayout.attributes.push_back({ 1, 3, GL_FLOAT, false, 3 * sizeof(float) });
+	// attribute 2 (u, v)
+	cubeLayout.attributes.push_back({ 2, 2, GL_FLOAT, false, 6 * sizeof(float) });
+
+	// note: shaders are not part of VAO state, but they are part of a pipeline state
+
+	// parse and prepare shader code, shared snippets come in through #include
+	ShaderPreprocessor shaderPreprocessor{ };
+	shaderPreprocessor.AddIncludeDirectory("resources/shaders");
+
+	// linked binaries from a previous run are loaded instead of compiling again
+	ProgramCache programCache(useShaderCache ? "shader-cache" : "");
+
+	// edits to the shader files get compiled in the background and swapped in once they link
+	std::unique_ptr<ShaderReloader> shaderReloader{ };
+	if (reloadShaders) {
+		shaderReloader = std::make_unique<ShaderReloader>(window, &shaderPreprocessor);
+	}
+
+	// compile, link, and validate the base shader program; feature variants follow when first drawn with
+	// with separate shader objects, each stage is linked once per feature set it uses and variants combine them in pipelines
+	auto shaderVariants = std::make_unique<ShaderVariants>(vertShaderPath, fragShaderPath, kShaderFeatures, shaderPreprocessor, programCache, shaderReloader.get(), useShaderPipelines);
+	ShaderVariants::Binding shaderBinding = shaderVariants->GetBinding(0);
+	// every combination gets built now rather than hitching when a toggle first asks for it
+	std::vector<ShaderVariants::Features> allShaderFeatures{ };
+	for (ShaderVariants::Features features = 1; features < (1u << kShaderFeatures.size()); features++) {
+		allShaderFeatures.push_back(features);
+	}
+	shaderVariants->Prewarm(allShaderFeatures);
+	programCache.PrintStats();
+
+	// uniforms are looked up once per program; unchanged values aren't uploaded again
+	UniformTable uniforms{ };
+	int timeUniform = -1;
+	int percentUniform = -1;
+	int transformUniform = -1;
+	int modelMatrixUniform = -1;
+	int viewMatrixUniform = -1;
+	int projMatrixUniform = -1;
+	// the cube is drawn solid or as wireframe; both pipeline states change with the shader
+	auto pipelineCache = std::make_unique<render::PipelineCache>();
+	const render::PipelineState* solidPipeline = nullptr;
+	const render::PipelineState* wireframePipeline = nullptr;
+	auto currentPipeline = [&]() -> const render::PipelineState& {
+		return user_input::wireframe_enabled ? *wireframePipeline : *solidPipeline;
+	};
+	// a reloaded program starts with fresh uniform state, so this runs again after every swap
+	auto bindShaderProgram = [&]() {
+		render::PipelineDesc cubeDesc{ };
+		cubeDesc.program = shaderBinding.program;
+		cubeDesc.programPipeline = shaderBinding.pipeline;
+		cubeDesc.layout = cubeLayout;
+		cubeDesc.depthTest = true;
+		solidPipeline = pipelineCache->Create(cubeDesc);
+		cubeDesc.polygonMode = GL_LINE;
+		wireframePipeline = pipelineCache->Create(cubeDesc);
+		// a reload may hand out the name of the program it deleted, which the cache would take for the one in use
+		pipelineCache->Invalidate();
+		pipelineCache->Bind(currentPipeline());
+		if (shaderBinding.pipeline != 0) {
+			uniforms.ReflectPipeline(shaderBinding.vertProgram, shaderBinding.fragProgram);
+		}
+		else {
+			uniforms.Reflect(shaderBinding.program);
+		}
+		timeUniform = uniforms.Find("time");
+		percentUniform = uniforms.Find("percent");
+		transformUniform = uniforms.Find("transform");
+		modelMatrixUniform = uniforms.Find("modelMatrix");
+		viewMatrixUniform = uniforms.Find("viewMatrix");
+		projMatrixUniform = uniforms.Find("projMatrix");
+		uniforms.Set("texture0", 0);
+		uniforms.Set("texture1", 1);
+	};
+	bindShaderProgram();
 
 	projectionMatrix = UpdateProjectionMatrix(user_input::perspective_enabled);
 	UpdateTransformMatrix();
 
-	glEnable(GL_DEPTH_TEST);
-
 	// setup debug props
-	propsToPrint.emplace_back(&infoMouse);
-	propsToPrint.emplace_back(&infoCamRot);
-	propsToPrint.emplace_back(&infoCamPos);
+	watches.Add("Mouse", "x", &mouseX, "y", &mouseY);
+	watches.Add("Cam rot", "x", &camPitch, "y", &camYaw);
+	watches.Add("Cam pos", "x", "y", "z", cam.getPositionPointer());
+	watches.Add("Uniform calls", "issued", &uniformCallsIssued, "skipped", &uniformCallsSkipped);
+	watches.Add("Pipeline binds", "applied", &pipelineBindsApplied, "redundant", &pipelineBindsRedundant);
+	watches.Add("GPU ms", "clear", &gpuClearMs, "scene", &gpuSceneMs, "imgui", &gpuImGuiMs);
+	watches.Add("GL calls", "total", &glCalls, "draws", &glDrawCalls, "upload KiB", &glUploadKiB);
+	watches.Add("Stress scene", "updated", &stressUpdated, "visible", &stressVisible, "materials", &stressMaterialRuns);
+	if (streamTextures) {
+		watches.Add("Texels", "resident", &residentTexels, "requested", &requestedTexels);
+		watches.Add("Texture KiB", "resident", &residentTextureKiB, "budget", &textureBudgetKiB);
+	}
+	if (profiling::IsMemoryTrackingEnabled()) {
+		for (size_t i = 0; i <= profiling::kMemoryTagCount; i++) {
+			std::string name = i < profiling::kMemoryTagCount ? std::string("Alloc ") + profiling::GetMemoryTagName(static_cast<profiling::MemoryTag>(i)) : "Alloc total";
+			watches.Add(name, "count", &frameAllocations[i], "bytes", &frameAllocatedBytes[i], "live KiB", &liveKiB[i]);
+		}
+	}
+
+	// GPU time of each pass, a few frames late so reading it never stalls
+	auto gpuTimer = std::make_unique<profiling::GpuTimer>();
+	std::unique_ptr<scene::StressScene> stressScene;
+	GUI::Debug::StressSceneRequest stressRequest = generateStressScene ? GUI::Debug::StressSceneRequest::Generate : GUI::Debug::StressSceneRequest::None;
+
+	std::vector<profiling::GpuTimer::FrameTime> gpuFrameTimes{ };
+	gpuFrameTimes.reserve(profiling::GpuTimer::kMaxUndrainedFrames);
+	profiling::FrameTimeRecorder frameTimes{ };
+
+	// the overlay's numbers go into frame captures too
+	profiling::RegisterCounter("Uniform calls issued", &uniformCallsIssued);
+	profiling::RegisterCounter("Pipeline binds applied", &pipelineBindsApplied);
+	profiling::RegisterCounter("GPU clear ms", &gpuClearMs);
+	profiling::RegisterCounter("GPU scene ms", &gpuSceneMs);
+	profiling::RegisterCounter("GPU ImGui ms", &gpuImGuiMs);
+	if (streamTextures) {
+		profiling::RegisterCounter("Resident texels", &residentTexels);
+		profiling::RegisterCounter("Resident texture KiB", &residentTextureKiB);
+	}
+	if (profiling::IsMemoryTrackingEnabled()) {
+		profiling::RegisterCounter("Frame allocations", &frameAllocations[profiling::kMemoryTagCount]);
+		profiling::RegisterCounter("Live KiB", &liveKiB[profiling::kMemoryTagCount]);
+	}
+	profiling::RegisterCounter("GL calls", &glCalls);
+	profiling::RegisterCounter("GL draw calls", &glDrawCalls);
+	profiling::RegisterCounter("GL upload KiB", &glUploadKiB);
+	profiling::RegisterCounter("Stress objects updated", &stressUpdated);
+	profiling::RegisterCounter("Stress objects visible", &stressVisible);
+	// a row per frame with every counter above, written at exit
+	std::unique_ptr<profiling::FrameLog> frameLog;
+	if (!timingsOutPath.empty()) {
+		frameLog = std::make_unique<profiling::FrameLog>(profiling::GetCounterNames(), frameLimit);
+		for (const GpuPassCounter& gpuPass : kGpuPassCounters) {
+			frameLog->SetLate(gpuPass.counter);
+		}
+	}
+	const std::vector<double> noCounters{ };
+	int exitCode = 0;
+	size_t framesDone = 0;
+	if (captureFrames > 0) {
+		profiling::StartCapture(captureFrames);
+	}
 
-	while (!glfwWindowShouldClose(window)) {
+	bool closeRequested = false;
+	while (!closeRequested) {
+#ifndef HEADLESS_ONLY
+		if (!headless && glfwWindowShouldClose(window)) {
+			break;
+		}
+#endif
+		// whatever the frame doesn't tag otherwise is rendering
+		MEMORY_TAG(profiling::MemoryTag::Render);
+		// the GL calls window shows what the instrumentation counts, so it's only on while the window is open
+		gl_calls::SetEnabled(*is_gl_calls_visible);
+		uint64_t frameBegin = profiling::Now();
+		uint64_t frameIndex = profiling::GetFrameIndex();
 		lastTime = currentTime;
-		currentTime = glfwGetTime();
+		currentTime = static_cast<double>(framesDone + 1) * kHeadlessFrameSeconds;
+#ifndef HEADLESS_ONLY
+		if (!headless) {
+			currentTime = glfwGetTime();
+		}
+#endif
 		deltaTime = currentTime - lastTime;
+		// the first frame would count the time since glfwInit; headless frames are timed as they run instead
+		if (!headless && lastTime > 0.0) {
+			frameTimes.RecordCpu(deltaTime * 1000.0);
+		}
 
 		//for (int i = 0; i < 3; i++) {
 		//	vertices[6 * i + 1] += 0.00025f * (sin(time));
@@ -507,23 +896,100 @@ int main() {
 		//glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
 		//glBindVertexArray(NULL);
 
-		// input
-		glfwPollEvents();
-		PollInput(window);
-		ProcessInput(window);
+		// input, nobody is at the keyboard of a headless run
+#ifndef HEADLESS_ONLY
+		if (!headless) {
+			MEMORY_TAG(profiling::MemoryTag::Input);
+			{
+				PROFILE_SCOPE("glfwPollEvents");
+				glfwPollEvents();
+			}
+			PollInput(window);
+			ProcessInput(window);
+		}
+#endif
 
 		// start ImGui frame
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
-		ImGui::NewFrame();
-		//ImGui::ShowDemoWindow();
-		if (*is_overlay_visible) {
-			GUI::Debug::showOverlay(is_overlay_visible, &propsToPrint);
+		{
+			MEMORY_TAG(profiling::MemoryTag::Gui);
+			ImGui_ImplOpenGL3_NewFrame();
+#ifndef HEADLESS_ONLY
+			if (!headless) {
+				ImGui_ImplGlfw_NewFrame();
+			}
+#endif
+			ImGui::NewFrame();
+			//ImGui::ShowDemoWindow();
+			if (*is_overlay_visible) {
+				GUI::Debug::showOverlay(is_overlay_visible, &watches, &frameTimes);
+			}
+			if (*is_profiler_visible) {
+				GUI::Debug::showProfiler(is_profiler_visible);
+			}
+			if (*is_gl_calls_visible) {
+				GUI::Debug::showGLCalls(is_gl_calls_visible, gl_calls::GetFrameStats());
+			}
+			if (*is_stress_scene_visible) {
+				GUI::Debug::StressSceneRequest request = GUI::Debug::showStressScene(is_stress_scene_visible, stressOptions, stressScene ? &stressScene->GetStats() : nullptr);
+				if (request != GUI::Debug::StressSceneRequest::None) {
+					stressRequest = request;
+				}
+			}
+			if (shaderReloader) {
+				shaderReloader->Update();
+				GUI::Debug::showShaderErrors(shaderReloader->GetErrors());
+			}
+		}
+
+		// the variant changes with the toggles, and its program or stage programs with every hot reload
+		shaderVariants->Update();
+		ShaderVariants::Features shaderFeatures = 0;
+		if (percent > 0.0f) {
+			shaderFeatures |= kFeatureTextureMix;
+		}
+		if (user_input::alpha_test_enabled) {
+			shaderFeatures |= kFeatureAlphaTest;
+		}
+		if (user_input::fog_enabled) {
+			shaderFeatures |= kFeatureFog;
+		}
+		ShaderVariants::Binding variantBinding = shaderVariants->GetBinding(shaderFeatures);
+		if (variantBinding != shaderBinding) {
+			shaderBinding = variantBinding;
+			bindShaderProgram();
+		}
+
+		if (stressRequest != GUI::Debug::StressSceneRequest::None) {
+			MEMORY_TAG(profiling::MemoryTag::Assets);
+			// the old scene goes first, so a million objects aren't in memory twice
+			stressScene.reset();
+			if (stressRequest == GUI::Debug::StressSceneRequest::Generate) {
+				stressScene = std::make_unique<scene::StressScene>(stressOptions);
+				const scene::StressSceneStats& stressStats = stressScene->GetStats();
+				std::cout << "Generated a stress scene of " << stressStats.objects << " objects (" << stressStats.roots << " roots, " << stressStats.movers
+					<< " movers, seed " << stressOptions.seed << ") in " << stressStats.generateMs << " ms" << std::endl;
+			}
+			stressRequest = GUI::Debug::StressSceneRequest::None;
 		}
 
 		// update matrices
 		UpdateModelMatrix();
+		if (headless) {
+			FollowCameraPath(framesDone, frameLimit);
+		}
 		UpdateViewMatrix();
+		if (stressScene) {
+			stressScene->Update(static_cast<float>(currentTime));
+			stressScene->Cull(projectionMatrix * viewMatrix);
+			stressUpdated = stressScene->GetStats().updated;
+			stressVisible = stressScene->GetStats().visible;
+			stressMaterialRuns = stressScene->GetStats().materialRuns;
+		}
+		else {
+			stressUpdated = 0;
+			stressVisible = 0;
+			stressMaterialRuns = 0;
+		}
 
 		//std::cout << "x: " << mouseX << ", y: " << mouseY << "                         " << std::endl;
 		//std::cout << "cam rotation: " << camYaw << " " << camPitch << "                         " << std::endl;
@@ -534,36 +1000,110 @@ int main() {
 		//std::cout << "delta_: " << delta_.x << ", " << delta_.y << ", " << delta_.z << "                           " << std::endl;
 		//std::cout << "\033[A\033[A\033[A\033[A\033[A\033[A\033[A\r";
 
+		// both textures are drawn on the cube, so they share its bounds
+		if (streamTextures) {
+			for (textures::TextureStreamer::Handle handle : streamedTextures) {
+				textureStreamer->SetBounds(handle, translation, 0.5f * std::sqrt(3.0f) * scale.x);
+			}
+			textureStreamer->Update(cam.getPosition(), glm::radians(vFov), windowHeight);
+			const textures::StreamingStats& streamingStats = textureStreamer->GetStats();
+			residentTexels = streamingStats.residentTexels;
+			requestedTexels = streamingStats.requestedTexels;
+			residentTextureKiB = streamingStats.residentBytes / 1024;
+			textureBudgetKiB = streamingStats.budgetBytes / 1024;
+		}
+
+		gpuTimer->BeginFrame();
+		gpuClearMs = gpuTimer->GetPassMs("GPU clear");
+		gpuSceneMs = gpuTimer->GetPassMs("GPU scene");
+		gpuImGuiMs = gpuTimer->GetPassMs("GPU ImGui");
+		gpuFrameTimes.clear();
+		gpuTimer->DrainFrameTimes(gpuFrameTimes);
+		for (const profiling::GpuTimer::FrameTime& gpuFrameTime : gpuFrameTimes) {
+			frameTimes.RecordGpu(gpuFrameTime.ms);
+			if (frameLog) {
+				frameLog->RecordGpu(gpuFrameTime.frameIndex, gpuFrameTime.ms);
+			}
+		}
+		if (frameLog) {
+			RecordGpuPasses(*frameLog, *gpuTimer);
+		}
+
 		// clear last render
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (headless) {
+			glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+		}
+		{
+			PROFILE_GPU_SCOPE(*gpuTimer, "GPU clear");
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
 
 		// I originally did this part in the texture setup step so I'm not doing this right now.
 		// But if we had multiple objects and texture sets we wanted to render
 		// Then this would be the time to set them
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textures[0]);
+		glBindTexture(GL_TEXTURE_2D, textureIds[0]);
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, textures[1]);
+		glBindTexture(GL_TEXTURE_2D, textureIds[1]);
 
 		// render
 		// draw triangles
-		if (shaderProgram) {
-			glUseProgram(shaderProgram);
-			glUniform1f(timeUniformLocation, currentTime);
-			glUniform1f(percentUniformLocation, percent);
-			glUniformMatrix4fv(transformUniformLocation, 1, GL_FALSE, glm::value_ptr(transform));
-			glUniformMatrix4fv(modelMatrixUniformLocation, 1, GL_FALSE, glm::value_ptr(modelMatrix));
-			glUniformMatrix4fv(viewMatrixUniformLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
-			glUniformMatrix4fv(projMatrixUniformLocation, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
-		}
-		//DrawTriangle(VAO, sizeof(indices) / sizeof(indices[0]));
-		DrawTriangle(VAO, 36);
+		if (shaderBinding) {
+			PROFILE_SCOPE("Draw cube");
+			PROFILE_GPU_SCOPE(*gpuTimer, "GPU scene");
+			pipelineCache->Bind(currentPipeline());
+			uniforms.Set(timeUniform, (float)currentTime);
+			uniforms.Set(percentUniform, percent);
+			uniforms.Set(transformUniform, transform);
+			uniforms.Set(modelMatrixUniform, modelMatrix);
+			uniforms.Set(viewMatrixUniform, viewMatrix);
+			uniforms.Set(projMatrixUniform, projectionMatrix);
+			pipelineCache->BindVertexBuffer(VBO);
+			//pipelineCache->Draw(0, sizeof(indices) / sizeof(indices[0]));
+			pipelineCache->Draw(0, 36);
+		}
+		if (stressScene && shaderBinding) {
+			PROFILE_SCOPE("Draw stress scene");
+			PROFILE_GPU_SCOPE(*gpuTimer, "GPU stress scene");
+			pipelineCache->Bind(currentPipeline());
+			pipelineCache->BindVertexBuffer(VBO);
+			// the objects' world matrices are all there is to their transform
+			uniforms.Set(transformUniform, glm::mat4{ 1.0f });
+			uint32_t boundMaterial = UINT32_MAX;
+			for (uint32_t object : stressScene->GetDrawList()) {
+				uint32_t materialIndex = stressScene->GetMaterialIndex(object);
+				if (materialIndex != boundMaterial) {
+					boundMaterial = materialIndex;
+					const scene::StressMaterial& material = stressScene->GetMaterial(materialIndex);
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, material.texture0);
+					glActiveTexture(GL_TEXTURE1);
+					glBindTexture(GL_TEXTURE_2D, material.texture1);
+					uniforms.Set(percentUniform, material.mix);
+				}
+				uniforms.Set(modelMatrixUniform, stressScene->GetWorldMatrix(object));
+				pipelineCache->Draw(0, 36);
+			}
+		}
+		// shown by the overlay next frame
+		uniformCallsIssued = uniforms.GetStats().issued;
+		uniformCallsSkipped = uniforms.GetStats().skipped;
+		uniforms.BeginFrame();
+		pipelineBindsApplied = pipelineCache->GetStats().binds - pipelineCache->GetStats().redundantBinds;
+		pipelineBindsRedundant = pipelineCache->GetStats().redundantBinds;
+		pipelineCache->BeginFrame();
 
 		// Render ImGui
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		{
+			PROFILE_SCOPE("ImGui render");
+			PROFILE_GPU_SCOPE(*gpuTimer, "GPU ImGui");
+			MEMORY_TAG(profiling::MemoryTag::Gui);
+			ImGui::Render();
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
 
+#ifndef HEADLESS_ONLY
 		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 		{
 			GLFWwindow* backup_current_context = glfwGetCurrentContext();
@@ -571,15 +1111,124 @@ int main() {
 			ImGui::RenderPlatformWindowsDefault();
 			glfwMakeContextCurrent(backup_current_context);
 		}
+#endif
 
 		// check and call events and swap buffers
-		
-		glfwSwapBuffers(window);
+		if (headless) {
+			// nothing to show, but the frame still has to reach the driver like a swap would send it
+			glFlush();
+		}
+#ifndef HEADLESS_ONLY
+		else {
+			PROFILE_SCOPE("glfwSwapBuffers");
+			glfwSwapBuffers(window);
+		}
+#endif
+		// shown by the overlay next frame, and set before EndFrame so the profiler's snapshot of them is this frame's
+		if (gl_calls::IsEnabled()) {
+			const gl_calls::FrameStats& glStats = gl_calls::EndFrame();
+			glCalls = glStats.totalCalls;
+			glDrawCalls = glStats.drawCalls;
+			glUploadKiB = glStats.uploadBytes / 1024;
+		}
+		else {
+			glCalls = 0;
+			glDrawCalls = 0;
+			glUploadKiB = 0;
+		}
+		const profiling::MemoryFrameStats& memoryStats = profiling::EndMemoryFrame();
+		for (size_t i = 0; i <= profiling::kMemoryTagCount; i++) {
+			const profiling::MemoryTagStats& tagStats = i < profiling::kMemoryTagCount ? memoryStats.tags[i] : memoryStats.total;
+			frameAllocations[i] = tagStats.allocations;
+			frameAllocatedBytes[i] = tagStats.bytes;
+			liveKiB[i] = tagStats.liveBytes / 1024;
+		}
+		// zones of every thread so far belong to this frame
+		{
+			MEMORY_TAG(profiling::MemoryTag::Untagged);
+			profiling::EndFrame();
+		}
+		double frameMs = profiling::TicksToMs(profiling::Now() - frameBegin);
+		if (headless) {
+			frameTimes.RecordCpu(frameMs);
+		}
+		if (frameLog) {
+			// the history doesn't get the frame while the profiler is paused
+			const profiling::FrameHistory& frames = profiling::GetFrames();
+			bool recorded = !frames.empty() && frames.back().index == frameIndex;
+			frameLog->Record(frameIndex, frameMs, recorded ? frames.back().counters : noCounters);
+		}
+		framesDone++;
+		if (frameLimit > 0 && framesDone >= frameLimit) {
+			closeRequested = true;
+		}
+		if (allocationFreeAfterFrame > 0 && framesDone > allocationFreeAfterFrame && memoryStats.total.allocations > 0 && exitCode == 0) {
+			std::cerr << "Frame " << framesDone << " allocated " << memoryStats.total.allocations << " times (" << memoryStats.total.bytes << " bytes):";
+			for (size_t i = 0; i < profiling::kMemoryTagCount; i++) {
+				if (memoryStats.tags[i].allocations > 0) {
+					std::cerr << " " << profiling::GetMemoryTagName(static_cast<profiling::MemoryTag>(i)) << " " << memoryStats.tags[i].allocations;
+				}
+			}
+			std::cerr << std::endl;
+			exitCode = -1;
+			closeRequested = true;
+		}
 	}
 
+	// the last frames' GPU times, which the loop ended before reading back
+	glFinish();
+	gpuTimer->BeginFrame();
+	gpuFrameTimes.clear();
+	gpuTimer->DrainFrameTimes(gpuFrameTimes);
+	for (const profiling::GpuTimer::FrameTime& gpuFrameTime : gpuFrameTimes) {
+		frameTimes.RecordGpu(gpuFrameTime.ms);
+		if (frameLog) {
+			frameLog->RecordGpu(gpuFrameTime.frameIndex, gpuFrameTime.ms);
+		}
+	}
+	if (frameLog) {
+		RecordGpuPasses(*frameLog, *gpuTimer);
+		std::string error;
+		if (!frameLog->Write(timingsOutPath, error)) {
+			std::cerr << "Failed to write frame timings: " << error << std::endl;
+			exitCode = -1;
+		}
+		else {
+			std::cout << "Wrote " << framesDone << " frame timings to " << timingsOutPath << std::endl;
+		}
+	}
+
+	// streamed textures, the stress scene's textures, vertex arrays, queries, shader programs and the shader compile context have to go while the main context is still current
+	textureStreamer.reset();
+	stressScene.reset();
+	shaderVariants->PrintReport();
+	programCache.PrintStats();
+	frameTimes.PrintReport();
+	if (!statsOutPath.empty()) {
+		std::string error;
+		if (!frameTimes.WriteReport(statsOutPath, error)) {
+			std::cerr << "Failed to write frame time stats: " << error << std::endl;
+		}
+	}
+	pipelineCache.reset();
+	gpuTimer.reset();
+	if (offscreenFramebuffer != 0) {
+		glDeleteFramebuffers(1, &offscreenFramebuffer);
+		glDeleteRenderbuffers(2, offscreenRenderbuffers);
+	}
+	shaderVariants.reset();
+	shaderReloader.reset();
 	ImGui_ImplOpenGL3_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
-	glfwTerminate();
-	return 0;
+	if (headless) {
+		ImGui::DestroyContext();
+		gl_headless::DestroyContext();
+	}
+#ifndef HEADLESS_ONLY
+	else {
+		ImGui_ImplGlfw_Shutdown();
+		ImGui::DestroyContext();
+		glfwTerminate();
+	}
+#endif
+	return exitCode;
 }
\ No newline at end of file
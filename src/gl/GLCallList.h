@@ -0,0 +1,408 @@
+// every entry point of our glad build (core 3.3), as GL_CALL(name without the gl prefix)
+// regenerate the GL_CALL lines along with the loader: grep -oP '^GLAPI PFNGL\w+PROC glad_gl\K\w+' glad.h | sed 's/.*/GL_CALL(&)/'
+// no include guard, define GL_CALL before including it, and GL_EXT_CALL for the gl_ext ones at the end
+GL_CALL(CullFace)
+GL_CALL(FrontFace)
+GL_CALL(Hint)
+GL_CALL(LineWidth)
+GL_CALL(PointSize)
+GL_CALL(PolygonMode)
+GL_CALL(Scissor)
+GL_CALL(TexParameterf)
+GL_CALL(TexParameterfv)
+GL_CALL(TexParameteri)
+GL_CALL(TexParameteriv)
+GL_CALL(TexImage1D)
+GL_CALL(TexImage2D)
+GL_CALL(DrawBuffer)
+GL_CALL(Clear)
+GL_CALL(ClearColor)
+GL_CALL(ClearStencil)
+GL_CALL(ClearDepth)
+GL_CALL(StencilMask)
+GL_CALL(ColorMask)
+GL_CALL(DepthMask)
+GL_CALL(Disable)
+GL_CALL(Enable)
+GL_CALL(Finish)
+GL_CALL(Flush)
+GL_CALL(BlendFunc)
+GL_CALL(LogicOp)
+GL_CALL(StencilFunc)
+GL_CALL(StencilOp)
+GL_CALL(DepthFunc)
+GL_CALL(PixelStoref)
+GL_CALL(PixelStorei)
+GL_CALL(ReadBuffer)
+GL_CALL(ReadPixels)
+GL_CALL(GetBooleanv)
+GL_CALL(GetDoublev)
+GL_CALL(GetError)
+GL_CALL(GetFloatv)
+GL_CALL(GetIntegerv)
+GL_CALL(GetString)
+GL_CALL(GetTexImage)
+GL_CALL(GetTexParameterfv)
+GL_CALL(GetTexParameteriv)
+GL_CALL(GetTexLevelParameterfv)
+GL_CALL(GetTexLevelParameteriv)
+GL_CALL(IsEnabled)
+GL_CALL(DepthRange)
+GL_CALL(Viewport)
+GL_CALL(DrawArrays)
+GL_CALL(DrawElements)
+GL_CALL(PolygonOffset)
+GL_CALL(CopyTexImage1D)
+GL_CALL(CopyTexImage2D)
+GL_CALL(CopyTexSubImage1D)
+GL_CALL(CopyTexSubImage2D)
+GL_CALL(TexSubImage1D)
+GL_CALL(TexSubImage2D)
+GL_CALL(BindTexture)
+GL_CALL(DeleteTextures)
+GL_CALL(GenTextures)
+GL_CALL(IsTexture)
+GL_CALL(DrawRangeElements)
+GL_CALL(TexImage3D)
+GL_CALL(TexSubImage3D)
+GL_CALL(CopyTexSubImage3D)
+GL_CALL(ActiveTexture)
+GL_CALL(SampleCoverage)
+GL_CALL(CompressedTexImage3D)
+GL_CALL(CompressedTexImage2D)
+GL_CALL(CompressedTexImage1D)
+GL_CALL(CompressedTexSubImage3D)
+GL_CALL(CompressedTexSubImage2D)
+GL_CALL(CompressedTexSubImage1D)
+GL_CALL(GetCompressedTexImage)
+GL_CALL(BlendFuncSeparate)
+GL_CALL(MultiDrawArrays)
+GL_CALL(MultiDrawElements)
+GL_CALL(PointParameterf)
+GL_CALL(PointParameterfv)
+GL_CALL(PointParameteri)
+GL_CALL(PointParameteriv)
+GL_CALL(BlendColor)
+GL_CALL(BlendEquation)
+GL_CALL(GenQueries)
+GL_CALL(DeleteQueries)
+GL_CALL(IsQuery)
+GL_CALL(BeginQuery)
+GL_CALL(EndQuery)
+GL_CALL(GetQueryiv)
+GL_CALL(GetQueryObjectiv)
+GL_CALL(GetQueryObjectuiv)
+GL_CALL(BindBuffer)
+GL_CALL(DeleteBuffers)
+GL_CALL(GenBuffers)
+GL_CALL(IsBuffer)
+GL_CALL(BufferData)
+GL_CALL(BufferSubData)
+GL_CALL(GetBufferSubData)
+GL_CALL(MapBuffer)
+GL_CALL(UnmapBuffer)
+GL_CALL(GetBufferParameteriv)
+GL_CALL(GetBufferPointerv)
+GL_CALL(BlendEquationSeparate)
+GL_CALL(DrawBuffers)
+GL_CALL(StencilOpSeparate)
+GL_CALL(StencilFuncSeparate)
+GL_CALL(StencilMaskSeparate)
+GL_CALL(AttachShader)
+GL_CALL(BindAttribLocation)
+GL_CALL(CompileShader)
+GL_CALL(CreateProgram)
+GL_CALL(CreateShader)
+GL_CALL(DeleteProgram)
+GL_CALL(DeleteShader)
+GL_CALL(DetachShader)
+GL_CALL(DisableVertexAttribArray)
+GL_CALL(EnableVertexAttribArray)
+GL_CALL(GetActiveAttrib)
+GL_CALL(GetActiveUniform)
+GL_CALL(GetAttachedShaders)
+GL_CALL(GetAttribLocation)
+GL_CALL(GetProgramiv)
+GL_CALL(GetProgramInfoLog)
+GL_CALL(GetShaderiv)
+GL_CALL(GetShaderInfoLog)
+GL_CALL(GetShaderSource)
+GL_CALL(GetUniformLocation)
+GL_CALL(GetUniformfv)
+GL_CALL(GetUniformiv)
+GL_CALL(GetVertexAttribdv)
+GL_CALL(GetVertexAttribfv)
+GL_CALL(GetVertexAttribiv)
+GL_CALL(GetVertexAttribPointerv)
+GL_CALL(IsProgram)
+GL_CALL(IsShader)
+GL_CALL(LinkProgram)
+GL_CALL(ShaderSource)
+GL_CALL(UseProgram)
+GL_CALL(Uniform1f)
+GL_CALL(Uniform2f)
+GL_CALL(Uniform3f)
+GL_CALL(Uniform4f)
+GL_CALL(Uniform1i)
+GL_CALL(Uniform2i)
+GL_CALL(Uniform3i)
+GL_CALL(Uniform4i)
+GL_CALL(Uniform1fv)
+GL_CALL(Uniform2fv)
+GL_CALL(Uniform3fv)
+GL_CALL(Uniform4fv)
+GL_CALL(Uniform1iv)
+GL_CALL(Uniform2iv)
+GL_CALL(Uniform3iv)
+GL_CALL(Uniform4iv)
+GL_CALL(UniformMatrix2fv)
+GL_CALL(UniformMatrix3fv)
+GL_CALL(UniformMatrix4fv)
+GL_CALL(ValidateProgram)
+GL_CALL(VertexAttrib1d)
+GL_CALL(VertexAttrib1dv)
+GL_CALL(VertexAttrib1f)
+GL_CALL(VertexAttrib1fv)
+GL_CALL(VertexAttrib1s)
+GL_CALL(VertexAttrib1sv)
+GL_CALL(VertexAttrib2d)
+GL_CALL(VertexAttrib2dv)
+GL_CALL(VertexAttrib2f)
+GL_CALL(VertexAttrib2fv)
+GL_CALL(VertexAttrib2s)
+GL_CALL(VertexAttrib2sv)
+GL_CALL(VertexAttrib3d)
+GL_CALL(VertexAttrib3dv)
+GL_CALL(VertexAttrib3f)
+GL_CALL(VertexAttrib3fv)
+GL_CALL(VertexAttrib3s)
+GL_CALL(VertexAttrib3sv)
+GL_CALL(VertexAttrib4Nbv)
+GL_CALL(VertexAttrib4Niv)
+GL_CALL(VertexAttrib4Nsv)
+GL_CALL(VertexAttrib4Nub)
+GL_CALL(VertexAttrib4Nubv)
+GL_CALL(VertexAttrib4Nuiv)
+GL_CALL(VertexAttrib4Nusv)
+GL_CALL(VertexAttrib4bv)
+GL_CALL(VertexAttrib4d)
+GL_CALL(VertexAttrib4dv)
+GL_CALL(VertexAttrib4f)
+GL_CALL(VertexAttrib4fv)
+GL_CALL(VertexAttrib4iv)
+GL_CALL(VertexAttrib4s)
+GL_CALL(VertexAttrib4sv)
+GL_CALL(VertexAttrib4ubv)
+GL_CALL(VertexAttrib4uiv)
+GL_CALL(VertexAttrib4usv)
+GL_CALL(VertexAttribPointer)
+GL_CALL(UniformMatrix2x3fv)
+GL_CALL(UniformMatrix3x2fv)
+GL_CALL(UniformMatrix2x4fv)
+GL_CALL(UniformMatrix4x2fv)
+GL_CALL(UniformMatrix3x4fv)
+GL_CALL(UniformMatrix4x3fv)
+GL_CALL(ColorMaski)
+GL_CALL(GetBooleani_v)
+GL_CALL(GetIntegeri_v)
+GL_CALL(Enablei)
+GL_CALL(Disablei)
+GL_CALL(IsEnabledi)
+GL_CALL(BeginTransformFeedback)
+GL_CALL(EndTransformFeedback)
+GL_CALL(BindBufferRange)
+GL_CALL(BindBufferBase)
+GL_CALL(TransformFeedbackVaryings)
+GL_CALL(GetTransformFeedbackVarying)
+GL_CALL(ClampColor)
+GL_CALL(BeginConditionalRender)
+GL_CALL(EndConditionalRender)
+GL_CALL(VertexAttribIPointer)
+GL_CALL(GetVertexAttribIiv)
+GL_CALL(GetVertexAttribIuiv)
+GL_CALL(VertexAttribI1i)
+GL_CALL(VertexAttribI2i)
+GL_CALL(VertexAttribI3i)
+GL_CALL(VertexAttribI4i)
+GL_CALL(VertexAttribI1ui)
+GL_CALL(VertexAttribI2ui)
+GL_CALL(VertexAttribI3ui)
+GL_CALL(VertexAttribI4ui)
+GL_CALL(VertexAttribI1iv)
+GL_CALL(VertexAttribI2iv)
+GL_CALL(VertexAttribI3iv)
+GL_CALL(VertexAttribI4iv)
+GL_CALL(VertexAttribI1uiv)
+GL_CALL(VertexAttribI2uiv)
+GL_CALL(VertexAttribI3uiv)
+GL_CALL(VertexAttribI4uiv)
+GL_CALL(VertexAttribI4bv)
+GL_CALL(VertexAttribI4sv)
+GL_CALL(VertexAttribI4ubv)
+GL_CALL(VertexAttribI4usv)
+GL_CALL(GetUniformuiv)
+GL_CALL(BindFragDataLocation)
+GL_CALL(GetFragDataLocation)
+GL_CALL(Uniform1ui)
+GL_CALL(Uniform2ui)
+GL_CALL(Uniform3ui)
+GL_CALL(Uniform4ui)
+GL_CALL(Uniform1uiv)
+GL_CALL(Uniform2uiv)
+GL_CALL(Uniform3uiv)
+GL_CALL(Uniform4uiv)
+GL_CALL(TexParameterIiv)
+GL_CALL(TexParameterIuiv)
+GL_CALL(GetTexParameterIiv)
+GL_CALL(GetTexParameterIuiv)
+GL_CALL(ClearBufferiv)
+GL_CALL(ClearBufferuiv)
+GL_CALL(ClearBufferfv)
+GL_CALL(ClearBufferfi)
+GL_CALL(GetStringi)
+GL_CALL(IsRenderbuffer)
+GL_CALL(BindRenderbuffer)
+GL_CALL(DeleteRenderbuffers)
+GL_CALL(GenRenderbuffers)
+GL_CALL(RenderbufferStorage)
+GL_CALL(GetRenderbufferParameteriv)
+GL_CALL(IsFramebuffer)
+GL_CALL(BindFramebuffer)
+GL_CALL(DeleteFramebuffers)
+GL_CALL(GenFramebuffers)
+GL_CALL(CheckFramebufferStatus)
+GL_CALL(FramebufferTexture1D)
+GL_CALL(FramebufferTexture2D)
+GL_CALL(FramebufferTexture3D)
+GL_CALL(FramebufferRenderbuffer)
+GL_CALL(GetFramebufferAttachmentParameteriv)
+GL_CALL(GenerateMipmap)
+GL_CALL(BlitFramebuffer)
+GL_CALL(RenderbufferStorageMultisample)
+GL_CALL(FramebufferTextureLayer)
+GL_CALL(MapBufferRange)
+GL_CALL(FlushMappedBufferRange)
+GL_CALL(BindVertexArray)
+GL_CALL(DeleteVertexArrays)
+GL_CALL(GenVertexArrays)
+GL_CALL(IsVertexArray)
+GL_CALL(DrawArraysInstanced)
+GL_CALL(DrawElementsInstanced)
+GL_CALL(TexBuffer)
+GL_CALL(PrimitiveRestartIndex)
+GL_CALL(CopyBufferSubData)
+GL_CALL(GetUniformIndices)
+GL_CALL(GetActiveUniformsiv)
+GL_CALL(GetActiveUniformName)
+GL_CALL(GetUniformBlockIndex)
+GL_CALL(GetActiveUniformBlockiv)
+GL_CALL(GetActiveUniformBlockName)
+GL_CALL(UniformBlockBinding)
+GL_CALL(DrawElementsBaseVertex)
+GL_CALL(DrawRangeElementsBaseVertex)
+GL_CALL(DrawElementsInstancedBaseVertex)
+GL_CALL(MultiDrawElementsBaseVertex)
+GL_CALL(ProvokingVertex)
+GL_CALL(FenceSync)
+GL_CALL(IsSync)
+GL_CALL(DeleteSync)
+GL_CALL(ClientWaitSync)
+GL_CALL(WaitSync)
+GL_CALL(GetInteger64v)
+GL_CALL(GetSynciv)
+GL_CALL(GetInteger64i_v)
+GL_CALL(GetBufferParameteri64v)
+GL_CALL(FramebufferTexture)
+GL_CALL(TexImage2DMultisample)
+GL_CALL(TexImage3DMultisample)
+GL_CALL(GetMultisamplefv)
+GL_CALL(SampleMaski)
+GL_CALL(BindFragDataLocationIndexed)
+GL_CALL(GetFragDataIndex)
+GL_CALL(GenSamplers)
+GL_CALL(DeleteSamplers)
+GL_CALL(IsSampler)
+GL_CALL(BindSampler)
+GL_CALL(SamplerParameteri)
+GL_CALL(SamplerParameteriv)
+GL_CALL(SamplerParameterf)
+GL_CALL(SamplerParameterfv)
+GL_CALL(SamplerParameterIiv)
+GL_CALL(SamplerParameterIuiv)
+GL_CALL(GetSamplerParameteriv)
+GL_CALL(GetSamplerParameterIiv)
+GL_CALL(GetSamplerParameterfv)
+GL_CALL(GetSamplerParameterIuiv)
+GL_CALL(QueryCounter)
+GL_CALL(GetQueryObjecti64v)
+GL_CALL(GetQueryObjectui64v)
+GL_CALL(VertexAttribDivisor)
+GL_CALL(VertexAttribP1ui)
+GL_CALL(VertexAttribP1uiv)
+GL_CALL(VertexAttribP2ui)
+GL_CALL(VertexAttribP2uiv)
+GL_CALL(VertexAttribP3ui)
+GL_CALL(VertexAttribP3uiv)
+GL_CALL(VertexAttribP4ui)
+GL_CALL(VertexAttribP4uiv)
+GL_CALL(VertexP2ui)
+GL_CALL(VertexP2uiv)
+GL_CALL(VertexP3ui)
+GL_CALL(VertexP3uiv)
+GL_CALL(VertexP4ui)
+GL_CALL(VertexP4uiv)
+GL_CALL(TexCoordP1ui)
+GL_CALL(TexCoordP1uiv)
+GL_CALL(TexCoordP2ui)
+GL_CALL(TexCoordP2uiv)
+GL_CALL(TexCoordP3ui)
+GL_CALL(TexCoordP3uiv)
+GL_CALL(TexCoordP4ui)
+GL_CALL(TexCoordP4uiv)
+GL_CALL(MultiTexCoordP1ui)
+GL_CALL(MultiTexCoordP1uiv)
+GL_CALL(MultiTexCoordP2ui)
+GL_CALL(MultiTexCoordP2uiv)
+GL_CALL(MultiTexCoordP3ui)
+GL_CALL(MultiTexCoordP3uiv)
+GL_CALL(MultiTexCoordP4ui)
+GL_CALL(MultiTexCoordP4uiv)
+GL_CALL(NormalP3ui)
+GL_CALL(NormalP3uiv)
+GL_CALL(ColorP3ui)
+GL_CALL(ColorP3uiv)
+GL_CALL(ColorP4ui)
+GL_CALL(ColorP4uiv)
+GL_CALL(SecondaryColorP3ui)
+GL_CALL(SecondaryColorP3uiv)
+
+// the entry points gl_ext resolves itself, as GL_EXT_CALL(name of the pointer in gl_ext); they're GL_CALL if it isn't defined
+#ifndef GL_EXT_CALL
+#define GL_EXT_CALL(name) GL_CALL(name)
+#define GL_EXT_CALL_DEFAULTED
+#endif
+GL_EXT_CALL(GetProgramBinary)
+GL_EXT_CALL(ProgramBinary)
+GL_EXT_CALL(ProgramParameteri)
+GL_EXT_CALL(MaxShaderCompilerThreads)
+GL_EXT_CALL(GenProgramPipelines)
+GL_EXT_CALL(DeleteProgramPipelines)
+GL_EXT_CALL(BindProgramPipeline)
+GL_EXT_CALL(UseProgramStages)
+GL_EXT_CALL(ValidateProgramPipeline)
+GL_EXT_CALL(GetProgramPipelineiv)
+GL_EXT_CALL(GetProgramPipelineInfoLog)
+GL_EXT_CALL(ProgramUniform1f)
+GL_EXT_CALL(ProgramUniform1i)
+GL_EXT_CALL(ProgramUniform2fv)
+GL_EXT_CALL(ProgramUniform3fv)
+GL_EXT_CALL(ProgramUniform4fv)
+GL_EXT_CALL(ProgramUniformMatrix3fv)
+GL_EXT_CALL(ProgramUniformMatrix4fv)
+GL_EXT_CALL(BindVertexBuffer)
+GL_EXT_CALL(VertexAttribFormat)
+GL_EXT_CALL(VertexAttribBinding)
+#ifdef GL_EXT_CALL_DEFAULTED
+#undef GL_EXT_CALL
+#undef GL_EXT_CALL_DEFAULTED
+#endif
@@ -0,0 +1,269 @@
+#include "GLCallStats.h"
+#include "GLExtensions.h"
+#include "../profiling/Profiler.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+namespace gl_calls {
+
+	static const char* const kCallNames[] = {
+#define GL_CALL(name) "gl" #name,
+#include "GLCallList.h"
+#undef GL_CALL
+	};
+
+	struct CallCounters {
+		std::atomic<uint64_t> calls{ 0 };
+		std::atomic<uint64_t> ticks{ 0 };
+		std::atomic<uint64_t> uploadBytes{ 0 };
+	};
+
+	static CallCounters counters[kCallCount];
+	static std::atomic<uint64_t> drawCalls{ 0 };
+	static bool enabled = false;
+	// shared by threads in the middle of GL calls, taken by SetEnabled to swap the pointers
+	static std::shared_mutex swapMutex;
+
+	// the counters at the previous EndFrame
+	static uint64_t previousCalls[kCallCount]{ };
+	static uint64_t previousTicks[kCallCount]{ };
+	static uint64_t previousUploadBytes[kCallCount]{ };
+	static uint64_t previousDrawCalls = 0;
+	static FrameStats frameStats{ };
+
+	const char* GetCallName(Call call) {
+		return static_cast<size_t>(call) < kCallCount ? kCallNames[static_cast<size_t>(call)] : "?";
+	}
+
+	// bytes of one pixel in client memory, ignoring the unpack row alignment
+	static uint64_t PixelBytes(GLenum format, GLenum type) {
+		switch (type) {
+		case GL_UNSIGNED_BYTE_3_3_2:
+		case GL_UNSIGNED_BYTE_2_3_3_REV:
+			return 1;
+		case GL_UNSIGNED_SHORT_5_6_5:
+		case GL_UNSIGNED_SHORT_5_6_5_REV:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+		case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+			return 2;
+		case GL_UNSIGNED_INT_8_8_8_8:
+		case GL_UNSIGNED_INT_8_8_8_8_REV:
+		case GL_UNSIGNED_INT_10_10_10_2:
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_24_8:
+		case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_5_9_9_9_REV:
+			return 4;
+		case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+			return 8;
+		}
+
+		uint64_t componentBytes = 1;
+		switch (type) {
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			componentBytes = 2;
+			break;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			componentBytes = 4;
+			break;
+		}
+		switch (format) {
+		case GL_RG:
+		case GL_RG_INTEGER:
+			return 2 * componentBytes;
+		case GL_RGB:
+		case GL_BGR:
+		case GL_RGB_INTEGER:
+		case GL_BGR_INTEGER:
+			return 3 * componentBytes;
+		case GL_RGBA:
+		case GL_BGRA:
+		case GL_RGBA_INTEGER:
+		case GL_BGRA_INTEGER:
+			return 4 * componentBytes;
+		default:
+			return componentBytes;
+		}
+	}
+
+	struct Work {
+		uint32_t draws;
+		uint64_t uploadBytes;
+	};
+
+	// what a call draws or uploads, worked out from its arguments
+	template <Call Id, typename... Args>
+	static Work CallWork(const Args&... args) {
+		auto arguments = std::forward_as_tuple(args...);
+		auto uploaded = [](const void* data, uint64_t bytes) {
+			return Work{ 0, data != nullptr ? bytes : 0 };
+		};
+		if constexpr (Id == Call::DrawArrays || Id == Call::DrawElements || Id == Call::DrawRangeElements
+			|| Id == Call::DrawArraysInstanced || Id == Call::DrawElementsInstanced || Id == Call::DrawElementsBaseVertex
+			|| Id == Call::DrawRangeElementsBaseVertex || Id == Call::DrawElementsInstancedBaseVertex) {
+			return Work{ 1, 0 };
+		}
+		else if constexpr (Id == Call::MultiDrawArrays) {
+			return Work{ static_cast<uint32_t>(std::get<3>(arguments)), 0 };
+		}
+		else if constexpr (Id == Call::MultiDrawElements || Id == Call::MultiDrawElementsBaseVertex) {
+			return Work{ static_cast<uint32_t>(std::get<4>(arguments)), 0 };
+		}
+		else if constexpr (Id == Call::BufferData) {
+			return uploaded(std::get<2>(arguments), static_cast<uint64_t>(std::get<1>(arguments)));
+		}
+		else if constexpr (Id == Call::BufferSubData) {
+			return uploaded(std::get<3>(arguments), static_cast<uint64_t>(std::get<2>(arguments)));
+		}
+		else if constexpr (Id == Call::TexImage1D) {
+			return uploaded(std::get<7>(arguments), std::get<3>(arguments) * PixelBytes(std::get<5>(arguments), std::get<6>(arguments)));
+		}
+		else if constexpr (Id == Call::TexImage2D) {
+			return uploaded(std::get<8>(arguments), static_cast<uint64_t>(std::get<3>(arguments)) * std::get<4>(arguments) * PixelBytes(std::get<6>(arguments), std::get<7>(arguments)));
+		}
+		else if constexpr (Id == Call::TexImage3D) {
+			return uploaded(std::get<9>(arguments), static_cast<uint64_t>(std::get<3>(arguments)) * std::get<4>(arguments) * std::get<5>(arguments) * PixelBytes(std::get<7>(arguments), std::get<8>(arguments)));
+		}
+		else if constexpr (Id == Call::TexSubImage1D) {
+			return uploaded(std::get<6>(arguments), std::get<3>(arguments) * PixelBytes(std::get<4>(arguments), std::get<5>(arguments)));
+		}
+		else if constexpr (Id == Call::TexSubImage2D) {
+			return uploaded(std::get<8>(arguments), static_cast<uint64_t>(std::get<4>(arguments)) * std::get<5>(arguments) * PixelBytes(std::get<6>(arguments), std::get<7>(arguments)));
+		}
+		else if constexpr (Id == Call::TexSubImage3D) {
+			return uploaded(std::get<10>(arguments), static_cast<uint64_t>(std::get<5>(arguments)) * std::get<6>(arguments) * std::get<7>(arguments) * PixelBytes(std::get<8>(arguments), std::get<9>(arguments)));
+		}
+		else if constexpr (Id == Call::CompressedTexImage1D || Id == Call::CompressedTexSubImage1D) {
+			return uploaded(std::get<6>(arguments), static_cast<uint64_t>(std::get<5>(arguments)));
+		}
+		else if constexpr (Id == Call::CompressedTexImage2D) {
+			return uploaded(std::get<7>(arguments), static_cast<uint64_t>(std::get<6>(arguments)));
+		}
+		else if constexpr (Id == Call::CompressedTexImage3D || Id == Call::CompressedTexSubImage2D) {
+			return uploaded(std::get<8>(arguments), static_cast<uint64_t>(std::get<7>(arguments)));
+		}
+		else if constexpr (Id == Call::CompressedTexSubImage3D) {
+			return uploaded(std::get<10>(arguments), static_cast<uint64_t>(std::get<9>(arguments)));
+		}
+		else {
+			(void)arguments;
+			return Work{ 0, 0 };
+		}
+	}
+
+	static void Record(Call call, uint64_t ticks, Work work) {
+		CallCounters& callCounters = counters[static_cast<size_t>(call)];
+		callCounters.calls.fetch_add(1, std::memory_order_relaxed);
+		callCounters.ticks.fetch_add(ticks, std::memory_order_relaxed);
+		if (work.uploadBytes > 0) {
+			callCounters.uploadBytes.fetch_add(work.uploadBytes, std::memory_order_relaxed);
+		}
+		if (work.draws > 0) {
+			drawCalls.fetch_add(work.draws, std::memory_order_relaxed);
+		}
+	}
+
+	// stands in for one entry point while instrumentation is on
+	template <Call Id, typename Proc>
+	struct Hook;
+
+	template <Call Id, typename R, typename... Args>
+	struct Hook<Id, R(APIENTRYP)(Args...)> {
+		using Proc = R(APIENTRYP)(Args...);
+		static inline Proc original = nullptr;
+
+		static R APIENTRY Forward(Args... args) {
+			uint64_t begin = profiling::Now();
+			if constexpr (std::is_void_v<R>) {
+				original(args...);
+				Record(Id, profiling::Now() - begin, CallWork<Id>(args...));
+			}
+			else {
+				R result = original(args...);
+				Record(Id, profiling::Now() - begin, CallWork<Id>(args...));
+				return result;
+			}
+		}
+
+		static void Swap(Proc& pointer, bool enable) {
+			if (enable && pointer != nullptr && pointer != &Forward) {
+				original = pointer;
+				pointer = &Forward;
+			}
+			else if (!enable && pointer == &Forward) {
+				pointer = original;
+			}
+		}
+	};
+
+	void SetEnabled(bool enable) {
+		if (enable == enabled) {
+			return;
+		}
+		// rather than stall the frame on a shader compile, try again next frame
+		std::unique_lock<std::shared_mutex> lock(swapMutex, std::try_to_lock);
+		if (!lock.owns_lock()) {
+			return;
+		}
+		enabled = enable;
+#define GL_CALL(name) Hook<Call::name, decltype(glad_gl##name)>::Swap(glad_gl##name, enable);
+#define GL_EXT_CALL(name) Hook<Call::name, decltype(gl_ext::name)>::Swap(gl_ext::name, enable);
+#include "GLCallList.h"
+#undef GL_EXT_CALL
+#undef GL_CALL
+	}
+
+	bool IsEnabled() {
+		return enabled;
+	}
+
+	std::shared_lock<std::shared_mutex> LockCalls() {
+		return std::shared_lock<std::shared_mutex>(swapMutex);
+	}
+
+	const FrameStats& EndFrame() {
+		frameStats.calls.reserve(kCallCount);
+		frameStats.calls.clear();
+		frameStats.totalCalls = 0;
+		frameStats.uploadBytes = 0;
+		frameStats.ms = 0.0;
+		for (size_t i = 0; i < kCallCount; i++) {
+			uint64_t calls = counters[i].calls.load(std::memory_order_relaxed);
+			if (calls == previousCalls[i]) {
+				continue;
+			}
+			uint64_t ticks = counters[i].ticks.load(std::memory_order_relaxed);
+			uint64_t uploadBytes = counters[i].uploadBytes.load(std::memory_order_relaxed);
+			CallStats stats{ static_cast<Call>(i), static_cast<uint32_t>(calls - previousCalls[i]),
+				profiling::TicksToMs(ticks - previousTicks[i]), uploadBytes - previousUploadBytes[i] };
+			frameStats.calls.push_back(stats);
+			frameStats.totalCalls += stats.calls;
+			frameStats.uploadBytes += stats.uploadBytes;
+			frameStats.ms += stats.ms;
+			previousCalls[i] = calls;
+			previousTicks[i] = ticks;
+			previousUploadBytes[i] = uploadBytes;
+		}
+		std::sort(frameStats.calls.begin(), frameStats.calls.end(), [](const CallStats& a, const CallStats& b) {
+			return a.ms > b.ms;
+		});
+		uint64_t draws = drawCalls.load(std::memory_order_relaxed);
+		frameStats.drawCalls = static_cast<uint32_t>(draws - previousDrawCalls);
+		previousDrawCalls = draws;
+		return frameStats;
+	}
+
+	const FrameStats& GetFrameStats() {
+		return frameStats;
+	}
+}
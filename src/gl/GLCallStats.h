@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+/*
+ * Counts and times GL calls by swapping glad's function pointers, and
+ * gl_ext's, for wrappers that record the call and then forward to the
+ * driver. Every entry point in GLCallList.h is covered.
+ *
+ * Turned off, the original pointers are back in place, so the cost is
+ * nothing at all. Turn it on and off between frames, after glad and
+ * gl_ext have loaded. Calls from every thread are counted, the shader
+ * compile context's included; any thread but the one calling SetEnabled
+ * has to hold LockCalls while it calls GL, so the pointers don't change
+ * under it.
+ */
+namespace gl_calls {
+
+	enum class Call : uint16_t {
+#define GL_CALL(name) name,
+#include "GLCallList.h"
+#undef GL_CALL
+		Count
+	};
+	const size_t kCallCount = static_cast<size_t>(Call::Count);
+
+	// "glClear" for Call::Clear
+	const char* GetCallName(Call call);
+
+	struct CallStats {
+		Call call;
+		uint32_t calls;
+		double ms;
+		// handed to buffer and texture uploads, 0 when they only allocate
+		uint64_t uploadBytes;
+	};
+
+	struct FrameStats {
+		// the entry points called during the frame, the slowest in total first
+		std::vector<CallStats> calls{ };
+		uint32_t totalCalls = 0;
+		// instanced and multi draws count as one per draw command
+		uint32_t drawCalls = 0;
+		uint64_t uploadBytes = 0;
+		double ms = 0.0;
+	};
+
+	// swaps the pointers unless another thread holds LockCalls, then it's left for a later call
+	void SetEnabled(bool enabled);
+	// whether the wrappers are in place, which lags behind SetEnabled while another thread is in GL
+	bool IsEnabled();
+	// for as long as it's held, SetEnabled won't touch the pointers
+	std::shared_lock<std::shared_mutex> LockCalls();
+	// what was called since the previous call; call once per frame from one thread
+	const FrameStats& EndFrame();
+	// of the last EndFrame
+	const FrameStats& GetFrameStats();
+}
@@ -0,0 +1,146 @@
+#include "GLExtensions.h"
+#include <string>
+#include <unordered_set>
+
+namespace gl_ext {
+
+	static GLADloadproc procLoader = nullptr;
+	static std::unordered_set<std::string> extensions{ };
+	static int versionMajor = 0;
+	static int versionMinor = 0;
+	static int programBinaryFormats = 0;
+
+	GetProgramBinaryProc GetProgramBinary = nullptr;
+	ProgramBinaryProc ProgramBinary = nullptr;
+	ProgramParameteriProc ProgramParameteri = nullptr;
+	MaxShaderCompilerThreadsProc MaxShaderCompilerThreads = nullptr;
+	GenProgramPipelinesProc GenProgramPipelines = nullptr;
+	DeleteProgramPipelinesProc DeleteProgramPipelines = nullptr;
+	BindProgramPipelineProc BindProgramPipeline = nullptr;
+	UseProgramStagesProc UseProgramStages = nullptr;
+	ValidateProgramPipelineProc ValidateProgramPipeline = nullptr;
+	GetProgramPipelineivProc GetProgramPipelineiv = nullptr;
+	GetProgramPipelineInfoLogProc GetProgramPipelineInfoLog = nullptr;
+	ProgramUniform1fProc ProgramUniform1f = nullptr;
+	ProgramUniform1iProc ProgramUniform1i = nullptr;
+	ProgramUniformfvProc ProgramUniform2fv = nullptr;
+	ProgramUniformfvProc ProgramUniform3fv = nullptr;
+	ProgramUniformfvProc ProgramUniform4fv = nullptr;
+	ProgramUniformMatrixfvProc ProgramUniformMatrix3fv = nullptr;
+	ProgramUniformMatrixfvProc ProgramUniformMatrix4fv = nullptr;
+	BindVertexBufferProc BindVertexBuffer = nullptr;
+	VertexAttribFormatProc VertexAttribFormat = nullptr;
+	VertexAttribBindingProc VertexAttribBinding = nullptr;
+	static bool separateShaderObjects = false;
+
+	void Init(GLADloadproc loader) {
+		procLoader = loader;
+		extensions.clear();
+		glGetIntegerv(GL_MAJOR_VERSION, &versionMajor);
+		glGetIntegerv(GL_MINOR_VERSION, &versionMinor);
+
+		// core profile removed GL_EXTENSIONS as one big string, so go through them one at a time
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; i++) {
+			const GLubyte* name = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+			if (name != nullptr) {
+				extensions.emplace(reinterpret_cast<const char*>(name));
+			}
+		}
+
+		GetProgramBinary = nullptr;
+		ProgramBinary = nullptr;
+		ProgramParameteri = nullptr;
+		programBinaryFormats = 0;
+		if (HasVersion(4, 1) || HasExtension("GL_ARB_get_program_binary")) {
+			GetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(GetProcAddress("glGetProgramBinary"));
+			ProgramBinary = reinterpret_cast<ProgramBinaryProc>(GetProcAddress("glProgramBinary"));
+			ProgramParameteri = reinterpret_cast<ProgramParameteriProc>(GetProcAddress("glProgramParameteri"));
+			// some drivers expose the entry points but no formats, which means binaries can't be saved
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &programBinaryFormats);
+		}
+
+		MaxShaderCompilerThreads = nullptr;
+		if (HasExtension("GL_KHR_parallel_shader_compile")) {
+			MaxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(GetProcAddress("glMaxShaderCompilerThreadsKHR"));
+		}
+		else if (HasExtension("GL_ARB_parallel_shader_compile")) {
+			MaxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(GetProcAddress("glMaxShaderCompilerThreadsARB"));
+		}
+
+		separateShaderObjects = false;
+		if (HasVersion(4, 1) || HasExtension("GL_ARB_separate_shader_objects")) {
+			// the extension doesn't need ARB_get_program_binary, but GL_PROGRAM_SEPARABLE is set through glProgramParameteri all the same
+			ProgramParameteri = reinterpret_cast<ProgramParameteriProc>(GetProcAddress("glProgramParameteri"));
+			GenProgramPipelines = reinterpret_cast<GenProgramPipelinesProc>(GetProcAddress("glGenProgramPipelines"));
+			DeleteProgramPipelines = reinterpret_cast<DeleteProgramPipelinesProc>(GetProcAddress("glDeleteProgramPipelines"));
+			BindProgramPipeline = reinterpret_cast<BindProgramPipelineProc>(GetProcAddress("glBindProgramPipeline"));
+			UseProgramStages = reinterpret_cast<UseProgramStagesProc>(GetProcAddress("glUseProgramStages"));
+			ValidateProgramPipeline = reinterpret_cast<ValidateProgramPipelineProc>(GetProcAddress("glValidateProgramPipeline"));
+			GetProgramPipelineiv = reinterpret_cast<GetProgramPipelineivProc>(GetProcAddress("glGetProgramPipelineiv"));
+			GetProgramPipelineInfoLog = reinterpret_cast<GetProgramPipelineInfoLogProc>(GetProcAddress("glGetProgramPipelineInfoLog"));
+			ProgramUniform1f = reinterpret_cast<ProgramUniform1fProc>(GetProcAddress("glProgramUniform1f"));
+			ProgramUniform1i = reinterpret_cast<ProgramUniform1iProc>(GetProcAddress("glProgramUniform1i"));
+			ProgramUniform2fv = reinterpret_cast<ProgramUniformfvProc>(GetProcAddress("glProgramUniform2fv"));
+			ProgramUniform3fv = reinterpret_cast<ProgramUniformfvProc>(GetProcAddress("glProgramUniform3fv"));
+			ProgramUniform4fv = reinterpret_cast<ProgramUniformfvProc>(GetProcAddress("glProgramUniform4fv"));
+			ProgramUniformMatrix3fv = reinterpret_cast<ProgramUniformMatrixfvProc>(GetProcAddress("glProgramUniformMatrix3fv"));
+			ProgramUniformMatrix4fv = reinterpret_cast<ProgramUniformMatrixfvProc>(GetProcAddress("glProgramUniformMatrix4fv"));
+			separateShaderObjects = ProgramParameteri != nullptr && GenProgramPipelines != nullptr && DeleteProgramPipelines != nullptr
+				&& BindProgramPipeline != nullptr && UseProgramStages != nullptr && ValidateProgramPipeline != nullptr
+				&& GetProgramPipelineiv != nullptr && GetProgramPipelineInfoLog != nullptr
+				&& ProgramUniform1f != nullptr && ProgramUniform1i != nullptr && ProgramUniform2fv != nullptr
+				&& ProgramUniform3fv != nullptr && ProgramUniform4fv != nullptr
+				&& ProgramUniformMatrix3fv != nullptr && ProgramUniformMatrix4fv != nullptr;
+		}
+
+		BindVertexBuffer = nullptr;
+		VertexAttribFormat = nullptr;
+		VertexAttribBinding = nullptr;
+		if (HasVersion(4, 3) || HasExtension("GL_ARB_vertex_attrib_binding")) {
+			BindVertexBuffer = reinterpret_cast<BindVertexBufferProc>(GetProcAddress("glBindVertexBuffer"));
+			VertexAttribFormat = reinterpret_cast<VertexAttribFormatProc>(GetProcAddress("glVertexAttribFormat"));
+			VertexAttribBinding = reinterpret_cast<VertexAttribBindingProc>(GetProcAddress("glVertexAttribBinding"));
+		}
+	}
+
+	bool HasExtension(const char* name) {
+		return extensions.find(name) != extensions.end();
+	}
+
+	bool HasVersion(int major, int minor) {
+		return versionMajor > major || (versionMajor == major && versionMinor >= minor);
+	}
+
+	void* GetProcAddress(const char* name) {
+		if (procLoader == nullptr) {
+			return nullptr;
+		}
+		return procLoader(name);
+	}
+
+	bool SupportsS3TC() {
+		return HasExtension("GL_EXT_texture_compression_s3tc");
+	}
+
+	bool SupportsBPTC() {
+		return HasVersion(4, 2) || HasExtension("GL_ARB_texture_compression_bptc");
+	}
+
+	bool SupportsProgramBinary() {
+		return GetProgramBinary != nullptr && ProgramBinary != nullptr && ProgramParameteri != nullptr && programBinaryFormats > 0;
+	}
+
+	bool SupportsParallelShaderCompile() {
+		return MaxShaderCompilerThreads != nullptr;
+	}
+
+	bool SupportsSeparateShaderObjects() {
+		return separateShaderObjects;
+	}
+
+	bool SupportsVertexAttribBinding() {
+		return BindVertexBuffer != nullptr && VertexAttribFormat != nullptr && VertexAttribBinding != nullptr;
+	}
+}
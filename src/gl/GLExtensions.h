@@ -0,0 +1,104 @@
+#pragma once
+#include <glad/glad.h>
+
+// our glad build only covers core 3.3 with no extensions, so the handful of
+// extension enums we rely on are declared here instead of regenerating the loader
+
+// EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// ARB_texture_compression_bptc (core in 4.2)
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM_ARB
+#define GL_COMPRESSED_RGBA_BPTC_UNORM_ARB 0x8E8C
+#endif
+
+// ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+// KHR_parallel_shader_compile, the ARB version uses the same values
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// ARB_separate_shader_objects (core in 4.1)
+#ifndef GL_PROGRAM_SEPARABLE
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#define GL_PROGRAM_SEPARABLE 0x8258
+#define GL_ACTIVE_PROGRAM 0x8259
+#define GL_PROGRAM_PIPELINE_BINDING 0x825A
+#endif
+
+namespace gl_ext {
+	typedef void (APIENTRY* GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRY* ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRY* ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+	typedef void (APIENTRY* MaxShaderCompilerThreadsProc)(GLuint count);
+	typedef void (APIENTRY* GenProgramPipelinesProc)(GLsizei n, GLuint* pipelines);
+	typedef void (APIENTRY* DeleteProgramPipelinesProc)(GLsizei n, const GLuint* pipelines);
+	typedef void (APIENTRY* BindProgramPipelineProc)(GLuint pipeline);
+	typedef void (APIENTRY* UseProgramStagesProc)(GLuint pipeline, GLbitfield stages, GLuint program);
+	typedef void (APIENTRY* ValidateProgramPipelineProc)(GLuint pipeline);
+	typedef void (APIENTRY* GetProgramPipelineivProc)(GLuint pipeline, GLenum pname, GLint* params);
+	typedef void (APIENTRY* GetProgramPipelineInfoLogProc)(GLuint pipeline, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+	typedef void (APIENTRY* ProgramUniform1fProc)(GLuint program, GLint location, GLfloat v0);
+	typedef void (APIENTRY* ProgramUniform1iProc)(GLuint program, GLint location, GLint v0);
+	typedef void (APIENTRY* ProgramUniformfvProc)(GLuint program, GLint location, GLsizei count, const GLfloat* value);
+	typedef void (APIENTRY* ProgramUniformMatrixfvProc)(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+	typedef void (APIENTRY* BindVertexBufferProc)(GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+	typedef void (APIENTRY* VertexAttribFormatProc)(GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+	typedef void (APIENTRY* VertexAttribBindingProc)(GLuint attribindex, GLuint bindingindex);
+
+	// resolved by Init, null when the context doesn't have them
+	extern GetProgramBinaryProc GetProgramBinary;
+	extern ProgramBinaryProc ProgramBinary;
+	extern ProgramParameteriProc ProgramParameteri;
+	extern MaxShaderCompilerThreadsProc MaxShaderCompilerThreads;
+	extern GenProgramPipelinesProc GenProgramPipelines;
+	extern DeleteProgramPipelinesProc DeleteProgramPipelines;
+	extern BindProgramPipelineProc BindProgramPipeline;
+	extern UseProgramStagesProc UseProgramStages;
+	extern ValidateProgramPipelineProc ValidateProgramPipeline;
+	extern GetProgramPipelineivProc GetProgramPipelineiv;
+	extern GetProgramPipelineInfoLogProc GetProgramPipelineInfoLog;
+	extern ProgramUniform1fProc ProgramUniform1f;
+	extern ProgramUniform1iProc ProgramUniform1i;
+	extern ProgramUniformfvProc ProgramUniform2fv;
+	extern ProgramUniformfvProc ProgramUniform3fv;
+	extern ProgramUniformfvProc ProgramUniform4fv;
+	extern ProgramUniformMatrixfvProc ProgramUniformMatrix3fv;
+	extern ProgramUniformMatrixfvProc ProgramUniformMatrix4fv;
+	extern BindVertexBufferProc BindVertexBuffer;
+	extern VertexAttribFormatProc VertexAttribFormat;
+	extern VertexAttribBindingProc VertexAttribBinding;
+
+	// queries the extension list of the current context, call once after gladLoadGLLoader
+	void Init(GLADloadproc loader);
+	bool HasExtension(const char* name);
+	// true if the context is at least major.minor
+	bool HasVersion(int major, int minor);
+	// resolves an entry point that glad doesn't know about, nullptr if unavailable
+	void* GetProcAddress(const char* name);
+
+	bool SupportsS3TC();
+	bool SupportsBPTC();
+	// entry points are there and the driver offers at least one binary format
+	bool SupportsProgramBinary();
+	// compiles and links run on driver threads and GL_COMPLETION_STATUS_KHR can be polled
+	bool SupportsParallelShaderCompile();
+	// stages link into separable programs that program pipelines combine at draw time, uniforms set with glProgramUniform
+	bool SupportsSeparateShaderObjects();
+	// vertex formats live in the VAO apart from the buffer, which is swapped with one glBindVertexBuffer
+	bool SupportsVertexAttribBinding();
+}
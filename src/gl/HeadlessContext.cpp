@@ -0,0 +1,313 @@
+// windows.h goes before glad, which would define APIENTRY differently otherwise
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+#include "HeadlessContext.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// the handful of EGL and OSMesa declarations we need, so neither SDK has to be installed to build
+
+typedef void* EGLDisplay;
+typedef void* EGLConfig;
+typedef void* EGLContext;
+typedef void* EGLSurface;
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+
+#define EGL_NONE 0x3038
+#define EGL_EXTENSIONS 0x3055
+#define EGL_RENDERABLE_TYPE 0x3040
+#define EGL_OPENGL_BIT 0x0008
+#define EGL_OPENGL_API 0x30A2
+#define EGL_CONTEXT_MAJOR_VERSION 0x3098
+#define EGL_CONTEXT_MINOR_VERSION 0x30FB
+#define EGL_CONTEXT_OPENGL_PROFILE_MASK 0x30FD
+#define EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT 0x00000001
+// EGL_MESA_platform_surfaceless
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+
+typedef struct osmesa_context* OSMesaContext;
+
+#define OSMESA_FORMAT 0x22
+#define OSMESA_DEPTH_BITS 0x30
+#define OSMESA_STENCIL_BITS 0x31
+#define OSMESA_PROFILE 0x33
+#define OSMESA_CORE_PROFILE 0x34
+#define OSMESA_CONTEXT_MAJOR_VERSION 0x36
+#define OSMESA_CONTEXT_MINOR_VERSION 0x37
+
+namespace gl_headless {
+
+	typedef void* (APIENTRY* EGLGetProcAddressProc)(const char* name);
+	typedef const char* (APIENTRY* EGLQueryStringProc)(EGLDisplay display, EGLint name);
+	typedef EGLDisplay (APIENTRY* EGLGetPlatformDisplayProc)(EGLenum platform, void* nativeDisplay, const EGLint* attributes);
+	typedef EGLDisplay (APIENTRY* EGLGetDisplayProc)(void* nativeDisplay);
+	typedef EGLBoolean (APIENTRY* EGLInitializeProc)(EGLDisplay display, EGLint* major, EGLint* minor);
+	typedef EGLBoolean (APIENTRY* EGLChooseConfigProc)(EGLDisplay display, const EGLint* attributes, EGLConfig* configs, EGLint size, EGLint* count);
+	typedef EGLBoolean (APIENTRY* EGLBindAPIProc)(EGLenum api);
+	typedef EGLContext (APIENTRY* EGLCreateContextProc)(EGLDisplay display, EGLConfig config, EGLContext share, const EGLint* attributes);
+	typedef EGLBoolean (APIENTRY* EGLMakeCurrentProc)(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context);
+	typedef EGLBoolean (APIENTRY* EGLDestroyContextProc)(EGLDisplay display, EGLContext context);
+	typedef EGLBoolean (APIENTRY* EGLTerminateProc)(EGLDisplay display);
+	typedef EGLint (APIENTRY* EGLGetErrorProc)();
+
+	typedef OSMesaContext (APIENTRY* OSMesaCreateContextAttribsProc)(const int* attributes, OSMesaContext share);
+	typedef GLboolean (APIENTRY* OSMesaMakeCurrentProc)(OSMesaContext context, void* buffer, GLenum type, GLsizei width, GLsizei height);
+	typedef void* (APIENTRY* OSMesaGetProcAddressProc)(const char* name);
+	typedef void (APIENTRY* OSMesaDestroyContextProc)(OSMesaContext context);
+
+	static void* library = nullptr;
+	static Backend backend = Backend::EGL;
+
+	static EGLGetProcAddressProc eglGetProcAddress = nullptr;
+	static EGLMakeCurrentProc eglMakeCurrent = nullptr;
+	static EGLDestroyContextProc eglDestroyContext = nullptr;
+	static EGLTerminateProc eglTerminate = nullptr;
+	static EGLDisplay eglDisplay = nullptr;
+	static EGLContext eglContext = nullptr;
+
+	static OSMesaGetProcAddressProc osMesaGetProcAddress = nullptr;
+	static OSMesaDestroyContextProc osMesaDestroyContext = nullptr;
+	static OSMesaContext osMesaContext = nullptr;
+	// what OSMesa renders the default framebuffer into
+	static std::vector<unsigned char> osMesaBuffer{ };
+
+	// the first of names that loads, nullptr if none do
+	static void* OpenLibrary(const std::vector<const char*>& names, std::string& tried) {
+		for (const char* name : names) {
+			tried += tried.empty() ? name : std::string(", ") + name;
+#ifdef _WIN32
+			void* handle = reinterpret_cast<void*>(LoadLibraryA(name));
+#else
+			void* handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+#endif
+			if (handle != nullptr) {
+				return handle;
+			}
+		}
+		return nullptr;
+	}
+
+	static void* FindSymbol(const char* name) {
+#ifdef _WIN32
+		return reinterpret_cast<void*>(::GetProcAddress(static_cast<HMODULE>(library), name));
+#else
+		return dlsym(library, name);
+#endif
+	}
+
+	static void CloseLibrary() {
+		if (library == nullptr) {
+			return;
+		}
+#ifdef _WIN32
+		FreeLibrary(static_cast<HMODULE>(library));
+#else
+		dlclose(library);
+#endif
+		library = nullptr;
+	}
+
+	// whether the space separated list has name in it as a whole word
+	static bool HasExtension(const char* extensions, const char* name) {
+		size_t length = std::strlen(name);
+		for (const char* at = extensions; at != nullptr && (at = std::strstr(at, name)) != nullptr; at += length) {
+			bool starts = at == extensions || at[-1] == ' ';
+			bool ends = at[length] == ' ' || at[length] == '\0';
+			if (starts && ends) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// EGL errors are listed in hex in the headers, e.g. 0x3003 for EGL_BAD_ALLOC
+	static std::string ToHex(EGLint value) {
+		char text[16];
+		std::snprintf(text, sizeof(text), "0x%04X", static_cast<unsigned int>(value));
+		return text;
+	}
+
+	static bool CreateEGLContext(std::string& error) {
+		std::string tried;
+#if defined(_WIN32)
+		library = OpenLibrary({ "libEGL.dll" }, tried);
+#elif defined(__APPLE__)
+		library = OpenLibrary({ "libEGL.dylib" }, tried);
+#else
+		library = OpenLibrary({ "libEGL.so.1", "libEGL.so" }, tried);
+#endif
+		if (library == nullptr) {
+			error = "EGL is unavailable, couldn't load " + tried;
+			return false;
+		}
+		eglGetProcAddress = reinterpret_cast<EGLGetProcAddressProc>(FindSymbol("eglGetProcAddress"));
+		auto eglQueryString = reinterpret_cast<EGLQueryStringProc>(FindSymbol("eglQueryString"));
+		auto eglGetDisplay = reinterpret_cast<EGLGetDisplayProc>(FindSymbol("eglGetDisplay"));
+		auto eglInitialize = reinterpret_cast<EGLInitializeProc>(FindSymbol("eglInitialize"));
+		auto eglChooseConfig = reinterpret_cast<EGLChooseConfigProc>(FindSymbol("eglChooseConfig"));
+		auto eglBindAPI = reinterpret_cast<EGLBindAPIProc>(FindSymbol("eglBindAPI"));
+		auto eglCreateContext = reinterpret_cast<EGLCreateContextProc>(FindSymbol("eglCreateContext"));
+		auto eglGetError = reinterpret_cast<EGLGetErrorProc>(FindSymbol("eglGetError"));
+		eglMakeCurrent = reinterpret_cast<EGLMakeCurrentProc>(FindSymbol("eglMakeCurrent"));
+		eglDestroyContext = reinterpret_cast<EGLDestroyContextProc>(FindSymbol("eglDestroyContext"));
+		eglTerminate = reinterpret_cast<EGLTerminateProc>(FindSymbol("eglTerminate"));
+		if (eglGetProcAddress == nullptr || eglQueryString == nullptr || eglGetDisplay == nullptr || eglInitialize == nullptr || eglChooseConfig == nullptr
+			|| eglBindAPI == nullptr || eglCreateContext == nullptr || eglGetError == nullptr || eglMakeCurrent == nullptr || eglDestroyContext == nullptr || eglTerminate == nullptr) {
+			error = "EGL is unavailable, " + tried + " lacks EGL 1.4 entry points";
+			return false;
+		}
+
+		// client extensions, queried without a display; drivers before EGL 1.5 return null
+		const char* clientExtensions = eglQueryString(nullptr, EGL_EXTENSIONS);
+		auto eglGetPlatformDisplay = reinterpret_cast<EGLGetPlatformDisplayProc>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (eglGetPlatformDisplay != nullptr && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+			eglDisplay = eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+		}
+		if (eglDisplay == nullptr) {
+			// other drivers may still make a context current without a surface on their default display
+			eglDisplay = eglGetDisplay(nullptr);
+		}
+		EGLint major = 0;
+		EGLint minor = 0;
+		if (eglDisplay == nullptr || !eglInitialize(eglDisplay, &major, &minor)) {
+			error = "EGL couldn't open a display (error " + ToHex(eglGetError()) + ")";
+			return false;
+		}
+		const char* displayExtensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+		if (!HasExtension(displayExtensions, "EGL_KHR_surfaceless_context")) {
+			error = "EGL " + std::to_string(major) + "." + std::to_string(minor) + " has no EGL_KHR_surfaceless_context";
+			return false;
+		}
+
+		// a context without a config is enough when nothing is drawn to a surface
+		EGLConfig config = nullptr;
+		if (!HasExtension(displayExtensions, "EGL_KHR_no_config_context")) {
+			const EGLint configAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+			EGLint configs = 0;
+			if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configs) || configs == 0) {
+				error = "EGL has no config for desktop OpenGL";
+				return false;
+			}
+		}
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			error = "EGL can't create desktop OpenGL contexts";
+			return false;
+		}
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		eglContext = eglCreateContext(eglDisplay, config, nullptr, contextAttributes);
+		if (eglContext == nullptr) {
+			error = "EGL couldn't create a GL 3.3 core context (error " + ToHex(eglGetError()) + ")";
+			return false;
+		}
+		if (!eglMakeCurrent(eglDisplay, nullptr, nullptr, eglContext)) {
+			error = "EGL couldn't make the context current without a surface (error " + ToHex(eglGetError()) + ")";
+			return false;
+		}
+		return true;
+	}
+
+	static bool CreateOSMesaContext(int width, int height, std::string& error) {
+		std::string tried;
+#if defined(_WIN32)
+		library = OpenLibrary({ "osmesa.dll" }, tried);
+#elif defined(__APPLE__)
+		library = OpenLibrary({ "libOSMesa.8.dylib", "libOSMesa.dylib" }, tried);
+#else
+		library = OpenLibrary({ "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" }, tried);
+#endif
+		if (library == nullptr) {
+			error = "OSMesa is unavailable, couldn't load " + tried;
+			return false;
+		}
+		auto osMesaCreateContextAttribs = reinterpret_cast<OSMesaCreateContextAttribsProc>(FindSymbol("OSMesaCreateContextAttribs"));
+		auto osMesaMakeCurrent = reinterpret_cast<OSMesaMakeCurrentProc>(FindSymbol("OSMesaMakeCurrent"));
+		osMesaGetProcAddress = reinterpret_cast<OSMesaGetProcAddressProc>(FindSymbol("OSMesaGetProcAddress"));
+		osMesaDestroyContext = reinterpret_cast<OSMesaDestroyContextProc>(FindSymbol("OSMesaDestroyContext"));
+		if (osMesaCreateContextAttribs == nullptr || osMesaMakeCurrent == nullptr || osMesaGetProcAddress == nullptr || osMesaDestroyContext == nullptr) {
+			// OSMesaCreateContextAttribs came with Mesa 11.2, older ones only make legacy contexts
+			error = "OSMesa is unavailable, " + tried + " lacks OSMesaCreateContextAttribs";
+			return false;
+		}
+
+		const int attributes[] = {
+			OSMESA_FORMAT, GL_RGBA,
+			OSMESA_DEPTH_BITS, 24,
+			OSMESA_STENCIL_BITS, 8,
+			OSMESA_PROFILE, OSMESA_CORE_PROFILE,
+			OSMESA_CONTEXT_MAJOR_VERSION, 3,
+			OSMESA_CONTEXT_MINOR_VERSION, 3,
+			0
+		};
+		osMesaContext = osMesaCreateContextAttribs(attributes, nullptr);
+		if (osMesaContext == nullptr) {
+			error = "OSMesa couldn't create a GL 3.3 core context";
+			return false;
+		}
+		osMesaBuffer.assign(static_cast<size_t>(width) * height * 4, 0);
+		if (!osMesaMakeCurrent(osMesaContext, osMesaBuffer.data(), GL_UNSIGNED_BYTE, width, height)) {
+			error = "OSMesa couldn't make the context current";
+			return false;
+		}
+		return true;
+	}
+
+	static void* LoadProc(const char* name) {
+		if (backend == Backend::EGL) {
+			return eglGetProcAddress != nullptr ? eglGetProcAddress(name) : nullptr;
+		}
+		return osMesaGetProcAddress != nullptr ? osMesaGetProcAddress(name) : nullptr;
+	}
+
+	const char* GetBackendName(Backend backend) {
+		return backend == Backend::EGL ? "EGL" : "OSMesa";
+	}
+
+	bool CreateContext(Backend requested, int width, int height, std::string& error) {
+		DestroyContext();
+		backend = requested;
+		bool created = backend == Backend::EGL ? CreateEGLContext(error) : CreateOSMesaContext(width, height, error);
+		if (!created) {
+			DestroyContext();
+		}
+		return created;
+	}
+
+	GLADloadproc GetLoader() {
+		return LoadProc;
+	}
+
+	void DestroyContext() {
+		if (eglContext != nullptr) {
+			eglMakeCurrent(eglDisplay, nullptr, nullptr, nullptr);
+			eglDestroyContext(eglDisplay, eglContext);
+			eglContext = nullptr;
+		}
+		if (eglDisplay != nullptr) {
+			eglTerminate(eglDisplay);
+			eglDisplay = nullptr;
+		}
+		if (osMesaContext != nullptr) {
+			osMesaDestroyContext(osMesaContext);
+			osMesaContext = nullptr;
+		}
+		osMesaBuffer.clear();
+		osMesaBuffer.shrink_to_fit();
+		eglGetProcAddress = nullptr;
+		osMesaGetProcAddress = nullptr;
+		CloseLibrary();
+	}
+}
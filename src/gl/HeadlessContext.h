@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <glad/glad.h>
+
+/*
+ * A GL 3.3 core context with no window, no display server and no GPU
+ * needed, for benchmark runs on build machines.
+ *
+ * EGL goes through Mesa's surfaceless platform and makes the context
+ * current with no surface at all (EGL_KHR_surfaceless_context). OSMesa
+ * renders into a buffer in client memory instead. Both libraries are
+ * loaded at runtime, so the build doesn't link against either and a
+ * machine without them gets an error naming what's missing. Frames go to
+ * a framebuffer object either way; nothing reads the default one.
+ */
+namespace gl_headless {
+
+	enum class Backend {
+		EGL,
+		OSMesa
+	};
+
+	const char* GetBackendName(Backend backend);
+
+	// makes the context current on the calling thread; false with error saying what was missing
+	bool CreateContext(Backend backend, int width, int height, std::string& error);
+	// resolves GL entry points of the current context, for gladLoadGLLoader and gl_ext::Init
+	GLADloadproc GetLoader();
+	void DestroyContext();
+}
@@ -0,0 +1,6 @@
+// The ImGui OpenGL3 backend, built on glad's function pointers rather than its own gl3w-based loader.
+// That loader opens libGL itself, which isn't there with OSMesa or on an EGL-only system, and it
+// would bypass the GL call hooks installed on glad's pointers.
+#include <glad/glad.h>
+#define IMGUI_IMPL_OPENGL_LOADER_CUSTOM
+#include <imgui/backends/imgui_impl_opengl3.cpp>
@@ -1,12 +1,62 @@
 #include "InfoOverlay.h"
+#include "../shader-loader/ShaderReloader.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/FrameTimes.h"
+#include "../gl/GLCallStats.h"
+#include "../scene/StressScene.h"
 #include <imgui/imgui.h>
+#include <algorithm>
+#include <iterator>
 #include <ostream>
 
 void GUI::Debug::showOverlay(bool* open) {
     showOverlay(open, nullptr);
 }
 
-void GUI::Debug::showOverlay(bool* open, std::vector<Printable*>* props) {
+// frames this many times slower than the median are marked as spikes
+static const float kSpikeFactor = 2.0f;
+static const int kHistogramBins = 32;
+
+static void showFrameTimes(const char* label, const std::vector<float>& values, const profiling::FrameTimeSummary& summary) {
+    ImGui::Text("%s ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f", label, summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs);
+    if (values.empty()) {
+        return;
+    }
+
+    float scaleMax = std::max(static_cast<float>(summary.maxMs) * 1.1f, 1.0f);
+    ImGui::PushID(label);
+    ImGui::PlotLines("##graph", values.data(), static_cast<int>(values.size()), 0, nullptr, 0.0f, scaleMax, ImVec2(320.0f, 60.0f));
+    ImVec2 min = ImGui::GetItemRectMin();
+    ImVec2 max = ImGui::GetItemRectMax();
+    float spikeMs = kSpikeFactor * static_cast<float>(summary.p50Ms);
+    float step = (max.x - min.x) / static_cast<float>(std::max<size_t>(values.size() - 1, 1));
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    int spikes = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+        if (values[i] > spikeMs) {
+            float x = min.x + step * static_cast<float>(i);
+            float y = max.y - (max.y - min.y) * std::min(values[i] / scaleMax, 1.0f);
+            drawList->AddLine(ImVec2(x, max.y), ImVec2(x, y), IM_COL32(220, 80, 80, 160));
+            drawList->AddCircleFilled(ImVec2(x, y), 2.5f, IM_COL32(255, 80, 80, 255));
+            spikes++;
+        }
+    }
+    ImGui::SameLine();
+    ImGui::Text("%d spike(s)\nover %.2f ms", spikes, spikeMs);
+
+    // evenly from 0 to the slowest frame
+    float bins[kHistogramBins]{ };
+    float binMs = scaleMax / kHistogramBins;
+    for (float ms : values) {
+        bins[std::min(static_cast<int>(ms / binMs), kHistogramBins - 1)] += 1.0f;
+    }
+    ImGui::PlotHistogram("##histogram", bins, kHistogramBins, 0, nullptr, 0.0f, FLT_MAX, ImVec2(320.0f, 40.0f));
+    ImGui::SameLine();
+    ImGui::Text("0 - %.1f ms", scaleMax);
+    ImGui::PopID();
+}
+
+void GUI::Debug::showOverlay(bool* open, WatchRegistry* watches, profiling::FrameTimeRecorder* frameTimes) {
     static int location = 0;
     ImGuiIO& io = ImGui::GetIO();
     ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_AlwaysAutoResize;
@@ -42,8 +92,17 @@ void GUI::Debug::showOverlay(bool* open, std::vector<Printable*>* props) {
             ImGui::Text("Mouse Position: <invalid>");
         }
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
-        for (auto p : *props) {
-            ImGui::Text("%s", p->toString().c_str());
+        if (watches != nullptr) {
+            watches->Format();
+            for (size_t i = 0; i < watches->GetCount(); i++) {
+                std::string_view line = watches->GetLine(i);
+                ImGui::TextUnformatted(line.data(), line.data() + line.size());
+            }
+        }
+        if (frameTimes != nullptr) {
+            ImGui::Separator();
+            showFrameTimes("CPU", frameTimes->GetRecentCpu(), frameTimes->SummarizeRecentCpu());
+            showFrameTimes("GPU", frameTimes->GetRecentGpu(), frameTimes->SummarizeRecentGpu());
         }
 
         if (ImGui::BeginPopupContextWindow()) {
@@ -57,4 +116,283 @@ void GUI::Debug::showOverlay(bool* open, std::vector<Printable*>* props) {
         }
     }
     ImGui::End();
-}
\ No newline at end of file
+}
+
+void GUI::Debug::showShaderErrors(const std::vector<ShaderReloadError>& errors) {
+    if (errors.empty()) {
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(520.0f, 240.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (ImGui::Begin("Shader errors", nullptr, ImGuiWindowFlags_NoFocusOnAppearing)) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%d shader program(s) failed to rebuild, the previous version is still in use", (int)errors.size());
+        for (const ShaderReloadError& error : errors) {
+            ImGui::Separator();
+            ImGui::Text("%s", error.programName.c_str());
+            ImGui::TextWrapped("%s", error.log.c_str());
+        }
+    }
+    ImGui::End();
+}
+
+// the same zone gets the same color in every frame
+static ImU32 ZoneColor(const char* name) {
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    }
+    return ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.75f);
+}
+
+void GUI::Debug::showProfiler(bool* open) {
+    // index of the frame being looked at, or the latest one when it's not in the history
+    static uint64_t selectedFrame = UINT64_MAX;
+    const float kTargetMs = 1000.0f / 60.0f;
+
+    ImGui::SetNextWindowSize(ImVec2(760.0f, 520.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+#ifndef PROFILING_ENABLED
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.4f, 1.0f), "Built with PROFILING_DISABLED, zones are compiled out");
+#endif
+    bool paused = profiling::IsPaused();
+    if (ImGui::Checkbox("Pause", &paused)) {
+        profiling::SetPaused(paused);
+    }
+    const profiling::FrameHistory& frames = profiling::GetFrames();
+    std::vector<profiling::ThreadInfo> threads = profiling::GetThreads();
+    size_t droppedZones = 0;
+    for (const profiling::ThreadInfo& thread : threads) {
+        droppedZones += thread.droppedZones;
+    }
+    ImGui::SameLine();
+    ImGui::Text("%d frames, %d threads, %d zones dropped", (int)frames.size(), (int)threads.size(), (int)droppedZones);
+
+    // writes the next frames to a file for chrome://tracing or ui.perfetto.dev
+    static int captureFrames = 300;
+    if (profiling::IsCapturing()) {
+        ImGui::Text("Capturing, %d frames so far", (int)profiling::GetCapturedFrames());
+    }
+    else {
+        if (ImGui::Button("Capture")) {
+            profiling::StartCapture((size_t)std::max(captureFrames, 1));
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80.0f);
+        ImGui::InputInt("frames", &captureFrames, 0);
+    }
+    if (!profiling::GetCaptureResult().empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", profiling::GetCaptureResult().c_str());
+    }
+    if (frames.empty()) {
+        ImGui::End();
+        return;
+    }
+
+    const profiling::Frame* frame = &frames.back();
+    for (const profiling::Frame& candidate : frames) {
+        if (candidate.index == selectedFrame) {
+            frame = &candidate;
+        }
+    }
+
+    // frame times, left click picks a frame and right click goes back to following the latest
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 barsOrigin = ImGui::GetCursorScreenPos();
+    ImVec2 barsSize(ImGui::GetContentRegionAvail().x, 64.0f);
+    float maxMs = 2.0f * kTargetMs;
+    for (const profiling::Frame& f : frames) {
+        maxMs = std::max(maxMs, (float)profiling::TicksToMs(f.end - f.begin));
+    }
+    float barWidth = barsSize.x / profiling::kFrameHistory;
+    for (size_t i = 0; i < frames.size(); i++) {
+        float ms = (float)profiling::TicksToMs(frames[i].end - frames[i].begin);
+        float x = barsOrigin.x + i * barWidth;
+        float top = barsOrigin.y + barsSize.y * (1.0f - ms / maxMs);
+        ImU32 color = ms <= kTargetMs ? IM_COL32(90, 200, 90, 255) : ms <= 2.0f * kTargetMs ? IM_COL32(220, 200, 80, 255) : IM_COL32(220, 80, 80, 255);
+        if (&frames[i] == frame) {
+            color = IM_COL32(255, 255, 255, 255);
+        }
+        drawList->AddRectFilled(ImVec2(x, top), ImVec2(x + std::max(barWidth - 1.0f, 1.0f), barsOrigin.y + barsSize.y), color);
+    }
+    float targetY = barsOrigin.y + barsSize.y * (1.0f - kTargetMs / maxMs);
+    drawList->AddLine(ImVec2(barsOrigin.x, targetY), ImVec2(barsOrigin.x + barsSize.x, targetY), IM_COL32(255, 255, 255, 80));
+    ImGui::InvisibleButton("frame times", barsSize);
+    if (ImGui::IsItemHovered()) {
+        size_t hovered = (size_t)std::max(0.0f, (ImGui::GetIO().MousePos.x - barsOrigin.x) / barWidth);
+        if (hovered < frames.size()) {
+            ImGui::SetTooltip("frame %llu: %.3f ms", (unsigned long long)frames[hovered].index, profiling::TicksToMs(frames[hovered].end - frames[hovered].begin));
+            if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+                selectedFrame = frames[hovered].index;
+            }
+        }
+        if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
+            selectedFrame = UINT64_MAX;
+        }
+    }
+
+    // the selected frame, a lane per thread with nested zones stacked downwards
+    double frameMs = profiling::TicksToMs(frame->end - frame->begin);
+    ImGui::Text("Frame %llu: %.3f ms%s", (unsigned long long)frame->index, frameMs, selectedFrame == UINT64_MAX ? " (latest)" : "");
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+    const float labelWidth = 140.0f;
+    if (ImGui::BeginChild("timeline", ImVec2(0.0f, 200.0f), ImGuiChildFlags_Border)) {
+        ImDrawList* timeline = ImGui::GetWindowDrawList();
+        float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 100.0f);
+        double pixelsPerTick = width / (double)std::max<uint64_t>(frame->end - frame->begin, 1);
+        size_t laneStart = 0;
+        while (laneStart < frame->zones.size()) {
+            uint32_t thread = frame->zones[laneStart].thread;
+            size_t laneEnd = laneStart;
+            uint32_t depth = 0;
+            while (laneEnd < frame->zones.size() && frame->zones[laneEnd].thread == thread) {
+                depth = std::max(depth, frame->zones[laneEnd].depth);
+                laneEnd++;
+            }
+
+            ImVec2 origin = ImGui::GetCursorScreenPos();
+            ImGui::Text("%s", thread < threads.size() ? threads[thread].name.c_str() : "?");
+            for (size_t i = laneStart; i < laneEnd; i++) {
+                const profiling::ZoneRecord& zone = frame->zones[i];
+                // zones of other threads may have started during the frame before
+                double begin = zone.begin > frame->begin ? (double)(zone.begin - frame->begin) : 0.0;
+                double end = zone.end > frame->begin ? (double)(zone.end - frame->begin) : 0.0;
+                ImVec2 min(origin.x + labelWidth + (float)(begin * pixelsPerTick), origin.y + zone.depth * rowHeight);
+                ImVec2 max(std::max(origin.x + labelWidth + (float)(end * pixelsPerTick), min.x + 1.0f), min.y + rowHeight - 1.0f);
+                timeline->AddRectFilled(min, max, ZoneColor(zone.name));
+                ImVec2 textSize = ImGui::CalcTextSize(zone.name);
+                if (textSize.x + 4.0f < max.x - min.x) {
+                    timeline->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(0, 0, 0, 255), zone.name);
+                }
+                if (ImGui::IsMouseHoveringRect(min, max)) {
+                    ImGui::SetTooltip("%s: %.3f ms", zone.name, profiling::TicksToMs(zone.end - zone.begin));
+                }
+            }
+            ImGui::SetCursorScreenPos(ImVec2(origin.x, origin.y + (depth + 1) * rowHeight + 4.0f));
+            ImGui::Dummy(ImVec2(labelWidth + width, 0.0f));
+            laneStart = laneEnd;
+        }
+    }
+    ImGui::EndChild();
+
+    // timings of every zone over the whole history
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+    if (ImGui::BeginTable("zones", 6, tableFlags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+        ImGui::TableSetupColumn("Calls/frame");
+        ImGui::TableSetupColumn("Min ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableSetupColumn("Ms/frame");
+        ImGui::TableHeadersRow();
+        for (const profiling::ZoneStats& stats : profiling::GetZoneStats()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImColor(ZoneColor(stats.name)), "%s", stats.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.callsPerFrame);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.minMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgFrameMs);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void GUI::Debug::showGLCalls(bool* open, const gl_calls::FrameStats& stats) {
+    ImGui::SetNextWindowSize(ImVec2(520.0f, 420.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("GL calls", open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Last frame: %u calls, %u draws, %.1f KiB uploaded, %.3f ms in GL", stats.totalCalls, stats.drawCalls, stats.uploadBytes / 1024.0, stats.ms);
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+    if (ImGui::BeginTable("calls", 4, tableFlags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Entry point", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Ms");
+        ImGui::TableSetupColumn("Upload KiB");
+        ImGui::TableHeadersRow();
+        for (const gl_calls::CallStats& call : stats.calls) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(gl_calls::GetCallName(call.call));
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", call.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", call.ms);
+            ImGui::TableNextColumn();
+            if (call.uploadBytes > 0) {
+                ImGui::Text("%.1f", call.uploadBytes / 1024.0);
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+GUI::Debug::StressSceneRequest GUI::Debug::showStressScene(bool* open, scene::StressSceneOptions& options, const scene::StressSceneStats* stats) {
+    ImGui::SetNextWindowSize(ImVec2(360.0f, 0.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Stress scene", open)) {
+        ImGui::End();
+        return StressSceneRequest::None;
+    }
+
+    StressSceneRequest request = StressSceneRequest::None;
+    static const uint64_t kPresets[] = { 1000, 10000, 100000, 1000000 };
+    static const char* const kPresetLabels[] = { "1k", "10k", "100k", "1M" };
+    for (size_t i = 0; i < std::size(kPresets); i++) {
+        if (i > 0) {
+            ImGui::SameLine();
+        }
+        if (ImGui::Button(kPresetLabels[i])) {
+            options.objectCount = static_cast<size_t>(kPresets[i]);
+            request = StressSceneRequest::Generate;
+        }
+    }
+    uint64_t objectCount = options.objectCount;
+    if (ImGui::InputScalar("Objects", ImGuiDataType_U64, &objectCount)) {
+        options.objectCount = static_cast<size_t>(objectCount);
+    }
+    ImGui::InputScalar("Seed", ImGuiDataType_U32, &options.seed);
+    ImGui::SliderFloat("Children", &options.childFraction, 0.0f, 1.0f);
+    // lower and upper bound of each slider
+    static const uint32_t kDepthRange[] = { 0, 8 };
+    static const uint32_t kMaterialRange[] = { 1, 256 };
+    static const uint32_t kTextureRange[] = { 1, 64 };
+    ImGui::SliderScalar("Max depth", ImGuiDataType_U32, &options.maxDepth, &kDepthRange[0], &kDepthRange[1]);
+    ImGui::SliderFloat("Movers", &options.moverFraction, 0.0f, 1.0f);
+    ImGui::SliderScalar("Materials", ImGuiDataType_U32, &options.materialCount, &kMaterialRange[0], &kMaterialRange[1]);
+    ImGui::SliderScalar("Textures", ImGuiDataType_U32, &options.textureCount, &kTextureRange[0], &kTextureRange[1]);
+    ImGui::SliderFloat("Spacing", &options.spacing, 0.5f, 5.0f);
+
+    if (ImGui::Button("Generate")) {
+        request = StressSceneRequest::Generate;
+    }
+    if (stats != nullptr) {
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            request = StressSceneRequest::Clear;
+        }
+        ImGui::Separator();
+        ImGui::Text("%zu objects, %zu roots, %u levels deep, %zu movers", stats->objects, stats->roots, stats->depth, stats->movers);
+        ImGui::Text("Generated in %.1f ms", stats->generateMs);
+        ImGui::Text("Last frame: %zu updated, %zu visible, %zu materials drawn", stats->updated, stats->visible, stats->materialRuns);
+    }
+    ImGui::End();
+    return request;
+}
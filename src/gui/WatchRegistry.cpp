@@ -0,0 +1,51 @@
+#include "WatchRegistry.h"
+
+void GUI::Debug::WatchRegistry::AddWatch(std::string_view name, std::initializer_list<std::string_view> labels, const void* const* values, uint32_t count, FormatFn format) {
+    Watch watch{ };
+    watch.componentCount = count;
+    watch.format = format;
+    size_t lineChars = 0;
+    uint32_t i = 0;
+    for (std::string_view label : labels) {
+        Component& component = watch.components[i];
+        component.labelOffset = static_cast<uint32_t>(labelText.size());
+        labelText.append(i == 0 ? name : std::string_view{ });
+        labelText.append(i == 0 ? ": " : ", ");
+        labelText.append(label);
+        labelText.append(": ");
+        component.labelLength = static_cast<uint32_t>(labelText.size() - component.labelOffset);
+        component.value = values[i];
+        lineChars += component.labelLength + kMaxValueChars;
+        i++;
+    }
+    watches.push_back(watch);
+    // room for every line at its longest, so Format never has to grow either
+    text.reserve(text.capacity() + lineChars);
+    lines.reserve(watches.size());
+}
+
+size_t GUI::Debug::WatchRegistry::GetCount() const {
+    return watches.size();
+}
+
+void GUI::Debug::WatchRegistry::Format() {
+    text.clear();
+    lines.clear();
+    char value[kMaxValueChars];
+    for (const Watch& watch : watches) {
+        size_t offset = text.size();
+        for (uint32_t i = 0; i < watch.componentCount; i++) {
+            const Component& component = watch.components[i];
+            const char* label = labelText.data() + component.labelOffset;
+            text.insert(text.end(), label, label + component.labelLength);
+            char* end = watch.format(component.value, value, value + kMaxValueChars);
+            text.insert(text.end(), value, end);
+        }
+        lines.push_back(Line{ offset, text.size() - offset });
+    }
+}
+
+std::string_view GUI::Debug::WatchRegistry::GetLine(size_t index) const {
+    const Line& line = lines[index];
+    return std::string_view(text.data() + line.offset, line.length);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace GUI {
+	namespace Debug {
+		/*
+		 * Values the overlay shows every frame, each as one line of labeled
+		 * components like "Cam pos: x: 1.5, y: 0, z: -3".
+		 *
+		 * Adding a watch copies its labels once and reserves room for the
+		 * line. Format then only copies labels and std::to_chars output into
+		 * the same reused buffer, so a frame of watches costs no allocation.
+		 * The watched values are read through their pointers, which have to
+		 * outlive the registry.
+		 */
+		class WatchRegistry {
+		public:
+			static const size_t kMaxComponents = 3;
+			// the longest a formatted number gets: 20 digits for a 64-bit integer, or %g of a double with 6 significant digits
+			static const size_t kMaxValueChars = 24;
+
+			template <typename T>
+			void Add(std::string_view name, std::string_view label, const T* value) {
+				const void* values[] = { value };
+				AddWatch(name, { label }, values, 1, &FormatValue<T>);
+			}
+
+			template <typename T>
+			void Add(std::string_view name, std::string_view xLabel, const T* x, std::string_view yLabel, const T* y) {
+				const void* values[] = { x, y };
+				AddWatch(name, { xLabel, yLabel }, values, 2, &FormatValue<T>);
+			}
+
+			template <typename T>
+			void Add(std::string_view name, std::string_view xLabel, const T* x, std::string_view yLabel, const T* y, std::string_view zLabel, const T* z) {
+				const void* values[] = { x, y, z };
+				AddWatch(name, { xLabel, yLabel, zLabel }, values, 3, &FormatValue<T>);
+			}
+
+			void Add(std::string_view name, std::string_view xLabel, std::string_view yLabel, std::string_view zLabel, const glm::vec3* vec) {
+				Add(name, xLabel, &vec->x, yLabel, &vec->y, zLabel, &vec->z);
+			}
+
+			size_t GetCount() const;
+			// reads every watched value into its line; call once per frame before GetLine
+			void Format();
+			// valid until the next Format
+			std::string_view GetLine(size_t index) const;
+
+		private:
+			using FormatFn = char* (*)(const void* value, char* first, char* last);
+
+			struct Component {
+				// the text in front of the value, in labelText
+				uint32_t labelOffset;
+				uint32_t labelLength;
+				const void* value;
+			};
+			struct Watch {
+				Component components[kMaxComponents];
+				uint32_t componentCount;
+				FormatFn format;
+			};
+			struct Line {
+				size_t offset;
+				size_t length;
+			};
+
+			std::vector<Watch> watches{ };
+			std::string labelText{ };
+			std::vector<char> text{ };
+			std::vector<Line> lines{ };
+
+			void AddWatch(std::string_view name, std::initializer_list<std::string_view> labels, const void* const* values, uint32_t count, FormatFn format);
+
+			template <typename T>
+			static char* FormatValue(const void* value, char* first, char* last) {
+				static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "watches are numbers");
+				const T& number = *static_cast<const T*>(value);
+				if constexpr (std::is_floating_point_v<T>) {
+					// what an ostream prints by default
+					return std::to_chars(first, last, number, std::chars_format::general, 6).ptr;
+				}
+				else {
+					return std::to_chars(first, last, number).ptr;
+				}
+			}
+		};
+	}
+}
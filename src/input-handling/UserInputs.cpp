@@ -7,6 +7,8 @@ namespace user_input {
 	bool should_quit = false;
 	bool wireframe_enabled = false;
 	bool perspective_enabled = true;
+	bool fog_enabled = false;
+	bool alpha_test_enabled = false;
 	bool move_forward = false;
 	bool move_left = false;
 	bool move_back = false;
@@ -15,11 +17,16 @@ namespace user_input {
 	float model_scale = 1.0f;
 	float roll_degrees = 0.0f;
 	bool show_debug_overlay = true;
+	bool show_profiler = false;
+	bool show_gl_calls = false;
+	bool show_stress_scene = false;
 
 	basic_input::KeyInput in_toggle_cursor_lock{ 0.0f, GLFW_KEY_C };
 	basic_input::KeyInput in_quit{ 0.0f, GLFW_KEY_ESCAPE };
 	basic_input::KeyInput in_toggle_wireframe{ 0.0f, GLFW_KEY_TAB };
 	basic_input::KeyInput in_toggle_perspective{ 0.0f, GLFW_KEY_F5 };
+	basic_input::KeyInput in_toggle_fog{ 0.0f, GLFW_KEY_F6 };
+	basic_input::KeyInput in_toggle_alpha_test{ 0.0f, GLFW_KEY_F7 };
 	basic_input::KeyInput in_move_forward{ 0.0f, GLFW_KEY_W };
 	basic_input::KeyInput in_move_left{ 0.0f, GLFW_KEY_A };
 	basic_input::KeyInput in_move_back{ 0.0f, GLFW_KEY_S };
@@ -31,15 +38,20 @@ namespace user_input {
 	basic_input::KeyInput in_scale_up{ 0.0f, GLFW_KEY_EQUAL };
 	basic_input::KeyInput in_scale_down{ 0.0f, GLFW_KEY_MINUS };
 	basic_input::KeyInput in_toggle_debug_overlay{ 0.0f, GLFW_KEY_F3 };
+	basic_input::KeyInput in_toggle_profiler{ 0.0f, GLFW_KEY_F4 };
+	basic_input::KeyInput in_toggle_gl_calls{ 0.0f, GLFW_KEY_F8 };
+	basic_input::KeyInput in_toggle_stress_scene{ 0.0f, GLFW_KEY_F9 };
 
 	std::vector<basic_input::KeyInput*> key_inputs{
 		&in_toggle_cursor_lock, &in_quit,
 		&in_toggle_wireframe, &in_toggle_perspective,
+		&in_toggle_fog, &in_toggle_alpha_test,
 		&in_move_forward, &in_move_left, &in_move_back, &in_move_right,
 		&in_increase_alpha, &in_decrease_alpha,
 		&in_roll_ccw, &in_roll_cw,
 		&in_scale_up, &in_scale_down,
-		&in_toggle_debug_overlay
+		&in_toggle_debug_overlay, &in_toggle_profiler, &in_toggle_gl_calls,
+		&in_toggle_stress_scene
 	};
 
 	void ProcessInputs(float deltaTime) {
@@ -72,12 +84,27 @@ namespace user_input {
 		if (in_toggle_perspective.WasKeyJustPressed()) {
 			perspective_enabled = !perspective_enabled;
 		}
+		if (in_toggle_fog.WasKeyJustPressed()) {
+			fog_enabled = !fog_enabled;
+		}
+		if (in_toggle_alpha_test.WasKeyJustPressed()) {
+			alpha_test_enabled = !alpha_test_enabled;
+		}
 		if (in_toggle_cursor_lock.WasKeyJustPressed()) {
 			cursor_locked = !cursor_locked;
 		}
 		if (in_toggle_debug_overlay.WasKeyJustPressed()) {
 			show_debug_overlay = !show_debug_overlay;
 		}
+		if (in_toggle_profiler.WasKeyJustPressed()) {
+			show_profiler = !show_profiler;
+		}
+		if (in_toggle_gl_calls.WasKeyJustPressed()) {
+			show_gl_calls = !show_gl_calls;
+		}
+		if (in_toggle_stress_scene.WasKeyJustPressed()) {
+			show_stress_scene = !show_stress_scene;
+		}
 		move_forward = in_move_forward.IsKeyDown();
 		move_back = in_move_back.IsKeyDown();
 		move_left = in_move_left.IsKeyDown();
@@ -18,6 +18,10 @@ namespace user_input {
 	extern bool perspective_enabled;
 	extern basic_input::KeyInput in_toggle_wireframe;
 	extern basic_input::KeyInput in_toggle_perspective;
+	extern bool fog_enabled;
+	extern bool alpha_test_enabled;
+	extern basic_input::KeyInput in_toggle_fog;
+	extern basic_input::KeyInput in_toggle_alpha_test;
 
 	// movement
 	extern bool move_forward;
@@ -43,6 +47,13 @@ namespace user_input {
 	// gui
 	extern bool show_debug_overlay;
 	extern basic_input::KeyInput in_toggle_debug_overlay;
+	extern bool show_profiler;
+	extern basic_input::KeyInput in_toggle_profiler;
+	// also turns GL call instrumentation on and off
+	extern bool show_gl_calls;
+	extern basic_input::KeyInput in_toggle_gl_calls;
+	extern bool show_stress_scene;
+	extern basic_input::KeyInput in_toggle_stress_scene;
 
 	extern std::vector<basic_input::KeyInput *> key_inputs;
 
@@ -0,0 +1,141 @@
+#include "FrameLog.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+namespace profiling {
+
+	FrameLog::FrameLog(std::vector<std::string> counterNames, size_t expectedFrames)
+		: counterNames(std::move(counterNames)) {
+		lateCounters.assign(this->counterNames.size(), false);
+		values.reserve(expectedFrames * GetStride());
+	}
+
+	size_t FrameLog::GetStride() const {
+		return 3 + counterNames.size();
+	}
+
+	void FrameLog::Record(uint64_t frameIndex, double cpuMs, const std::vector<double>& counters) {
+		if (rows == 0) {
+			firstFrame = frameIndex;
+		}
+		values.push_back(static_cast<double>(frameIndex));
+		values.push_back(cpuMs);
+		values.push_back(std::numeric_limits<double>::quiet_NaN());
+		for (size_t i = 0; i < counterNames.size(); i++) {
+			if (lateCounters[i]) {
+				values.push_back(std::numeric_limits<double>::quiet_NaN());
+			}
+			else {
+				values.push_back(i < counters.size() ? counters[i] : 0.0);
+			}
+		}
+		rows++;
+	}
+
+	void FrameLog::RecordGpu(uint64_t frameIndex, double gpuMs) {
+		if (frameIndex < firstFrame || frameIndex - firstFrame >= rows) {
+			return;
+		}
+		values[(frameIndex - firstFrame) * GetStride() + 2] = gpuMs;
+	}
+
+	void FrameLog::SetLate(std::string_view counterName) {
+		for (size_t i = 0; i < counterNames.size(); i++) {
+			if (counterNames[i] == counterName) {
+				lateCounters[i] = true;
+			}
+		}
+	}
+
+	void FrameLog::RecordLate(uint64_t frameIndex, std::string_view counterName, double value) {
+		if (frameIndex < firstFrame || frameIndex - firstFrame >= rows) {
+			return;
+		}
+		for (size_t i = 0; i < counterNames.size(); i++) {
+			if (lateCounters[i] && counterNames[i] == counterName) {
+				values[(frameIndex - firstFrame) * GetStride() + 3 + i] = value;
+			}
+		}
+	}
+
+	void FrameLog::WriteCsv(std::ostream& stream) const {
+		stream << "frame,cpu_ms,gpu_ms";
+		for (const std::string& name : counterNames) {
+			stream << ",\"" << name << "\"";
+		}
+		stream << "\n";
+		for (size_t row = 0; row < rows; row++) {
+			const double* rowValues = values.data() + row * GetStride();
+			stream << static_cast<uint64_t>(rowValues[0]) << "," << rowValues[1] << ",";
+			// a frame whose GPU time never came back is left empty
+			if (!std::isnan(rowValues[2])) {
+				stream << rowValues[2];
+			}
+			for (size_t i = 3; i < GetStride(); i++) {
+				stream << ",";
+				if (!std::isnan(rowValues[i])) {
+					stream << rowValues[i];
+				}
+			}
+			stream << "\n";
+		}
+	}
+
+	void FrameLog::WriteJson(std::ostream& stream) const {
+		stream << "{\"counters\":[";
+		for (size_t i = 0; i < counterNames.size(); i++) {
+			stream << (i > 0 ? "," : "") << "\"" << counterNames[i] << "\"";
+		}
+		stream << "],\n\"frames\":[";
+		for (size_t row = 0; row < rows; row++) {
+			const double* rowValues = values.data() + row * GetStride();
+			stream << (row > 0 ? ",\n" : "\n") << "{\"frame\":" << static_cast<uint64_t>(rowValues[0]) << ",\"cpuMs\":" << rowValues[1] << ",\"gpuMs\":";
+			if (std::isnan(rowValues[2])) {
+				stream << "null";
+			}
+			else {
+				stream << rowValues[2];
+			}
+			stream << ",\"counters\":[";
+			for (size_t i = 3; i < GetStride(); i++) {
+				stream << (i > 3 ? "," : "");
+				if (std::isnan(rowValues[i])) {
+					stream << "null";
+				}
+				else {
+					stream << rowValues[i];
+				}
+			}
+			stream << "]}";
+		}
+		stream << "\n]}\n";
+	}
+
+	bool FrameLog::Write(const std::string& path, std::string& error) const {
+		std::filesystem::path filePath(path);
+		if (filePath.has_parent_path()) {
+			std::error_code directoryError;
+			std::filesystem::create_directories(filePath.parent_path(), directoryError);
+		}
+		std::ofstream stream(path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream.is_open()) {
+			error = "can't create " + path;
+			return false;
+		}
+		stream << std::fixed << std::setprecision(4);
+		if (filePath.extension() == ".json") {
+			WriteJson(stream);
+		}
+		else {
+			WriteCsv(stream);
+		}
+		if (!stream) {
+			error = "can't write " + path;
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace profiling {
+
+	/*
+	 * One row per frame of a benchmark run: CPU time, GPU time and the
+	 * registered counters, written out once the run is over.
+	 *
+	 * GPU times come in a few frames after their frame's row, so they are
+	 * looked up by frame index; a frame whose GPU time never arrived is
+	 * left empty. Counters marked late, like the times of single GPU
+	 * passes, work the same way. Rows live in one flat array reserved up
+	 * front, so recording a frame doesn't allocate.
+	 */
+	class FrameLog {
+	public:
+		FrameLog(std::vector<std::string> counterNames, size_t expectedFrames);
+
+		// counters in the order of the names, missing ones are written as 0
+		void Record(uint64_t frameIndex, double cpuMs, const std::vector<double>& counters);
+		// ignored for frames that weren't recorded
+		void RecordGpu(uint64_t frameIndex, double gpuMs);
+		// Record leaves a late counter empty, for RecordLate to fill in once its frame's value is known
+		void SetLate(std::string_view counterName);
+		// ignored for frames that weren't recorded and counters that aren't late
+		void RecordLate(uint64_t frameIndex, std::string_view counterName, double value);
+
+		// JSON if path ends in .json, CSV otherwise; the directory is created if it doesn't exist yet
+		bool Write(const std::string& path, std::string& error) const;
+
+	private:
+		std::vector<std::string> counterNames;
+		std::vector<bool> lateCounters;
+		// frame index, CPU ms, GPU ms and then the counters, for every row
+		std::vector<double> values{ };
+		uint64_t firstFrame = 0;
+		size_t rows = 0;
+
+		size_t GetStride() const;
+		void WriteCsv(std::ostream& stream) const;
+		void WriteJson(std::ostream& stream) const;
+	};
+}
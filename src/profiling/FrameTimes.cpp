@@ -0,0 +1,187 @@
+#include "FrameTimes.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace profiling {
+
+	// the rings fill up over the first kRecentFrames frames, and growing them then would allocate during those frames
+	FrameTimeRecorder::FrameTimeRecorder() {
+		for (Ring* ring : { &recentCpu, &recentGpu }) {
+			ring->values.reserve(kRecentFrames);
+			ring->ordered.reserve(kRecentFrames);
+			ring->sorted.reserve(kRecentFrames);
+		}
+	}
+
+	void FrameTimeRecorder::Record(Ring& ring, Distribution& distribution, double ms) {
+		if (ring.values.size() < kRecentFrames) {
+			ring.values.push_back(static_cast<float>(ms));
+		}
+		else {
+			ring.values[ring.next] = static_cast<float>(ms);
+		}
+		ring.next = (ring.next + 1) % kRecentFrames;
+
+		size_t bucket = std::min(static_cast<size_t>(std::max(ms, 0.0) / kBucketMs), kBucketCount - 1);
+		distribution.buckets[bucket]++;
+		distribution.frames++;
+		distribution.totalMs += ms;
+		distribution.maxMs = std::max(distribution.maxMs, ms);
+	}
+
+	void FrameTimeRecorder::RecordCpu(double ms) {
+		Record(recentCpu, sessionCpu, ms);
+	}
+
+	void FrameTimeRecorder::RecordGpu(double ms) {
+		Record(recentGpu, sessionGpu, ms);
+	}
+
+	const std::vector<float>& FrameTimeRecorder::Order(Ring& ring) {
+		ring.ordered.clear();
+		if (ring.values.size() < kRecentFrames) {
+			ring.ordered.assign(ring.values.begin(), ring.values.end());
+		}
+		else {
+			ring.ordered.insert(ring.ordered.end(), ring.values.begin() + ring.next, ring.values.end());
+			ring.ordered.insert(ring.ordered.end(), ring.values.begin(), ring.values.begin() + ring.next);
+		}
+		return ring.ordered;
+	}
+
+	const std::vector<float>& FrameTimeRecorder::GetRecentCpu() {
+		return Order(recentCpu);
+	}
+
+	const std::vector<float>& FrameTimeRecorder::GetRecentGpu() {
+		return Order(recentGpu);
+	}
+
+	FrameTimeSummary FrameTimeRecorder::Summarize(const Ring& ring) {
+		FrameTimeSummary summary{ };
+		if (ring.values.empty()) {
+			return summary;
+		}
+		std::vector<float>& sorted = ring.sorted;
+		sorted.assign(ring.values.begin(), ring.values.end());
+		std::sort(sorted.begin(), sorted.end());
+		// nearest rank, so p99 of 512 frames is the 6th slowest rather than an interpolation
+		auto percentile = [&sorted](double p) {
+			size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+			return static_cast<double>(sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1]);
+		};
+		double total = 0.0;
+		for (float ms : sorted) {
+			total += ms;
+		}
+		summary.frames = sorted.size();
+		summary.meanMs = total / sorted.size();
+		summary.p50Ms = percentile(0.50);
+		summary.p95Ms = percentile(0.95);
+		summary.p99Ms = percentile(0.99);
+		summary.maxMs = sorted.back();
+		return summary;
+	}
+
+	FrameTimeSummary FrameTimeRecorder::Summarize(const Distribution& distribution) {
+		FrameTimeSummary summary{ };
+		if (distribution.frames == 0) {
+			return summary;
+		}
+		// the upper edge of the bucket the percentile falls into, but never more than the slowest frame
+		auto percentile = [&distribution](double p) {
+			uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(p * distribution.frames + 0.999999), 1);
+			uint64_t seen = 0;
+			for (size_t i = 0; i < kBucketCount; i++) {
+				seen += distribution.buckets[i];
+				if (seen >= rank) {
+					return std::min((i + 1) * kBucketMs, distribution.maxMs);
+				}
+			}
+			return distribution.maxMs;
+		};
+		summary.frames = distribution.frames;
+		summary.meanMs = distribution.totalMs / distribution.frames;
+		summary.p50Ms = percentile(0.50);
+		summary.p95Ms = percentile(0.95);
+		summary.p99Ms = percentile(0.99);
+		summary.maxMs = distribution.maxMs;
+		return summary;
+	}
+
+	FrameTimeSummary FrameTimeRecorder::SummarizeRecentCpu() const {
+		return Summarize(recentCpu);
+	}
+
+	FrameTimeSummary FrameTimeRecorder::SummarizeRecentGpu() const {
+		return Summarize(recentGpu);
+	}
+
+	FrameTimeSummary FrameTimeRecorder::SummarizeSessionCpu() const {
+		return Summarize(sessionCpu);
+	}
+
+	FrameTimeSummary FrameTimeRecorder::SummarizeSessionGpu() const {
+		return Summarize(sessionGpu);
+	}
+
+	static void WriteSummary(std::ostream& stream, const FrameTimeSummary& summary) {
+		stream << "{\"frames\":" << summary.frames << ",\"mean\":" << summary.meanMs << ",\"p50\":" << summary.p50Ms
+			<< ",\"p95\":" << summary.p95Ms << ",\"p99\":" << summary.p99Ms << ",\"max\":" << summary.maxMs << "}";
+	}
+
+	// up to the last non-empty bucket
+	static void WriteBuckets(std::ostream& stream, const std::vector<uint64_t>& buckets) {
+		size_t used = buckets.size();
+		while (used > 0 && buckets[used - 1] == 0) {
+			used--;
+		}
+		stream << "[";
+		for (size_t i = 0; i < used; i++) {
+			stream << (i > 0 ? "," : "") << buckets[i];
+		}
+		stream << "]";
+	}
+
+	bool FrameTimeRecorder::WriteReport(const std::string& path, std::string& error) const {
+		std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (!parent.empty()) {
+			std::error_code directoryError;
+			std::filesystem::create_directories(parent, directoryError);
+		}
+		std::ofstream stream(path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream.is_open()) {
+			error = "can't create " + path;
+			return false;
+		}
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\n\"unit\":\"ms\",\n\"bucketMs\":" << kBucketMs << ",\n\"cpu\":";
+		WriteSummary(stream, SummarizeSessionCpu());
+		stream << ",\n\"gpu\":";
+		WriteSummary(stream, SummarizeSessionGpu());
+		stream << ",\n\"cpuHistogram\":";
+		WriteBuckets(stream, sessionCpu.buckets);
+		stream << ",\n\"gpuHistogram\":";
+		WriteBuckets(stream, sessionGpu.buckets);
+		stream << "\n}\n";
+		if (!stream) {
+			error = "can't write " + path;
+			return false;
+		}
+		return true;
+	}
+
+	void FrameTimeRecorder::PrintReport() const {
+		auto print = [](const char* label, const FrameTimeSummary& summary) {
+			std::cout << label << ": " << summary.frames << " frames, mean " << summary.meanMs << " ms, p50 " << summary.p50Ms
+				<< " ms, p95 " << summary.p95Ms << " ms, p99 " << summary.p99Ms << " ms, max " << summary.maxMs << " ms" << std::endl;
+		};
+		std::cout << std::fixed << std::setprecision(2);
+		print("CPU frame time", SummarizeSessionCpu());
+		print("GPU frame time", SummarizeSessionGpu());
+		std::cout << std::defaultfloat;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace profiling {
+
+	struct FrameTimeSummary {
+		size_t frames = 0;
+		double meanMs = 0.0;
+		double p50Ms = 0.0;
+		double p95Ms = 0.0;
+		double p99Ms = 0.0;
+		double maxMs = 0.0;
+	};
+
+	/*
+	 * CPU and GPU time of the recent frames, and how the whole session was
+	 * distributed, so stutters show up instead of disappearing into an
+	 * average.
+	 *
+	 * The recent frames are a fixed ring for the overlay's graph and live
+	 * percentiles. The session is kept as a histogram of kBucketMs wide
+	 * buckets, which is what WriteReport writes out; its percentiles are
+	 * accurate to a bucket. Frames over kBucketMs * kBucketCount all land
+	 * in the last bucket, but still count towards the maximum.
+	 */
+	class FrameTimeRecorder {
+	public:
+		static const size_t kRecentFrames = 512;
+		static constexpr double kBucketMs = 0.1;
+		static const size_t kBucketCount = 1000;
+
+		FrameTimeRecorder();
+
+		// once per frame
+		void RecordCpu(double ms);
+		// once per frame that the GPU timings arrived for, which may be a few frames later
+		void RecordGpu(double ms);
+
+		// oldest first, at most kRecentFrames
+		const std::vector<float>& GetRecentCpu();
+		const std::vector<float>& GetRecentGpu();
+		FrameTimeSummary SummarizeRecentCpu() const;
+		FrameTimeSummary SummarizeRecentGpu() const;
+		FrameTimeSummary SummarizeSessionCpu() const;
+		FrameTimeSummary SummarizeSessionGpu() const;
+
+		// the session's summaries and histograms as JSON, for comparing builds
+		bool WriteReport(const std::string& path, std::string& error) const;
+		void PrintReport() const;
+
+	private:
+		struct Ring {
+			std::vector<float> values{ };
+			size_t next = 0;
+			// oldest first, rebuilt when asked for
+			std::vector<float> ordered{ };
+			// reused by Summarize so the overlay doesn't allocate every frame
+			mutable std::vector<float> sorted{ };
+		};
+		struct Distribution {
+			std::vector<uint64_t> buckets = std::vector<uint64_t>(kBucketCount, 0);
+			size_t frames = 0;
+			double totalMs = 0.0;
+			double maxMs = 0.0;
+		};
+
+		Ring recentCpu{ };
+		Ring recentGpu{ };
+		Distribution sessionCpu{ };
+		Distribution sessionGpu{ };
+
+		static void Record(Ring& ring, Distribution& distribution, double ms);
+		static const std::vector<float>& Order(Ring& ring);
+		static FrameTimeSummary Summarize(const Ring& ring);
+		static FrameTimeSummary Summarize(const Distribution& distribution);
+	};
+}
@@ -0,0 +1,153 @@
+#include "GpuTimer.h"
+#include <glad/glad.h>
+#include <cstring>
+
+namespace profiling {
+
+	GpuTimer::GpuTimer() {
+		track = AddTrack("GPU");
+		frameTimes.reserve(kMaxUndrainedFrames);
+		Calibrate();
+	}
+
+	GpuTimer::~GpuTimer() {
+		for (FrameQueries& frame : frames) {
+			if (!frame.queries.empty()) {
+				glDeleteQueries(static_cast<int>(frame.queries.size()), frame.queries.data());
+			}
+		}
+	}
+
+	void GpuTimer::Calibrate() {
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		cpuReference = Now();
+		gpuReference = static_cast<uint64_t>(gpuNow);
+	}
+
+	unsigned int GpuTimer::AcquireQuery(FrameQueries& frame) {
+		if (frame.usedQueries == frame.queries.size()) {
+			unsigned int query = 0;
+			glGenQueries(1, &query);
+			frame.queries.push_back(query);
+		}
+		return frame.queries[frame.usedQueries++];
+	}
+
+	bool GpuTimer::ReadBack(FrameQueries& frame) {
+		// queries finish in the order they were issued, so the last one stands for all of them
+		GLint available = 0;
+		glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			return false;
+		}
+
+		passes.clear();
+		passesFrameIndex = frame.frameIndex;
+		zones.clear();
+		frameMs = 0.0;
+		for (const PendingPass& pass : frame.passes) {
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(pass.beginQuery, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(pass.endQuery, GL_QUERY_RESULT, &end);
+			double ms = static_cast<double>(end - begin) / 1e6;
+			passes.push_back(Pass{ pass.name, ms, pass.depth });
+			if (pass.depth == 0) {
+				frameMs += ms;
+			}
+
+			double sinceReferenceMs = (static_cast<double>(begin) - static_cast<double>(gpuReference)) / 1e6;
+			uint64_t cpuBegin = cpuReference + static_cast<int64_t>(MsToTicks(sinceReferenceMs));
+			uint64_t cpuEnd = cpuBegin + static_cast<uint64_t>(MsToTicks(ms));
+			zones.push_back(ZoneRecord{ pass.name, cpuBegin, cpuEnd, pass.depth, track });
+		}
+		AddTrackZones(frame.frameIndex, zones);
+		if (frameTimes.size() == kMaxUndrainedFrames) {
+			frameTimes.erase(frameTimes.begin());
+		}
+		frameTimes.push_back(FrameTime{ frame.frameIndex, frameMs });
+		frame.pending = false;
+		return true;
+	}
+
+	void GpuTimer::BeginFrame() {
+		// a pass left open has no end to read
+		if (!openPasses.empty()) {
+			frames[current].pending = false;
+		}
+		current = (current + 1) % (kFramesInFlight + 1);
+		// oldest first, so the latest results win
+		for (int i = 0; i <= kFramesInFlight; i++) {
+			FrameQueries& frame = frames[(current + i) % (kFramesInFlight + 1)];
+			if (frame.pending) {
+				ReadBack(frame);
+			}
+		}
+
+		FrameQueries& frame = frames[current];
+		if (frame.pending) {
+			skippedFrames++;
+		}
+		frame.frameIndex = GetFrameIndex();
+		frame.passes.clear();
+		frame.usedQueries = 0;
+		frame.pending = false;
+		openPasses.clear();
+
+		// both clocks drift a little, so they are lined up again about once a second
+		if (TicksToMs(Now() - cpuReference) > 1000.0) {
+			Calibrate();
+		}
+	}
+
+	void GpuTimer::BeginPass(const char* name) {
+		FrameQueries& frame = frames[current];
+		PendingPass pass{ name, static_cast<uint32_t>(openPasses.size()), AcquireQuery(frame), 0 };
+		glQueryCounter(pass.beginQuery, GL_TIMESTAMP);
+		openPasses.push_back(frame.passes.size());
+		frame.passes.push_back(pass);
+	}
+
+	void GpuTimer::EndPass() {
+		if (openPasses.empty()) {
+			return;
+		}
+		FrameQueries& frame = frames[current];
+		PendingPass& pass = frame.passes[openPasses.back()];
+		openPasses.pop_back();
+		pass.endQuery = AcquireQuery(frame);
+		glQueryCounter(pass.endQuery, GL_TIMESTAMP);
+		frame.pending = openPasses.empty();
+	}
+
+	const std::vector<GpuTimer::Pass>& GpuTimer::GetPasses() const {
+		return passes;
+	}
+
+	double GpuTimer::GetPassMs(const char* name) const {
+		for (const Pass& pass : passes) {
+			if (std::strcmp(pass.name, name) == 0) {
+				return pass.ms;
+			}
+		}
+		return 0.0;
+	}
+
+	uint64_t GpuTimer::GetPassesFrameIndex() const {
+		return passesFrameIndex;
+	}
+
+	double GpuTimer::GetFrameMs() const {
+		return frameMs;
+	}
+
+	void GpuTimer::DrainFrameTimes(std::vector<FrameTime>& out) {
+		out.insert(out.end(), frameTimes.begin(), frameTimes.end());
+		frameTimes.clear();
+	}
+
+	size_t GpuTimer::GetSkippedFrames() const {
+		return skippedFrames;
+	}
+}
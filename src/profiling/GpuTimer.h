@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Profiler.h"
+
+namespace profiling {
+
+	/*
+	 * Times passes on the GPU with pairs of timestamp queries, without ever
+	 * waiting on a result. A frame's queries are read back once they're
+	 * available, which is usually a frame or two later. If they still aren't
+	 * after kFramesInFlight frames, the GPU is that far behind; the frame's
+	 * timings are skipped so its queries can be reused.
+	 *
+	 * Finished passes go into the profiler's "GPU" track, on the frame that
+	 * issued them, lined up with the CPU zones. Passes may nest. Use it on
+	 * the thread the context is current on, and destroy it while it still is.
+	 */
+	class GpuTimer {
+	public:
+		static const int kFramesInFlight = 3;
+
+		struct Pass {
+			const char* name;
+			double ms;
+			uint32_t depth;
+		};
+		// the outermost passes of one frame added up
+		struct FrameTime {
+			uint64_t frameIndex;
+			double ms;
+		};
+		// read back but not drained yet; older ones are dropped past this
+		static const size_t kMaxUndrainedFrames = 64;
+
+		GpuTimer();
+		~GpuTimer();
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		// reads back frames that finished and starts recording the next; call once per frame before the first pass
+		void BeginFrame();
+		// names have to be string literals, like zone names
+		void BeginPass(const char* name);
+		void EndPass();
+
+		// of the latest frame that was read back, in the order they began
+		const std::vector<Pass>& GetPasses() const;
+		// 0 if the latest frame didn't have a pass with that name
+		double GetPassMs(const char* name) const;
+		// the profiler frame index of the latest frame that was read back; only meaningful once GetPasses isn't empty
+		uint64_t GetPassesFrameIndex() const;
+		// the outermost passes of the latest frame added up, so the time between them doesn't count
+		double GetFrameMs() const;
+		// appends the frames read back since the last call, oldest first
+		void DrainFrameTimes(std::vector<FrameTime>& out);
+		// frames the GPU was too far behind on to time
+		size_t GetSkippedFrames() const;
+
+	private:
+		struct PendingPass {
+			const char* name;
+			uint32_t depth;
+			unsigned int beginQuery;
+			unsigned int endQuery;
+		};
+		// the queries of one frame, grown as needed and reused every kFramesInFlight + 1 frames
+		struct FrameQueries {
+			uint64_t frameIndex = 0;
+			std::vector<PendingPass> passes{ };
+			std::vector<unsigned int> queries{ };
+			size_t usedQueries = 0;
+			bool pending = false;
+		};
+
+		FrameQueries frames[kFramesInFlight + 1]{ };
+		int current = 0;
+		// indices into the current frame's passes
+		std::vector<size_t> openPasses{ };
+		uint32_t track = 0;
+		// GPU nanoseconds and profiler ticks taken at about the same moment, to line the two up
+		uint64_t gpuReference = 0;
+		uint64_t cpuReference = 0;
+		std::vector<Pass> passes{ };
+		uint64_t passesFrameIndex = 0;
+		double frameMs = 0.0;
+		std::vector<FrameTime> frameTimes{ };
+		std::vector<ZoneRecord> zones{ };
+		size_t skippedFrames = 0;
+
+		unsigned int AcquireQuery(FrameQueries& frame);
+		// false while the GPU hasn't got to the end of the frame yet
+		bool ReadBack(FrameQueries& frame);
+		void Calibrate();
+	};
+
+	class ScopedGpuPass {
+	public:
+		ScopedGpuPass(GpuTimer& timer, const char* name) : timer(timer) {
+			timer.BeginPass(name);
+		}
+		~ScopedGpuPass() {
+			timer.EndPass();
+		}
+		ScopedGpuPass(const ScopedGpuPass&) = delete;
+		ScopedGpuPass& operator=(const ScopedGpuPass&) = delete;
+
+	private:
+		GpuTimer& timer;
+	};
+}
+
+#ifdef PROFILING_ENABLED
+// times the GL commands issued in the rest of the enclosing scope
+#define PROFILE_GPU_SCOPE(timer, name) ::profiling::ScopedGpuPass PROFILE_CONCAT(profileGpuPass, __LINE__)(timer, name)
+#else
+#define PROFILE_GPU_SCOPE(timer, name)
+#endif
@@ -0,0 +1,231 @@
+#include "MemoryTags.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace profiling {
+
+	// one cache line per tag, so threads allocating under different tags don't share one
+	struct alignas(64) TagCounters {
+		std::atomic<size_t> allocations{ 0 };
+		std::atomic<size_t> allocatedBytes{ 0 };
+		std::atomic<size_t> freedBytes{ 0 };
+	};
+
+	// constant initialized, so allocations made before main are counted too
+	static TagCounters counters[kMemoryTagCount];
+	static size_t previousAllocations[kMemoryTagCount]{ };
+	static size_t previousBytes[kMemoryTagCount]{ };
+	static MemoryFrameStats frameStats{ };
+
+	const char* GetMemoryTagName(MemoryTag tag) {
+		switch (tag) {
+		case MemoryTag::Render:
+			return "render";
+		case MemoryTag::Assets:
+			return "assets";
+		case MemoryTag::Gui:
+			return "gui";
+		case MemoryTag::Input:
+			return "input";
+		default:
+			return "untagged";
+		}
+	}
+
+	const MemoryFrameStats& EndMemoryFrame() {
+		frameStats.total = MemoryTagStats{ };
+		for (size_t i = 0; i < kMemoryTagCount; i++) {
+			size_t allocations = counters[i].allocations.load(std::memory_order_relaxed);
+			size_t allocatedBytes = counters[i].allocatedBytes.load(std::memory_order_relaxed);
+			size_t freedBytes = counters[i].freedBytes.load(std::memory_order_relaxed);
+			MemoryTagStats& stats = frameStats.tags[i];
+			stats.allocations = allocations - previousAllocations[i];
+			stats.bytes = allocatedBytes - previousBytes[i];
+			// other threads may have counted a free before the allocation it belongs to
+			stats.liveBytes = allocatedBytes > freedBytes ? allocatedBytes - freedBytes : 0;
+			previousAllocations[i] = allocations;
+			previousBytes[i] = allocatedBytes;
+
+			frameStats.total.allocations += stats.allocations;
+			frameStats.total.bytes += stats.bytes;
+			frameStats.total.liveBytes += stats.liveBytes;
+		}
+		return frameStats;
+	}
+
+	const MemoryFrameStats& GetMemoryFrameStats() {
+		return frameStats;
+	}
+
+	bool IsMemoryTrackingEnabled() {
+#ifdef MEMORY_TRACKING_ENABLED
+		return true;
+#else
+		return false;
+#endif
+	}
+
+#ifdef MEMORY_TRACKING_ENABLED
+	// right in front of every block handed out
+	struct AllocationHeader {
+		uint64_t size;
+		uint32_t tag;
+		// from the start of what malloc returned to the block
+		uint32_t offset;
+	};
+	static_assert(sizeof(AllocationHeader) == 16, "the header has to keep the default alignment of the block after it");
+
+	static void* Allocate(size_t size, size_t alignment) {
+		bool overaligned = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+		size_t offset = std::max(alignment, sizeof(AllocationHeader));
+		void* base = nullptr;
+		if (!overaligned) {
+			base = std::malloc(size + offset);
+		}
+		else {
+#ifdef _MSC_VER
+			base = _aligned_malloc(size + offset, alignment);
+#else
+			// aligned_alloc wants a multiple of the alignment
+			base = std::aligned_alloc(alignment, (size + offset + alignment - 1) & ~(alignment - 1));
+#endif
+		}
+		if (base == nullptr) {
+			return nullptr;
+		}
+
+		MemoryTag tag = CurrentMemoryTag();
+		char* block = static_cast<char*>(base) + offset;
+		AllocationHeader* header = reinterpret_cast<AllocationHeader*>(block) - 1;
+		header->size = size;
+		header->tag = static_cast<uint32_t>(tag);
+		header->offset = static_cast<uint32_t>(offset);
+		TagCounters& tagCounters = counters[static_cast<size_t>(tag)];
+		tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+		tagCounters.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		return block;
+	}
+
+	static void* AllocateOrThrow(size_t size, size_t alignment) {
+		while (true) {
+			void* block = Allocate(size, alignment);
+			if (block != nullptr) {
+				return block;
+			}
+			std::new_handler handler = std::get_new_handler();
+			if (handler == nullptr) {
+				throw std::bad_alloc();
+			}
+			handler();
+		}
+	}
+
+	static void Free(void* block, bool overaligned) {
+		if (block == nullptr) {
+			return;
+		}
+		AllocationHeader* header = static_cast<AllocationHeader*>(block) - 1;
+		counters[header->tag].freedBytes.fetch_add(static_cast<size_t>(header->size), std::memory_order_relaxed);
+		void* base = static_cast<char*>(block) - header->offset;
+#ifdef _MSC_VER
+		if (overaligned) {
+			_aligned_free(base);
+			return;
+		}
+#else
+		(void)overaligned;
+#endif
+		std::free(base);
+	}
+#endif
+}
+
+#ifdef MEMORY_TRACKING_ENABLED
+// every replaceable form, so nothing slips past the counters or reaches a free without its header
+static const size_t kDefaultAlignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* operator new(size_t size) {
+	return profiling::AllocateOrThrow(size, kDefaultAlignment);
+}
+
+void* operator new[](size_t size) {
+	return profiling::AllocateOrThrow(size, kDefaultAlignment);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return profiling::Allocate(size, kDefaultAlignment);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return profiling::Allocate(size, kDefaultAlignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return profiling::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return profiling::AllocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return profiling::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return profiling::Allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete[](void* block) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete(void* block, size_t) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+	profiling::Free(block, false);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+	profiling::Free(block, true);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+	profiling::Free(block, true);
+}
+
+void operator delete(void* block, size_t, std::align_val_t) noexcept {
+	profiling::Free(block, true);
+}
+
+void operator delete[](void* block, size_t, std::align_val_t) noexcept {
+	profiling::Free(block, true);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	profiling::Free(block, true);
+}
+
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	profiling::Free(block, true);
+}
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// define MEMORY_TRACKING_DISABLED to keep the default operator new and delete; the stats then stay at 0
+#ifndef MEMORY_TRACKING_DISABLED
+#define MEMORY_TRACKING_ENABLED
+#endif
+
+/*
+ * Counts every allocation made through operator new, by the subsystem
+ * that made it.
+ *
+ *	{
+ *		MEMORY_TAG(profiling::MemoryTag::Gui);
+ *		ImGui::NewFrame();
+ *		...
+ *	}
+ *
+ * The tag belongs to the calling thread and holds for the rest of the
+ * scope; ThreadPool jobs run with the tag of the thread that submitted
+ * them. Each block carries a small header with its size and tag, so a
+ * free is counted against the tag that allocated it, whichever thread
+ * frees it. The counters are relaxed atomics and take no lock.
+ * EndMemoryFrame turns them into what happened since the last call.
+ */
+namespace profiling {
+
+	enum class MemoryTag : uint8_t {
+		Untagged,
+		Render,
+		Assets,
+		Gui,
+		Input,
+	};
+	const size_t kMemoryTagCount = 5;
+
+	const char* GetMemoryTagName(MemoryTag tag);
+
+	// the calling thread's tag
+	inline MemoryTag& CurrentMemoryTag() {
+		thread_local MemoryTag tag = MemoryTag::Untagged;
+		return tag;
+	}
+
+	class ScopedMemoryTag {
+	public:
+		explicit ScopedMemoryTag(MemoryTag tag) : previous(CurrentMemoryTag()) {
+			CurrentMemoryTag() = tag;
+		}
+		~ScopedMemoryTag() {
+			CurrentMemoryTag() = previous;
+		}
+		ScopedMemoryTag(const ScopedMemoryTag&) = delete;
+		ScopedMemoryTag& operator=(const ScopedMemoryTag&) = delete;
+
+	private:
+		MemoryTag previous;
+	};
+
+	struct MemoryTagStats {
+		// during the frame
+		size_t allocations = 0;
+		size_t bytes = 0;
+		// still allocated when the frame ended, including what earlier frames left
+		size_t liveBytes = 0;
+	};
+
+	struct MemoryFrameStats {
+		// indexed by MemoryTag
+		MemoryTagStats tags[kMemoryTagCount]{ };
+		MemoryTagStats total{ };
+	};
+
+	// what every thread allocated since the previous call; call once per frame from one thread
+	const MemoryFrameStats& EndMemoryFrame();
+	// of the last EndMemoryFrame
+	const MemoryFrameStats& GetMemoryFrameStats();
+	bool IsMemoryTrackingEnabled();
+}
+
+#define MEMORY_TAG_CONCAT_INNER(a, b) a##b
+#define MEMORY_TAG_CONCAT(a, b) MEMORY_TAG_CONCAT_INNER(a, b)
+// tags the calling thread's allocations in the rest of the enclosing scope
+#define MEMORY_TAG(tag) ::profiling::ScopedMemoryTag MEMORY_TAG_CONCAT(memoryTag, __LINE__)(tag)
@@ -0,0 +1,376 @@
+#include "Profiler.h"
+#include "TraceExport.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace profiling {
+
+	ThreadBuffer::ThreadBuffer(uint32_t index) : index(index), records(kCapacity) { }
+
+	void ThreadBuffer::Drain(std::vector<ZoneRecord>& out) {
+		uint64_t read = tail.load(std::memory_order_relaxed);
+		uint64_t write = head.load(std::memory_order_acquire);
+		for (; read != write; read++) {
+			out.push_back(records[read & (kCapacity - 1)]);
+		}
+		tail.store(read, std::memory_order_release);
+	}
+
+	FrameHistory::FrameHistory()
+		: slots(kFrameHistory) {
+		for (Frame& slot : slots) {
+			slot.zones.reserve(zoneCapacity);
+			slot.counters.reserve(counterCapacity);
+		}
+	}
+
+	Frame& FrameHistory::Push() {
+		if (count < kFrameHistory) {
+			return slots[(first + count++) % kFrameHistory];
+		}
+		Frame& oldest = slots[first];
+		first = (first + 1) % kFrameHistory;
+		return oldest;
+	}
+
+	Frame* FrameHistory::Find(uint64_t frameIndex) {
+		for (size_t i = 0; i < count; i++) {
+			Frame& frame = slots[(first + i) % kFrameHistory];
+			if (frame.index == frameIndex) {
+				return &frame;
+			}
+		}
+		return nullptr;
+	}
+
+	void FrameHistory::ReserveZones(size_t zones) {
+		if (zones <= zoneCapacity) {
+			return;
+		}
+		zoneCapacity = std::max(zones, zoneCapacity * 2);
+		for (Frame& slot : slots) {
+			slot.zones.reserve(zoneCapacity);
+		}
+	}
+
+	void FrameHistory::ReserveCounters(size_t counters) {
+		if (counters <= counterCapacity) {
+			return;
+		}
+		counterCapacity = std::max(counters, counterCapacity * 2);
+		for (Frame& slot : slots) {
+			slot.counters.reserve(counterCapacity);
+		}
+	}
+
+	/*
+	 * Every thread that ever recorded a zone, and the frame history. Threads
+	 * register once and their buffers are never freed, since a thread pool
+	 * worker can still end a zone while statics are being destroyed.
+	 */
+	class Registry {
+	public:
+		std::mutex mutex;
+		// null for tracks
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers{ };
+		std::vector<std::string> names{ };
+
+		// main thread only
+		FrameHistory frames{ };
+		// cleared but never shrunk, so draining allocates only when a frame has more zones than any before
+		std::vector<ZoneRecord> drained{ };
+		uint64_t frameIndex = 0;
+		uint64_t frameBegin = Now();
+		bool paused = false;
+
+		struct Counter {
+			const size_t* sizeValue;
+			const double* doubleValue;
+		};
+		std::vector<Counter> counters{ };
+		std::vector<std::string> counterNames{ };
+
+		// frames from captureFirst on go into capture until captureCount of them are there
+		bool capturing = false;
+		uint64_t captureFirst = 0;
+		size_t captureCount = 0;
+		std::string capturePath{ };
+		Capture capture{ };
+		std::string captureResult{ };
+
+		// Now() and steady_clock at startup, to find out how fast ticks go
+		uint64_t startTicks = Now();
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+#ifdef PROFILING_USE_TSC
+		double msPerTick = 1e-6;
+#else
+		double msPerTick = 1000.0 * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+
+		Registry() {
+			drained.reserve(FrameHistory::kReservedZones);
+		}
+
+		size_t GetDropped(const ThreadBuffer& buffer) const {
+			return buffer.dropped.load(std::memory_order_relaxed);
+		}
+	};
+
+	static Registry& GetRegistry() {
+		static Registry* registry = new Registry();
+		return *registry;
+	}
+
+	ThreadBuffer& RegisterThread() {
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		uint32_t index = static_cast<uint32_t>(registry.buffers.size());
+		registry.buffers.push_back(std::make_unique<ThreadBuffer>(index));
+		registry.names.push_back("thread " + std::to_string(index));
+		return *registry.buffers.back();
+	}
+
+	void SetThreadName(const std::string& name) {
+		ThreadBuffer& buffer = CurrentThreadBuffer();
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (size_t i = 0; i < registry.buffers.size(); i++) {
+			if (registry.buffers[i].get() == &buffer) {
+				registry.names[i] = name;
+			}
+		}
+	}
+
+	uint32_t AddTrack(const std::string& name) {
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		registry.buffers.push_back(nullptr);
+		registry.names.push_back(name);
+		return static_cast<uint32_t>(registry.buffers.size() - 1);
+	}
+
+	static void SortZones(Frame& frame) {
+		std::sort(frame.zones.begin(), frame.zones.end(), [](const ZoneRecord& a, const ZoneRecord& b) {
+			return a.thread != b.thread ? a.thread < b.thread : a.begin < b.begin;
+		});
+	}
+
+	static void AddZonesToFrame(Frame& frame, const std::vector<ZoneRecord>& zones) {
+		frame.zones.insert(frame.zones.end(), zones.begin(), zones.end());
+		SortZones(frame);
+	}
+
+	void AddTrackZones(uint64_t frameIndex, const std::vector<ZoneRecord>& zones) {
+		Registry& registry = GetRegistry();
+		if (Frame* frame = registry.frames.Find(frameIndex)) {
+			registry.frames.ReserveZones(frame->zones.size() + zones.size());
+			AddZonesToFrame(*frame, zones);
+		}
+		if (registry.capturing) {
+			for (Frame& frame : registry.capture.frames) {
+				if (frame.index == frameIndex) {
+					AddZonesToFrame(frame, zones);
+				}
+			}
+		}
+	}
+
+	uint64_t GetFrameIndex() {
+		return GetRegistry().frameIndex;
+	}
+
+	void EndFrame() {
+		Registry& registry = GetRegistry();
+		uint64_t end = Now();
+
+#ifdef PROFILING_USE_TSC
+		// the longer the run, the better the estimate; it settles within the first second
+		double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - registry.startTime).count();
+		if (end > registry.startTicks && elapsedMs > 0.0) {
+			registry.msPerTick = elapsedMs / static_cast<double>(end - registry.startTicks);
+		}
+#endif
+
+		registry.drained.clear();
+		{
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers) {
+				if (buffer != nullptr) {
+					buffer->Drain(registry.drained);
+				}
+			}
+		}
+
+		bool capturingFrame = registry.capturing && registry.frameIndex - registry.captureFirst < registry.captureCount;
+		if (!registry.paused || capturingFrame) {
+			// a paused history stays as it is, so a captured frame is built on the side
+			Frame pausedFrame{ };
+			if (!registry.paused) {
+				registry.frames.ReserveZones(registry.drained.size());
+			}
+			Frame& frame = registry.paused ? pausedFrame : registry.frames.Push();
+			frame.index = registry.frameIndex;
+			frame.begin = registry.frameBegin;
+			frame.end = end;
+			frame.zones.assign(registry.drained.begin(), registry.drained.end());
+			SortZones(frame);
+			frame.counters.clear();
+			for (const Registry::Counter& counter : registry.counters) {
+				frame.counters.push_back(counter.sizeValue != nullptr ? static_cast<double>(*counter.sizeValue) : *counter.doubleValue);
+			}
+			if (capturingFrame) {
+				registry.capture.frames.push_back(frame);
+			}
+		}
+		registry.frameIndex++;
+		registry.frameBegin = end;
+
+		// written once the zones that arrive late had their chance, outside of the captured frames
+		if (registry.capturing && registry.frameIndex >= registry.captureFirst + registry.captureCount + kCaptureSettleFrames) {
+			registry.capturing = false;
+			registry.capture.threads = GetThreads();
+			registry.capture.counterNames = registry.counterNames;
+			std::string error;
+			if (WriteChromeTrace(registry.capturePath, registry.capture, error)) {
+				registry.captureResult = registry.capturePath;
+				std::cout << "Wrote " << registry.capture.frames.size() << " frames to " << registry.capturePath << std::endl;
+			}
+			else {
+				registry.captureResult = "capture failed: " + error;
+				std::cerr << "Failed to write frame capture: " << error << std::endl;
+			}
+			registry.capture = Capture{ };
+		}
+	}
+
+	void RegisterCounter(const std::string& name, const size_t* value) {
+		Registry& registry = GetRegistry();
+		registry.counters.push_back(Registry::Counter{ value, nullptr });
+		registry.counterNames.push_back(name);
+		registry.frames.ReserveCounters(registry.counters.size());
+	}
+
+	void RegisterCounter(const std::string& name, const double* value) {
+		Registry& registry = GetRegistry();
+		registry.counters.push_back(Registry::Counter{ nullptr, value });
+		registry.counterNames.push_back(name);
+		registry.frames.ReserveCounters(registry.counters.size());
+	}
+
+	std::vector<std::string> GetCounterNames() {
+		return GetRegistry().counterNames;
+	}
+
+	bool StartCapture(size_t frameCount, const std::string& path) {
+		Registry& registry = GetRegistry();
+		if (registry.capturing || frameCount == 0) {
+			return false;
+		}
+		registry.capturePath = path;
+		if (registry.capturePath.empty()) {
+			std::time_t now = std::time(nullptr);
+			std::tm local{ };
+#ifdef _WIN32
+			localtime_s(&local, &now);
+#else
+			localtime_r(&now, &local);
+#endif
+			char stamp[32] = { };
+			std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+			registry.capturePath = std::string("captures/frames-") + stamp + ".json";
+		}
+		registry.capturing = true;
+		registry.captureFirst = registry.frameIndex;
+		registry.captureCount = frameCount;
+		registry.capture = Capture{ };
+		return true;
+	}
+
+	bool IsCapturing() {
+		return GetRegistry().capturing;
+	}
+
+	size_t GetCapturedFrames() {
+		return GetRegistry().capture.frames.size();
+	}
+
+	const std::string& GetCaptureResult() {
+		return GetRegistry().captureResult;
+	}
+
+	void SetPaused(bool paused) {
+		GetRegistry().paused = paused;
+	}
+
+	bool IsPaused() {
+		return GetRegistry().paused;
+	}
+
+	const FrameHistory& GetFrames() {
+		return GetRegistry().frames;
+	}
+
+	std::vector<ThreadInfo> GetThreads() {
+		Registry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		std::vector<ThreadInfo> threads{ };
+		for (size_t i = 0; i < registry.buffers.size(); i++) {
+			size_t dropped = registry.buffers[i] != nullptr ? registry.GetDropped(*registry.buffers[i]) : 0;
+			threads.push_back(ThreadInfo{ registry.names[i], dropped });
+		}
+		return threads;
+	}
+
+	std::vector<ZoneStats> GetZoneStats() {
+		struct Totals {
+			ZoneStats stats;
+			size_t frames;
+			uint64_t ticks;
+			uint64_t lastFrame;
+		};
+		// literals with the same text may or may not share a pointer, so zones are told apart by their text
+		std::unordered_map<std::string, Totals> totals{ };
+		const FrameHistory& frames = GetFrames();
+		for (const Frame& frame : frames) {
+			for (const ZoneRecord& zone : frame.zones) {
+				double ms = TicksToMs(zone.end - zone.begin);
+				auto [entry, added] = totals.try_emplace(zone.name, Totals{ ZoneStats{ zone.name, 0, 0.0, ms, 0.0, ms, 0.0 }, 0, 0, frame.index });
+				Totals& zoneTotals = entry->second;
+				if (added || zoneTotals.lastFrame != frame.index) {
+					zoneTotals.frames++;
+					zoneTotals.lastFrame = frame.index;
+				}
+				zoneTotals.stats.calls++;
+				zoneTotals.stats.minMs = std::min(zoneTotals.stats.minMs, ms);
+				zoneTotals.stats.maxMs = std::max(zoneTotals.stats.maxMs, ms);
+				zoneTotals.ticks += zone.end - zone.begin;
+			}
+		}
+
+		std::vector<ZoneStats> stats{ };
+		for (auto& [name, zoneTotals] : totals) {
+			ZoneStats& zoneStats = zoneTotals.stats;
+			zoneStats.callsPerFrame = static_cast<double>(zoneStats.calls) / static_cast<double>(frames.size());
+			zoneStats.avgMs = TicksToMs(zoneTotals.ticks) / static_cast<double>(zoneStats.calls);
+			zoneStats.avgFrameMs = TicksToMs(zoneTotals.ticks) / static_cast<double>(zoneTotals.frames);
+			stats.push_back(zoneStats);
+		}
+		std::sort(stats.begin(), stats.end(), [](const ZoneStats& a, const ZoneStats& b) {
+			return a.avgFrameMs > b.avgFrameMs;
+		});
+		return stats;
+	}
+
+	double TicksToMs(uint64_t ticks) {
+		return static_cast<double>(ticks) * GetRegistry().msPerTick;
+	}
+
+	double MsToTicks(double ms) {
+		return ms / GetRegistry().msPerTick;
+	}
+}
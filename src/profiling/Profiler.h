@@ -0,0 +1,258 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// define PROFILING_DISABLED for builds without zones; every PROFILE_ macro then compiles to nothing
+#ifndef PROFILING_DISABLED
+#define PROFILING_ENABLED
+#endif
+
+// the time stamp counter is a few cycles to read, steady_clock goes through the OS
+#if defined(_M_X64) || defined(__x86_64__)
+#define PROFILING_USE_TSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+/*
+ * Scoped CPU zones, collected once per frame for a profiler window.
+ *
+ *	void UpdateViewMatrix() {
+ *		PROFILE_SCOPE("UpdateViewMatrix");
+ *		...
+ *	}
+ *
+ * Names have to be string literals, only the pointer is recorded. A zone
+ * writes a single record into a ring buffer owned by its thread when it
+ * ends, which takes no lock and no allocation. EndFrame on the main thread
+ * drains every buffer into the history of the last kFrameHistory frames.
+ * A thread that records faster than frames end drops its newest zones
+ * instead of waiting; ThreadInfo counts them.
+ */
+namespace profiling {
+
+	// ticks of Now(); TicksToMs converts them
+	inline uint64_t Now() {
+#ifdef PROFILING_USE_TSC
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	struct ZoneRecord {
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		// zones that were open on the same thread when this one began
+		uint32_t depth;
+		uint32_t thread;
+	};
+
+	/*
+	 * Zones of one thread that EndFrame hasn't picked up yet. Only the owning
+	 * thread pushes and only EndFrame drains, so head and tail are all that's
+	 * shared between them.
+	 */
+	class ThreadBuffer {
+	public:
+		static const size_t kCapacity = 8192;
+
+		ThreadBuffer(uint32_t index);
+		ThreadBuffer(const ThreadBuffer&) = delete;
+		ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+		inline void Push(const char* name, uint64_t begin, uint64_t end, uint32_t depth) {
+			uint64_t write = head.load(std::memory_order_relaxed);
+			if (write - tail.load(std::memory_order_acquire) == kCapacity) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			records[write & (kCapacity - 1)] = ZoneRecord{ name, begin, end, depth, index };
+			head.store(write + 1, std::memory_order_release);
+		}
+		// appends everything pushed so far to out; EndFrame's thread only
+		void Drain(std::vector<ZoneRecord>& out);
+
+		// zones open on the owning thread right now, only that thread touches it
+		uint32_t depth = 0;
+
+	private:
+		friend class Registry;
+
+		uint32_t index;
+		std::vector<ZoneRecord> records;
+		std::atomic<uint64_t> head{ 0 };
+		std::atomic<uint64_t> tail{ 0 };
+		std::atomic<size_t> dropped{ 0 };
+	};
+
+	// the calling thread's buffer, registered the first time it's asked for
+	ThreadBuffer& RegisterThread();
+	inline ThreadBuffer& CurrentThreadBuffer() {
+		thread_local ThreadBuffer* buffer = &RegisterThread();
+		return *buffer;
+	}
+
+	class ScopedZone {
+	public:
+		explicit ScopedZone(const char* name)
+			: name(name), buffer(CurrentThreadBuffer()), depth(buffer.depth++), begin(Now()) { }
+		~ScopedZone() {
+			uint64_t end = Now();
+			buffer.depth--;
+			buffer.Push(name, begin, end, depth);
+		}
+		ScopedZone(const ScopedZone&) = delete;
+		ScopedZone& operator=(const ScopedZone&) = delete;
+
+	private:
+		const char* name;
+		ThreadBuffer& buffer;
+		uint32_t depth;
+		uint64_t begin;
+	};
+
+	struct Frame {
+		// counts up from 0 with every EndFrame
+		uint64_t index = 0;
+		uint64_t begin = 0;
+		uint64_t end = 0;
+		// every zone that ended during the frame, by thread and then by begin
+		std::vector<ZoneRecord> zones{ };
+		// values of the registered counters when the frame ended, in the order they were registered
+		std::vector<double> counters{ };
+	};
+
+	// a thread that recorded zones, or a track that zones measured elsewhere are added to
+	struct ThreadInfo {
+		// "thread 3" until the thread names itself
+		std::string name;
+		size_t droppedZones;
+	};
+
+	// per call, over every frame in the history
+	struct ZoneStats {
+		const char* name;
+		size_t calls;
+		double callsPerFrame;
+		double minMs;
+		double avgMs;
+		double maxMs;
+		// of a frame's calls added up, averaged over the frames it ran in
+		double avgFrameMs;
+	};
+
+	const size_t kFrameHistory = 240;
+	// frames a capture waits after its last one, for zones measured later like the GPU's
+	const uint64_t kCaptureSettleFrames = 8;
+
+	/*
+	 * The last kFrameHistory frames, oldest first, in a ring of slots that
+	 * are created up front with room for kReservedZones zones and
+	 * kReservedCounters counters each. A new frame overwrites the oldest
+	 * slot's vectors in place, so ending a frame allocates nothing unless
+	 * it has more zones than any frame before it; then every slot grows at
+	 * once instead of each one the next time it comes around.
+	 */
+	class FrameHistory {
+	public:
+		static const size_t kReservedZones = 256;
+		static const size_t kReservedCounters = 32;
+
+		class Iterator {
+		public:
+			Iterator(const FrameHistory* history, size_t position)
+				: history(history), position(position) { }
+			const Frame& operator*() const { return (*history)[position]; }
+			const Frame* operator->() const { return &(*history)[position]; }
+			Iterator& operator++() { position++; return *this; }
+			bool operator!=(const Iterator& other) const { return position != other.position; }
+			bool operator==(const Iterator& other) const { return position == other.position; }
+
+		private:
+			const FrameHistory* history;
+			size_t position;
+		};
+
+		FrameHistory();
+
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		const Frame& operator[](size_t position) const { return slots[(first + position) % kFrameHistory]; }
+		const Frame& front() const { return (*this)[0]; }
+		const Frame& back() const { return (*this)[count - 1]; }
+		Iterator begin() const { return Iterator{ this, 0 }; }
+		Iterator end() const { return Iterator{ this, count }; }
+
+		// the slot for a new frame, the oldest one once the history is full; EndFrame's thread only
+		Frame& Push();
+		// nullptr once the frame has left the history
+		Frame* Find(uint64_t frameIndex);
+		// grows every slot so a frame with that many zones or counters fits without allocating
+		void ReserveZones(size_t zones);
+		void ReserveCounters(size_t counters);
+
+	private:
+		std::vector<Frame> slots;
+		size_t first = 0;
+		size_t count = 0;
+		size_t zoneCapacity = kReservedZones;
+		size_t counterCapacity = kReservedCounters;
+	};
+
+	// shown in the profiler window instead of "thread n"
+	void SetThreadName(const std::string& name);
+	// a lane for zones that weren't timed by a CPU thread, e.g. GPU passes; returns what goes into ZoneRecord::thread
+	uint32_t AddTrack(const std::string& name);
+	// zones of frameIndex that were measured after it ended; dropped once the frame is out of the history and any capture
+	void AddTrackZones(uint64_t frameIndex, const std::vector<ZoneRecord>& zones);
+	// of the frame being recorded, the next EndFrame closes it
+	uint64_t GetFrameIndex();
+	// closes the current frame and starts the next; call once per frame on the main thread
+	void EndFrame();
+	// zones keep being drained and thrown away, while the history stays as it is to be looked at
+	void SetPaused(bool paused);
+	bool IsPaused();
+
+	// a value sampled at every EndFrame; it has to stay valid for as long as frames end
+	void RegisterCounter(const std::string& name, const size_t* value);
+	void RegisterCounter(const std::string& name, const double* value);
+	std::vector<std::string> GetCounterNames();
+
+	// records the next frameCount frames, with counters and GPU passes, and writes them to path as a Chrome trace
+	// an empty path picks captures/frames-<date>-<time>.json; false while another capture is running
+	bool StartCapture(size_t frameCount, const std::string& path = "");
+	bool IsCapturing();
+	// frames recorded by the running capture so far
+	size_t GetCapturedFrames();
+	// where the latest capture went, or why it didn't; empty before the first one finished
+	const std::string& GetCaptureResult();
+
+	// oldest first; the main thread only, and only between EndFrame calls
+	const FrameHistory& GetFrames();
+	std::vector<ThreadInfo> GetThreads();
+	// sorted by avgFrameMs, most expensive first
+	std::vector<ZoneStats> GetZoneStats();
+	double TicksToMs(uint64_t ticks);
+	double MsToTicks(double ms);
+}
+
+#ifdef PROFILING_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing scope
+#define PROFILE_SCOPE(name) ::profiling::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) ::profiling::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
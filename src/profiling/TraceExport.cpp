@@ -0,0 +1,77 @@
+#include "TraceExport.h"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace profiling {
+
+	static void WriteJsonString(std::ostream& stream, const std::string& text) {
+		stream << '"';
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				stream << '\\' << c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+			}
+			else {
+				stream << c;
+			}
+		}
+		stream << '"';
+	}
+
+	bool WriteChromeTrace(const std::string& path, const Capture& capture, std::string& error) {
+		if (capture.frames.empty()) {
+			error = "nothing was captured";
+			return false;
+		}
+		std::filesystem::path parent = std::filesystem::path(path).parent_path();
+		if (!parent.empty()) {
+			std::error_code directoryError;
+			std::filesystem::create_directories(parent, directoryError);
+		}
+		std::ofstream stream(path, std::ios_base::out | std::ios_base::trunc);
+		if (!stream.is_open()) {
+			error = "can't create " + path;
+			return false;
+		}
+
+		// microseconds since the first frame began, which is what ts and dur are in
+		uint64_t start = capture.frames.front().begin;
+		auto micros = [start](uint64_t ticks) {
+			return ticks > start ? TicksToMs(ticks - start) * 1000.0 : -TicksToMs(start - ticks) * 1000.0;
+		};
+		stream << std::fixed << std::setprecision(3);
+		stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"learnOpenGL\"}}";
+		for (size_t i = 0; i < capture.threads.size(); i++) {
+			stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":";
+			WriteJsonString(stream, capture.threads[i].name);
+			stream << "}}";
+			// lanes in the order threads registered, with tracks like the GPU's where they were added
+			stream << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"sort_index\":" << i << "}}";
+		}
+
+		for (const Frame& frame : capture.frames) {
+			stream << ",\n{\"name\":\"Frame " << frame.index << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << micros(frame.begin) << "}";
+			for (const ZoneRecord& zone : frame.zones) {
+				stream << ",\n{\"name\":";
+				WriteJsonString(stream, zone.name);
+				stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << zone.thread << ",\"ts\":" << micros(zone.begin)
+					<< ",\"dur\":" << TicksToMs(zone.end - zone.begin) * 1000.0 << "}";
+			}
+			for (size_t i = 0; i < frame.counters.size() && i < capture.counterNames.size(); i++) {
+				stream << ",\n{\"name\":";
+				WriteJsonString(stream, capture.counterNames[i]);
+				stream << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << micros(frame.end) << ",\"args\":{\"value\":" << frame.counters[i] << "}}";
+			}
+		}
+		stream << "\n]}\n";
+		if (!stream) {
+			error = "can't write " + path;
+			return false;
+		}
+		return true;
+	}
+}
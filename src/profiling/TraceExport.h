@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Profiler.h"
+
+namespace profiling {
+
+	// frames recorded by StartCapture, with everything needed to make sense of them on their own
+	struct Capture {
+		std::vector<Frame> frames{ };
+		// indexed by ZoneRecord::thread
+		std::vector<ThreadInfo> threads{ };
+		// indexed like Frame::counters
+		std::vector<std::string> counterNames{ };
+	};
+
+	/*
+	 * Writes capture in the Trace Event format, which chrome://tracing and
+	 * ui.perfetto.dev both open: a complete event per zone on its thread's
+	 * lane, an instant event at the start of every frame and a counter
+	 * track per registered counter. Timestamps start at 0 with the first
+	 * frame. The directory is created if it doesn't exist yet.
+	 */
+	bool WriteChromeTrace(const std::string& path, const Capture& capture, std::string& error);
+}
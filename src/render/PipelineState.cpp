@@ -0,0 +1,243 @@
+#include "PipelineState.h"
+#include <cstdint>
+
+namespace render {
+
+	// 64-bit FNV-1a over each field on its own, so struct padding never ends up in a hash
+	static uint64_t HashValue(uint64_t hash, uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			hash ^= (value >> (8 * i)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static const uint64_t kHashSeed = 14695981039346656037ull;
+
+	static uint64_t HashLayout(const VertexLayout& layout) {
+		uint64_t hash = HashValue(kHashSeed, layout.stride);
+		for (const VertexAttribute& attribute : layout.attributes) {
+			hash = HashValue(hash, attribute.location);
+			hash = HashValue(hash, static_cast<uint64_t>(attribute.components));
+			hash = HashValue(hash, attribute.type);
+			hash = HashValue(hash, attribute.normalized);
+			hash = HashValue(hash, attribute.offset);
+		}
+		return hash;
+	}
+
+	PipelineState::PipelineState(const PipelineDesc& desc, size_t layoutIndex, unsigned int vertexArray)
+		: desc(desc), layoutIndex(layoutIndex), vertexArray(vertexArray) {
+		shaderHash = HashValue(HashValue(kHashSeed, desc.program), desc.programPipeline);
+		uint64_t raster = kHashSeed;
+		for (uint64_t value : { (uint64_t)desc.topology, (uint64_t)desc.depthTest, (uint64_t)desc.depthWrite, (uint64_t)desc.depthFunc,
+			(uint64_t)desc.blend, (uint64_t)desc.blendSrc, (uint64_t)desc.blendDst,
+			(uint64_t)desc.cullFace, (uint64_t)desc.frontFace, (uint64_t)desc.polygonMode }) {
+			raster = HashValue(raster, value);
+		}
+		rasterHash = raster;
+		hash = HashValue(HashValue(shaderHash, HashLayout(desc.layout)), rasterHash);
+
+		// 20 bits of shader, the pipeline flag on top since program and pipeline names overlap, 12 of layout, 32 of the rest
+		uint64_t shaderBits = desc.program != 0 ? desc.program & 0x7ffff : (1u << 19) | (desc.programPipeline & 0x7ffff);
+		sortKey = (shaderBits << 44) | ((uint64_t)(layoutIndex & 0xfff) << 32) | (rasterHash & 0xffffffff);
+	}
+
+	const PipelineDesc& PipelineState::GetDesc() const {
+		return desc;
+	}
+
+	uint64_t PipelineState::GetHash() const {
+		return hash;
+	}
+
+	uint64_t PipelineState::GetShaderHash() const {
+		return shaderHash;
+	}
+
+	uint64_t PipelineState::GetRasterHash() const {
+		return rasterHash;
+	}
+
+	uint64_t PipelineState::GetSortKey() const {
+		return sortKey;
+	}
+
+	unsigned int PipelineState::GetVertexArray() const {
+		return vertexArray;
+	}
+
+	PipelineCache::~PipelineCache() {
+		for (const Layout& layout : layouts) {
+			glDeleteVertexArrays(1, &layout.vertexArray);
+		}
+	}
+
+	size_t PipelineCache::FindLayout(const VertexLayout& layout) {
+		for (size_t i = 0; i < layouts.size(); i++) {
+			if (layouts[i].layout == layout) {
+				return i;
+			}
+		}
+
+		unsigned int vertexArray = 0;
+		glGenVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+		for (const VertexAttribute& attribute : layout.attributes) {
+			glEnableVertexAttribArray(attribute.location);
+			if (gl_ext::SupportsVertexAttribBinding()) {
+				// every attribute reads from binding 0, the buffer comes later
+				gl_ext::VertexAttribFormat(attribute.location, attribute.components, attribute.type, attribute.normalized, attribute.offset);
+				gl_ext::VertexAttribBinding(attribute.location, 0);
+			}
+		}
+		// whatever was bound before is unknown now
+		if (bound != nullptr) {
+			glBindVertexArray(bound->GetVertexArray());
+		}
+		layouts.push_back(Layout{ layout, vertexArray, 0 });
+		return layouts.size() - 1;
+	}
+
+	const PipelineState* PipelineCache::Create(const PipelineDesc& desc) {
+		size_t layoutIndex = FindLayout(desc.layout);
+		std::unique_ptr<PipelineState> state(new PipelineState(desc, layoutIndex, layouts[layoutIndex].vertexArray));
+		auto [first, last] = statesByHash.equal_range(state->GetHash());
+		for (auto existing = first; existing != last; ++existing) {
+			if (existing->second->GetDesc() == desc) {
+				return existing->second;
+			}
+		}
+		statesByHash.emplace(state->GetHash(), state.get());
+		states.push_back(std::move(state));
+		return states.back().get();
+	}
+
+	size_t PipelineCache::GetStateCount() const {
+		return states.size();
+	}
+
+	void PipelineCache::ApplyShader(const PipelineDesc& desc) {
+		stats.shaderChanges++;
+		if (desc.program != 0 || desc.programPipeline == 0) {
+			glUseProgram(desc.program);
+			return;
+		}
+		// a program in use takes precedence over the bound pipeline
+		glUseProgram(0);
+		gl_ext::BindProgramPipeline(desc.programPipeline);
+	}
+
+	static void SetEnabled(unsigned int capability, bool enabled) {
+		if (enabled) {
+			glEnable(capability);
+		}
+		else {
+			glDisable(capability);
+		}
+	}
+
+	void PipelineCache::ApplyRaster(const PipelineDesc& desc, const PipelineDesc* previous) {
+		// previous is null when nothing is known about the current state
+		if (previous == nullptr || desc.depthTest != previous->depthTest) {
+			SetEnabled(GL_DEPTH_TEST, desc.depthTest);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.depthWrite != previous->depthWrite) {
+			glDepthMask(desc.depthWrite ? GL_TRUE : GL_FALSE);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.depthFunc != previous->depthFunc) {
+			glDepthFunc(desc.depthFunc);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.blend != previous->blend) {
+			SetEnabled(GL_BLEND, desc.blend);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.blendSrc != previous->blendSrc || desc.blendDst != previous->blendDst) {
+			glBlendFunc(desc.blendSrc, desc.blendDst);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || (desc.cullFace != GL_NONE) != (previous->cullFace != GL_NONE)) {
+			SetEnabled(GL_CULL_FACE, desc.cullFace != GL_NONE);
+			stats.rasterCalls++;
+		}
+		if (desc.cullFace != GL_NONE && (previous == nullptr || desc.cullFace != previous->cullFace)) {
+			glCullFace(desc.cullFace);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.frontFace != previous->frontFace) {
+			glFrontFace(desc.frontFace);
+			stats.rasterCalls++;
+		}
+		if (previous == nullptr || desc.polygonMode != previous->polygonMode) {
+			// core profile only takes GL_FRONT_AND_BACK
+			glPolygonMode(GL_FRONT_AND_BACK, desc.polygonMode);
+			stats.rasterCalls++;
+		}
+	}
+
+	void PipelineCache::Bind(const PipelineState& state) {
+		stats.binds++;
+		if (bound == &state) {
+			stats.redundantBinds++;
+			return;
+		}
+		const PipelineDesc* previous = bound != nullptr ? &bound->GetDesc() : nullptr;
+		if (previous == nullptr || state.GetShaderHash() != bound->GetShaderHash()) {
+			ApplyShader(state.GetDesc());
+		}
+		if (previous == nullptr || state.GetVertexArray() != bound->GetVertexArray()) {
+			glBindVertexArray(state.GetVertexArray());
+			stats.layoutChanges++;
+		}
+		if (previous == nullptr || state.GetRasterHash() != bound->GetRasterHash()) {
+			ApplyRaster(state.GetDesc(), previous);
+		}
+		bound = &state;
+	}
+
+	void PipelineCache::BindVertexBuffer(unsigned int buffer) {
+		vertexBuffer = buffer;
+	}
+
+	void PipelineCache::ApplyVertexBuffer(Layout& layout) {
+		if (layout.buffer == vertexBuffer) {
+			return;
+		}
+		stats.vertexBufferChanges++;
+		layout.buffer = vertexBuffer;
+		if (gl_ext::SupportsVertexAttribBinding()) {
+			gl_ext::BindVertexBuffer(0, vertexBuffer, 0, layout.layout.stride);
+			return;
+		}
+		// the VAO keeps the buffer each pointer was set with, GL_ARRAY_BUFFER itself isn't part of it
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		for (const VertexAttribute& attribute : layout.layout.attributes) {
+			glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized,
+				layout.layout.stride, reinterpret_cast<const void*>(static_cast<uintptr_t>(attribute.offset)));
+		}
+	}
+
+	void PipelineCache::Draw(int first, int count) {
+		if (bound == nullptr) {
+			return;
+		}
+		ApplyVertexBuffer(layouts[bound->layoutIndex]);
+		glDrawArrays(bound->GetDesc().topology, first, count);
+		stats.draws++;
+	}
+
+	void PipelineCache::Invalidate() {
+		bound = nullptr;
+	}
+
+	void PipelineCache::BeginFrame() {
+		stats = PipelineStats{ };
+	}
+
+	const PipelineStats& PipelineCache::GetStats() const {
+		return stats;
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "../gl/GLExtensions.h"
+
+namespace render {
+
+	// one float attribute of an interleaved vertex, normalized integers included
+	struct VertexAttribute {
+		unsigned int location = 0;
+		int components = 4;
+		unsigned int type = GL_FLOAT;
+		bool normalized = false;
+		unsigned int offset = 0;
+
+		bool operator==(const VertexAttribute& other) const = default;
+	};
+
+	// how vertices are laid out in a single interleaved buffer
+	struct VertexLayout {
+		unsigned int stride = 0;
+		std::vector<VertexAttribute> attributes{ };
+
+		bool operator==(const VertexLayout& other) const = default;
+	};
+
+	// everything a draw needs besides its buffers, textures and uniforms; starts out as GL's defaults
+	struct PipelineDesc {
+		// a program for glUseProgram, or a program pipeline of separable stages while program is 0
+		unsigned int program = 0;
+		unsigned int programPipeline = 0;
+		VertexLayout layout{ };
+		unsigned int topology = GL_TRIANGLES;
+		bool depthTest = false;
+		bool depthWrite = true;
+		unsigned int depthFunc = GL_LESS;
+		bool blend = false;
+		unsigned int blendSrc = GL_ONE;
+		unsigned int blendDst = GL_ZERO;
+		// GL_NONE draws both sides
+		unsigned int cullFace = GL_NONE;
+		unsigned int frontFace = GL_CCW;
+		unsigned int polygonMode = GL_FILL;
+
+		bool operator==(const PipelineDesc& other) const = default;
+	};
+
+	/*
+	 * An immutable PipelineDesc, hashed once when it's created. States come
+	 * from a PipelineCache, which hands out the same object for equal descs,
+	 * so comparing pointers is enough to tell two states apart.
+	 */
+	class PipelineState {
+	public:
+		const PipelineDesc& GetDesc() const;
+		// of the whole desc, and of the parts that get applied together
+		uint64_t GetHash() const;
+		uint64_t GetShaderHash() const;
+		uint64_t GetRasterHash() const;
+		/*
+		 * Draws sorted by this switch shaders least often, then vertex layouts,
+		 * then everything else. Equal states always have equal keys; different
+		 * ones almost always differ too, a collision only costs some grouping.
+		 */
+		uint64_t GetSortKey() const;
+		// the vertex array the cache keeps for this layout, shared with every state that has the same one
+		unsigned int GetVertexArray() const;
+
+	private:
+		friend class PipelineCache;
+		PipelineState(const PipelineDesc& desc, size_t layoutIndex, unsigned int vertexArray);
+
+		PipelineDesc desc;
+		size_t layoutIndex;
+		unsigned int vertexArray;
+		uint64_t hash = 0;
+		uint64_t shaderHash = 0;
+		uint64_t rasterHash = 0;
+		uint64_t sortKey = 0;
+	};
+
+	struct PipelineStats {
+		size_t binds = 0;
+		// binds of the state that was already bound, which cost nothing
+		size_t redundantBinds = 0;
+		size_t shaderChanges = 0;
+		size_t layoutChanges = 0;
+		size_t vertexBufferChanges = 0;
+		// individual glEnable, glDepthFunc, glPolygonMode, ... calls
+		size_t rasterCalls = 0;
+		size_t draws = 0;
+	};
+
+	/*
+	 * Creates pipeline states and keeps track of what's bound, so binding a
+	 * state only issues the GL calls for the parts that differ from the one
+	 * bound before. Each vertex layout gets a VAO of its own; with
+	 * ARB_vertex_attrib_binding the format is set up once and a new vertex
+	 * buffer is a single glBindVertexBuffer, without it the attribute
+	 * pointers are set again when the buffer changes.
+	 *
+	 * GL state changed behind the cache's back has to be followed by
+	 * Invalidate. Code that restores what it changed, like the ImGui
+	 * backend, doesn't count. States live as long as the cache and it has
+	 * to go while the context is still current.
+	 */
+	class PipelineCache {
+	public:
+		PipelineCache() = default;
+		~PipelineCache();
+		PipelineCache(const PipelineCache&) = delete;
+		PipelineCache& operator=(const PipelineCache&) = delete;
+
+		// the existing state if one with an equal desc was created before
+		const PipelineState* Create(const PipelineDesc& desc);
+		size_t GetStateCount() const;
+
+		void Bind(const PipelineState& state);
+		// the buffer the bound state's layout reads vertices from
+		void BindVertexBuffer(unsigned int buffer);
+		// with the topology of the bound state
+		void Draw(int first, int count);
+		// forgets what's bound, the next Bind applies everything
+		void Invalidate();
+
+		// starts counting from zero
+		void BeginFrame();
+		const PipelineStats& GetStats() const;
+
+	private:
+		struct Layout {
+			VertexLayout layout;
+			unsigned int vertexArray;
+			// the buffer the attribute pointers currently point into
+			unsigned int buffer;
+		};
+
+		std::vector<std::unique_ptr<PipelineState>> states{ };
+		std::unordered_multimap<uint64_t, const PipelineState*> statesByHash{ };
+		std::vector<Layout> layouts{ };
+		const PipelineState* bound = nullptr;
+		unsigned int vertexBuffer = 0;
+		PipelineStats stats{ };
+
+		size_t FindLayout(const VertexLayout& layout);
+		void ApplyShader(const PipelineDesc& desc);
+		void ApplyRaster(const PipelineDesc& desc, const PipelineDesc* previous);
+		void ApplyVertexBuffer(Layout& layout);
+	};
+}
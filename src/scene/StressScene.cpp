@@ -0,0 +1,279 @@
+#include "StressScene.h"
+#include "../profiling/Profiler.h"
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace scene {
+
+	// bounding sphere of the unit cube the objects are drawn with
+	static const float kCubeRadius = 0.8660254f;
+	static const int kTextureSize = 64;
+	static const int kTextureCell = 8;
+
+	// splitmix64
+	class Random {
+	public:
+		explicit Random(uint64_t seed)
+			: state(seed) { }
+
+		uint64_t Next() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+		// in [0, 1), from the top 24 bits so every value is exact
+		float NextFloat() {
+			return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+		}
+		float Range(float low, float high) {
+			return low + (high - low) * NextFloat();
+		}
+		// in [0, count)
+		uint32_t Below(uint32_t count) {
+			return static_cast<uint32_t>((Next() >> 32) * count >> 32);
+		}
+		glm::vec3 Direction() {
+			glm::vec3 direction{ Range(-1.0f, 1.0f), Range(-1.0f, 1.0f), Range(-1.0f, 1.0f) };
+			float length = glm::length(direction);
+			return length > 1e-3f ? direction / length : glm::vec3{ 0.0f, 1.0f, 0.0f };
+		}
+
+	private:
+		uint64_t state;
+	};
+
+	StressScene::StressScene(const StressSceneOptions& options)
+		: options(options) {
+		this->options.materialCount = std::clamp<uint32_t>(this->options.materialCount, 1, 65536);
+		this->options.textureCount = std::max<uint32_t>(this->options.textureCount, 1);
+		uint64_t begin = profiling::Now();
+		Generate();
+		stats.generateMs = profiling::TicksToMs(profiling::Now() - begin);
+	}
+
+	StressScene::~StressScene() {
+		if (!textures.empty()) {
+			glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+		}
+	}
+
+	void StressScene::Generate() {
+		PROFILE_SCOPE("StressScene::Generate");
+		size_t count = options.objectCount;
+		parents.resize(count);
+		positions.resize(count);
+		axes.resize(count);
+		angles.resize(count);
+		scales.resize(count);
+		materialIndices.resize(count);
+		worldMatrices.resize(count);
+		boundingRadii.resize(count);
+		dirty.assign(count, 1);
+		visible.reserve(count);
+		drawList.reserve(count);
+		materialOffsets.resize(options.materialCount + 1);
+
+		Random random{ options.seed };
+		// roots fill a cube that grows with their number, so their density stays the same
+		float expectedRoots = std::max(1.0f, static_cast<float>(count) * (1.0f - options.childFraction));
+		float extent = options.spacing * std::cbrt(expectedRoots);
+		std::vector<uint8_t> depths(count);
+		for (size_t i = 0; i < count; i++) {
+			int32_t parent = -1;
+			if (i > 0 && options.maxDepth > 0 && random.NextFloat() < options.childFraction) {
+				parent = static_cast<int32_t>(random.Below(static_cast<uint32_t>(i)));
+				// too deep already, so it goes next to the object instead of below it
+				while (parent >= 0 && depths[parent] >= options.maxDepth) {
+					parent = parents[parent];
+				}
+			}
+			parents[i] = parent;
+			if (parent >= 0) {
+				depths[i] = depths[parent] + 1;
+				positions[i] = random.Direction() * random.Range(0.6f, 1.2f);
+				scales[i] = random.Range(0.3f, 0.8f);
+				boundingRadii[i] = boundingRadii[parent] * scales[i];
+			}
+			else {
+				depths[i] = 0;
+				positions[i] = glm::vec3{ random.Range(-0.5f, 0.5f), random.Range(-0.5f, 0.5f), random.Range(-0.5f, 0.5f) } * extent;
+				scales[i] = random.Range(0.2f, 0.6f);
+				boundingRadii[i] = kCubeRadius * scales[i];
+				stats.roots++;
+			}
+			stats.depth = std::max<uint32_t>(stats.depth, depths[i]);
+			axes[i] = random.Direction();
+			angles[i] = random.Range(0.0f, glm::two_pi<float>());
+			materialIndices[i] = static_cast<uint16_t>(random.Below(options.materialCount));
+
+			if (random.NextFloat() < options.moverFraction) {
+				Mover mover{ static_cast<uint32_t>(i), static_cast<MoverKind>(random.Below(3)), random.Range(0.5f, 2.0f),
+					random.Range(0.0f, glm::two_pi<float>()), random.Range(0.1f, 0.5f), positions[i], angles[i] };
+				movers.push_back(mover);
+			}
+		}
+		stats.objects = count;
+		stats.movers = movers.size();
+
+		CreateTextures(random.Next());
+		materials.resize(options.materialCount);
+		for (StressMaterial& material : materials) {
+			material.texture0 = textures[random.Below(options.textureCount)];
+			material.texture1 = textures[random.Below(options.textureCount)];
+			material.mix = random.Range(0.2f, 0.8f);
+		}
+
+		Update(0.0f);
+	}
+
+	// checkerboards of two colors, with see-through cells in every other one for the ALPHA_TEST variant
+	void StressScene::CreateTextures(uint64_t seed) {
+		Random random{ seed };
+		std::vector<unsigned char> pixels(kTextureSize * kTextureSize * 4);
+		textures.resize(options.textureCount);
+		glGenTextures(static_cast<GLsizei>(textures.size()), textures.data());
+		for (size_t t = 0; t < textures.size(); t++) {
+			unsigned char colors[2][4];
+			for (auto& color : colors) {
+				for (int c = 0; c < 3; c++) {
+					color[c] = static_cast<unsigned char>(random.Below(256));
+				}
+				color[3] = 255;
+			}
+			if (t % 2 == 1) {
+				colors[1][3] = 0;
+			}
+			for (int y = 0; y < kTextureSize; y++) {
+				for (int x = 0; x < kTextureSize; x++) {
+					const unsigned char* color = colors[(x / kTextureCell + y / kTextureCell) % 2];
+					std::copy(color, color + 4, pixels.data() + (static_cast<size_t>(y) * kTextureSize + x) * 4);
+				}
+			}
+			glBindTexture(GL_TEXTURE_2D, textures[t]);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, kTextureSize, kTextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	glm::mat4 StressScene::GetLocalMatrix(uint32_t object) const {
+		glm::mat4 local = glm::rotate(glm::mat4{ 1.0f }, angles[object], axes[object]);
+		local[0] *= scales[object];
+		local[1] *= scales[object];
+		local[2] *= scales[object];
+		local[3] = glm::vec4{ positions[object], 1.0f };
+		return local;
+	}
+
+	void StressScene::Update(float time) {
+		PROFILE_SCOPE("StressScene::Update");
+		for (const Mover& mover : movers) {
+			float phase = mover.speed * time + mover.phase;
+			switch (mover.kind) {
+			case MoverKind::Spin:
+				angles[mover.object] = mover.baseAngle + mover.speed * time;
+				break;
+			case MoverKind::Orbit:
+				positions[mover.object] = mover.basePosition + mover.amplitude * glm::vec3{ std::cos(phase), 0.0f, std::sin(phase) };
+				break;
+			case MoverKind::Bob:
+				positions[mover.object] = mover.basePosition + glm::vec3{ 0.0f, mover.amplitude * std::sin(phase), 0.0f };
+				break;
+			}
+			dirty[mover.object] = 1;
+		}
+
+		// parents come first, so their world matrix is already up to date when a child needs it
+		size_t updated = 0;
+		for (size_t i = 0; i < parents.size(); i++) {
+			int32_t parent = parents[i];
+			if (parent >= 0 && dirty[parent]) {
+				dirty[i] = 1;
+			}
+			if (!dirty[i]) {
+				continue;
+			}
+			uint32_t object = static_cast<uint32_t>(i);
+			worldMatrices[i] = parent >= 0 ? worldMatrices[parent] * GetLocalMatrix(object) : GetLocalMatrix(object);
+			updated++;
+		}
+		std::fill(dirty.begin(), dirty.end(), static_cast<uint8_t>(0));
+		stats.updated = updated;
+	}
+
+	void StressScene::Cull(const glm::mat4& viewProjection) {
+		PROFILE_SCOPE("StressScene::Cull");
+		// the planes of the frustum, pointing inwards, from the rows of the matrix
+		glm::vec4 planes[6];
+		for (int row = 0; row < 3; row++) {
+			glm::vec4 rowVector{ viewProjection[0][row], viewProjection[1][row], viewProjection[2][row], viewProjection[3][row] };
+			glm::vec4 wRow{ viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+			planes[row * 2] = wRow + rowVector;
+			planes[row * 2 + 1] = wRow - rowVector;
+		}
+		for (glm::vec4& plane : planes) {
+			plane /= glm::length(glm::vec3{ plane });
+		}
+
+		visible.clear();
+		std::fill(materialOffsets.begin(), materialOffsets.end(), 0u);
+		for (size_t i = 0; i < worldMatrices.size(); i++) {
+			glm::vec3 center{ worldMatrices[i][3] };
+			float radius = boundingRadii[i];
+			bool inside = true;
+			for (const glm::vec4& plane : planes) {
+				if (glm::dot(glm::vec3{ plane }, center) + plane.w < -radius) {
+					inside = false;
+					break;
+				}
+			}
+			if (inside) {
+				visible.push_back(static_cast<uint32_t>(i));
+				materialOffsets[materialIndices[i] + 1]++;
+			}
+		}
+
+		// counting sort by material, which keeps the objects of a material in order
+		stats.materialRuns = 0;
+		for (size_t m = 1; m < materialOffsets.size(); m++) {
+			stats.materialRuns += materialOffsets[m] > 0 ? 1 : 0;
+			materialOffsets[m] += materialOffsets[m - 1];
+		}
+		drawList.resize(visible.size());
+		for (uint32_t object : visible) {
+			drawList[materialOffsets[materialIndices[object]]++] = object;
+		}
+		stats.visible = drawList.size();
+	}
+
+	const std::vector<uint32_t>& StressScene::GetDrawList() const {
+		return drawList;
+	}
+
+	const glm::mat4& StressScene::GetWorldMatrix(uint32_t object) const {
+		return worldMatrices[object];
+	}
+
+	uint32_t StressScene::GetMaterialIndex(uint32_t object) const {
+		return materialIndices[object];
+	}
+
+	const StressMaterial& StressScene::GetMaterial(uint32_t material) const {
+		return materials[material];
+	}
+
+	const StressSceneOptions& StressScene::GetOptions() const {
+		return options;
+	}
+
+	const StressSceneStats& StressScene::GetStats() const {
+		return stats;
+	}
+}
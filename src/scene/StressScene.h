@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace scene {
+
+	struct StressSceneOptions {
+		// the same seed and options give the same scene, on every platform
+		uint32_t seed = 1;
+		size_t objectCount = 1000;
+		// share of the objects attached to an earlier object instead of placed in the world
+		float childFraction = 0.3f;
+		// levels below a root object, 0 for no hierarchy at all
+		uint32_t maxDepth = 3;
+		// share of the objects that spin, orbit or bob, taking their children with them
+		float moverFraction = 0.2f;
+		uint32_t materialCount = 16;
+		// small generated textures the materials pick from
+		uint32_t textureCount = 8;
+		// between neighbouring root objects, on average
+		float spacing = 1.5f;
+	};
+
+	struct StressSceneStats {
+		size_t objects = 0;
+		size_t roots = 0;
+		size_t movers = 0;
+		uint32_t depth = 0;
+		// world matrices rebuilt by the last Update
+		size_t updated = 0;
+		// in the draw list after the last Cull
+		size_t visible = 0;
+		// material changes along the draw list, each one rebinds textures
+		size_t materialRuns = 0;
+		double generateMs = 0.0;
+	};
+
+	struct StressMaterial {
+		unsigned int texture0;
+		unsigned int texture1;
+		// of texture1 over texture0, with the TEXTURE_MIX variant
+		float mix;
+	};
+
+	/*
+	 * A seeded crowd of cubes for finding out how updates, culling and draw
+	 * submission scale, from a thousand objects to a million.
+	 *
+	 * Objects are kept as arrays, parents before their children, so one
+	 * pass in order rebuilds every world matrix that changed: a mover's, and
+	 * those of everything below it. Culling tests each object's bounding
+	 * sphere against the frustum and sorts what's left by material, so
+	 * drawing binds each material's textures once.
+	 *
+	 * Random numbers come from splitmix64 rather than <random>, whose
+	 * distributions differ between standard libraries. The textures are
+	 * created in the constructor, so it needs the GL context current.
+	 */
+	class StressScene {
+	public:
+		explicit StressScene(const StressSceneOptions& options);
+		~StressScene();
+		StressScene(const StressScene&) = delete;
+		StressScene& operator=(const StressScene&) = delete;
+
+		// moves the movers to where they are at time, in seconds, and rebuilds the world matrices that changed
+		void Update(float time);
+		// keeps the objects in view of viewProjection, grouped by material
+		void Cull(const glm::mat4& viewProjection);
+
+		// object indices from the last Cull
+		const std::vector<uint32_t>& GetDrawList() const;
+		const glm::mat4& GetWorldMatrix(uint32_t object) const;
+		uint32_t GetMaterialIndex(uint32_t object) const;
+		const StressMaterial& GetMaterial(uint32_t material) const;
+		const StressSceneOptions& GetOptions() const;
+		const StressSceneStats& GetStats() const;
+
+	private:
+		enum class MoverKind : uint8_t {
+			Spin,
+			Orbit,
+			Bob
+		};
+		struct Mover {
+			uint32_t object;
+			MoverKind kind;
+			// radians per second
+			float speed;
+			float phase;
+			// of the orbit or bob
+			float amplitude;
+			glm::vec3 basePosition;
+			float baseAngle;
+		};
+
+		StressSceneOptions options;
+		StressSceneStats stats{ };
+
+		// local to the parent, or to the world for roots
+		std::vector<int32_t> parents{ };
+		std::vector<glm::vec3> positions{ };
+		std::vector<glm::vec3> axes{ };
+		std::vector<float> angles{ };
+		std::vector<float> scales{ };
+		std::vector<uint16_t> materialIndices{ };
+		std::vector<glm::mat4> worldMatrices{ };
+		// of the unit cube, scaled by the object's and its parents' scales
+		std::vector<float> boundingRadii{ };
+		std::vector<uint8_t> dirty{ };
+		std::vector<Mover> movers{ };
+
+		std::vector<unsigned int> textures{ };
+		std::vector<StressMaterial> materials{ };
+
+		std::vector<uint32_t> visible{ };
+		std::vector<uint32_t> drawList{ };
+		// objects per material during Cull, then where each material starts in the draw list
+		std::vector<uint32_t> materialOffsets{ };
+
+		void Generate();
+		void CreateTextures(uint64_t seed);
+		glm::mat4 GetLocalMatrix(uint32_t object) const;
+	};
+}
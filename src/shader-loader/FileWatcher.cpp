@@ -0,0 +1,102 @@
+#include "FileWatcher.h"
+#include "../vfs/FileSystem.h"
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() {
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0) {
+		std::cerr << "inotify_init1 failed, file changes won't be noticed: " << std::strerror(errno) << std::endl;
+	}
+}
+
+FileWatcher::~FileWatcher() {
+	if (inotifyFd >= 0) {
+		close(inotifyFd);
+	}
+}
+
+void FileWatcher::Watch(const std::string& path) {
+	std::string normalized = vfs::FileSystem::NormalizePath(path);
+	if (!files.emplace(normalized, path).second || inotifyFd < 0) {
+		return;
+	}
+	std::string directory = std::filesystem::path(normalized).parent_path().generic_string();
+	// watching a directory twice hands back the same descriptor, so this just refreshes the map entry
+	int wd = inotify_add_watch(inotifyFd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd < 0) {
+		std::cerr << "Can't watch " << directory << ": " << std::strerror(errno) << std::endl;
+		return;
+	}
+	directories[wd] = directory;
+}
+
+std::vector<std::string> FileWatcher::Poll() {
+	std::vector<std::string> changed{ };
+	if (inotifyFd < 0) {
+		return changed;
+	}
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			// EAGAIN once the queue is drained
+			break;
+		}
+		for (char* p = buffer; p < buffer + length; ) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+			p += sizeof(inotify_event) + event->len;
+			auto directory = directories.find(event->wd);
+			if (event->len == 0 || directory == directories.end()) {
+				continue;
+			}
+			auto file = files.find((std::filesystem::path(directory->second) / event->name).generic_string());
+			if (file != files.end() && std::find(changed.begin(), changed.end(), file->second) == changed.end()) {
+				changed.push_back(file->second);
+			}
+		}
+	}
+	return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() = default;
+FileWatcher::~FileWatcher() = default;
+
+void FileWatcher::Watch(const std::string& path) {
+	std::string normalized = vfs::FileSystem::NormalizePath(path);
+	if (files.emplace(normalized, path).second) {
+		std::error_code error;
+		writeTimes[normalized] = std::filesystem::last_write_time(normalized, error);
+	}
+}
+
+std::vector<std::string> FileWatcher::Poll() {
+	std::vector<std::string> changed{ };
+	auto now = std::chrono::steady_clock::now();
+	if (now - lastScan < std::chrono::milliseconds(250)) {
+		return changed;
+	}
+	lastScan = now;
+	for (auto& [normalized, writeTime] : writeTimes) {
+		std::error_code error;
+		auto current = std::filesystem::last_write_time(normalized, error);
+		// a file that's missing for a moment is probably being replaced, wait for it to come back
+		if (!error && current != writeTime) {
+			writeTime = current;
+			changed.push_back(files[normalized]);
+		}
+	}
+	return changed;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Reports watched files that changed on disk.
+ *
+ * On Linux this is inotify on each file's directory rather than on the file
+ * itself, because most editors save by writing a new file and renaming it
+ * over the old one, which would silently end a per-file watch. Elsewhere the
+ * modification times are compared a few times per second.
+ */
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	void Watch(const std::string& path);
+	// never blocks; every changed file is returned once, spelled the way it was passed to Watch
+	std::vector<std::string> Poll();
+
+private:
+	// path normalized like the VFS does -> path as passed to Watch
+	std::unordered_map<std::string, std::string> files{ };
+#ifdef __linux__
+	int inotifyFd = -1;
+	// inotify watch descriptor -> directory it watches, normalized, empty for the working directory
+	std::unordered_map<int, std::string> directories{ };
+#else
+	std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes{ };
+	std::chrono::steady_clock::time_point lastScan{ };
+#endif
+};
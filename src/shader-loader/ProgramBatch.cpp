@@ -0,0 +1,124 @@
+#include "ProgramBatch.h"
+#include "ShaderLoader.h"
+#include "../gl/GLExtensions.h"
+#include <iostream>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+ProgramBatch::ProgramBatch(int programsPerPoll) : programsPerPoll(programsPerPoll > 0 ? programsPerPoll : 1) {
+	parallel = gl_ext::SupportsParallelShaderCompile();
+	if (parallel) {
+		// all ones lets the driver pick how many threads it wants
+		gl_ext::MaxShaderCompilerThreads(0xFFFFFFFF);
+	}
+}
+
+ProgramBatch::~ProgramBatch() {
+	// programs still in flight or never taken would leak otherwise
+	for (Build& build : builds) {
+		if (build.started && !build.taken) {
+			glDeleteProgram(build.program);
+		}
+	}
+}
+
+ProgramBatch::Ticket ProgramBatch::Submit(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary) {
+	if (pending.empty()) {
+		// a new wave, the report covers this one only
+		firstSubmit = Clock::now();
+		succeeded = 0;
+		failed = 0;
+	}
+	Ticket ticket = builds.size();
+	builds.push_back(Build{ vertShader, fragShader, retrievableBinary });
+	pending.push_back(ticket);
+	if (parallel) {
+		Build& build = builds.back();
+		build.program = ShaderLoader::StartShaderProgram(build.vertShader, build.fragShader, retrievableBinary);
+		build.started = true;
+		// the driver has its own copy now
+		build.vertShader.clear();
+		build.fragShader.clear();
+	}
+	return ticket;
+}
+
+bool ProgramBatch::Poll() {
+	if (pending.empty()) {
+		return true;
+	}
+	int started = 0;
+	for (auto it = pending.begin(); it != pending.end(); ) {
+		Build& build = builds[*it];
+		if (!build.started) {
+			if (started == programsPerPoll) {
+				// staggered builds go in submit order, so everything after this one is queued too
+				break;
+			}
+			build.program = ShaderLoader::StartShaderProgram(build.vertShader, build.fragShader, build.retrievableBinary);
+			build.started = true;
+			build.vertShader.clear();
+			build.fragShader.clear();
+			started++;
+		}
+		else if (!ShaderLoader::IsShaderProgramDone(build.program)) {
+			++it;
+			continue;
+		}
+		build.program = ShaderLoader::FinishShaderProgram(build.program, &build.log);
+		build.done = true;
+		(build.program != 0 ? succeeded : failed)++;
+		it = pending.erase(it);
+	}
+	if (pending.empty()) {
+		wallMs = std::chrono::duration<double, std::milli>(Clock::now() - firstSubmit).count();
+		return true;
+	}
+	return false;
+}
+
+void ProgramBatch::Finish() {
+	while (!Poll()) {
+		// the driver threads need a moment, spinning on the status only steals time from them
+		std::this_thread::yield();
+	}
+}
+
+bool ProgramBatch::IsParallel() const {
+	return parallel;
+}
+
+bool ProgramBatch::IsDone(Ticket ticket) const {
+	return builds[ticket].done;
+}
+
+unsigned int ProgramBatch::TakeProgram(Ticket ticket) {
+	Build& build = builds[ticket];
+	if (!build.done || build.taken) {
+		return 0;
+	}
+	build.taken = true;
+	return build.program;
+}
+
+const std::string& ProgramBatch::GetLog(Ticket ticket) const {
+	return builds[ticket].log;
+}
+
+size_t ProgramBatch::GetPendingCount() const {
+	return pending.size();
+}
+
+double ProgramBatch::GetWallMs() const {
+	return wallMs;
+}
+
+void ProgramBatch::PrintReport() const {
+	std::cout << "Built " << succeeded + failed << " shader programs in " << wallMs << " ms wall clock ("
+		<< (parallel ? "parallel driver compile" : "staggered, " + std::to_string(programsPerPoll) + " per poll") << ")";
+	if (failed > 0) {
+		std::cout << ", " << failed << " failed";
+	}
+	std::cout << std::endl;
+}
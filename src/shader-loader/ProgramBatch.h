@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+ * Builds many shader programs at once without stalling the frame.
+ *
+ * With KHR_parallel_shader_compile every submitted program is compiled and
+ * linked right away on the driver's threads, and Poll only looks at
+ * GL_COMPLETION_STATUS_KHR. Without it, Poll builds a few programs per call
+ * the ordinary blocking way, so the cost is spread over several frames.
+ * Either way the wall-clock time from the first submit to the last finished
+ * program is measured. Everything runs on the thread whose context is current.
+ */
+class ProgramBatch {
+public:
+	using Ticket = size_t;
+
+	// programsPerPoll only matters without the extension
+	explicit ProgramBatch(int programsPerPoll = 2);
+	~ProgramBatch();
+	ProgramBatch(const ProgramBatch&) = delete;
+	ProgramBatch& operator=(const ProgramBatch&) = delete;
+
+	// retrievableBinary as for ShaderLoader::CreateShaderProgram
+	Ticket Submit(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary = false);
+	// never blocks with the extension; returns true once nothing is pending
+	bool Poll();
+	// keeps polling until every program is done
+	void Finish();
+
+	bool IsParallel() const;
+	bool IsDone(Ticket ticket) const;
+	// hands over the finished program, 0 if it failed; the batch forgets about it
+	unsigned int TakeProgram(Ticket ticket);
+	const std::string& GetLog(Ticket ticket) const;
+	size_t GetPendingCount() const;
+	// from the first submit to the last finished program of the latest wave, i.e. since the batch last ran empty
+	double GetWallMs() const;
+	void PrintReport() const;
+
+private:
+	struct Build {
+		std::string vertShader;
+		std::string fragShader;
+		bool retrievableBinary;
+		// 0 while a staggered build is still queued
+		unsigned int program = 0;
+		bool started = false;
+		bool done = false;
+		bool taken = false;
+		std::string log{ };
+	};
+
+	bool parallel = false;
+	int programsPerPoll;
+	std::vector<Build> builds{ };
+	// tickets not done yet, in submit order
+	std::deque<Ticket> pending{ };
+	std::chrono::steady_clock::time_point firstSubmit{ };
+	double wallMs = 0.0;
+	size_t succeeded = 0;
+	size_t failed = 0;
+};
@@ -0,0 +1,291 @@
+#include "ProgramCache.h"
+#include "ShaderLoader.h"
+#include "../gl/GLExtensions.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static const char kMagic[4] = { 'L', 'O', 'P', 'B' };
+static const uint32_t kFileVersion = 1;
+
+struct BinaryHeader {
+	char magic[4];
+	uint32_t version;
+	// the full key, in case two keys ever land in the same file name
+	uint64_t key;
+	uint32_t binaryFormat;
+	uint32_t binaryLength;
+	float compileMs;
+	uint32_t reserved;
+};
+
+// 64-bit FNV-1a, chained over every part of the key
+static uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t HashString(uint64_t hash, const std::string& value) {
+	// the length keeps "ab" + "c" apart from "a" + "bc"
+	uint64_t length = value.size();
+	hash = HashBytes(hash, &length, sizeof(length));
+	return HashBytes(hash, value.data(), value.size());
+}
+
+static double MsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::string GetGLString(GLenum name) {
+	const GLubyte* value = glGetString(name);
+	return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+}
+
+ProgramCache::ProgramCache(const std::string& directory) : directory(directory) {
+	if (directory.empty()) {
+		return;
+	}
+	if (!gl_ext::SupportsProgramBinary()) {
+		std::cout << "Shader cache disabled: the driver can't save program binaries" << std::endl;
+		return;
+	}
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cerr << "Shader cache disabled: can't create " << directory << ": " << error.message() << std::endl;
+		return;
+	}
+	driverId = GetGLString(GL_VENDOR) + '\n' + GetGLString(GL_RENDERER) + '\n' + GetGLString(GL_VERSION);
+	enabled = true;
+}
+
+bool ProgramCache::IsEnabled() const {
+	return enabled;
+}
+
+const ProgramCacheStats& ProgramCache::GetStats() const {
+	return stats;
+}
+
+uint64_t ProgramCache::MakeKey(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines) const {
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashString(hash, driverId);
+	for (const std::string& define : defines) {
+		hash = HashString(hash, define);
+	}
+	hash = HashString(hash, vertShader);
+	return HashString(hash, fragShader);
+}
+
+uint64_t ProgramCache::MakeStageKey(unsigned int type, const std::string& source, const std::vector<std::string>& defines) const {
+	uint64_t hash = 14695981039346656037ull;
+	hash = HashString(hash, driverId);
+	// keeps a stage program apart from a two stage program whose other source happens to be empty
+	hash = HashString(hash, "separable");
+	hash = HashBytes(hash, &type, sizeof(type));
+	for (const std::string& define : defines) {
+		hash = HashString(hash, define);
+	}
+	return HashString(hash, source);
+}
+
+std::string ProgramCache::PathForKey(uint64_t key) const {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(directory) / name).string();
+}
+
+// closed first, as Windows can't delete a file that is still open
+static void RemoveEntry(std::ifstream& stream, const std::string& path) {
+	stream.close();
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
+
+unsigned int ProgramCache::LoadBinary(const std::string& path, uint64_t key, bool separable, float* compileMs) {
+	std::ifstream stream(path, std::ios_base::in | std::ios_base::binary);
+	if (!stream.is_open()) {
+		return 0;
+	}
+	BinaryHeader header{ };
+	stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!stream || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFileVersion || header.key != key) {
+		return 0;
+	}
+	// the length comes from the file, so it has to match what's left of it before anything is allocated for it
+	std::error_code sizeError;
+	uintmax_t fileSize = std::filesystem::file_size(path, sizeError);
+	if (sizeError || header.binaryLength == 0 || fileSize - sizeof(header) != header.binaryLength) {
+		stats.rejected++;
+		RemoveEntry(stream, path);
+		return 0;
+	}
+	std::vector<char> binary(header.binaryLength);
+	stream.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+	if (!stream) {
+		return 0;
+	}
+
+	unsigned int program = glCreateProgram();
+	if (separable) {
+		// not every driver keeps the flag in the binary, so it's set the same way as before linking
+		gl_ext::ProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+	}
+	gl_ext::ProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE) {
+		// an unknown format raises GL_INVALID_ENUM, don't leave it for the next glGetError
+		while (glGetError() != GL_NO_ERROR) {}
+		glDeleteProgram(program);
+		stats.rejected++;
+		RemoveEntry(stream, path);
+		return 0;
+	}
+	*compileMs = header.compileMs;
+	return program;
+}
+
+void ProgramCache::StoreBinary(unsigned int program, const std::string& path, uint64_t key, float compileMs) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLenum format = 0;
+	GLsizei written = 0;
+	gl_ext::GetProgramBinary(program, length, &written, &format, binary.data());
+	if (written <= 0) {
+		return;
+	}
+
+	BinaryHeader header{ };
+	std::memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kFileVersion;
+	header.key = key;
+	header.binaryFormat = format;
+	header.binaryLength = static_cast<uint32_t>(written);
+	header.compileMs = compileMs;
+
+	// written under a temporary name so a crash never leaves a truncated entry behind
+	std::string tempPath = path + ".tmp";
+	{
+		std::ofstream stream(tempPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(binary.data(), written);
+		if (!stream) {
+			std::cerr << "Failed to write shader cache entry " << tempPath << std::endl;
+			return;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+	if (error) {
+		std::cerr << "Failed to store shader cache entry " << path << ": " << error.message() << std::endl;
+		std::filesystem::remove(tempPath, error);
+	}
+}
+
+unsigned int ProgramCache::Load(uint64_t key, bool separable) {
+	auto start = Clock::now();
+	float compileMs = 0.0f;
+	unsigned int program = LoadBinary(PathForKey(key), key, separable, &compileMs);
+	if (program != 0) {
+		stats.hits++;
+		stats.hitMs += MsSince(start);
+		stats.hitCompileMs += compileMs;
+	}
+	return program;
+}
+
+void ProgramCache::Store(unsigned int program, uint64_t key, double compileMs) {
+	stats.misses++;
+	stats.missMs += compileMs;
+	if (program != 0) {
+		StoreBinary(program, PathForKey(key), key, static_cast<float>(compileMs));
+	}
+}
+
+unsigned int ProgramCache::LoadShaderProgram(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines) {
+	if (!enabled) {
+		return 0;
+	}
+	return Load(MakeKey(vertShader, fragShader, defines), false);
+}
+
+void ProgramCache::StoreShaderProgram(unsigned int program, const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines, double compileMs) {
+	if (!enabled) {
+		return;
+	}
+	Store(program, MakeKey(vertShader, fragShader, defines), compileMs);
+}
+
+unsigned int ProgramCache::CreateShaderProgram(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines) {
+	if (!enabled) {
+		return ShaderLoader::CreateShaderProgram(vertShader, fragShader);
+	}
+
+	auto start = Clock::now();
+	unsigned int program = LoadShaderProgram(vertShader, fragShader, defines);
+	if (program != 0) {
+		return program;
+	}
+	program = ShaderLoader::CreateShaderProgram(vertShader, fragShader, true);
+	StoreShaderProgram(program, vertShader, fragShader, defines, MsSince(start));
+	return program;
+}
+
+unsigned int ProgramCache::LoadStageProgram(unsigned int type, const std::string& source, const std::vector<std::string>& defines) {
+	if (!enabled) {
+		return 0;
+	}
+	return Load(MakeStageKey(type, source, defines), true);
+}
+
+void ProgramCache::StoreStageProgram(unsigned int program, unsigned int type, const std::string& source, const std::vector<std::string>& defines, double compileMs) {
+	if (!enabled) {
+		return;
+	}
+	Store(program, MakeStageKey(type, source, defines), compileMs);
+}
+
+unsigned int ProgramCache::CreateStageProgram(unsigned int type, const std::string& source, const std::vector<std::string>& defines) {
+	if (!enabled) {
+		return ShaderLoader::CreateStageProgram(type, source);
+	}
+
+	auto start = Clock::now();
+	unsigned int program = LoadStageProgram(type, source, defines);
+	if (program != 0) {
+		return program;
+	}
+	program = ShaderLoader::CreateStageProgram(type, source, true);
+	StoreStageProgram(program, type, source, defines, MsSince(start));
+	return program;
+}
+
+void ProgramCache::PrintStats() const {
+	if (!enabled) {
+		return;
+	}
+	int total = stats.hits + stats.misses;
+	std::cout << "Shader cache: " << stats.hits << "/" << total << " programs from cache ("
+		<< (total > 0 ? 100 * stats.hits / total : 0) << "%), " << stats.rejected << " rejected" << std::endl;
+	if (stats.hits > 0) {
+		std::cout << "  cached programs loaded in " << stats.hitMs << " ms, saving about "
+			<< stats.hitCompileMs - stats.hitMs << " ms of compiling" << std::endl;
+	}
+	if (stats.misses > 0) {
+		std::cout << "  " << stats.misses << " programs compiled from source in " << stats.missMs << " ms" << std::endl;
+	}
+}
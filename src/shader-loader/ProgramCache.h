@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ProgramCacheStats {
+	int hits = 0;
+	int misses = 0;
+	// binaries the driver refused, usually after a driver update, and truncated entries; those programs count as misses too
+	int rejected = 0;
+	double hitMs = 0.0;
+	double missMs = 0.0;
+	// what the programs loaded from the cache took to compile when they were stored
+	double hitCompileMs = 0.0;
+};
+
+/*
+ * On-disk cache of linked shader programs, stored through glGetProgramBinary.
+ *
+ * Entries are keyed by a hash of the GL vendor, renderer and version strings,
+ * the defines and the final sources, so a driver update or an edited shader
+ * simply misses and gets compiled again. A binary the driver rejects is
+ * deleted and replaced by a fresh one built from source.
+ */
+class ProgramCache {
+public:
+	// an empty directory, or a context without program binary support, turns the cache into a pass-through
+	explicit ProgramCache(const std::string& directory);
+
+	// same contract as ShaderLoader::CreateShaderProgram; defines are whatever the sources were preprocessed with
+	unsigned int CreateShaderProgram(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines = {});
+	// the cached program for these sources, or 0 without touching the miss count
+	unsigned int LoadShaderProgram(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines = {});
+	// for programs compiled elsewhere, with retrievableBinary set; counts as a miss
+	void StoreShaderProgram(unsigned int program, const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines, double compileMs);
+	// the same three for separable single stage programs, see ShaderLoader::CreateStageProgram
+	unsigned int CreateStageProgram(unsigned int type, const std::string& source, const std::vector<std::string>& defines = {});
+	unsigned int LoadStageProgram(unsigned int type, const std::string& source, const std::vector<std::string>& defines = {});
+	void StoreStageProgram(unsigned int program, unsigned int type, const std::string& source, const std::vector<std::string>& defines, double compileMs);
+	bool IsEnabled() const;
+	const ProgramCacheStats& GetStats() const;
+	void PrintStats() const;
+
+private:
+	std::string directory;
+	// vendor, renderer and version of the current context
+	std::string driverId;
+	bool enabled = false;
+	ProgramCacheStats stats{ };
+
+	uint64_t MakeKey(const std::string& vertShader, const std::string& fragShader, const std::vector<std::string>& defines) const;
+	uint64_t MakeStageKey(unsigned int type, const std::string& source, const std::vector<std::string>& defines) const;
+	std::string PathForKey(uint64_t key) const;
+	unsigned int Load(uint64_t key, bool separable);
+	void Store(unsigned int program, uint64_t key, double compileMs);
+	unsigned int LoadBinary(const std::string& path, uint64_t key, bool separable, float* compileMs);
+	void StoreBinary(unsigned int program, const std::string& path, uint64_t key, float compileMs);
+};
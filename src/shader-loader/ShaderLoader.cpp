@@ -1,79 +1,95 @@
 #include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
+#include "../gl/GLExtensions.h"
+#include "../vfs/FileSystem.h"
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <vector>
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
-#include <errno.h>
 
 ShaderLoader::ShaderSources ShaderLoader::ParseCombinedShaderSource(const std::string& filepath) {
-	std::ifstream stream(filepath);
-	std::string line;
-    std::stringstream stringStreams[2];
-
+    vfs::FileData file = vfs::FileSystem::Shared().Read(filepath);
+    if (!file) {
+        std::cerr << "Error opening file at " << filepath << std::endl;
+    }
+    std::string sources[2];
     ShaderType type = ShaderType::NONE;
 
-    stream.open(filepath, std::ios_base::in);
-    if (!stream.is_open()) {
-        std::cerr << "Error opening file at " << filepath;
-        perror(" ");
-    }
-    while (getline(stream, line)) {
+    std::string_view text = file.GetText();
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
         // if we find #shader, determine what kind it is
-        if (line.find("#shader") != std::string::npos) {
-            if (line.find("vertex") != std::string::npos) {
+        if (line.find("#shader") != std::string_view::npos) {
+            if (line.find("vertex") != std::string_view::npos) {
                 type = ShaderType::VERTEX;
-            } else if (line.find("fragment") != std::string::npos) {
+            } else if (line.find("fragment") != std::string_view::npos) {
                 type = ShaderType::FRAGMENT;
             }
         } else {
             // add to appropriate shader
             if ((int)type > -1) {
-                stringStreams[(int)type] << line << '\n';
+                sources[(int)type].append(line).push_back('\n');
             }
         }
     }
-    if (stream.bad()) {
-        std::cerr << "Error while reading file at " << filepath;
-        perror(" ");
-    }
 
-    return { stringStreams[(int) ShaderType::VERTEX].str(), stringStreams[(int)ShaderType::FRAGMENT].str() };
+    return { std::move(sources[(int)ShaderType::VERTEX]), std::move(sources[(int)ShaderType::FRAGMENT]) };
 }
 
 ShaderLoader::ShaderSources ShaderLoader::ParseShaderSources(const std::string& vertFilepath, const std::string& fragFilepath) {
     return { ReadShaderSource(vertFilepath), ReadShaderSource(fragFilepath) };
 }
 
+// the stage's files go into the legend and the list of files to watch
+static void AddStageFiles(ShaderLoader::ShaderSources& sources, const PreprocessedShader& stage, const char* label) {
+    sources.sourceLegend += label;
+    for (size_t i = 0; i < stage.files.size(); i++) {
+        sources.sourceLegend += " " + std::to_string(i) + " = " + stage.files[i] + (i + 1 < stage.files.size() ? "," : "\n");
+    }
+    // missing includes are watched too, so creating one triggers a rebuild
+    for (const std::vector<std::string>* files : { &stage.files, &stage.missingFiles }) {
+        for (const std::string& file : *files) {
+            if (std::find(sources.files.begin(), sources.files.end(), file) == sources.files.end()) {
+                sources.files.push_back(file);
+            }
+        }
+    }
+}
+
+ShaderLoader::ShaderSources ShaderLoader::PreprocessShaderSources(ShaderPreprocessor& preprocessor, const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<std::string>& defines) {
+    PreprocessedShader vert = preprocessor.Process(vertFilepath, defines);
+    PreprocessedShader frag = preprocessor.Process(fragFilepath, defines);
+
+    ShaderSources sources{ std::move(vert.source), std::move(frag.source) };
+    AddStageFiles(sources, vert, "vertex shader sources:");
+    AddStageFiles(sources, frag, "fragment shader sources:");
+    return sources;
+}
+
+ShaderLoader::ShaderSources ShaderLoader::PreprocessStageSource(ShaderPreprocessor& preprocessor, unsigned int type, const std::string& filepath, const std::vector<std::string>& defines) {
+    PreprocessedShader stage = preprocessor.Process(filepath, defines);
+
+    ShaderSources sources{ };
+    AddStageFiles(sources, stage, type == GL_VERTEX_SHADER ? "vertex shader sources:" : "fragment shader sources:");
+    (type == GL_VERTEX_SHADER ? sources.vertShaderSrc : sources.fragShaderSrc) = std::move(stage.source);
+    return sources;
+}
+
 std::string ShaderLoader::ReadShaderSource(const std::string& filepath) {
-    std::ifstream stream;
-    std::string line;
-    std::stringstream stringStream;
-
-    // todo: find out best way to read in text file
-    // ref: https://stackoverflow.com/questions/34464705/rdbuf-vs-getline-vs
-    // article on ifstream error detection : https://gehrcke.de/2011/06/reading-files-in-c-using-ifstream-dealing-correctly-with-badbit-failbit-eofbit-and-perror/
-    stream.open(filepath, std::ios_base::in);
-    if (!stream.is_open()) {
-        std::cerr << "Error opening file at " << filepath;
-        perror(" ");
-    }
-    while (getline(stream, line)) {
-        stringStream << line << '\n';
-    }
-    // failbit can be set by getline if it cannot extract data
-    // this can often happen if the last char in a file is a lin delimiter
-    // only when bad bit is set will errno be updated and we know there's an exception
-    if (stream.bad()) {
-        std::string errorBuffer;
-        //size_t buffSize = strerrorlen_s();
-        // strerror is not threadsafe, but can't use strerror_s:
-        // msvc seems to be missing strerrorlen_s
-        std::cerr << "Error while reading file at " << filepath;
-        perror(" ");
-    }
-    //stream.close(); // not needed, destructor will call this automatically
-    return stringStream.str();
+    // a loose file or a pack entry, depending on what is mounted
+    vfs::FileData file = vfs::FileSystem::Shared().Read(filepath);
+    if (!file) {
+        std::cerr << "Error opening file at " << filepath << std::endl;
+        return "";
+    }
+    std::string source(file.GetText());
+    if (!source.empty() && source.back() != '\n') {
+        source.push_back('\n');
+    }
+    return source;
 }
 
 std::string ShaderLoader::TypeToName(unsigned int type) {
@@ -87,45 +103,83 @@ std::string ShaderLoader::TypeToName(unsigned int type) {
     }
 }
 
-unsigned int ShaderLoader::CompileShader(unsigned int type, const std::string& source) {
+void ShaderLoader::ReportError(std::string* errorLog, const std::string& message) {
+    if (errorLog != nullptr) {
+        errorLog->append(message);
+        errorLog->push_back('\n');
+    }
+    else {
+        std::cout << message << std::endl;
+    }
+}
+
+// the info logs, sized by GL_INFO_LOG_LENGTH, which counts the terminating null
+static std::string GetShaderLog(unsigned int shader) {
+    int length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(std::max(length, 1), '\0');
+    glGetShaderInfoLog(shader, static_cast<GLsizei>(log.size()), nullptr, log.data());
+    return log.data();
+}
+
+static std::string GetProgramLog(unsigned int program) {
+    int length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(std::max(length, 1), '\0');
+    glGetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr, log.data());
+    return log.data();
+}
+
+// some drivers report no log length for pipelines at all, hence the room for at least the null
+static std::string GetPipelineLog(unsigned int pipeline) {
+    int length = 0;
+    gl_ext::GetProgramPipelineiv(pipeline, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> log(std::max(length, 1), '\0');
+    gl_ext::GetProgramPipelineInfoLog(pipeline, static_cast<GLsizei>(log.size()), nullptr, log.data());
+    return log.data();
+}
+
+unsigned int ShaderLoader::CompileShader(unsigned int type, const std::string& source, std::string* errorLog) {
     unsigned int id = glCreateShader(type);
     const char* src = source.c_str();
     glShaderSource(id, 1, &src, NULL); // returns a non-zero reference ID for the shader
     glCompileShader(id);
 
-    // check if compilation had any errors
-    int success;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-    if (success == GL_FALSE) {
-        int msgLen;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &msgLen);
-        GLchar* msg = (GLchar*)_malloca(msgLen * sizeof(GLchar));
-
-        glGetShaderInfoLog(id, msgLen, &msgLen, msg);
-        std::cout << "Failed to compile " << (TypeToName(type)) << "! " << msg << std::endl;
-
+    if (!CheckShader(id, type, errorLog)) {
         // cleanup failed shader compile
         glDeleteShader(id);
-        
-        _freea(msg);
         return 0;
     }
 
     return id;
 }
 
-unsigned int ShaderLoader::CreateShaderProgram(const std::string& vertShader, const std::string& fragShader) {
+bool ShaderLoader::CheckShader(unsigned int id, unsigned int type, std::string* errorLog) {
+    // check if compilation had any errors
+    int success;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &success);
+    if (success == GL_FALSE) {
+        ReportError(errorLog, "Failed to compile " + TypeToName(type) + "! " + GetShaderLog(id));
+        return false;
+    }
+    return true;
+}
+
+unsigned int ShaderLoader::CreateShaderProgram(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary, std::string* errorLog) {
     unsigned int program = glCreateProgram(); // non-zero id
 
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertShader);
+    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertShader, errorLog);
     if (!vs) {
-        std::cout << "Vertex shader failed to compile, aborting shader program creation." << std::endl;
+        ReportError(errorLog, "Vertex shader failed to compile, aborting shader program creation.");
+        glDeleteProgram(program);
         return 0;
     }
 
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragShader);
+    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragShader, errorLog);
     if (!fs) {
-        std::cout << "Fragment shader failed to compile, aborting shader program creation." << std::endl;
+        ReportError(errorLog, "Fragment shader failed to compile, aborting shader program creation.");
+        glDeleteShader(vs);
+        glDeleteProgram(program);
         return 0;
     }
     
@@ -133,6 +187,11 @@ unsigned int ShaderLoader::CreateShaderProgram(const std::string& vertShader, co
     glAttachShader(program, vs);
     glAttachShader(program, fs);
 
+    // the hint only counts if it's set before linking
+    if (retrievableBinary && gl_ext::ProgramParameteri != nullptr) {
+        gl_ext::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(program);
     
     // linking done, detach shader intermediates
@@ -148,14 +207,8 @@ unsigned int ShaderLoader::CreateShaderProgram(const std::string& vertShader, co
     int success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (success == GL_FALSE) {
-        int msgLen;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &msgLen);
-        GLchar* msg = (GLchar*)_malloca(msgLen * sizeof(GLchar));
-
-        glGetProgramInfoLog(program, msgLen, &msgLen, msg);
-        std::cout << "Shader program linking failed: " << msg << std::endl;
-
-        _freea(msg);
+        ReportError(errorLog, "Shader program linking failed: " + GetProgramLog(program));
+        glDeleteProgram(program);
         return 0;
     }
 
@@ -164,17 +217,130 @@ unsigned int ShaderLoader::CreateShaderProgram(const std::string& vertShader, co
     // check if validation had errors
     glGetProgramiv(program, GL_VALIDATE_STATUS, &success);
     if (success == GL_FALSE) {
-        int msgLen;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &msgLen);
-        GLchar* msg = (GLchar*)_malloca(msgLen * sizeof(GLchar));
+        ReportError(errorLog, "Shader program validation failed: " + GetProgramLog(program));
+        glDeleteProgram(program);
+        return 0;
+    }
 
-        glGetProgramInfoLog(program, msgLen, &msgLen, msg);
-        std::cout << "Shader program validation failed: " << msg << std::endl;
 
-        _freea(msg);
+    return program;
+}
+
+unsigned int ShaderLoader::StartShaderProgram(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary) {
+    unsigned int program = glCreateProgram();
+    const char* sources[2] = { vertShader.c_str(), fragShader.c_str() };
+    const unsigned int types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    for (int i = 0; i < 2; i++) {
+        unsigned int id = glCreateShader(types[i]);
+        glShaderSource(id, 1, &sources[i], NULL);
+        glCompileShader(id);
+        glAttachShader(program, id);
+        // flagged for deletion, it goes away with the program or when Finish detaches it
+        glDeleteShader(id);
+    }
+    if (retrievableBinary && gl_ext::ProgramParameteri != nullptr) {
+        gl_ext::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    // linking a program whose shaders failed just fails too, Finish sorts out which one it was
+    glLinkProgram(program);
+    return program;
+}
+
+bool ShaderLoader::IsShaderProgramDone(unsigned int program) {
+    if (!gl_ext::SupportsParallelShaderCompile()) {
+        // without the extension, asking blocks anyway
+        return true;
+    }
+    int done = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+unsigned int ShaderLoader::FinishShaderProgram(unsigned int program, std::string* errorLog) {
+    unsigned int shaders[2] = { 0, 0 };
+    int count = 0;
+    glGetAttachedShaders(program, 2, &count, shaders);
+
+    bool compiled = true;
+    for (int i = 0; i < count; i++) {
+        int type;
+        glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+        compiled = CheckShader(shaders[i], type, errorLog) && compiled;
+        glDetachShader(program, shaders[i]);
+    }
+    if (!compiled) {
+        ReportError(errorLog, "Shader compile failed, aborting shader program creation.");
+        glDeleteProgram(program);
         return 0;
     }
 
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        ReportError(errorLog, "Shader program linking failed: " + GetProgramLog(program));
+        glDeleteProgram(program);
+        return 0;
+    }
+    // the same validation as CreateShaderProgram, so a batch lets through nothing a single program wouldn't
+    glValidateProgram(program);
+    glGetProgramiv(program, GL_VALIDATE_STATUS, &success);
+    if (success == GL_FALSE) {
+        ReportError(errorLog, "Shader program validation failed: " + GetProgramLog(program));
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+unsigned int ShaderLoader::CreateStageProgram(unsigned int type, const std::string& source, bool retrievableBinary, std::string* errorLog) {
+    unsigned int shader = CompileShader(type, source, errorLog);
+    if (!shader) {
+        ReportError(errorLog, "Failed to compile separable " + TypeToName(type) + ", aborting stage program creation.");
+        return 0;
+    }
+
+    unsigned int program = glCreateProgram();
+    // both have to be set before linking
+    gl_ext::ProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    if (retrievableBinary) {
+        gl_ext::ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDetachShader(program, shader);
+    glDeleteShader(shader);
 
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        ReportError(errorLog, "Separable " + TypeToName(type) + " linking failed: " + GetProgramLog(program));
+        glDeleteProgram(program);
+        return 0;
+    }
     return program;
 }
+
+unsigned int ShaderLoader::CreateProgramPipeline(unsigned int vertProgram, unsigned int fragProgram, std::string* errorLog) {
+    unsigned int pipeline = 0;
+    gl_ext::GenProgramPipelines(1, &pipeline);
+    if (!UpdateProgramPipeline(pipeline, vertProgram, fragProgram, errorLog)) {
+        gl_ext::DeleteProgramPipelines(1, &pipeline);
+        return 0;
+    }
+    return pipeline;
+}
+
+bool ShaderLoader::UpdateProgramPipeline(unsigned int pipeline, unsigned int vertProgram, unsigned int fragProgram, std::string* errorLog) {
+    gl_ext::UseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, vertProgram);
+    gl_ext::UseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, fragProgram);
+
+    // the counterpart of glValidateProgram for monolithic programs, it's where mismatched stage interfaces show up
+    gl_ext::ValidateProgramPipeline(pipeline);
+    int success;
+    gl_ext::GetProgramPipelineiv(pipeline, GL_VALIDATE_STATUS, &success);
+    if (success == GL_FALSE) {
+        ReportError(errorLog, "Program pipeline validation failed: " + GetPipelineLog(pipeline));
+        return false;
+    }
+    return true;
+}
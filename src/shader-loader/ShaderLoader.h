@@ -1,6 +1,9 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <vector>
+
+class ShaderPreprocessor;
 
 class ShaderLoader {
 	enum class ShaderType {
@@ -10,18 +13,52 @@ class ShaderLoader {
 	};
 
 	static std::string TypeToName(unsigned int type);
-	static unsigned int CompileShader(unsigned int type, const std::string& source);
+	static unsigned int CompileShader(unsigned int type, const std::string& source, std::string* errorLog);
+	static bool CheckShader(unsigned int id, unsigned int type, std::string* errorLog);
+	static void ReportError(std::string* errorLog, const std::string& message);
 public:
 	struct ShaderSources {
 		std::string vertShaderSrc;
 		std::string fragShaderSrc;
+		// every file that went into the two sources, the stage files and includes that are still missing included
+		std::vector<std::string> files{ };
+		// which file each #line source string number stands for, to make sense of driver errors
+		std::string sourceLegend{ };
 	};
 
 	static std::string ReadShaderSource(const std::string& filepath);
 	static ShaderSources ParseShaderSources(const std::string& vertFilepath, const std::string& fragFilepath);
 	static ShaderSources ParseCombinedShaderSource(const std::string& filepath);
+	// like ParseShaderSources, but with #include resolved and defines injected after #version
+	static ShaderSources PreprocessShaderSources(ShaderPreprocessor& preprocessor, const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<std::string>& defines = {});
+	// a single stage of type, for stage programs; only the source of that stage is filled in
+	static ShaderSources PreprocessStageSource(ShaderPreprocessor& preprocessor, unsigned int type, const std::string& filepath, const std::vector<std::string>& defines = {});
+
+	/*
+	 * retrievableBinary asks the driver to keep the linked binary around for glGetProgramBinary.
+	 * Compile and link errors go to errorLog when one is given, otherwise to stdout.
+	 */
+	static unsigned int CreateShaderProgram(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary = false, std::string* errorLog = nullptr);
+
+	/*
+	 * CreateShaderProgram split in two so nothing waits on the driver in between:
+	 * Start submits compiles and the link without asking for any status, Finish checks
+	 * the results, reports errors and returns the program or 0. Once IsShaderProgramDone
+	 * says so, Finish won't block; with KHR_parallel_shader_compile that can be polled.
+	 */
+	static unsigned int StartShaderProgram(const std::string& vertShader, const std::string& fragShader, bool retrievableBinary = false);
+	static bool IsShaderProgramDone(unsigned int program);
+	static unsigned int FinishShaderProgram(unsigned int program, std::string* errorLog = nullptr);
 
-	static unsigned int CreateShaderProgram(const std::string& vertShader, const std::string& fragShader);
+	/*
+	 * A single stage linked on its own with GL_PROGRAM_SEPARABLE, so program pipelines can
+	 * combine it with any other stage at draw time. Needs gl_ext::SupportsSeparateShaderObjects.
+	 */
+	static unsigned int CreateStageProgram(unsigned int type, const std::string& source, bool retrievableBinary = false, std::string* errorLog = nullptr);
+	// a pipeline of two stage programs, validated; 0 if their interfaces don't match
+	static unsigned int CreateProgramPipeline(unsigned int vertProgram, unsigned int fragProgram, std::string* errorLog = nullptr);
+	// swaps the stages of an existing pipeline and validates it again
+	static bool UpdateProgramPipeline(unsigned int pipeline, unsigned int vertProgram, unsigned int fragProgram, std::string* errorLog = nullptr);
 };
 
 
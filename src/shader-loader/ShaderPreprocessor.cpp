@@ -0,0 +1,249 @@
+#include "ShaderPreprocessor.h"
+#include "../vfs/FileSystem.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+struct ShaderPreprocessor::Expansion {
+	const std::vector<std::string>* defines;
+	std::string output{ };
+	std::vector<std::string> files{ };
+	std::vector<std::string> missingFiles{ };
+	// files currently being expanded, outermost first
+	std::vector<std::string> stack{ };
+	// #pragma once files already pulled into this shader
+	std::unordered_set<std::string> onceIncluded{ };
+};
+
+// returns the directive name of a preprocessor line ("include", "version", ...) and leaves rest pointing past it
+static std::string_view DirectiveName(std::string_view line, size_t& rest) {
+	size_t i = line.find_first_not_of(" \t");
+	if (i == std::string_view::npos || line[i] != '#') {
+		return "";
+	}
+	i = line.find_first_not_of(" \t", i + 1);
+	if (i == std::string_view::npos) {
+		return "";
+	}
+	size_t end = i;
+	while (end < line.size() && (std::isalnum((unsigned char)line[end]) || line[end] == '_')) {
+		end++;
+	}
+	rest = end;
+	return line.substr(i, end - i);
+}
+
+static bool IsPragmaOnce(std::string_view line) {
+	size_t rest = 0;
+	if (DirectiveName(line, rest) != "pragma") {
+		return false;
+	}
+	size_t word = line.find_first_not_of(" \t", rest);
+	if (word == std::string_view::npos || line.compare(word, 4, "once") != 0) {
+		return false;
+	}
+	return word + 4 == line.size() || line[word + 4] == ' ' || line[word + 4] == '\t';
+}
+
+// "NAME=VALUE" reads nicer on a command line, GLSL wants "NAME VALUE"
+static std::string DefineLine(std::string define) {
+	size_t equals = define.find('=');
+	if (equals != std::string::npos) {
+		define[equals] = ' ';
+	}
+	return "#define " + define + "\n";
+}
+
+void ShaderPreprocessor::AddIncludeDirectory(const std::string& directory) {
+	std::lock_guard<std::mutex> lock(mutex);
+	includeDirectories.push_back(vfs::FileSystem::NormalizePath(directory));
+}
+
+const vfs::FileData* ShaderPreprocessor::ReadFile(const std::string& path, std::string& error) {
+	auto cached = fileCache.find(path);
+	if (cached != fileCache.end()) {
+		return &cached->second;
+	}
+	vfs::FileData contents = vfs::FileSystem::Shared().Read(path, error);
+	if (!contents) {
+		// not remembered, so the file is picked up once it exists
+		return nullptr;
+	}
+	fileReads++;
+	return &fileCache.emplace(path, std::move(contents)).first->second;
+}
+
+std::string ShaderPreprocessor::ResolveInclude(const std::string& includingFile, const std::string& name) const {
+	const vfs::FileSystem& fileSystem = vfs::FileSystem::Shared();
+	std::string candidate = vfs::FileSystem::NormalizePath((std::filesystem::path(includingFile).parent_path() / name).string());
+	if (fileCache.count(candidate) || fileSystem.Exists(candidate)) {
+		return candidate;
+	}
+	for (const std::string& directory : includeDirectories) {
+		std::string found = vfs::FileSystem::NormalizePath((std::filesystem::path(directory) / name).string());
+		if (fileCache.count(found) || fileSystem.Exists(found)) {
+			return found;
+		}
+	}
+	return "";
+}
+
+void ShaderPreprocessor::Expand(Expansion& expansion, const std::string& path, int sourceString, bool root) {
+	std::string error;
+	const vfs::FileData* contents = ReadFile(path, error);
+	if (contents == nullptr) {
+		// the include was resolved a moment ago, so this only happens if it was deleted in between
+		expansion.output += "#error can't read " + path + ": " + error + "\n";
+		return;
+	}
+	expansion.stack.push_back(path);
+	std::set<std::string> direct{ };
+	std::string_view lines = contents->GetText();
+	int lineNumber = 0;
+	bool definesInjected = !root;
+	if (!root) {
+		expansion.output += "#line 1 " + std::to_string(sourceString) + "\n";
+	}
+	while (!lines.empty()) {
+		size_t newline = lines.find('\n');
+		std::string_view line = lines.substr(0, newline);
+		lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r') {
+			line.remove_suffix(1);
+		}
+		size_t rest = 0;
+		std::string_view directive = DirectiveName(line, rest);
+
+		if (directive == "version") {
+			// only the outermost #version counts, an included one would be a compile error
+			if (root) {
+				expansion.output.append(line).push_back('\n');
+				if (!definesInjected) {
+					for (const std::string& define : *expansion.defines) {
+						expansion.output += DefineLine(define);
+					}
+					definesInjected = true;
+					expansion.output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceString) + "\n";
+				}
+			}
+			else {
+				expansion.output += "\n";
+			}
+			continue;
+		}
+		if (IsPragmaOnce(line)) {
+			expansion.onceIncluded.insert(path);
+			expansion.output += "\n";
+			continue;
+		}
+		if (directive != "include") {
+			expansion.output.append(line).push_back('\n');
+			continue;
+		}
+
+		size_t open = line.find_first_of("\"<", rest);
+		size_t close = open == std::string_view::npos ? std::string_view::npos : line.find(line[open] == '<' ? '>' : '"', open + 1);
+		if (close == std::string_view::npos) {
+			expansion.output += "#error malformed #include\n";
+			continue;
+		}
+		std::string name(line.substr(open + 1, close - open - 1));
+		std::string included = ResolveInclude(path, name);
+		if (included.empty()) {
+			// remember where it would have been, so creating the file triggers a rebuild
+			std::string expected = vfs::FileSystem::NormalizePath((std::filesystem::path(path).parent_path() / name).string());
+			direct.insert(expected);
+			expansion.missingFiles.push_back(expected);
+			expansion.output += "#error can't find include " + name + "\n";
+		}
+		else {
+			direct.insert(included);
+			if (std::find(expansion.stack.begin(), expansion.stack.end(), included) != expansion.stack.end()) {
+				std::string chain{ };
+				for (const std::string& file : expansion.stack) {
+					chain += std::filesystem::path(file).filename().string() + " -> ";
+				}
+				expansion.output += "#error include cycle " + chain + std::filesystem::path(included).filename().string() + "\n";
+			}
+			else if (!expansion.onceIncluded.count(included)) {
+				auto known = std::find(expansion.files.begin(), expansion.files.end(), included);
+				int includedString = (int)(known - expansion.files.begin());
+				if (known == expansion.files.end()) {
+					expansion.files.push_back(included);
+				}
+				Expand(expansion, included, includedString, false);
+			}
+		}
+		// back to the line after the #include
+		expansion.output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceString) + "\n";
+	}
+	if (!definesInjected) {
+		// no #version, which GLSL reads as 110; the defines still have to go somewhere
+		std::string defines{ };
+		for (const std::string& define : *expansion.defines) {
+			defines += DefineLine(define);
+		}
+		expansion.output.insert(0, defines + "#line 1 " + std::to_string(sourceString) + "\n");
+	}
+	expansion.stack.pop_back();
+
+	for (const std::string& old : includes[path]) {
+		includedBy[old].erase(path);
+	}
+	for (const std::string& file : direct) {
+		includedBy[file].insert(path);
+	}
+	includes[path] = std::move(direct);
+}
+
+PreprocessedShader ShaderPreprocessor::Process(const std::string& filepath, const std::vector<std::string>& defines) {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::string root = vfs::FileSystem::NormalizePath(filepath);
+	roots.insert(root);
+	Expansion expansion{ &defines };
+	expansion.files.push_back(root);
+	std::string error;
+	if (ReadFile(root, error) == nullptr) {
+		std::cerr << "Can't read shader " << root << ": " << error << std::endl;
+		return PreprocessedShader{ "", expansion.files };
+	}
+	Expand(expansion, root, 0, true);
+	return PreprocessedShader{ std::move(expansion.output), std::move(expansion.files), std::move(expansion.missingFiles) };
+}
+
+void ShaderPreprocessor::Invalidate(const std::string& filepath) {
+	std::lock_guard<std::mutex> lock(mutex);
+	fileCache.erase(vfs::FileSystem::NormalizePath(filepath));
+}
+
+std::vector<std::string> ShaderPreprocessor::GetDependents(const std::string& filepath) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::vector<std::string> dependents{ };
+	std::vector<std::string> pending{ vfs::FileSystem::NormalizePath(filepath) };
+	std::unordered_set<std::string> visited{ pending.front() };
+	while (!pending.empty()) {
+		std::string file = std::move(pending.back());
+		pending.pop_back();
+		if (roots.count(file)) {
+			dependents.push_back(file);
+		}
+		auto parents = includedBy.find(file);
+		if (parents == includedBy.end()) {
+			continue;
+		}
+		for (const std::string& parent : parents->second) {
+			if (visited.insert(parent).second) {
+				pending.push_back(parent);
+			}
+		}
+	}
+	return dependents;
+}
+
+int ShaderPreprocessor::GetFileReads() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return fileReads;
+}
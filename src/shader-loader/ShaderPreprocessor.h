@@ -0,0 +1,64 @@
+#pragma once
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "../vfs/FileSystem.h"
+
+struct PreprocessedShader {
+	std::string source;
+	// every file that went into source; the index is the source string number used in #line and in driver logs
+	std::vector<std::string> files{ };
+	// includes that couldn't be found, where they were looked for next to the including file
+	std::vector<std::string> missingFiles{ };
+};
+
+/*
+ * Expands #include "file" (or <file>) in GLSL sources.
+ *
+ * Includes resolve relative to the including file first, then against the
+ * include directories. #pragma once skips a file that was already pulled
+ * into the same shader, defines are injected right after #version, and
+ * #line directives keep driver error locations pointing at the right file and
+ * line (numbered the GLSL 3.30 way, older versions are off by one). A missing
+ * include or an include cycle becomes an #error, so it shows up in the compile
+ * log like any other shader error.
+ *
+ * Files are read through the vfs once per session and remembered until
+ * Invalidate. The include graph of every processed shader is kept, so a
+ * changed file can be mapped back to the shaders that have to be rebuilt.
+ * Safe to use from several threads.
+ */
+class ShaderPreprocessor {
+public:
+	void AddIncludeDirectory(const std::string& directory);
+
+	// defines are "NAME" or "NAME VALUE"
+	PreprocessedShader Process(const std::string& filepath, const std::vector<std::string>& defines = {});
+	// forgets the cached contents of a file that changed on disk
+	void Invalidate(const std::string& filepath);
+	// shaders passed to Process whose output depends on filepath, including through nested includes
+	std::vector<std::string> GetDependents(const std::string& filepath) const;
+	// files actually read through the vfs, as opposed to served from memory
+	int GetFileReads() const;
+
+private:
+	struct Expansion;
+
+	mutable std::mutex mutex;
+	std::vector<std::string> includeDirectories{ };
+	// normalized path -> contents, or no entry if it couldn't be read
+	std::unordered_map<std::string, vfs::FileData> fileCache{ };
+	// files passed to Process
+	std::unordered_set<std::string> roots{ };
+	// normalized path -> files it includes directly, and the reverse
+	std::unordered_map<std::string, std::set<std::string>> includes{ };
+	std::unordered_map<std::string, std::set<std::string>> includedBy{ };
+	int fileReads = 0;
+
+	const vfs::FileData* ReadFile(const std::string& path, std::string& error);
+	std::string ResolveInclude(const std::string& includingFile, const std::string& name) const;
+	void Expand(Expansion& expansion, const std::string& path, int sourceString, bool root);
+};
@@ -0,0 +1,275 @@
+#include "ShaderReloader.h"
+#include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
+#include "../gl/GLCallStats.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/MemoryTags.h"
+#include "../vfs/FileSystem.h"
+#include <glad/glad.h>
+#ifndef HEADLESS_ONLY
+#include <GLFW/glfw3.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+static std::string DisplayName(const std::string& vertPath, const std::string& fragPath, const std::vector<std::string>& defines) {
+	std::string name = vertPath.empty() || fragPath.empty()
+		? std::filesystem::path(vertPath + fragPath).filename().string() + " (separable)"
+		: std::filesystem::path(vertPath).filename().string() + " + " + std::filesystem::path(fragPath).filename().string();
+	for (size_t i = 0; i < defines.size(); i++) {
+		name += (i == 0 ? " [" : ", ") + defines[i] + (i + 1 == defines.size() ? "]" : "");
+	}
+	return name;
+}
+
+ShaderReloader::ShaderReloader(GLFWwindow* mainWindow, ShaderPreprocessor* preprocessor) : preprocessor(preprocessor) {
+#ifndef HEADLESS_ONLY
+	// a context can only be created on the main thread, but it may be made current anywhere
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	compileWindow = glfwCreateWindow(1, 1, "shader compiler", nullptr, mainWindow);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+#endif
+	if (compileWindow == nullptr) {
+		std::cout << "No shared context for shader compiles, hot reload will compile on the main thread" << std::endl;
+		return;
+	}
+	worker = std::thread(&ShaderReloader::WorkerLoop, this);
+}
+
+ShaderReloader::~ShaderReloader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	if (worker.joinable()) {
+		worker.join();
+	}
+#ifndef HEADLESS_ONLY
+	if (compileWindow != nullptr) {
+		glfwDestroyWindow(compileWindow);
+	}
+#endif
+	// programs are shared, so the main context can delete the ones the worker made
+	for (const Result& result : results) {
+		glDeleteProgram(result.program);
+	}
+	for (const Entry& entry : entries) {
+		glDeleteProgram(entry.program);
+	}
+}
+
+ShaderReloader::Handle ShaderReloader::Add(const std::string& vertPath, const std::string& fragPath, unsigned int program,
+	const std::vector<std::string>& defines, const std::vector<std::string>& files) {
+	Entry entry{ };
+	entry.vertPath = vertPath;
+	entry.fragPath = fragPath;
+	entry.defines = defines;
+	entry.program = program;
+	entries.push_back(std::move(entry));
+	watcher.Watch(vertPath);
+	watcher.Watch(fragPath);
+	for (const std::string& file : files) {
+		watcher.Watch(file);
+	}
+	return entries.size() - 1;
+}
+
+ShaderReloader::Handle ShaderReloader::AddStage(unsigned int type, const std::string& path, unsigned int program,
+	const std::vector<std::string>& defines, const std::vector<std::string>& files) {
+	Entry entry{ };
+	(type == GL_VERTEX_SHADER ? entry.vertPath : entry.fragPath) = path;
+	entry.stageType = type;
+	entry.defines = defines;
+	entry.program = program;
+	entries.push_back(std::move(entry));
+	watcher.Watch(path);
+	for (const std::string& file : files) {
+		watcher.Watch(file);
+	}
+	return entries.size() - 1;
+}
+
+void ShaderReloader::AddDependency(Handle handle, const std::string& path) {
+	entries[handle].dependencies.push_back(path);
+	watcher.Watch(path);
+}
+
+unsigned int ShaderReloader::GetProgram(Handle handle) const {
+	return entries[handle].program;
+}
+
+ShaderReloader::Result ShaderReloader::Build(const Job& job) const {
+	PROFILE_SCOPE("ShaderReloader::Build");
+	if (job.stageType != 0) {
+		return BuildStage(job);
+	}
+	auto start = std::chrono::steady_clock::now();
+	ShaderLoader::ShaderSources sources = preprocessor != nullptr
+		? ShaderLoader::PreprocessShaderSources(*preprocessor, job.vertPath, job.fragPath, job.defines)
+		: ShaderLoader::ParseShaderSources(job.vertPath, job.fragPath);
+	Result result{ job.handle, 0, "", 0.0, std::move(sources.files) };
+	// retrievable so a finished build can go into the program cache
+	result.program = ShaderLoader::CreateShaderProgram(sources.vertShaderSrc, sources.fragShaderSrc, true, &result.log);
+	if (result.program == 0) {
+		result.log += sources.sourceLegend;
+	}
+	result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+ShaderReloader::Result ShaderReloader::BuildStage(const Job& job) const {
+	auto start = std::chrono::steady_clock::now();
+	const std::string& path = job.stageType == GL_VERTEX_SHADER ? job.vertPath : job.fragPath;
+	ShaderLoader::ShaderSources sources{ };
+	if (preprocessor != nullptr) {
+		sources = ShaderLoader::PreprocessStageSource(*preprocessor, job.stageType, path, job.defines);
+	}
+	else {
+		(job.stageType == GL_VERTEX_SHADER ? sources.vertShaderSrc : sources.fragShaderSrc) = ShaderLoader::ReadShaderSource(path);
+	}
+	const std::string& source = job.stageType == GL_VERTEX_SHADER ? sources.vertShaderSrc : sources.fragShaderSrc;
+	Result result{ job.handle, 0, "", 0.0, std::move(sources.files) };
+	result.program = ShaderLoader::CreateStageProgram(job.stageType, source, true, &result.log);
+	if (result.program == 0) {
+		result.log += sources.sourceLegend;
+	}
+	result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+void ShaderReloader::WorkerLoop() {
+	PROFILE_THREAD("shader reloader");
+	MEMORY_TAG(profiling::MemoryTag::Assets);
+#ifndef HEADLESS_ONLY
+	glfwMakeContextCurrent(compileWindow);
+#endif
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+		if (stopping) {
+			break;
+		}
+		Job job = std::move(jobs.front());
+		jobs.pop_front();
+		lock.unlock();
+
+		// the main thread can't swap the call stats hooks in or out while this calls GL
+		std::shared_lock<std::shared_mutex> glCalls = gl_calls::LockCalls();
+		Result result = Build(job);
+		if (result.program != 0) {
+			// make sure the driver is done with the program before another context picks it up
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+		}
+		glCalls.unlock();
+
+		lock.lock();
+		results.push_back(std::move(result));
+	}
+	lock.unlock();
+#ifndef HEADLESS_ONLY
+	glfwMakeContextCurrent(nullptr);
+#endif
+}
+
+void ShaderReloader::Rebuild(Handle handle) {
+	Queue(handle);
+}
+
+void ShaderReloader::Queue(Handle handle) {
+	Entry& entry = entries[handle];
+	if (entry.building) {
+		entry.dirty = true;
+		return;
+	}
+	entry.building = true;
+	Job job{ handle, entry.vertPath, entry.fragPath, entry.stageType, entry.defines };
+	if (compileWindow == nullptr) {
+		results.push_back(Build(job));
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	jobAvailable.notify_one();
+}
+
+bool ShaderReloader::IsAffected(const Entry& entry, const std::string& changedPath, const std::vector<std::string>& dependents) const {
+	if (std::find(entry.dependencies.begin(), entry.dependencies.end(), changedPath) != entry.dependencies.end()) {
+		return true;
+	}
+	for (const std::string* path : { &entry.vertPath, &entry.fragPath }) {
+		if (path->empty()) {
+			continue;
+		}
+		if (preprocessor == nullptr ? changedPath == *path
+			// dependents are the stage files whose include graph reaches the changed file
+			: std::find(dependents.begin(), dependents.end(), vfs::FileSystem::NormalizePath(*path)) != dependents.end()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ShaderReloader::Update() {
+	PROFILE_SCOPE("ShaderReloader::Update");
+	MEMORY_TAG(profiling::MemoryTag::Assets);
+	for (const std::string& path : watcher.Poll()) {
+		std::vector<std::string> dependents{ };
+		if (preprocessor != nullptr) {
+			preprocessor->Invalidate(path);
+			dependents = preprocessor->GetDependents(path);
+		}
+		for (Handle handle = 0; handle < entries.size(); handle++) {
+			if (IsAffected(entries[handle], path, dependents)) {
+				Queue(handle);
+			}
+		}
+	}
+
+	std::vector<Result> finished{ };
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.swap(results);
+	}
+	bool changed = false;
+	for (Result& result : finished) {
+		Entry& entry = entries[result.handle];
+		entry.building = false;
+		for (const std::string& file : result.files) {
+			watcher.Watch(file);
+		}
+		if (result.program != 0) {
+			const char* verb = entry.program == 0 ? "Built " : "Reloaded ";
+			// deleting a program that's still bound only takes effect once it's unbound
+			glDeleteProgram(entry.program);
+			entry.program = result.program;
+			entry.error.clear();
+			changed = true;
+			std::cout << verb << DisplayName(entry.vertPath, entry.fragPath, entry.defines) << " in " << result.ms << " ms" << std::endl;
+		}
+		else {
+			entry.error = std::move(result.log);
+		}
+		if (entry.dirty) {
+			entry.dirty = false;
+			Queue(result.handle);
+		}
+	}
+	return changed;
+}
+
+std::vector<ShaderReloadError> ShaderReloader::GetErrors() const {
+	std::vector<ShaderReloadError> errors{ };
+	for (const Entry& entry : entries) {
+		if (!entry.error.empty()) {
+			errors.push_back(ShaderReloadError{ DisplayName(entry.vertPath, entry.fragPath, entry.defines), entry.error });
+		}
+	}
+	return errors;
+}
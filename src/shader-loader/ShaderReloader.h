@@ -0,0 +1,109 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileWatcher.h"
+
+struct GLFWwindow;
+class ShaderPreprocessor;
+
+struct ShaderReloadError {
+	// "vertex.glsl + fragment.glsl", followed by the defines if there are any
+	std::string programName;
+	std::string log;
+};
+
+/*
+ * Rebuilds shader programs when their source files change on disk.
+ *
+ * Compiling happens on a worker thread that owns a hidden GLFW context
+ * sharing objects with the main one, so the frame never waits on the driver.
+ * A rebuilt program only replaces the running one after it linked; after a
+ * failed build the old program keeps drawing and the log is kept for the UI.
+ * Without a second context the rebuild runs inside Update instead.
+ *
+ * With a preprocessor, a changed file only rebuilds the programs whose
+ * include graph reaches it, and files a rebuild newly includes get watched.
+ */
+class ShaderReloader {
+public:
+	using Handle = size_t;
+
+	// call on the main thread with mainWindow's context current
+	// preprocessor may be null, then sources are read as they are; it has to outlive the reloader
+	explicit ShaderReloader(GLFWwindow* mainWindow, ShaderPreprocessor* preprocessor = nullptr);
+	~ShaderReloader();
+	ShaderReloader(const ShaderReloader&) = delete;
+	ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+	// takes ownership of program, which was built from the two files with defines; files are the includes it pulled in, if known
+	Handle Add(const std::string& vertPath, const std::string& fragPath, unsigned int program,
+		const std::vector<std::string>& defines = {}, const std::vector<std::string>& files = {});
+	// same for a separable stage program of type built from path alone, see ShaderLoader::CreateStageProgram
+	Handle AddStage(unsigned int type, const std::string& path, unsigned int program,
+		const std::vector<std::string>& defines = {}, const std::vector<std::string>& files = {});
+	// another file that should trigger a rebuild of handle, e.g. an include
+	void AddDependency(Handle handle, const std::string& path);
+	// 0 until the first build of a program added without one finished
+	unsigned int GetProgram(Handle handle) const;
+	// builds handle again even though none of its files changed, e.g. for a program added without one
+	void Rebuild(Handle handle);
+
+	// queues rebuilds for changed files and swaps in finished ones; returns true if any program changed
+	bool Update();
+	// one entry per program whose latest rebuild failed
+	std::vector<ShaderReloadError> GetErrors() const;
+
+private:
+	struct Entry {
+		// a stage program only has the path of its own stage
+		std::string vertPath;
+		std::string fragPath;
+		// GL_VERTEX_SHADER or GL_FRAGMENT_SHADER for a stage program, 0 for a program with both stages
+		unsigned int stageType = 0;
+		std::vector<std::string> defines{ };
+		std::vector<std::string> dependencies{ };
+		unsigned int program = 0;
+		std::string error{ };
+		// a rebuild is queued or running
+		bool building = false;
+		// files changed again while building, so the result is already stale
+		bool dirty = false;
+	};
+	struct Job {
+		Handle handle;
+		std::string vertPath;
+		std::string fragPath;
+		unsigned int stageType;
+		std::vector<std::string> defines;
+	};
+	struct Result {
+		Handle handle;
+		unsigned int program;
+		std::string log;
+		double ms;
+		// files the sources were built from, so new includes get watched
+		std::vector<std::string> files;
+	};
+
+	std::vector<Entry> entries{ };
+	ShaderPreprocessor* preprocessor = nullptr;
+	FileWatcher watcher{ };
+	GLFWwindow* compileWindow = nullptr;
+	std::thread worker{ };
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::deque<Job> jobs{ };
+	std::vector<Result> results{ };
+	bool stopping = false;
+
+	Result Build(const Job& job) const;
+	Result BuildStage(const Job& job) const;
+	bool IsAffected(const Entry& entry, const std::string& changedPath, const std::vector<std::string>& dependents) const;
+	void WorkerLoop();
+	void Queue(Handle handle);
+};
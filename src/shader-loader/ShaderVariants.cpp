@@ -0,0 +1,446 @@
+#include "ShaderVariants.h"
+#include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
+#include "ProgramCache.h"
+#include "../gl/GLExtensions.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/MemoryTags.h"
+#include <glad/glad.h>
+#include <cctype>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+static const unsigned int kStageTypes[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+static double MsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// a define can only change sources that use its name as a whole identifier
+static bool MentionsIdentifier(const std::string& source, const std::string& name) {
+	auto isIdentifierChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	for (size_t at = source.find(name); at != std::string::npos; at = source.find(name, at + 1)) {
+		bool starts = at == 0 || !isIdentifierChar(source[at - 1]);
+		bool ends = at + name.size() == source.size() || !isIdentifierChar(source[at + name.size()]);
+		if (starts && ends) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static std::string& StageSource(ShaderLoader::ShaderSources& sources, int stage) {
+	return stage == 0 ? sources.vertShaderSrc : sources.fragShaderSrc;
+}
+
+void ShaderVariants::Binding::Use() const {
+	if (pipeline != 0) {
+		// a program in use takes precedence over the bound pipeline
+		glUseProgram(0);
+		gl_ext::BindProgramPipeline(pipeline);
+	}
+	else {
+		glUseProgram(program);
+	}
+}
+
+ShaderVariants::Binding::operator bool() const {
+	return program != 0 || pipeline != 0;
+}
+
+ShaderVariants::ShaderVariants(const std::string& vertPath, const std::string& fragPath, const std::vector<std::string>& features,
+	ShaderPreprocessor& preprocessor, ProgramCache& programCache, ShaderReloader* reloader, bool usePipelines)
+	: vertPath(vertPath), fragPath(fragPath), features(features), preprocessor(preprocessor), programCache(programCache), reloader(reloader) {
+	if (features.size() > 32) {
+		std::cerr << "Only the first 32 of " << features.size() << " shader features can be selected" << std::endl;
+		this->features.resize(32);
+	}
+
+	// the fallback is the one variant that's always built right away
+	Variant& fallback = variants[0];
+	fallback.requested = Clock::now();
+	separable = usePipelines && gl_ext::SupportsSeparateShaderObjects();
+	if (separable) {
+		for (int stage = 0; stage < 2; stage++) {
+			stageFeatures[stage] = FindStageFeatures(stage);
+		}
+		RequestPipeline(0, fallback, true);
+		fallback.failed = !fallback.ready;
+		return;
+	}
+	std::vector<std::string> defines = GetDefines(0);
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessShaderSources(preprocessor, vertPath, fragPath, defines);
+	fallback.program = programCache.LoadShaderProgram(sources.vertShaderSrc, sources.fragShaderSrc, defines);
+	fallback.origin = Origin::PROGRAM_CACHE;
+	if (fallback.program == 0) {
+		fallback.program = programCache.CreateShaderProgram(sources.vertShaderSrc, sources.fragShaderSrc, defines);
+		fallback.origin = Origin::COMPILED;
+	}
+	if (fallback.program == 0) {
+		std::cout << sources.sourceLegend;
+	}
+	fallback.ready = fallback.program != 0;
+	fallback.failed = fallback.program == 0;
+	fallback.readyMs = MsSince(fallback.requested);
+	Register(fallback, fallback.program, defines, sources.files);
+}
+
+ShaderVariants::~ShaderVariants() {
+	// pipelines only reference the stage programs, so they're ours even with a reloader
+	for (auto& [features, variant] : variants) {
+		if (variant.pipeline != 0) {
+			gl_ext::DeleteProgramPipelines(1, &variant.pipeline);
+		}
+	}
+	if (reloader != nullptr) {
+		return;
+	}
+	for (auto& [features, variant] : variants) {
+		glDeleteProgram(variant.program);
+	}
+	for (std::map<Features, Stage>& stagePrograms : stages) {
+		for (auto& [features, built] : stagePrograms) {
+			glDeleteProgram(built.program);
+		}
+	}
+}
+
+bool ShaderVariants::UsesPipelines() const {
+	return separable;
+}
+
+std::vector<std::string> ShaderVariants::GetDefines(Features features) const {
+	std::vector<std::string> defines{ };
+	for (size_t i = 0; i < this->features.size(); i++) {
+		if (features & (1u << i)) {
+			defines.push_back(this->features[i]);
+		}
+	}
+	return defines;
+}
+
+std::string ShaderVariants::Describe(Features features) const {
+	std::string description{ };
+	for (const std::string& define : GetDefines(features)) {
+		description += (description.empty() ? "" : " | ") + define;
+	}
+	return description.empty() ? "base" : description;
+}
+
+ShaderVariants::Binding ShaderVariants::Current(const Variant& variant) const {
+	if (separable) {
+		return Binding{ 0, variant.pipeline, variant.vertProgram, variant.fragProgram };
+	}
+	// the reloader swaps programs on edits, so its copy is the current one
+	return Binding{ variant.registered ? reloader->GetProgram(variant.handle) : variant.program };
+}
+
+void ShaderVariants::Register(Variant& variant, unsigned int program, const std::vector<std::string>& defines, const std::vector<std::string>& files) {
+	variant.program = program;
+	if (reloader != nullptr) {
+		variant.handle = reloader->Add(vertPath, fragPath, program, defines, files);
+		variant.registered = true;
+	}
+}
+
+void ShaderVariants::Store(Features features, Variant& variant, unsigned int program) {
+	// an edit while it compiled means the binary belongs to newer sources than the ones it would be filed under
+	std::vector<std::string> defines = GetDefines(features);
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessShaderSources(preprocessor, vertPath, fragPath, defines);
+	if (sources.vertShaderSrc == variant.vertShaderSrc && sources.fragShaderSrc == variant.fragShaderSrc) {
+		programCache.StoreShaderProgram(program, sources.vertShaderSrc, sources.fragShaderSrc, defines, variant.readyMs);
+	}
+	variant.vertShaderSrc.clear();
+	variant.fragShaderSrc.clear();
+}
+
+ShaderVariants::Variant& ShaderVariants::Request(Features features, bool prewarm) {
+	auto existing = variants.find(features);
+	if (existing != variants.end()) {
+		return existing->second;
+	}
+	Variant& variant = variants[features];
+	variant.requested = Clock::now();
+	if (separable) {
+		RequestPipeline(features, variant, prewarm);
+		return variant;
+	}
+	std::vector<std::string> defines = GetDefines(features);
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessShaderSources(preprocessor, vertPath, fragPath, defines);
+
+	unsigned int program = programCache.LoadShaderProgram(sources.vertShaderSrc, sources.fragShaderSrc, defines);
+	if (program != 0) {
+		variant.origin = Origin::PROGRAM_CACHE;
+	}
+	else if (prewarm || batch.IsParallel()) {
+		variant.origin = Origin::BATCH;
+		variant.ticket = batch.Submit(sources.vertShaderSrc, sources.fragShaderSrc, programCache.IsEnabled());
+	}
+	else if (reloader != nullptr) {
+		variant.origin = Origin::BACKGROUND;
+		Register(variant, 0, defines, sources.files);
+		reloader->Rebuild(variant.handle);
+	}
+	else {
+		variant.origin = Origin::COMPILED;
+		program = programCache.CreateShaderProgram(sources.vertShaderSrc, sources.fragShaderSrc, defines);
+		variant.failed = program == 0;
+	}
+
+	if (variant.origin == Origin::PROGRAM_CACHE || variant.origin == Origin::COMPILED) {
+		variant.ready = program != 0;
+		variant.readyMs = MsSince(variant.requested);
+		Register(variant, program, defines, sources.files);
+		return variant;
+	}
+	variant.vertShaderSrc = std::move(sources.vertShaderSrc);
+	variant.fragShaderSrc = std::move(sources.fragShaderSrc);
+	return variant;
+}
+
+ShaderVariants::Binding ShaderVariants::GetBinding(Features features) {
+	Variant& variant = Request(features, false);
+	if (variant.ready) {
+		variant.uses++;
+		return Current(variant);
+	}
+	variant.fallbackUses++;
+	return Current(variants[0]);
+}
+
+bool ShaderVariants::IsReady(Features features) const {
+	auto variant = variants.find(features);
+	return variant != variants.end() && variant->second.ready;
+}
+
+void ShaderVariants::Prewarm(const std::vector<Features>& featureSets) {
+	for (Features features : featureSets) {
+		Request(features, true);
+	}
+}
+
+void ShaderVariants::Update() {
+	PROFILE_SCOPE("ShaderVariants::Update");
+	MEMORY_TAG(profiling::MemoryTag::Assets);
+	if (separable) {
+		for (int stage = 0; stage < 2 && reloader != nullptr; stage++) {
+			for (auto& [features, built] : stages[stage]) {
+				unsigned int program = built.registered ? reloader->GetProgram(built.handle) : 0;
+				if (built.ready || program == 0) {
+					continue;
+				}
+				built.ready = true;
+				built.failed = false;
+				built.readyMs = MsSince(built.requested);
+				StoreStage(stage, features, built, program);
+			}
+		}
+		for (auto& [features, variant] : variants) {
+			Assemble(features, variant);
+		}
+		return;
+	}
+
+	if (batch.GetPendingCount() > 0) {
+		bool finished = batch.Poll();
+		for (auto& [features, variant] : variants) {
+			if (variant.origin != Origin::BATCH || variant.ready || variant.failed || variant.registered || !batch.IsDone(variant.ticket)) {
+				continue;
+			}
+			unsigned int program = batch.TakeProgram(variant.ticket);
+			std::vector<std::string> defines = GetDefines(features);
+			ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessShaderSources(preprocessor, vertPath, fragPath, defines);
+			if (program != 0) {
+				variant.ready = true;
+				variant.readyMs = MsSince(variant.requested);
+				Store(features, variant, program);
+			}
+			else {
+				// still handed to the reloader, so fixing the shader brings the variant in after all
+				variant.failed = true;
+				std::cout << "Shader variant " << Describe(features) << " failed to build:\n" << batch.GetLog(variant.ticket) << sources.sourceLegend;
+			}
+			Register(variant, program, defines, sources.files);
+		}
+		if (finished) {
+			batch.PrintReport();
+		}
+	}
+
+	if (reloader == nullptr) {
+		return;
+	}
+	for (auto& [features, variant] : variants) {
+		if (variant.ready || !variant.registered) {
+			continue;
+		}
+		unsigned int program = reloader->GetProgram(variant.handle);
+		if (program == 0) {
+			continue;
+		}
+		variant.ready = true;
+		variant.failed = false;
+		variant.readyMs = MsSince(variant.requested);
+		Store(features, variant, program);
+	}
+}
+
+ShaderVariants::Features ShaderVariants::FindStageFeatures(int stage) const {
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessStageSource(preprocessor, kStageTypes[stage], stage == 0 ? vertPath : fragPath);
+	const std::string& source = StageSource(sources, stage);
+	Features mentioned = 0;
+	for (size_t i = 0; i < features.size(); i++) {
+		// "NAME=VALUE" defines NAME
+		if (MentionsIdentifier(source, features[i].substr(0, features[i].find_first_of("= ")))) {
+			mentioned |= 1u << i;
+		}
+	}
+	return mentioned;
+}
+
+unsigned int ShaderVariants::CurrentStage(const Stage& built) const {
+	return built.registered ? reloader->GetProgram(built.handle) : built.program;
+}
+
+void ShaderVariants::RequestPipeline(Features features, Variant& variant, bool now) {
+	variant.origin = Origin::PIPELINE;
+	RequestStage(0, features, now);
+	RequestStage(1, features, now);
+	Assemble(features, variant);
+}
+
+ShaderVariants::Stage& ShaderVariants::RequestStage(int stage, Features features, bool now) {
+	// features the stage doesn't mention would build the same program again
+	Features key = features & stageFeatures[stage];
+	auto existing = stages[stage].find(key);
+	if (existing != stages[stage].end()) {
+		return existing->second;
+	}
+	Stage& built = stages[stage][key];
+	built.requested = Clock::now();
+	unsigned int type = kStageTypes[stage];
+	const std::string& path = stage == 0 ? vertPath : fragPath;
+	std::vector<std::string> defines = GetDefines(key);
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessStageSource(preprocessor, type, path, defines);
+	std::string& source = StageSource(sources, stage);
+
+	unsigned int program = programCache.LoadStageProgram(type, source, defines);
+	if (program != 0) {
+		built.origin = Origin::PROGRAM_CACHE;
+	}
+	else if (!now && reloader != nullptr) {
+		built.origin = Origin::BACKGROUND;
+		built.handle = reloader->AddStage(type, path, 0, defines, sources.files);
+		built.registered = true;
+		built.source = std::move(source);
+		reloader->Rebuild(built.handle);
+		return built;
+	}
+	else {
+		built.origin = Origin::COMPILED;
+		program = programCache.CreateStageProgram(type, source, defines);
+		if (program == 0) {
+			std::cout << sources.sourceLegend;
+		}
+	}
+
+	built.program = program;
+	built.ready = program != 0;
+	built.failed = program == 0;
+	built.readyMs = MsSince(built.requested);
+	if (reloader != nullptr) {
+		built.handle = reloader->AddStage(type, path, program, defines, sources.files);
+		built.registered = true;
+	}
+	return built;
+}
+
+void ShaderVariants::StoreStage(int stage, Features features, Stage& built, unsigned int program) {
+	// same as Store: a binary built from sources edited since the request would be filed under the wrong key
+	std::vector<std::string> defines = GetDefines(features);
+	ShaderLoader::ShaderSources sources = ShaderLoader::PreprocessStageSource(preprocessor, kStageTypes[stage], stage == 0 ? vertPath : fragPath, defines);
+	if (StageSource(sources, stage) == built.source) {
+		programCache.StoreStageProgram(program, kStageTypes[stage], built.source, defines, built.readyMs);
+	}
+	built.source.clear();
+}
+
+void ShaderVariants::Assemble(Features features, Variant& variant) {
+	const Stage& vert = stages[0].at(features & stageFeatures[0]);
+	const Stage& frag = stages[1].at(features & stageFeatures[1]);
+	unsigned int vertProgram = CurrentStage(vert);
+	unsigned int fragProgram = CurrentStage(frag);
+	if (vertProgram == 0 || fragProgram == 0) {
+		// a stage that failed fails every variant it's part of, until a reload fixes it
+		variant.failed = vert.failed || frag.failed;
+		return;
+	}
+	if (vertProgram == variant.vertProgram && fragProgram == variant.fragProgram) {
+		return;
+	}
+	variant.vertProgram = vertProgram;
+	variant.fragProgram = fragProgram;
+
+	std::string log{ };
+	bool valid = false;
+	if (variant.pipeline == 0) {
+		variant.pipeline = ShaderLoader::CreateProgramPipeline(vertProgram, fragProgram, &log);
+		valid = variant.pipeline != 0;
+	}
+	else {
+		valid = ShaderLoader::UpdateProgramPipeline(variant.pipeline, vertProgram, fragProgram, &log);
+	}
+	if (!valid) {
+		// the fallback stands in again until the next reload of either stage
+		variant.ready = false;
+		variant.failed = true;
+		std::cout << "Shader variant " << Describe(features) << " failed to build:\n" << log;
+		return;
+	}
+	if (!variant.ready) {
+		variant.ready = true;
+		variant.readyMs = MsSince(variant.requested);
+	}
+	variant.failed = false;
+}
+
+void ShaderVariants::PrintReport() const {
+	auto describeOrigin = [](Origin origin) {
+		return origin == Origin::PROGRAM_CACHE ? "from cache"
+			: origin == Origin::COMPILED ? "compiled in place"
+			: origin == Origin::BATCH ? "compiled in a batch"
+			: origin == Origin::BACKGROUND ? "compiled by the reloader" : "program pipeline";
+	};
+	std::cout << "Shader variants of " << vertPath << " + " << fragPath << ": " << variants.size() << " requested";
+	if (separable) {
+		std::cout << ", as pipelines over " << stages[0].size() << " vertex and " << stages[1].size() << " fragment stage programs";
+	}
+	std::cout << std::endl;
+	for (int stage = 0; stage < 2; stage++) {
+		for (const auto& [features, built] : stages[stage]) {
+			std::cout << "  " << (stage == 0 ? "vertex stage " : "fragment stage ") << Describe(features) << ": ";
+			if (built.ready) {
+				std::cout << describeOrigin(built.origin) << ", ready after " << built.readyMs << " ms" << std::endl;
+			}
+			else {
+				std::cout << (built.failed ? "failed to build" : "never finished") << std::endl;
+			}
+		}
+	}
+	for (const auto& [features, variant] : variants) {
+		const char* origin = describeOrigin(variant.origin);
+		std::cout << "  " << Describe(features) << ": ";
+		if (variant.ready) {
+			std::cout << origin << ", ready after " << variant.readyMs << " ms";
+		}
+		else {
+			std::cout << (variant.failed ? "failed to build" : "never finished");
+		}
+		std::cout << ", used " << variant.uses << " times";
+		if (variant.fallbackUses > 0) {
+			std::cout << ", fallback stood in " << variant.fallbackUses << " times";
+		}
+		std::cout << std::endl;
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "ProgramBatch.h"
+#include "ShaderReloader.h"
+
+class ShaderPreprocessor;
+class ProgramCache;
+
+/*
+ * Programs built from one pair of shader files with different sets of
+ * feature defines, so optional work becomes an #ifdef instead of a runtime
+ * branch or a copied shader.
+ *
+ * A variant is a bitmask over the feature list: bit i defines features[i].
+ * The variant without any features is built up front and stands in for the
+ * others until they are ready. A variant that isn't in the program cache
+ * compiles the first time it's asked for: on the driver's threads with
+ * KHR_parallel_shader_compile, otherwise on the reloader's worker, and
+ * without either on the spot. It goes into the cache once it linked. Every
+ * built variant stays in memory for the rest of the session.
+ *
+ * With ARB_separate_shader_objects, each stage is linked on its own as a
+ * separable program and a variant is a program pipeline over two of them.
+ * A stage is only built once for every combination of the features its
+ * sources mention, so n vertex and m fragment variants take n + m links
+ * instead of n * m. Which features those are is worked out once, from the
+ * sources without any defines; a stage that starts using another feature
+ * during a hot reload session only picks it up after a restart.
+ */
+class ShaderVariants {
+public:
+	using Features = uint32_t;
+
+	// what to bind for a variant: a program, or a pipeline and the two stage programs it's made of
+	struct Binding {
+		unsigned int program = 0;
+		unsigned int pipeline = 0;
+		unsigned int vertProgram = 0;
+		unsigned int fragProgram = 0;
+
+		// glUseProgram for a program, glBindProgramPipeline with no program in use for a pipeline
+		void Use() const;
+		// false if not even the fallback built
+		explicit operator bool() const;
+		bool operator==(const Binding& other) const = default;
+	};
+
+	// reloader may be null; otherwise it owns the programs, keeps them up to date and has to outlive this
+	// usePipelines builds program pipelines where the driver has separate shader objects, monolithic programs otherwise
+	ShaderVariants(const std::string& vertPath, const std::string& fragPath, const std::vector<std::string>& features,
+		ShaderPreprocessor& preprocessor, ProgramCache& programCache, ShaderReloader* reloader, bool usePipelines = true);
+	~ShaderVariants();
+	ShaderVariants(const ShaderVariants&) = delete;
+	ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+	// the program or pipeline for features, or the fallback while it's compiling
+	Binding GetBinding(Features features);
+	bool UsesPipelines() const;
+	bool IsReady(Features features) const;
+	// starts building variants that are likely needed soon, all at once; staggered over frames without the extension
+	// with pipelines, missing stages compile on the spot since there are only a few of them
+	void Prewarm(const std::vector<Features>& featureSets);
+	// picks up finished variants; call once per frame, after ShaderReloader::Update
+	void Update();
+
+	std::vector<std::string> GetDefines(Features features) const;
+	// one line per requested variant: how it was built and how often it was used or stood in for
+	void PrintReport() const;
+
+private:
+	enum class Origin {
+		PROGRAM_CACHE,
+		COMPILED,
+		BATCH,
+		BACKGROUND,
+		PIPELINE
+	};
+	struct Variant {
+		unsigned int program = 0;
+		// handle is only valid once the reloader knows about the variant
+		ShaderReloader::Handle handle = 0;
+		bool registered = false;
+		ProgramBatch::Ticket ticket = 0;
+		Origin origin = Origin::COMPILED;
+		bool ready = false;
+		bool failed = false;
+		// sources a batch or background build is expected to use, kept until it's stored in the program cache
+		std::string vertShaderSrc{ };
+		std::string fragShaderSrc{ };
+		std::chrono::steady_clock::time_point requested{ };
+		double readyMs = 0.0;
+		// GetBinding calls answered with this variant, and with the fallback while it was compiling
+		size_t uses = 0;
+		size_t fallbackUses = 0;
+		// stage programs the pipeline was last assembled from; they change with hot reloads
+		unsigned int pipeline = 0;
+		unsigned int vertProgram = 0;
+		unsigned int fragProgram = 0;
+	};
+	struct Stage {
+		unsigned int program = 0;
+		ShaderReloader::Handle handle = 0;
+		bool registered = false;
+		Origin origin = Origin::COMPILED;
+		bool ready = false;
+		bool failed = false;
+		// the source a background build is expected to use, kept until it's stored in the program cache
+		std::string source{ };
+		std::chrono::steady_clock::time_point requested{ };
+		double readyMs = 0.0;
+	};
+
+	std::string vertPath;
+	std::string fragPath;
+	std::vector<std::string> features;
+	ShaderPreprocessor& preprocessor;
+	ProgramCache& programCache;
+	ShaderReloader* reloader;
+	std::map<Features, Variant> variants{ };
+	ProgramBatch batch{ };
+	bool separable = false;
+	// features the sources of the vertex and the fragment stage mention; the others can't change them
+	Features stageFeatures[2] = { 0, 0 };
+	// stage programs of the vertex and the fragment stage, by the features they were built with
+	std::map<Features, Stage> stages[2]{ };
+
+	// on a cache miss, prewarm goes to the batch even when it can only stagger, instead of the reloader or compiling on the spot
+	Variant& Request(Features features, bool prewarm);
+	void Register(Variant& variant, unsigned int program, const std::vector<std::string>& defines, const std::vector<std::string>& files);
+	void Store(Features features, Variant& variant, unsigned int program);
+	Binding Current(const Variant& variant) const;
+	std::string Describe(Features features) const;
+
+	// now builds missing stages on the spot instead of handing them to the reloader
+	void RequestPipeline(Features features, Variant& variant, bool now);
+	Stage& RequestStage(int stage, Features features, bool now);
+	void StoreStage(int stage, Features features, Stage& built, unsigned int program);
+	unsigned int CurrentStage(const Stage& built) const;
+	// (re)builds the pipeline once both stages are there, and again whenever a reload swapped one
+	void Assemble(Features features, Variant& variant);
+	Features FindStageFeatures(int stage) const;
+};
@@ -0,0 +1,290 @@
+#include "UniformTable.h"
+#include "../gl/GLExtensions.h"
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+#include <iostream>
+
+// shadow bytes for one element of a uniform that has a setter; 0 for types nothing can set
+static size_t ShadowBytes(unsigned int type) {
+	switch (type) {
+	case GL_FLOAT:
+		return sizeof(float);
+	case GL_FLOAT_VEC2:
+		return sizeof(glm::vec2);
+	case GL_FLOAT_VEC3:
+		return sizeof(glm::vec3);
+	case GL_FLOAT_VEC4:
+		return sizeof(glm::vec4);
+	case GL_FLOAT_MAT3:
+		return sizeof(glm::mat3);
+	case GL_FLOAT_MAT4:
+		return sizeof(glm::mat4);
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_1D_SHADOW:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_1D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_1D_ARRAY_SHADOW:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_2D_RECT:
+	case GL_SAMPLER_2D_RECT_SHADOW:
+	case GL_SAMPLER_BUFFER:
+	case GL_SAMPLER_2D_MULTISAMPLE:
+	case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+	case GL_INT_SAMPLER_1D:
+	case GL_INT_SAMPLER_2D:
+	case GL_INT_SAMPLER_3D:
+	case GL_INT_SAMPLER_CUBE:
+	case GL_INT_SAMPLER_1D_ARRAY:
+	case GL_INT_SAMPLER_2D_ARRAY:
+	case GL_INT_SAMPLER_2D_RECT:
+	case GL_INT_SAMPLER_BUFFER:
+	case GL_INT_SAMPLER_2D_MULTISAMPLE:
+	case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+	case GL_UNSIGNED_INT_SAMPLER_1D:
+	case GL_UNSIGNED_INT_SAMPLER_2D:
+	case GL_UNSIGNED_INT_SAMPLER_3D:
+	case GL_UNSIGNED_INT_SAMPLER_CUBE:
+	case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+	case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+	case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+	case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+	case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+	case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		return sizeof(int);
+	default:
+		return 0;
+	}
+}
+
+// glUniform1i sets ints, bools and samplers alike
+static bool Accepts(unsigned int declared, unsigned int given) {
+	if (given == GL_INT) {
+		return declared != GL_FLOAT && ShadowBytes(declared) == sizeof(int);
+	}
+	return declared == given;
+}
+
+UniformTable::UniformTable(unsigned int program) {
+	Reflect(program);
+}
+
+void UniformTable::Reflect(unsigned int program) {
+	this->program = program;
+	separable = false;
+	uniforms.clear();
+	values.clear();
+	AddUniforms(program);
+}
+
+void UniformTable::ReflectPipeline(unsigned int vertProgram, unsigned int fragProgram) {
+	program = vertProgram;
+	separable = true;
+	uniforms.clear();
+	values.clear();
+	AddUniforms(vertProgram);
+	AddUniforms(fragProgram);
+}
+
+void UniformTable::AddUniforms(unsigned int program) {
+	if (program == 0) {
+		return;
+	}
+
+	int count = 0;
+	int maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength + 1);
+	size_t offset = values.size();
+	for (int i = 0; i < count; i++) {
+		int nameLength = 0;
+		int size = 0;
+		unsigned int type = 0;
+		glGetActiveUniform(program, i, (int)nameBuffer.size(), &nameLength, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+		int location = glGetUniformLocation(program, name.c_str());
+		if (location < 0) {
+			// members of uniform blocks have no location, they're set through buffers
+			continue;
+		}
+		// arrays are reported as "name[0]"
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+			name.resize(name.size() - 3);
+		}
+		// another stage already has it, so it shares that slot and shadow value
+		int existing = Find(name);
+		if (existing >= 0) {
+			Uniform& uniform = uniforms[existing];
+			if (uniform.type != type) {
+				std::cerr << "Uniform " << name << " has a different type in each stage of the pipeline, only the vertex stage one is set" << std::endl;
+				continue;
+			}
+			uniform.targets.push_back(Target{ program, location });
+			continue;
+		}
+		size_t bytes = ShadowBytes(type);
+		uniforms.push_back(Uniform{ std::move(name), { Target{ program, location } }, type, size, offset, bytes, false, false });
+		offset += bytes;
+	}
+	values.resize(offset);
+}
+
+unsigned int UniformTable::GetProgram() const {
+	return program;
+}
+
+int UniformTable::Find(const std::string& name) const {
+	// a handful of uniforms per program, a linear scan beats hashing the name
+	for (size_t i = 0; i < uniforms.size(); i++) {
+		if (uniforms[i].name == name) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+size_t UniformTable::GetCount() const {
+	return uniforms.size();
+}
+
+bool UniformTable::Update(int slot, unsigned int type, const void* value, size_t bytes) {
+	if (slot < 0 || slot >= (int)uniforms.size()) {
+		return false;
+	}
+	Uniform& uniform = uniforms[slot];
+	if (!Accepts(uniform.type, type) || uniform.bytes != bytes) {
+		if (!uniform.reportedMismatch) {
+			std::cerr << "Uniform " << uniform.name << " set with the wrong type (declared 0x" << std::hex << uniform.type
+				<< ", given 0x" << type << std::dec << ")" << std::endl;
+			uniform.reportedMismatch = true;
+		}
+		return false;
+	}
+	unsigned char* shadow = values.data() + uniform.offset;
+	if (uniform.known && std::memcmp(shadow, value, bytes) == 0) {
+		stats.skipped++;
+		return false;
+	}
+	std::memcpy(shadow, value, bytes);
+	uniform.known = true;
+	stats.issued++;
+	return true;
+}
+
+void UniformTable::Set(int slot, float value) {
+	if (Update(slot, GL_FLOAT, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniform1f(target.program, target.location, value);
+			}
+			else {
+				glUniform1f(target.location, value);
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, int value) {
+	if (Update(slot, GL_INT, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniform1i(target.program, target.location, value);
+			}
+			else {
+				glUniform1i(target.location, value);
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, const glm::vec2& value) {
+	if (Update(slot, GL_FLOAT_VEC2, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniform2fv(target.program, target.location, 1, glm::value_ptr(value));
+			}
+			else {
+				glUniform2fv(target.location, 1, glm::value_ptr(value));
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, const glm::vec3& value) {
+	if (Update(slot, GL_FLOAT_VEC3, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniform3fv(target.program, target.location, 1, glm::value_ptr(value));
+			}
+			else {
+				glUniform3fv(target.location, 1, glm::value_ptr(value));
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, const glm::vec4& value) {
+	if (Update(slot, GL_FLOAT_VEC4, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniform4fv(target.program, target.location, 1, glm::value_ptr(value));
+			}
+			else {
+				glUniform4fv(target.location, 1, glm::value_ptr(value));
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, const glm::mat3& value) {
+	if (Update(slot, GL_FLOAT_MAT3, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniformMatrix3fv(target.program, target.location, 1, GL_FALSE, glm::value_ptr(value));
+			}
+			else {
+				glUniformMatrix3fv(target.location, 1, GL_FALSE, glm::value_ptr(value));
+			}
+		}
+	}
+}
+
+void UniformTable::Set(int slot, const glm::mat4& value) {
+	if (Update(slot, GL_FLOAT_MAT4, &value, sizeof(value))) {
+		for (const Target& target : uniforms[slot].targets) {
+			if (separable) {
+				gl_ext::ProgramUniformMatrix4fv(target.program, target.location, 1, GL_FALSE, glm::value_ptr(value));
+			}
+			else {
+				glUniformMatrix4fv(target.location, 1, GL_FALSE, glm::value_ptr(value));
+			}
+		}
+	}
+}
+
+void UniformTable::BeginFrame() {
+	stats = UniformStats{ };
+}
+
+const UniformStats& UniformTable::GetStats() const {
+	return stats;
+}
+
+void UniformTable::PrintUniforms() const {
+	std::cout << (separable ? "Program pipeline of " : "Program ") << program << " has " << uniforms.size() << " uniforms" << std::endl;
+	for (const Uniform& uniform : uniforms) {
+		std::cout << "  " << uniform.name << (uniform.size > 1 ? "[" + std::to_string(uniform.size) + "]" : "");
+		for (const Target& target : uniform.targets) {
+			std::cout << (separable ? " program " + std::to_string(target.program) : "") << " location " << target.location;
+		}
+		std::cout << " type 0x" << std::hex << uniform.type << std::dec << std::endl;
+	}
+}
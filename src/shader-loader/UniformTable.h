@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct UniformStats {
+	// glUniform calls made, and ones left out because the value was already set
+	size_t issued = 0;
+	size_t skipped = 0;
+};
+
+/*
+ * Every active uniform of a program, reflected once after linking, with the
+ * last value uploaded to each.
+ *
+ * The setters compare against that shadow copy and only call glUniform when
+ * the value actually changed. Uniforms the compiler optimized away, or that
+ * don't exist, are ignored the same way glUniform ignores location -1. A
+ * setter whose type doesn't match the declaration reports it once and does
+ * nothing. The program has to be bound with glUseProgram when setting.
+ *
+ * For a program pipeline, the table spans both stage programs: a uniform
+ * declared in both is one slot whose value goes to each, through
+ * glProgramUniform so nothing has to be bound.
+ */
+class UniformTable {
+public:
+	UniformTable() = default;
+	explicit UniformTable(unsigned int program);
+
+	// forgets the old program and all shadow values, e.g. after a hot reload
+	void Reflect(unsigned int program);
+	// the same for the two separable stage programs of a pipeline
+	void ReflectPipeline(unsigned int vertProgram, unsigned int fragProgram);
+	// the vertex stage program for a pipeline
+	unsigned int GetProgram() const;
+
+	// slot for name, usable instead of the name in hot paths; -1 if the program has no such uniform
+	int Find(const std::string& name) const;
+	size_t GetCount() const;
+
+	void Set(int slot, float value);
+	void Set(int slot, int value);
+	void Set(int slot, const glm::vec2& value);
+	void Set(int slot, const glm::vec3& value);
+	void Set(int slot, const glm::vec4& value);
+	void Set(int slot, const glm::mat3& value);
+	void Set(int slot, const glm::mat4& value);
+	template <typename T>
+	void Set(const std::string& name, const T& value) {
+		Set(Find(name), value);
+	}
+
+	// starts counting issued and skipped calls from zero
+	void BeginFrame();
+	const UniformStats& GetStats() const;
+	void PrintUniforms() const;
+
+private:
+	struct Target {
+		unsigned int program;
+		int location;
+	};
+	struct Uniform {
+		std::string name;
+		// one per program that declares it, so two for a uniform both stages of a pipeline use
+		std::vector<Target> targets;
+		unsigned int type;
+		// elements, for arrays; only the first one is shadowed
+		int size;
+		size_t offset;
+		size_t bytes;
+		// nothing uploaded yet, so the first set always goes through
+		bool known;
+		bool reportedMismatch;
+	};
+
+	unsigned int program = 0;
+	// set with glProgramUniform instead of glUniform
+	bool separable = false;
+	std::vector<Uniform> uniforms{ };
+	// shadow values of all uniforms, back to back
+	std::vector<unsigned char> values{ };
+	UniformStats stats{ };
+
+	void AddUniforms(unsigned int program);
+	// true if value differs from the shadow copy, which then gets updated
+	bool Update(int slot, unsigned int type, const void* value, size_t bytes);
+};
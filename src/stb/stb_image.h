@@ -523,6 +523,14 @@ extern "C" {
     STBIDEF void stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert);
     STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip);
 
+    // lets the JPEG decoder spread work over several threads. fn must call
+    // job(job_user, i) once for every i in [0, count), possibly concurrently,
+    // and only return once all of them have finished. Images decode to exactly
+    // the same pixels with or without it. Only images loaded from memory can
+    // have their entropy-coded data split up; pass NULL to turn it off again.
+    typedef void stbi_parallel_for_func(void* user, int count, void (*job)(void* job_user, int index), void* job_user);
+    STBIDEF void stbi_set_parallel_for(stbi_parallel_for_func* fn, void* user);
+
     // ZLIB client - used by PNG, available for other purposes
 
     STBIDEF char* stbi_zlib_decode_malloc_guesssize(const char* buffer, int len, int initial_size, int* outlen);
@@ -1112,6 +1120,15 @@ static stbi_uc* stbi__hdr_to_ldr(float* data, int x, int y, int comp);
 
 static int stbi__vertically_flip_on_load_global = 0;
 
+static stbi_parallel_for_func* stbi__parallel_for = NULL;
+static void* stbi__parallel_for_user = NULL;
+
+STBIDEF void stbi_set_parallel_for(stbi_parallel_for_func* fn, void* user)
+{
+    stbi__parallel_for = fn;
+    stbi__parallel_for_user = user;
+}
+
 STBIDEF void stbi_set_flip_vertically_on_load(int flag_true_if_should_flip)
 {
     stbi__vertically_flip_on_load_global = flag_true_if_should_flip;
@@ -2958,68 +2975,235 @@ static void stbi__jpeg_reset(stbi__jpeg* j)
     // since we don't even allow 1<<30 pixels
 }
 
+// blocks of a baseline scan whose IDCT is put off until the whole scan is decoded
+typedef struct
+{
+    short* coeff;     // 64 dequantized coefficients per block, in decode order
+    stbi_uc** out;    // where each block's pixels go
+    int* stride;
+    int count, capacity;
+    void* raw_coeff;
+    void (*idct_block_kernel)(stbi_uc* out, int out_stride, short data[64]);
+} stbi__jpeg_deferred;
+
+// number of MCUs in the current baseline scan; in a single component scan every block is an MCU
+static int stbi__jpeg_mcu_count(stbi__jpeg* z)
+{
+    if (z->scan_n == 1) {
+        int n = z->order[0];
+        return ((z->img_comp[n].x + 7) >> 3) * ((z->img_comp[n].y + 7) >> 3);
+    }
+    return z->img_mcu_x * z->img_mcu_y;
+}
+
+// decodes one MCU of a baseline scan and either IDCTs it straight away or queues its blocks in defer
+static int stbi__jpeg_decode_mcu(stbi__jpeg* z, int mcu, short data[64], stbi__jpeg_deferred* defer)
+{
+    int k, x, y;
+    for (k = 0; k < z->scan_n; ++k) {
+        int n = z->order[k];
+        int ha = z->img_comp[n].ha;
+        // non-interleaved data is in trivial scanline order, one block per MCU;
+        // interleaved MCUs hold an h by v group of blocks of every component
+        int bw = z->scan_n == 1 ? 1 : z->img_comp[n].h;
+        int bh = z->scan_n == 1 ? 1 : z->img_comp[n].v;
+        int mcu_x = z->scan_n == 1 ? (z->img_comp[n].x + 7) >> 3 : z->img_mcu_x;
+        int i = mcu % mcu_x, j = mcu / mcu_x;
+        for (y = 0; y < bh; ++y) {
+            for (x = 0; x < bw; ++x) {
+                int x2 = (i * bw + x) * 8;
+                int y2 = (j * bh + y) * 8;
+                stbi_uc* out = z->img_comp[n].data + z->img_comp[n].w2 * y2 + x2;
+                short* block = defer ? defer->coeff + 64 * defer->count : data;
+                if (!stbi__jpeg_decode_block(z, block, z->huff_dc + z->img_comp[n].hd, z->huff_ac + ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
+                if (defer) {
+                    defer->out[defer->count] = out;
+                    defer->stride[defer->count] = z->img_comp[n].w2;
+                    defer->count++;
+                }
+                else {
+                    z->idct_block_kernel(out, z->img_comp[n].w2, block);
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+#define STBI__JPEG_IDCT_BATCH 64
+
+static int stbi__jpeg_deferred_init(stbi__jpeg* z, stbi__jpeg_deferred* defer, int mcu_count)
+{
+    int k, blocks_per_mcu = 0;
+    if (z->scan_n == 1)
+        blocks_per_mcu = 1;
+    else
+        for (k = 0; k < z->scan_n; ++k)
+            blocks_per_mcu += z->img_comp[z->order[k]].h * z->img_comp[z->order[k]].v;
+    memset(defer, 0, sizeof(*defer));
+    if (!stbi__mul2sizes_valid(mcu_count, blocks_per_mcu)) return 0;
+    defer->capacity = mcu_count * blocks_per_mcu;
+    defer->raw_coeff = stbi__malloc_mad3(defer->capacity, 64 * sizeof(short), 1, 15);
+    defer->out = (stbi_uc**)stbi__malloc_mad2(defer->capacity, sizeof(stbi_uc*), 0);
+    defer->stride = (int*)stbi__malloc_mad2(defer->capacity, sizeof(int), 0);
+    defer->idct_block_kernel = z->idct_block_kernel;
+    if (!defer->raw_coeff || !defer->out || !defer->stride) {
+        STBI_FREE(defer->raw_coeff);
+        STBI_FREE(defer->out);
+        STBI_FREE(defer->stride);
+        return 0;
+    }
+    // the SIMD IDCT uses aligned loads
+    defer->coeff = (short*)(((size_t)defer->raw_coeff + 15) & ~15);
+    return 1;
+}
+
+static void stbi__jpeg_deferred_idct(void* user, int batch)
+{
+    stbi__jpeg_deferred* defer = (stbi__jpeg_deferred*)user;
+    int b = batch * STBI__JPEG_IDCT_BATCH;
+    int end = b + STBI__JPEG_IDCT_BATCH < defer->count ? b + STBI__JPEG_IDCT_BATCH : defer->count;
+    for (; b < end; ++b)
+        defer->idct_block_kernel(defer->out[b], defer->stride[b], defer->coeff + 64 * b);
+}
+
+// restart intervals of a baseline scan that are decoded on worker threads
+typedef struct
+{
+    stbi__jpeg* z;
+    stbi_uc** seg_start;  // entropy-coded data of each interval
+    stbi_uc** seg_end;    // one past the restart marker that closes it
+    int* seg_ok;
+} stbi__jpeg_restart_jobs;
+
+static void stbi__jpeg_decode_restart_segment(void* user, int seg)
+{
+    stbi__jpeg_restart_jobs* jobs = (stbi__jpeg_restart_jobs*)user;
+    stbi__jpeg* j = (stbi__jpeg*)stbi__malloc(sizeof(stbi__jpeg));
+    stbi__context s;
+    STBI_SIMD_ALIGN(short, data[64]);
+    int mcu, end, ok = j != NULL;
+    if (ok) {
+        // a private copy of the decoder reading only this interval; output blocks don't overlap
+        memcpy(j, jobs->z, sizeof(stbi__jpeg));
+        stbi__start_mem(&s, jobs->seg_start[seg], (int)(jobs->seg_end[seg] - jobs->seg_start[seg]));
+        j->s = &s;
+        stbi__jpeg_reset(j);
+        mcu = seg * j->restart_interval;
+        end = mcu + j->restart_interval;
+        for (; mcu < end && ok; ++mcu)
+            ok = stbi__jpeg_decode_mcu(j, mcu, data, NULL);
+        // the serial decoder only carries on past this interval if it sees the restart marker here
+        if (ok) {
+            if (j->code_bits < 24) stbi__grow_buffer_unsafe(j);
+            ok = STBI__RESTART(j->marker);
+        }
+        STBI_FREE(j);
+    }
+    jobs->seg_ok[seg] = ok;
+}
+
+// decodes a baseline scan one restart interval per job; returns -1 without
+// touching the stream if the scan can't be split, otherwise what the serial
+// decoder would have returned
+static int stbi__jpeg_parse_restart_parallel(stbi__jpeg* z, int mcu_count)
+{
+    stbi__jpeg_restart_jobs jobs;
+    STBI_SIMD_ALIGN(short, data[64]);
+    stbi_uc* p, * end;
+    int seg_count, seg, mcu, ok = 1;
+
+    if (!z->restart_interval || z->s->read_from_callbacks) return -1;
+    seg_count = (mcu_count + z->restart_interval - 1) / z->restart_interval;
+    if (seg_count < 2) return -1;
+    jobs.z = z;
+    jobs.seg_start = (stbi_uc**)stbi__malloc_mad2(seg_count, sizeof(stbi_uc*), 0);
+    jobs.seg_end = (stbi_uc**)stbi__malloc_mad2(seg_count, sizeof(stbi_uc*), 0);
+    jobs.seg_ok = (int*)stbi__malloc_mad2(seg_count, sizeof(int), 0);
+    if (!jobs.seg_start || !jobs.seg_end || !jobs.seg_ok) ok = 0;
+
+    // find the restart markers up to the first marker of any other kind, which ends the scan
+    if (ok) {
+        p = z->s->img_buffer;
+        end = z->s->img_buffer_end;
+        seg = 0;
+        jobs.seg_start[0] = p;
+        while (p < end && seg < seg_count - 1) {
+            int c;
+            if (*p++ != 0xff) continue;
+            while (p < end && *p == 0xff) ++p; // fill bytes
+            if (p == end) break;
+            c = *p++;
+            if (c == 0) continue; // stuffed zero
+            if (!STBI__RESTART(c)) break;
+            jobs.seg_end[seg] = p;
+            jobs.seg_start[++seg] = p;
+        }
+        // anything unusual, like a truncated file, is left to the serial decoder
+        ok = seg == seg_count - 1;
+    }
+    if (ok) {
+        stbi__parallel_for(stbi__parallel_for_user, seg_count - 1, stbi__jpeg_decode_restart_segment, &jobs);
+        for (seg = 0; seg < seg_count - 1; ++seg)
+            ok &= jobs.seg_ok[seg];
+    }
+    if (!ok) {
+        STBI_FREE(jobs.seg_start);
+        STBI_FREE(jobs.seg_end);
+        STBI_FREE(jobs.seg_ok);
+        return -1;
+    }
+
+    // the last interval runs on z itself so the stream ends up exactly where the serial decoder leaves it
+    z->s->img_buffer = jobs.seg_start[seg_count - 1];
+    STBI_FREE(jobs.seg_start);
+    STBI_FREE(jobs.seg_end);
+    STBI_FREE(jobs.seg_ok);
+    stbi__jpeg_reset(z);
+    for (mcu = (seg_count - 1) * z->restart_interval; mcu < mcu_count; ++mcu) {
+        if (!stbi__jpeg_decode_mcu(z, mcu, data, NULL)) return 0;
+        if (--z->todo <= 0) {
+            if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
+            if (!STBI__RESTART(z->marker)) return 1;
+            stbi__jpeg_reset(z);
+        }
+    }
+    return 1;
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg* z)
 {
     stbi__jpeg_reset(z);
     if (!z->progressive) {
-        if (z->scan_n == 1) {
-            int i, j;
-            STBI_SIMD_ALIGN(short, data[64]);
-            int n = z->order[0];
-            // non-interleaved data, we just need to process one block at a time,
-            // in trivial scanline order
-            // number of blocks to do just depends on how many actual "pixels" this
-            // component has, independent of interleaved MCU blocking and such
-            int w = (z->img_comp[n].x + 7) >> 3;
-            int h = (z->img_comp[n].y + 7) >> 3;
-            for (j = 0; j < h; ++j) {
-                for (i = 0; i < w; ++i) {
-                    int ha = z->img_comp[n].ha;
-                    if (!stbi__jpeg_decode_block(z, data, z->huff_dc + z->img_comp[n].hd, z->huff_ac + ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                    z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * j * 8 + i * 8, z->img_comp[n].w2, data);
-                    // every data block is an MCU, so countdown the restart interval
-                    if (--z->todo <= 0) {
-                        if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
-                        // if it's NOT a restart, then just bail, so we get corrupt data
-                        // rather than no data
-                        if (!STBI__RESTART(z->marker)) return 1;
-                        stbi__jpeg_reset(z);
-                    }
-                }
+        STBI_SIMD_ALIGN(short, data[64]);
+        stbi__jpeg_deferred deferred, * defer = NULL;
+        int mcu, mcu_count = stbi__jpeg_mcu_count(z), result = 1;
+        if (stbi__parallel_for) {
+            result = stbi__jpeg_parse_restart_parallel(z, mcu_count);
+            if (result >= 0) return result;
+            // no restart intervals to split on, so at least spread the IDCT out
+            if (stbi__jpeg_deferred_init(z, &deferred, mcu_count)) defer = &deferred;
+            result = 1;
+        }
+        for (mcu = 0; mcu < mcu_count; ++mcu) {
+            if (!stbi__jpeg_decode_mcu(z, mcu, data, defer)) { result = 0; break; }
+            // after every MCU count down the restart interval
+            if (--z->todo <= 0) {
+                if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
+                // if it's NOT a restart, then just bail, so we get corrupt data
+                // rather than no data
+                if (!STBI__RESTART(z->marker)) break;
+                stbi__jpeg_reset(z);
             }
-            return 1;
         }
-        else { // interleaved
-            int i, j, k, x, y;
-            STBI_SIMD_ALIGN(short, data[64]);
-            for (j = 0; j < z->img_mcu_y; ++j) {
-                for (i = 0; i < z->img_mcu_x; ++i) {
-                    // scan an interleaved mcu... process scan_n components in order
-                    for (k = 0; k < z->scan_n; ++k) {
-                        int n = z->order[k];
-                        // scan out an mcu's worth of this component; that's just determined
-                        // by the basic H and V specified for the component
-                        for (y = 0; y < z->img_comp[n].v; ++y) {
-                            for (x = 0; x < z->img_comp[n].h; ++x) {
-                                int x2 = (i * z->img_comp[n].h + x) * 8;
-                                int y2 = (j * z->img_comp[n].v + y) * 8;
-                                int ha = z->img_comp[n].ha;
-                                if (!stbi__jpeg_decode_block(z, data, z->huff_dc + z->img_comp[n].hd, z->huff_ac + ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                                z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * y2 + x2, z->img_comp[n].w2, data);
-                            }
-                        }
-                    }
-                    // after all interleaved components, that's an interleaved MCU,
-                    // so now count down the restart interval
-                    if (--z->todo <= 0) {
-                        if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
-                        if (!STBI__RESTART(z->marker)) return 1;
-                        stbi__jpeg_reset(z);
-                    }
-                }
-            }
-            return 1;
+        if (defer) {
+            if (result)
+                stbi__parallel_for(stbi__parallel_for_user, (defer->count + STBI__JPEG_IDCT_BATCH - 1) / STBI__JPEG_IDCT_BATCH, stbi__jpeg_deferred_idct, defer);
+            STBI_FREE(defer->raw_coeff);
+            STBI_FREE(defer->out);
+            STBI_FREE(defer->stride);
         }
+        return result;
     }
     else {
         if (z->scan_n == 1) {
@@ -3093,22 +3277,35 @@ static void stbi__jpeg_dequantize(short* data, stbi__uint16* dequant)
         data[i] *= dequant[i];
 }
 
+// dequantize and idct one row of blocks; rows of all components are numbered one after another
+static void stbi__jpeg_finish_row(void* user, int j)
+{
+    stbi__jpeg* z = (stbi__jpeg*)user;
+    int i, w, n = 0;
+    while (j >= (z->img_comp[n].y + 7) >> 3) {
+        j -= (z->img_comp[n].y + 7) >> 3;
+        ++n;
+    }
+    w = (z->img_comp[n].x + 7) >> 3;
+    for (i = 0; i < w; ++i) {
+        short* data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
+        stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
+        z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * j * 8 + i * 8, z->img_comp[n].w2, data);
+    }
+}
+
 static void stbi__jpeg_finish(stbi__jpeg* z)
 {
     if (z->progressive) {
         // dequantize and idct the data
-        int i, j, n;
-        for (n = 0; n < z->s->img_n; ++n) {
-            int w = (z->img_comp[n].x + 7) >> 3;
-            int h = (z->img_comp[n].y + 7) >> 3;
-            for (j = 0; j < h; ++j) {
-                for (i = 0; i < w; ++i) {
-                    short* data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
-                    stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-                    z->idct_block_kernel(z->img_comp[n].data + z->img_comp[n].w2 * j * 8 + i * 8, z->img_comp[n].w2, data);
-                }
-            }
-        }
+        int j, n, rows = 0;
+        for (n = 0; n < z->s->img_n; ++n)
+            rows += (z->img_comp[n].y + 7) >> 3;
+        if (stbi__parallel_for)
+            stbi__parallel_for(stbi__parallel_for_user, rows, stbi__jpeg_finish_row, z);
+        else
+            for (j = 0; j < rows; ++j)
+                stbi__jpeg_finish_row(z, j);
     }
 }
 
@@ -3883,6 +4080,171 @@ static stbi_uc stbi__blinn_8x8(stbi_uc x, stbi_uc y)
     return (stbi_uc)((t + (t >> 8)) >> 8);
 }
 
+// everything load_jpeg_image needs to resample and color convert any range of rows
+typedef struct
+{
+    stbi__jpeg* z;
+    stbi__resample res_comp[4]; // resamplers positioned at row 0
+    stbi_uc* output;
+    stbi_uc* scratch;           // per chunk line buffers and spare output row when converting in parallel
+    size_t chunk_scratch;
+    int n, decode_n, is_rgb;
+} stbi__jpeg_convert;
+
+#define STBI__JPEG_CONVERT_ROWS 32
+
+// moves a resampler from row 0 to just before it produces row `rows`
+static void stbi__resample_seek(stbi__resample* r, stbi__jpeg* z, int k, unsigned int rows)
+{
+    unsigned int steps = (unsigned int)(r->vs >> 1) + rows;
+    unsigned int wraps = steps / r->vs;
+    unsigned int last = (unsigned int)z->img_comp[k].y - 1;
+    r->ystep = steps % r->vs;
+    r->ypos = wraps;
+    r->line1 = z->img_comp[k].data + z->img_comp[k].w2 * (wraps < last ? wraps : last);
+    if (wraps)
+        r->line0 = z->img_comp[k].data + z->img_comp[k].w2 * (wraps - 1 < last ? wraps - 1 : last);
+}
+
+// rows are written with one byte of slack past their end, so a chunk that isn't
+// the last must put its final row in spare_row to keep off the next chunk's pixels
+static void stbi__jpeg_convert_rows(stbi__jpeg_convert* c, stbi_uc** linebuf, stbi_uc* spare_row, unsigned int row_begin, unsigned int row_end)
+{
+    stbi__jpeg* z = c->z;
+    stbi_uc* output = c->output;
+    int k, n = c->n, decode_n = c->decode_n, is_rgb = c->is_rgb;
+    unsigned int i, j;
+    stbi_uc* coutput[4] = { NULL, NULL, NULL, NULL };
+    stbi__resample res_comp[4];
+
+    for (k = 0; k < decode_n; ++k) {
+        res_comp[k] = c->res_comp[k];
+        if (row_begin) stbi__resample_seek(&res_comp[k], z, k, row_begin);
+    }
+    for (j = row_begin; j < row_end; ++j) {
+        stbi_uc* row = output + n * z->s->img_x * j;
+        stbi_uc* out = spare_row && j + 1 == row_end ? spare_row : row;
+        for (k = 0; k < decode_n; ++k) {
+            stbi__resample* r = &res_comp[k];
+            int y_bot = r->ystep >= (r->vs >> 1);
+            coutput[k] = r->resample(linebuf[k],
+                y_bot ? r->line1 : r->line0,
+                y_bot ? r->line0 : r->line1,
+                r->w_lores, r->hs);
+            if (++r->ystep >= r->vs) {
+                r->ystep = 0;
+                r->line0 = r->line1;
+                if (++r->ypos < z->img_comp[k].y)
+                    r->line1 += z->img_comp[k].w2;
+            }
+        }
+        if (n >= 3) {
+            stbi_uc* y = coutput[0];
+            if (z->s->img_n == 3) {
+                if (is_rgb) {
+                    for (i = 0; i < z->s->img_x; ++i) {
+                        out[0] = y[i];
+                        out[1] = coutput[1][i];
+                        out[2] = coutput[2][i];
+                        out[3] = 255;
+                        out += n;
+                    }
+                }
+                else {
+                    z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+                }
+            }
+            else if (z->s->img_n == 4) {
+                if (z->app14_color_transform == 0) { // CMYK
+                    for (i = 0; i < z->s->img_x; ++i) {
+                        stbi_uc m = coutput[3][i];
+                        out[0] = stbi__blinn_8x8(coutput[0][i], m);
+                        out[1] = stbi__blinn_8x8(coutput[1][i], m);
+                        out[2] = stbi__blinn_8x8(coutput[2][i], m);
+                        out[3] = 255;
+                        out += n;
+                    }
+                }
+                else if (z->app14_color_transform == 2) { // YCCK
+                    z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+                    for (i = 0; i < z->s->img_x; ++i) {
+                        stbi_uc m = coutput[3][i];
+                        out[0] = stbi__blinn_8x8(255 - out[0], m);
+                        out[1] = stbi__blinn_8x8(255 - out[1], m);
+                        out[2] = stbi__blinn_8x8(255 - out[2], m);
+                        out += n;
+                    }
+                }
+                else { // YCbCr + alpha?  Ignore the fourth channel for now
+                    z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
+                }
+            }
+            else
+                for (i = 0; i < z->s->img_x; ++i) {
+                    out[0] = out[1] = out[2] = y[i];
+                    out[3] = 255; // not used if n==3
+                    out += n;
+                }
+        }
+        else {
+            if (is_rgb) {
+                if (n == 1)
+                    for (i = 0; i < z->s->img_x; ++i)
+                        *out++ = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
+                else {
+                    for (i = 0; i < z->s->img_x; ++i, out += 2) {
+                        out[0] = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
+                        out[1] = 255;
+                    }
+                }
+            }
+            else if (z->s->img_n == 4 && z->app14_color_transform == 0) {
+                for (i = 0; i < z->s->img_x; ++i) {
+                    stbi_uc m = coutput[3][i];
+                    stbi_uc r = stbi__blinn_8x8(coutput[0][i], m);
+                    stbi_uc g = stbi__blinn_8x8(coutput[1][i], m);
+                    stbi_uc b = stbi__blinn_8x8(coutput[2][i], m);
+                    out[0] = stbi__compute_y(r, g, b);
+                    out[1] = 255;
+                    out += n;
+                }
+            }
+            else if (z->s->img_n == 4 && z->app14_color_transform == 2) {
+                for (i = 0; i < z->s->img_x; ++i) {
+                    out[0] = stbi__blinn_8x8(255 - coutput[0][i], coutput[3][i]);
+                    out[1] = 255;
+                    out += n;
+                }
+            }
+            else {
+                stbi_uc* y = coutput[0];
+                if (n == 1)
+                    for (i = 0; i < z->s->img_x; ++i) out[i] = y[i];
+                else
+                    for (i = 0; i < z->s->img_x; ++i) { *out++ = y[i]; *out++ = 255; }
+            }
+        }
+        if (spare_row && j + 1 == row_end)
+            memcpy(row, spare_row, n * z->s->img_x);
+    }
+}
+
+static void stbi__jpeg_convert_chunk(void* user, int chunk)
+{
+    stbi__jpeg_convert* c = (stbi__jpeg_convert*)user;
+    stbi_uc* linebuf[4];
+    stbi_uc* scratch = c->scratch + c->chunk_scratch * chunk;
+    unsigned int row_begin = (unsigned int)chunk * STBI__JPEG_CONVERT_ROWS;
+    unsigned int row_end = row_begin + STBI__JPEG_CONVERT_ROWS;
+    int k;
+    for (k = 0; k < c->decode_n; ++k)
+        linebuf[k] = scratch + (size_t)k * (c->z->s->img_x + 3);
+    if (row_end >= c->z->s->img_y)
+        stbi__jpeg_convert_rows(c, linebuf, NULL, row_begin, c->z->s->img_y);
+    else
+        stbi__jpeg_convert_rows(c, linebuf, scratch + (size_t)c->decode_n * (c->z->s->img_x + 3), row_begin, row_end);
+}
+
 static stbi_uc* load_jpeg_image(stbi__jpeg* z, int* out_x, int* out_y, int* comp, int req_comp)
 {
     int n, decode_n, is_rgb;
@@ -3910,12 +4272,10 @@ static stbi_uc* load_jpeg_image(stbi__jpeg* z, int* out_x, int* out_y, int* comp
 
     // resample and color-convert
     {
-        int k;
-        unsigned int i, j;
+        int k, chunks;
         stbi_uc* output;
-        stbi_uc* coutput[4] = { NULL, NULL, NULL, NULL };
-
-        stbi__resample res_comp[4];
+        stbi__jpeg_convert convert;
+        stbi__resample* res_comp = convert.res_comp;
 
         for (k = 0; k < decode_n; ++k) {
             stbi__resample* r = &res_comp[k];
@@ -3943,109 +4303,27 @@ static stbi_uc* load_jpeg_image(stbi__jpeg* z, int* out_x, int* out_y, int* comp
         output = (stbi_uc*)stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
         if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
 
-        // now go ahead and resample
-        for (j = 0; j < z->s->img_y; ++j) {
-            stbi_uc* out = output + n * z->s->img_x * j;
-            for (k = 0; k < decode_n; ++k) {
-                stbi__resample* r = &res_comp[k];
-                int y_bot = r->ystep >= (r->vs >> 1);
-                coutput[k] = r->resample(z->img_comp[k].linebuf,
-                    y_bot ? r->line1 : r->line0,
-                    y_bot ? r->line0 : r->line1,
-                    r->w_lores, r->hs);
-                if (++r->ystep >= r->vs) {
-                    r->ystep = 0;
-                    r->line0 = r->line1;
-                    if (++r->ypos < z->img_comp[k].y)
-                        r->line1 += z->img_comp[k].w2;
-                }
-            }
-            if (n >= 3) {
-                stbi_uc* y = coutput[0];
-                if (z->s->img_n == 3) {
-                    if (is_rgb) {
-                        for (i = 0; i < z->s->img_x; ++i) {
-                            out[0] = y[i];
-                            out[1] = coutput[1][i];
-                            out[2] = coutput[2][i];
-                            out[3] = 255;
-                            out += n;
-                        }
-                    }
-                    else {
-                        z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-                    }
-                }
-                else if (z->s->img_n == 4) {
-                    if (z->app14_color_transform == 0) { // CMYK
-                        for (i = 0; i < z->s->img_x; ++i) {
-                            stbi_uc m = coutput[3][i];
-                            out[0] = stbi__blinn_8x8(coutput[0][i], m);
-                            out[1] = stbi__blinn_8x8(coutput[1][i], m);
-                            out[2] = stbi__blinn_8x8(coutput[2][i], m);
-                            out[3] = 255;
-                            out += n;
-                        }
-                    }
-                    else if (z->app14_color_transform == 2) { // YCCK
-                        z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-                        for (i = 0; i < z->s->img_x; ++i) {
-                            stbi_uc m = coutput[3][i];
-                            out[0] = stbi__blinn_8x8(255 - out[0], m);
-                            out[1] = stbi__blinn_8x8(255 - out[1], m);
-                            out[2] = stbi__blinn_8x8(255 - out[2], m);
-                            out += n;
-                        }
-                    }
-                    else { // YCbCr + alpha?  Ignore the fourth channel for now
-                        z->YCbCr_to_RGB_kernel(out, y, coutput[1], coutput[2], z->s->img_x, n);
-                    }
-                }
-                else
-                    for (i = 0; i < z->s->img_x; ++i) {
-                        out[0] = out[1] = out[2] = y[i];
-                        out[3] = 255; // not used if n==3
-                        out += n;
-                    }
-            }
-            else {
-                if (is_rgb) {
-                    if (n == 1)
-                        for (i = 0; i < z->s->img_x; ++i)
-                            *out++ = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
-                    else {
-                        for (i = 0; i < z->s->img_x; ++i, out += 2) {
-                            out[0] = stbi__compute_y(coutput[0][i], coutput[1][i], coutput[2][i]);
-                            out[1] = 255;
-                        }
-                    }
-                }
-                else if (z->s->img_n == 4 && z->app14_color_transform == 0) {
-                    for (i = 0; i < z->s->img_x; ++i) {
-                        stbi_uc m = coutput[3][i];
-                        stbi_uc r = stbi__blinn_8x8(coutput[0][i], m);
-                        stbi_uc g = stbi__blinn_8x8(coutput[1][i], m);
-                        stbi_uc b = stbi__blinn_8x8(coutput[2][i], m);
-                        out[0] = stbi__compute_y(r, g, b);
-                        out[1] = 255;
-                        out += n;
-                    }
-                }
-                else if (z->s->img_n == 4 && z->app14_color_transform == 2) {
-                    for (i = 0; i < z->s->img_x; ++i) {
-                        out[0] = stbi__blinn_8x8(255 - coutput[0][i], coutput[3][i]);
-                        out[1] = 255;
-                        out += n;
-                    }
-                }
-                else {
-                    stbi_uc* y = coutput[0];
-                    if (n == 1)
-                        for (i = 0; i < z->s->img_x; ++i) out[i] = y[i];
-                    else
-                        for (i = 0; i < z->s->img_x; ++i) { *out++ = y[i]; *out++ = 255; }
-                }
-            }
+        convert.z = z;
+        convert.output = output;
+        convert.n = n;
+        convert.decode_n = decode_n;
+        convert.is_rgb = is_rgb;
+        convert.scratch = NULL;
+        convert.chunk_scratch = (size_t)decode_n * (z->s->img_x + 3) + (size_t)n * z->s->img_x;
+
+        // rows only depend on the decoded planes, so chunks of them can be converted independently
+        chunks = (int)((z->s->img_y + STBI__JPEG_CONVERT_ROWS - 1) / STBI__JPEG_CONVERT_ROWS);
+        if (stbi__parallel_for && chunks > 1 && convert.chunk_scratch <= INT_MAX)
+            convert.scratch = (stbi_uc*)stbi__malloc_mad2(chunks, (int)convert.chunk_scratch, 0);
+        if (convert.scratch) {
+            stbi__parallel_for(stbi__parallel_for_user, chunks, stbi__jpeg_convert_chunk, &convert);
+            STBI_FREE(convert.scratch);
+        }
+        else {
+            stbi_uc* linebuf[4];
+            for (k = 0; k < decode_n; ++k)
+                linebuf[k] = z->img_comp[k].linebuf;
+            stbi__jpeg_convert_rows(&convert, linebuf, NULL, 0, z->s->img_y);
         }
         stbi__cleanup_jpeg(z);
         *out_x = z->s->img_x;
@@ -4114,13 +4392,24 @@ static int stbi__jpeg_info(stbi__context* s, int* x, int* y, int* comp)
 //      - all output is written to a single output buffer (can malloc/realloc)
 //    performance
 //      - fast huffman
+//      - 64-bit bit buffer refilled a word at a time
+//      - literal pairs decoded with one table lookup
+//      - back-references copied 8 bytes at a time away from the buffer ends
 
 #ifndef STBI_NO_ZLIB
 
 // fast-way is faster to check than jpeg huffman, but slow way is slower
-#define STBI__ZFAST_BITS  9 // accelerate all cases in default tables
+#define STBI__ZFAST_BITS  10 // accelerate all cases in default tables
 #define STBI__ZFAST_MASK  ((1 << STBI__ZFAST_BITS) - 1)
 #define STBI__ZNSYMS 288 // number of symbols in literal/length alphabet
+#define STBI__ZMULTI_BITS 11 // literal/length lookup that can also return two literals at once
+#define STBI__ZMULTI_MASK ((1 << STBI__ZMULTI_BITS) - 1)
+// bits one refill must provide so a length, its extra bits, a distance and its extra bits never refill midway
+#define STBI__ZFAST_REFILL 48
+// output room needed to write a longest match 8 bytes at a time without checking the end
+#define STBI__ZCOPY_SLACK (258 + 8)
+
+typedef unsigned long long stbi__zbits;
 
 // zlib-style huffman encoding
 // (jpegs packs from left, zlib from right, so can't share code)
@@ -4209,7 +4498,8 @@ typedef struct
     stbi_uc* zbuffer, * zbuffer_end;
     int num_bits;
     int hit_zeof_once;
-    stbi__uint32 code_buffer;
+    // bits above num_bits are always zero
+    stbi__zbits code_buffer;
 
     char* zout;
     char* zout_start;
@@ -4217,6 +4507,8 @@ typedef struct
     int   z_expandable;
 
     stbi__zhuffman z_length, z_distance;
+    // literal/length lookup for the fast loop, see stbi__zbuild_length_multi
+    stbi__uint32 z_length_multi[1 << STBI__ZMULTI_BITS];
 } stbi__zbuf;
 
 stbi_inline static int stbi__zeof(stbi__zbuf* z)
@@ -4232,20 +4524,20 @@ stbi_inline static stbi_uc stbi__zget8(stbi__zbuf* z)
 static void stbi__fill_bits(stbi__zbuf* z)
 {
     do {
-        if (z->code_buffer >= (1U << z->num_bits)) {
+        if (z->code_buffer >= ((stbi__zbits)1 << z->num_bits)) {
             z->zbuffer = z->zbuffer_end;  /* treat this as EOF so we fail. */
             return;
         }
-        z->code_buffer |= (unsigned int)stbi__zget8(z) << z->num_bits;
+        z->code_buffer |= (stbi__zbits)stbi__zget8(z) << z->num_bits;
         z->num_bits += 8;
-    } while (z->num_bits <= 24);
+    } while (z->num_bits <= 56);
 }
 
 stbi_inline static unsigned int stbi__zreceive(stbi__zbuf* z, int n)
 {
     unsigned int k;
     if (z->num_bits < n) stbi__fill_bits(z);
-    k = z->code_buffer & ((1 << n) - 1);
+    k = (unsigned int)(z->code_buffer & ((1 << n) - 1));
     z->code_buffer >>= n;
     z->num_bits -= n;
     return k;
@@ -4256,7 +4548,7 @@ static int stbi__zhuffman_decode_slowpath(stbi__zbuf* a, stbi__zhuffman* z)
     int b, s, k;
     // not resolved by fast table, so compute it the slow way
     // use jpeg approach, which requires MSbits at top
-    k = stbi__bit_reverse(a->code_buffer, 16);
+    k = stbi__bit_reverse((int)(a->code_buffer & 0xffff), 16);
     for (s = STBI__ZFAST_BITS + 1; ; ++s)
         if (k < z->maxcode[s])
             break;
@@ -4324,6 +4616,29 @@ static int stbi__zexpand(stbi__zbuf* z, char* zout, int n)  // need to make room
     return 1;
 }
 
+// Each entry is one of
+//   (1 << 31) | (bits << 24) | (second literal << 9) | first literal, when two literals fit in the index
+//   (bits << 24) | symbol, for a single code of up to STBI__ZFAST_BITS bits
+//   0, when the code is longer and needs the slow path
+static void stbi__zbuild_length_multi(stbi__zbuf* a)
+{
+    int i;
+    for (i = 0; i < (1 << STBI__ZMULTI_BITS); ++i) {
+        int first = a->z_length.fast[i & STBI__ZFAST_MASK], second, s1, s2;
+        a->z_length_multi[i] = 0;
+        if (!first) continue;
+        s1 = first >> 9;
+        a->z_length_multi[i] = (stbi__uint32)((s1 << 24) | (first & 511));
+        if ((first & 511) >= 256) continue;
+        // only the low STBI__ZMULTI_BITS - s1 bits are real, which is enough when the second code fits
+        second = a->z_length.fast[(i >> s1) & STBI__ZFAST_MASK];
+        if (!second || (second & 511) >= 256) continue;
+        s2 = second >> 9;
+        if (s1 + s2 > STBI__ZMULTI_BITS) continue;
+        a->z_length_multi[i] = (stbi__uint32)((1u << 31) | ((s1 + s2) << 24) | ((second & 255) << 9) | (first & 255));
+    }
+}
+
 static const int stbi__zlength_base[31] = {
    3,4,5,6,7,8,9,10,11,13,
    15,17,19,23,27,31,35,43,51,59,
@@ -4338,11 +4653,142 @@ static const int stbi__zdist_base[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129
 static const int stbi__zdist_extra[32] =
 { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
 
+// Decodes while at least 8 input bytes and STBI__ZCOPY_SLACK bytes of output room remain,
+// so a single word load refills the bit buffer for a whole length/distance pair and
+// matches can be copied 8 bytes at a time without end checks. The bit buffer lives in
+// locals because stores through zout may alias a and would force it to be reloaded.
+// Returns 1 at the end of the block, 0 on error and -1 when it runs out of margin.
+static int stbi__parse_huffman_block_fast(stbi__zbuf* a)
+{
+    stbi__zbits code_buffer = a->code_buffer;
+    int num_bits = a->num_bits;
+    stbi_uc* zbuffer = a->zbuffer;
+    char* zout = a->zout;
+    const stbi__uint16* distance_fast = a->z_distance.fast;
+    int result = -1;
+
+#define STBI__ZFAST_SAVE() (a->code_buffer = code_buffer, a->num_bits = num_bits, a->zbuffer = zbuffer, a->zout = zout)
+#define STBI__ZFAST_LOAD() (code_buffer = a->code_buffer, num_bits = a->num_bits)
+    while (a->zbuffer_end - zbuffer >= 8 && a->zout_end - zout >= STBI__ZCOPY_SLACK) {
+        stbi__uint32 entry;
+        int b, z, len, dist;
+        stbi_uc* p;
+        if (num_bits < STBI__ZFAST_REFILL) {
+            stbi__zbits word;
+            int bytes = (63 - num_bits) >> 3;
+#if defined(STBI__X86_TARGET) || defined(STBI__X64_TARGET)
+            memcpy(&word, zbuffer, 8); // little-endian
+#else
+            int i;
+            word = 0;
+            for (i = 7; i >= 0; --i)
+                word = (word << 8) | zbuffer[i];
+#endif
+            // keep whole bytes only, so the bits above num_bits stay zero
+            word &= ((stbi__zbits)1 << (bytes * 8)) - 1;
+            code_buffer |= word << num_bits;
+            zbuffer += bytes;
+            num_bits += bytes * 8;
+        }
+
+        entry = a->z_length_multi[code_buffer & STBI__ZMULTI_MASK];
+        if (entry >> 31) {
+            zout[0] = (char)(entry & 255);
+            zout[1] = (char)((entry >> 9) & 255);
+            zout += 2;
+            code_buffer >>= (entry >> 24) & 31;
+            num_bits -= (entry >> 24) & 31;
+            continue;
+        }
+        if (entry) {
+            code_buffer >>= entry >> 24;
+            num_bits -= entry >> 24;
+            z = entry & 511;
+        }
+        else {
+            STBI__ZFAST_SAVE();
+            z = stbi__zhuffman_decode_slowpath(a, &a->z_length);
+            STBI__ZFAST_LOAD();
+        }
+        if (z < 256) {
+            if (z < 0) { result = stbi__err("bad huffman code", "Corrupt PNG"); break; }
+            *zout++ = (char)z;
+            continue;
+        }
+        if (z == 256) {
+            result = 1;
+            break;
+        }
+        if (z >= 286) { result = stbi__err("bad huffman code", "Corrupt PNG"); break; }
+        z -= 257;
+        len = stbi__zlength_base[z];
+        if (stbi__zlength_extra[z]) {
+            len += (int)(code_buffer & ((1 << stbi__zlength_extra[z]) - 1));
+            code_buffer >>= stbi__zlength_extra[z];
+            num_bits -= stbi__zlength_extra[z];
+        }
+
+        b = distance_fast[code_buffer & STBI__ZFAST_MASK];
+        if (b) {
+            code_buffer >>= b >> 9;
+            num_bits -= b >> 9;
+            z = b & 511;
+        }
+        else {
+            STBI__ZFAST_SAVE();
+            z = stbi__zhuffman_decode_slowpath(a, &a->z_distance);
+            STBI__ZFAST_LOAD();
+        }
+        if (z < 0 || z >= 30) { result = stbi__err("bad huffman code", "Corrupt PNG"); break; }
+        dist = stbi__zdist_base[z];
+        if (stbi__zdist_extra[z]) {
+            dist += (int)(code_buffer & ((1 << stbi__zdist_extra[z]) - 1));
+            code_buffer >>= stbi__zdist_extra[z];
+            num_bits -= stbi__zdist_extra[z];
+        }
+        if (zout - a->zout_start < dist) { result = stbi__err("bad dist", "Corrupt PNG"); break; }
+
+        p = (stbi_uc*)(zout - dist);
+        if (dist == 1) {
+            memset(zout, *p, len);
+            zout += len;
+        }
+        else {
+            // 8 byte moves write past len into the slack; below 8 apart each move
+            // only lands dist good bytes, since the rest of its source isn't written yet
+            char* q = zout;
+            int step = dist < 8 ? dist : 8;
+            zout += len;
+            do {
+                stbi__zbits v;
+                memcpy(&v, p, 8);
+                memcpy(q, &v, 8);
+                q += step;
+                p += step;
+                len -= step;
+            } while (len > 0);
+        }
+    }
+    STBI__ZFAST_SAVE();
+#undef STBI__ZFAST_SAVE
+#undef STBI__ZFAST_LOAD
+    return result;
+}
+
 static int stbi__parse_huffman_block(stbi__zbuf* a)
 {
     char* zout = a->zout;
     for (;;) {
-        int z = stbi__zhuffman_decode(a, &a->z_length);
+        int z;
+        if (a->zbuffer_end - a->zbuffer >= 8 && a->zout_end - zout >= STBI__ZCOPY_SLACK) {
+            int r;
+            a->zout = zout;
+            r = stbi__parse_huffman_block_fast(a);
+            if (r >= 0) return r;
+            zout = a->zout;
+            continue;
+        }
+        z = stbi__zhuffman_decode(a, &a->z_length);
         if (z < 256) {
             if (z < 0) return stbi__err("bad huffman code", "Corrupt PNG"); // error in huffman codes
             if (zout >= a->zout_end) {
@@ -4451,12 +4897,20 @@ static int stbi__parse_uncompressed_block(stbi__zbuf* a)
         stbi__zreceive(a, a->num_bits & 7); // discard
     // drain the bit-packed data into header
     k = 0;
-    while (a->num_bits > 0) {
+    while (a->num_bits > 0 && k < 4) {
         header[k++] = (stbi_uc)(a->code_buffer & 255); // suppress MSVC run-time check
         a->code_buffer >>= 8;
         a->num_bits -= 8;
     }
     if (a->num_bits < 0) return stbi__err("zlib corrupt", "Corrupt PNG");
+    if (a->num_bits > 0) {
+        // the wide bit buffer read ahead of the header; bytes it still holds come from
+        // just before zbuffer, unless they are the zero padding inserted at eof
+        if (a->hit_zeof_once) return stbi__err("zlib corrupt", "Corrupt PNG");
+        a->zbuffer -= a->num_bits >> 3;
+        a->code_buffer = 0;
+        a->num_bits = 0;
+    }
     // now fill header the normal way
     while (k < 4)
         header[k++] = stbi__zget8(a);
@@ -4541,6 +4995,7 @@ static int stbi__parse_zlib(stbi__zbuf* a, int parse_header)
             else {
                 if (!stbi__compute_huffman_codes(a)) return 0;
             }
+            stbi__zbuild_length_multi(a);
             if (!stbi__parse_huffman_block(a)) return 0;
         }
     } while (!final);
@@ -4685,7 +5140,9 @@ enum {
     STBI__F_avg = 3,
     STBI__F_paeth = 4,
     // synthetic filter used for first scanline to avoid needing a dummy row of 0s
-    STBI__F_avg_first
+    STBI__F_avg_first,
+    // synthetic filter for a row the SIMD path already unfiltered
+    STBI__F_done
 };
 
 static stbi_uc first_row_filter[5] =
@@ -4710,6 +5167,105 @@ static int stbi__paeth(int a, int b, int c)
     return t1;
 }
 
+#ifdef STBI_SSE2
+// Unfiltering for 8-bit RGB and RGBA rows. Up has no dependency along the row, so it
+// runs 16 bytes at a time; Sub, Avg and Paeth depend on the pixel to their left, so
+// they step one pixel at a time with all of its channels in one register.
+// Results are bit-identical to the scalar loops in stbi__create_png_image_raw.
+
+stbi_inline static __m128i stbi__png_load_pixel(const stbi_uc* p, int bpp)
+{
+    int v;
+    if (bpp == 4) memcpy(&v, p, 4);
+    else v = p[0] | (p[1] << 8) | (p[2] << 16); // assembled in registers; a 3 byte memcpy stalls the reload
+    return _mm_cvtsi32_si128(v);
+}
+
+stbi_inline static void stbi__png_store_pixel(stbi_uc* p, __m128i pixel, int bpp)
+{
+    int v = _mm_cvtsi128_si32(pixel);
+    if (bpp == 4) {
+        memcpy(p, &v, 4);
+    }
+    else {
+        p[0] = (stbi_uc)v;
+        p[1] = (stbi_uc)(v >> 8);
+        p[2] = (stbi_uc)(v >> 16);
+    }
+}
+
+static void stbi__png_unfilter_up_sse2(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk)
+{
+    int k = 0;
+    for (; k + 16 <= nk; k += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(raw + k));
+        __m128i b = _mm_loadu_si128((const __m128i*)(prior + k));
+        _mm_storeu_si128((__m128i*)(cur + k), _mm_add_epi8(x, b));
+    }
+    for (; k < nk; ++k)
+        cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+}
+
+stbi_inline static void stbi__png_unfilter_sub_sse2(stbi_uc* cur, const stbi_uc* raw, int nk, int bpp)
+{
+    __m128i a = _mm_setzero_si128();
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        a = _mm_add_epi8(a, stbi__png_load_pixel(raw + k, bpp));
+        stbi__png_store_pixel(cur + k, a, bpp);
+    }
+}
+
+stbi_inline static void stbi__png_unfilter_avg_sse2(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk, int bpp)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        __m128i b = stbi__png_load_pixel(prior + k, bpp);
+        // avg_epu8 rounds up, the filter rounds down
+        __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(stbi__png_load_pixel(raw + k, bpp), avg);
+        stbi__png_store_pixel(cur + k, a, bpp);
+    }
+}
+
+stbi_inline static __m128i stbi__png_abs_epi16(__m128i x)
+{
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+stbi_inline static __m128i stbi__png_select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+stbi_inline static void stbi__png_unfilter_paeth_sse2(stbi_uc* cur, const stbi_uc* raw, const stbi_uc* prior, int nk, int bpp)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // a, b and c widened to 16 bits so the predictor distances can't overflow
+    __m128i a = zero, c = zero;
+    int k;
+    for (k = 0; k < nk; k += bpp) {
+        __m128i b = _mm_unpacklo_epi8(stbi__png_load_pixel(prior + k, bpp), zero);
+        __m128i pa = _mm_sub_epi16(b, c); // |p - a| once abs'd, with p = a + b - c
+        __m128i pb = _mm_sub_epi16(a, c); // |p - b|
+        __m128i pc = stbi__png_abs_epi16(_mm_add_epi16(pa, pb)); // |p - c|
+        __m128i smallest, nearest, out;
+        pa = stbi__png_abs_epi16(pa);
+        pb = stbi__png_abs_epi16(pb);
+        smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        // ties prefer a, then b, as in the spec
+        nearest = stbi__png_select(_mm_cmpeq_epi16(pa, smallest), a,
+            stbi__png_select(_mm_cmpeq_epi16(pb, smallest), b, c));
+        out = _mm_add_epi8(stbi__png_load_pixel(raw + k, bpp), _mm_packus_epi16(nearest, nearest));
+        stbi__png_store_pixel(cur + k, out, bpp);
+        a = _mm_unpacklo_epi8(out, zero);
+        c = b;
+    }
+}
+#endif // STBI_SSE2
+
 static const stbi_uc stbi__depth_scale_table[9] = { 0, 0xff, 0x55, 0, 0x11, 0,0,0, 0x01 };
 
 // adds an extra all-255 alpha channel
@@ -4795,6 +5351,33 @@ static int stbi__create_png_image_raw(stbi__png* a, stbi_uc* raw, stbi__uint32 r
         // if first row, use special filter that doesn't sample previous row
         if (j == 0) filter = first_row_filter[filter];
 
+#ifdef STBI_SSE2
+        if (filter == STBI__F_up) {
+            stbi__png_unfilter_up_sse2(cur, raw, prior, nk);
+            filter = STBI__F_done;
+        }
+        else if (filter_bytes == 4 || filter_bytes == 3) {
+            int done = 1;
+            // constant bpp arguments let the pixel loads and stores inline to single moves
+            if (filter == STBI__F_sub) {
+                if (filter_bytes == 4) stbi__png_unfilter_sub_sse2(cur, raw, nk, 4);
+                else stbi__png_unfilter_sub_sse2(cur, raw, nk, 3);
+            }
+            else if (filter == STBI__F_avg) {
+                if (filter_bytes == 4) stbi__png_unfilter_avg_sse2(cur, raw, prior, nk, 4);
+                else stbi__png_unfilter_avg_sse2(cur, raw, prior, nk, 3);
+            }
+            else if (filter == STBI__F_paeth) {
+                if (filter_bytes == 4) stbi__png_unfilter_paeth_sse2(cur, raw, prior, nk, 4);
+                else stbi__png_unfilter_paeth_sse2(cur, raw, prior, nk, 3);
+            }
+            else {
+                done = 0;
+            }
+            if (done) filter = STBI__F_done;
+        }
+#endif
+
         // perform actual filtering
         switch (filter) {
         case STBI__F_none:
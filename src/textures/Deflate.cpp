@@ -0,0 +1,177 @@
+#include "Deflate.h"
+#include <algorithm>
+
+namespace textures {
+
+	static const int kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	static const int kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	static const int kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	static const int kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	static const int kWindowSize = 32768;
+	static const int kHashBits = 15;
+	static const int kMinMatch = 3;
+	static const int kMaxMatch = 258;
+
+	struct DeflateBitWriter {
+		std::vector<uint8_t>& out;
+		uint32_t buffer = 0;
+		int count = 0;
+
+		void Write(uint32_t bits, int bitCount) {
+			buffer |= bits << count;
+			count += bitCount;
+			while (count >= 8) {
+				out.push_back(static_cast<uint8_t>(buffer));
+				buffer >>= 8;
+				count -= 8;
+			}
+		}
+
+		// huffman codes are defined MSB first but the stream is packed LSB first
+		void WriteCode(uint32_t code, int bitCount) {
+			uint32_t reversed = 0;
+			for (int i = 0; i < bitCount; i++) {
+				reversed = (reversed << 1) | ((code >> i) & 1);
+			}
+			Write(reversed, bitCount);
+		}
+
+		void Flush() {
+			if (count > 0) {
+				out.push_back(static_cast<uint8_t>(buffer));
+			}
+			buffer = 0;
+			count = 0;
+		}
+	};
+
+	static void WriteLiteral(DeflateBitWriter& writer, int symbol) {
+		if (symbol <= 143) {
+			writer.WriteCode(0x30 + symbol, 8);
+		}
+		else if (symbol <= 255) {
+			writer.WriteCode(0x190 + symbol - 144, 9);
+		}
+		else if (symbol <= 279) {
+			writer.WriteCode(symbol - 256, 7);
+		}
+		else {
+			writer.WriteCode(0xC0 + symbol - 280, 8);
+		}
+	}
+
+	static void WriteMatch(DeflateBitWriter& writer, int length, int distance) {
+		int lengthCode = 0;
+		while (lengthCode < 28 && kLengthBase[lengthCode + 1] <= length) {
+			lengthCode++;
+		}
+		WriteLiteral(writer, 257 + lengthCode);
+		if (kLengthExtra[lengthCode] > 0) {
+			writer.Write(static_cast<uint32_t>(length - kLengthBase[lengthCode]), kLengthExtra[lengthCode]);
+		}
+
+		int distCode = 0;
+		while (distCode < 29 && kDistBase[distCode + 1] <= distance) {
+			distCode++;
+		}
+		writer.WriteCode(static_cast<uint32_t>(distCode), 5);
+		if (kDistExtra[distCode] > 0) {
+			writer.Write(static_cast<uint32_t>(distance - kDistBase[distCode]), kDistExtra[distCode]);
+		}
+	}
+
+	static uint32_t Hash3(const uint8_t* p) {
+		uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+		return (v * 2654435761u) >> (32 - kHashBits);
+	}
+
+	std::vector<uint8_t> ZlibCompress(const uint8_t* data, size_t size, int level) {
+		level = std::max(1, std::min(level, 9));
+		int maxChain = 4 << level;
+
+		std::vector<uint8_t> out{ };
+		out.reserve(size / 2 + 64);
+		// CMF: deflate with a 32K window, FLG: no dictionary, check bits make it divisible by 31
+		out.push_back(0x78);
+		out.push_back(0x01);
+
+		DeflateBitWriter writer{ out };
+		writer.Write(1, 1); // final block
+		writer.Write(1, 2); // fixed huffman
+
+		std::vector<int32_t> head(size_t(1) << kHashBits, -1);
+		std::vector<int32_t> prev(kWindowSize, -1);
+
+		auto insert = [&](size_t pos) {
+			if (pos + kMinMatch > size) {
+				return;
+			}
+			uint32_t h = Hash3(data + pos);
+			prev[pos & (kWindowSize - 1)] = head[h];
+			head[h] = static_cast<int32_t>(pos);
+		};
+
+		size_t pos = 0;
+		while (pos < size) {
+			int bestLength = 0;
+			int bestDistance = 0;
+			if (pos + kMinMatch <= size) {
+				size_t maxLength = std::min<size_t>(kMaxMatch, size - pos);
+				int32_t candidate = head[Hash3(data + pos)];
+				for (int chain = 0; candidate >= 0 && chain < maxChain; chain++) {
+					size_t distance = pos - static_cast<size_t>(candidate);
+					if (distance > kWindowSize - 1) {
+						break;
+					}
+					const uint8_t* a = data + candidate;
+					const uint8_t* b = data + pos;
+					size_t length = 0;
+					while (length < maxLength && a[length] == b[length]) {
+						length++;
+					}
+					if (static_cast<int>(length) > bestLength) {
+						bestLength = static_cast<int>(length);
+						bestDistance = static_cast<int>(distance);
+						if (length == maxLength) {
+							break;
+						}
+					}
+					int32_t next = prev[candidate & (kWindowSize - 1)];
+					// chain slots get recycled once the window wraps, stop at anything not strictly older
+					if (next >= candidate) {
+						break;
+					}
+					candidate = next;
+				}
+			}
+
+			if (bestLength >= kMinMatch) {
+				WriteMatch(writer, bestLength, bestDistance);
+				for (int i = 0; i < bestLength; i++) {
+					insert(pos + i);
+				}
+				pos += bestLength;
+			}
+			else {
+				WriteLiteral(writer, data[pos]);
+				insert(pos);
+				pos++;
+			}
+		}
+		WriteLiteral(writer, 256); // end of block
+		writer.Flush();
+
+		uint32_t a = 1, b = 0;
+		for (size_t i = 0; i < size; i++) {
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		uint32_t adler = (b << 16) | a;
+		out.push_back(static_cast<uint8_t>(adler >> 24));
+		out.push_back(static_cast<uint8_t>(adler >> 16));
+		out.push_back(static_cast<uint8_t>(adler >> 8));
+		out.push_back(static_cast<uint8_t>(adler));
+		return out;
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace textures {
+	/*
+	 * Minimal zlib (RFC 1950) writer: LZ77 over hash chains, emitted as a single
+	 * fixed-Huffman deflate block. Good enough for packing block-compressed
+	 * texture data; decoding goes through stb_image's inflate.
+	 * level trades speed for ratio, 1 (fastest) to 9.
+	 */
+	std::vector<uint8_t> ZlibCompress(const uint8_t* data, size_t size, int level = 6);
+}
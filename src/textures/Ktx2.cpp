@@ -0,0 +1,413 @@
+#include "Ktx2.h"
+#include "Deflate.h"
+#include "../stb/stb_image.h"
+#include "../vfs/FileSystem.h"
+#include <zstd/zstd.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+
+namespace textures {
+
+	static const uint8_t kKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	static const size_t kHeaderSize = 80; // identifier + header + index
+	static const size_t kLevelIndexEntrySize = 24;
+
+	// khr_df colour models
+	static const uint8_t kDfModelRGBSDA = 1;
+	static const uint8_t kDfModelBC1A = 128;
+	static const uint8_t kDfModelBC3 = 130;
+	static const uint8_t kDfModelBC4 = 131;
+	static const uint8_t kDfModelBC5 = 132;
+	static const uint8_t kDfModelBC7 = 134;
+	static const uint8_t kDfModelETC1S = 163;
+	static const uint8_t kDfModelUASTC = 166;
+	// khr_df channel ids of the Basis models that carry alpha
+	static const uint8_t kDfChannelETC1SAAA = 15;
+	static const uint8_t kDfChannelUASTCRGBA = 3;
+	static const uint8_t kDfChannelUASTCRRRG = 5;
+	// larger levels than this are a corrupt header, not a texture
+	static const uint64_t kMaxLevelSize = 1u << 30;
+
+	static uint32_t ReadU32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	static uint64_t ReadU64(const uint8_t* p) {
+		return ReadU32(p) | (static_cast<uint64_t>(ReadU32(p + 4)) << 32);
+	}
+
+	static void WriteU32(std::vector<uint8_t>& out, size_t at, uint32_t v) {
+		for (int i = 0; i < 4; i++) {
+			out[at + i] = static_cast<uint8_t>(v >> (8 * i));
+		}
+	}
+
+	static void WriteU64(std::vector<uint8_t>& out, size_t at, uint64_t v) {
+		WriteU32(out, at, static_cast<uint32_t>(v));
+		WriteU32(out, at + 4, static_cast<uint32_t>(v >> 32));
+	}
+
+	static bool VkFormatToBlockFormat(uint32_t vkFormat, BlockFormat& format) {
+		switch (vkFormat) {
+		case kVkFormatBC1RgbUnorm:
+		case kVkFormatBC1RgbSrgb:
+		case kVkFormatBC1RgbaUnorm:
+			format = BlockFormat::BC1;
+			return true;
+		case kVkFormatBC3Unorm:
+		case kVkFormatBC3Srgb:
+			format = BlockFormat::BC3;
+			return true;
+		case kVkFormatBC4Unorm:
+			format = BlockFormat::BC4;
+			return true;
+		case kVkFormatBC5Unorm:
+			format = BlockFormat::BC5;
+			return true;
+		case kVkFormatBC7Unorm:
+		case kVkFormatBC7Srgb:
+			format = BlockFormat::BC7;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	uint32_t GetKtx2VkFormat(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return kVkFormatBC1RgbUnorm;
+		case BlockFormat::BC3: return kVkFormatBC3Unorm;
+		case BlockFormat::BC4: return kVkFormatBC4Unorm;
+		case BlockFormat::BC5: return kVkFormatBC5Unorm;
+		case BlockFormat::BC7: return kVkFormatBC7Unorm;
+		default: return kVkFormatUndefined;
+		}
+	}
+
+	// bytes of one image for formats we understand, 0 otherwise
+	static size_t GetImageSize(uint32_t vkFormat, int width, int height) {
+		BlockFormat format;
+		if (VkFormatToBlockFormat(vkFormat, format)) {
+			return GetCompressedSize(format, width, height);
+		}
+		if (vkFormat == kVkFormatR8G8B8A8Unorm || vkFormat == kVkFormatR8G8B8A8Srgb) {
+			return static_cast<size_t>(width) * height * 4;
+		}
+		return 0;
+	}
+
+	Ktx2Payload Ktx2Texture::GetPayload() const {
+		if (colorModel == kDfModelETC1S || supercompression == kSupercompressionBasisLZ) {
+			return Ktx2Payload::BasisETC1S;
+		}
+		if (colorModel == kDfModelUASTC) {
+			return Ktx2Payload::BasisUASTC;
+		}
+		BlockFormat format;
+		if (VkFormatToBlockFormat(vkFormat, format)) {
+			return Ktx2Payload::BlockCompressed;
+		}
+		if (vkFormat == kVkFormatR8G8B8A8Unorm || vkFormat == kVkFormatR8G8B8A8Srgb) {
+			return Ktx2Payload::RGBA8;
+		}
+		return Ktx2Payload::Unsupported;
+	}
+
+	BlockFormat Ktx2Texture::GetBlockFormat() const {
+		BlockFormat format = BlockFormat::BC1;
+		VkFormatToBlockFormat(vkFormat, format);
+		return format;
+	}
+
+	const uint8_t* Ktx2Texture::GetImage(size_t level, int layer, int face) const {
+		const Ktx2Level& l = levels[level];
+		return l.data.data() + (static_cast<size_t>(layer) * faceCount + face) * l.imageSize;
+	}
+
+	uint8_t* Ktx2Texture::GetImage(size_t level, int layer, int face) {
+		Ktx2Level& l = levels[level];
+		return l.data.data() + (static_cast<size_t>(layer) * faceCount + face) * l.imageSize;
+	}
+
+	bool ReadKtx2(const uint8_t* bytes, size_t size, Ktx2Texture& texture, std::string& error) {
+		if (size < kHeaderSize || std::memcmp(bytes, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0) {
+			error = "not a KTX2 file";
+			return false;
+		}
+
+		const uint8_t* header = bytes + 12;
+		texture.vkFormat = ReadU32(header + 0);
+		texture.width = static_cast<int>(ReadU32(header + 8));
+		texture.height = static_cast<int>(ReadU32(header + 12));
+		uint32_t depth = ReadU32(header + 16);
+		uint32_t layerCount = ReadU32(header + 20);
+		uint32_t faceCount = ReadU32(header + 24);
+		uint32_t levelCount = ReadU32(header + 28);
+		texture.supercompression = ReadU32(header + 32);
+		uint32_t dfdOffset = ReadU32(header + 36);
+		uint32_t dfdLength = ReadU32(header + 40);
+
+		if (texture.width <= 0 || texture.height <= 0 || depth > 1) {
+			error = "only 2D textures are supported";
+			return false;
+		}
+		if (faceCount != 1 && faceCount != 6) {
+			error = "invalid face count " + std::to_string(faceCount);
+			return false;
+		}
+		// 0 means "not an array" and "generate mips at load" respectively
+		texture.layerCount = static_cast<int>(std::max<uint32_t>(layerCount, 1));
+		texture.faceCount = static_cast<int>(faceCount);
+		levelCount = std::max<uint32_t>(levelCount, 1);
+		if (levelCount > 32 || kHeaderSize + levelCount * kLevelIndexEntrySize > size) {
+			error = "truncated level index";
+			return false;
+		}
+
+		texture.colorModel = 0;
+		texture.hasAlpha = false;
+		if (dfdLength >= 16 && static_cast<uint64_t>(dfdOffset) + dfdLength <= size) {
+			// total size, then the basic descriptor block: vendor/type, version, block size, colour model
+			const uint8_t* dfd = bytes + dfdOffset;
+			texture.colorModel = dfd[12];
+			// 24 bytes of block header, then 16 per sample with the channel id in the low bits of byte 3
+			size_t samples = dfdLength >= 28 ? (dfdLength - 28) / 16 : 0;
+			for (size_t s = 0; s < samples; s++) {
+				uint8_t channel = dfd[28 + 16 * s + 3] & 0xF;
+				if ((texture.colorModel == kDfModelETC1S && channel == kDfChannelETC1SAAA) ||
+					(texture.colorModel == kDfModelUASTC && (channel == kDfChannelUASTCRGBA || channel == kDfChannelUASTCRRRG))) {
+					texture.hasAlpha = true;
+				}
+			}
+		}
+		Ktx2Payload payload = texture.GetPayload();
+		bool basis = payload == Ktx2Payload::BasisETC1S || payload == Ktx2Payload::BasisUASTC;
+		if (basis) {
+			// the basisu transcoder parses the container itself, supercompression included
+			texture.basisFile.assign(bytes, bytes + size);
+		}
+		else {
+			texture.basisFile.clear();
+		}
+
+		size_t images = static_cast<size_t>(texture.layerCount) * texture.faceCount;
+		std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> zstd{ nullptr, ZSTD_freeDCtx };
+		texture.levels.clear();
+		texture.levels.reserve(levelCount);
+		for (uint32_t i = 0; i < levelCount; i++) {
+			const uint8_t* entry = bytes + kHeaderSize + i * kLevelIndexEntrySize;
+			uint64_t offset = ReadU64(entry);
+			uint64_t length = ReadU64(entry + 8);
+			uint64_t uncompressedLength = ReadU64(entry + 16);
+			if (offset > size || length > size - offset) {
+				error = "level " + std::to_string(i) + " lies outside the file";
+				return false;
+			}
+
+			Ktx2Level level{ };
+			level.width = std::max(1, texture.width >> i);
+			level.height = std::max(1, texture.height >> i);
+			const uint8_t* src = bytes + offset;
+
+			bool zlib = texture.supercompression == kSupercompressionZlib;
+			bool zstandard = texture.supercompression == kSupercompressionZstd && !basis;
+			if ((zlib || zstandard) && uncompressedLength > kMaxLevelSize) {
+				error = "level " + std::to_string(i) + " is implausibly large";
+				return false;
+			}
+			if (zlib) {
+				level.data.resize(static_cast<size_t>(uncompressedLength));
+				int written = stbi_zlib_decode_buffer(reinterpret_cast<char*>(level.data.data()), static_cast<int>(level.data.size()),
+					reinterpret_cast<const char*>(src), static_cast<int>(length));
+				if (written != static_cast<int>(uncompressedLength)) {
+					error = "level " + std::to_string(i) + " failed to inflate";
+					return false;
+				}
+			}
+			else if (zstandard) {
+				if (!zstd) {
+					zstd.reset(ZSTD_createDCtx());
+				}
+				level.data.resize(static_cast<size_t>(uncompressedLength));
+				size_t written = ZSTD_decompressDCtx(zstd.get(), level.data.data(), level.data.size(), src, static_cast<size_t>(length));
+				if (ZSTD_isError(written) || written != uncompressedLength) {
+					error = "level " + std::to_string(i) + " failed to inflate";
+					if (ZSTD_isError(written)) {
+						error += std::string(": ") + ZSTD_getErrorName(written);
+					}
+					return false;
+				}
+			}
+			else {
+				// none, or a scheme the transcoder has to deal with
+				level.data.assign(src, src + length);
+			}
+
+			size_t expected = GetImageSize(texture.vkFormat, level.width, level.height);
+			if (expected != 0 && !basis) {
+				if (level.data.size() != expected * images) {
+					error = "level " + std::to_string(i) + " has " + std::to_string(level.data.size()) + " bytes, expected " + std::to_string(expected * images);
+					return false;
+				}
+				level.imageSize = expected;
+			}
+			else {
+				level.imageSize = level.data.size() / images;
+			}
+			texture.levels.push_back(std::move(level));
+		}
+		return true;
+	}
+
+	bool ReadKtx2File(const std::string& filepath, Ktx2Texture& texture, std::string& error) {
+		vfs::FileData file = vfs::FileSystem::Shared().Read(filepath);
+		if (!file) {
+			error = "can't open " + filepath;
+			return false;
+		}
+		return ReadKtx2(file.GetBytes().data(), file.GetSize(), texture, error);
+	}
+
+	/*
+	 * Basic data format descriptor for the formats we write.
+	 * Layout per the Khronos Data Format spec, section 5.
+	 */
+	static std::vector<uint8_t> BuildDfd(uint32_t vkFormat) {
+		struct Sample {
+			uint16_t bitOffset;
+			uint8_t bitLength; // minus one
+			uint8_t channel;
+			uint32_t upper;
+		};
+		std::vector<Sample> samples{ };
+		uint8_t model = kDfModelRGBSDA;
+		uint8_t blockDim = 0;
+		uint8_t bytesPlane0 = 4;
+		BlockFormat format;
+		if (VkFormatToBlockFormat(vkFormat, format)) {
+			blockDim = 3;
+			bytesPlane0 = static_cast<uint8_t>(GetBlockSize(format));
+			switch (format) {
+			case BlockFormat::BC1:
+				model = kDfModelBC1A;
+				samples.push_back({ 0, 63, 0, 0xFFFFFFFFu });
+				break;
+			case BlockFormat::BC3:
+				model = kDfModelBC3;
+				samples.push_back({ 0, 63, 15, 0xFFFFFFFFu });
+				samples.push_back({ 64, 63, 0, 0xFFFFFFFFu });
+				break;
+			case BlockFormat::BC4:
+				model = kDfModelBC4;
+				samples.push_back({ 0, 63, 0, 0xFFFFFFFFu });
+				break;
+			case BlockFormat::BC5:
+				model = kDfModelBC5;
+				samples.push_back({ 0, 63, 0, 0xFFFFFFFFu });
+				samples.push_back({ 64, 63, 1, 0xFFFFFFFFu });
+				break;
+			case BlockFormat::BC7:
+				model = kDfModelBC7;
+				samples.push_back({ 0, 127, 0, 0xFFFFFFFFu });
+				break;
+			}
+		}
+		else {
+			samples.push_back({ 0, 7, 0, 255 });
+			samples.push_back({ 8, 7, 1, 255 });
+			samples.push_back({ 16, 7, 2, 255 });
+			samples.push_back({ 24, 7, 15, 255 });
+		}
+
+		size_t blockSize = 24 + 16 * samples.size();
+		std::vector<uint8_t> dfd(4 + blockSize, 0);
+		WriteU32(dfd, 0, static_cast<uint32_t>(dfd.size()));
+		WriteU32(dfd, 4, 0); // khronos vendor, basic descriptor type
+		dfd[8] = 2; // version 1.3
+		dfd[10] = static_cast<uint8_t>(blockSize);
+		dfd[11] = static_cast<uint8_t>(blockSize >> 8);
+		dfd[12] = model;
+		dfd[13] = 1; // BT.709 primaries
+		dfd[14] = 1; // linear transfer
+		dfd[15] = 0; // straight alpha
+		dfd[16] = blockDim;
+		dfd[17] = blockDim;
+		dfd[20] = bytesPlane0;
+		for (size_t i = 0; i < samples.size(); i++) {
+			size_t at = 28 + 16 * i;
+			dfd[at + 0] = static_cast<uint8_t>(samples[i].bitOffset);
+			dfd[at + 1] = static_cast<uint8_t>(samples[i].bitOffset >> 8);
+			dfd[at + 2] = samples[i].bitLength;
+			dfd[at + 3] = samples[i].channel;
+			WriteU32(dfd, at + 12, samples[i].upper);
+		}
+		return dfd;
+	}
+
+	std::vector<uint8_t> WriteKtx2(const Ktx2Texture& texture, bool zlib) {
+		size_t levelCount = texture.levels.size();
+		std::vector<std::vector<uint8_t>> packed(levelCount);
+		bool useZlib = false;
+		if (zlib) {
+			size_t rawTotal = 0;
+			size_t packedTotal = 0;
+			for (size_t i = 0; i < levelCount; i++) {
+				packed[i] = ZlibCompress(texture.levels[i].data.data(), texture.levels[i].data.size());
+				rawTotal += texture.levels[i].data.size();
+				packedTotal += packed[i].size();
+			}
+			// incompressible payloads would only get bigger
+			useZlib = packedTotal < rawTotal;
+		}
+
+		std::vector<uint8_t> dfd = BuildDfd(texture.vkFormat);
+		size_t dfdOffset = kHeaderSize + levelCount * kLevelIndexEntrySize;
+		size_t alignment = 1;
+		if (!useZlib) {
+			BlockFormat format;
+			alignment = VkFormatToBlockFormat(texture.vkFormat, format) ? GetBlockSize(format) : 4;
+		}
+
+		std::vector<uint8_t> out(dfdOffset + dfd.size(), 0);
+		std::memcpy(out.data(), kKtx2Identifier, sizeof(kKtx2Identifier));
+		WriteU32(out, 12, texture.vkFormat);
+		WriteU32(out, 16, 1); // typeSize
+		WriteU32(out, 20, static_cast<uint32_t>(texture.width));
+		WriteU32(out, 24, static_cast<uint32_t>(texture.height));
+		WriteU32(out, 28, 0); // depth
+		WriteU32(out, 32, texture.layerCount > 1 ? static_cast<uint32_t>(texture.layerCount) : 0);
+		WriteU32(out, 36, static_cast<uint32_t>(texture.faceCount));
+		WriteU32(out, 40, static_cast<uint32_t>(levelCount));
+		WriteU32(out, 44, useZlib ? kSupercompressionZlib : kSupercompressionNone);
+		WriteU32(out, 48, static_cast<uint32_t>(dfdOffset));
+		WriteU32(out, 52, static_cast<uint32_t>(dfd.size()));
+		std::memcpy(out.data() + dfdOffset, dfd.data(), dfd.size());
+
+		// the spec wants level data stored smallest mip first
+		for (size_t n = levelCount; n-- > 0;) {
+			const std::vector<uint8_t>& payload = useZlib ? packed[n] : texture.levels[n].data;
+			size_t offset = (out.size() + alignment - 1) / alignment * alignment;
+			out.resize(offset, 0);
+			out.insert(out.end(), payload.begin(), payload.end());
+
+			size_t entry = kHeaderSize + n * kLevelIndexEntrySize;
+			WriteU64(out, entry, offset);
+			WriteU64(out, entry + 8, payload.size());
+			WriteU64(out, entry + 16, texture.levels[n].data.size());
+		}
+		return out;
+	}
+
+	Ktx2Texture MakeKtx2Texture(const CompressedImage& image) {
+		Ktx2Texture texture{ };
+		texture.vkFormat = GetKtx2VkFormat(image.format);
+		texture.width = image.width;
+		texture.height = image.height;
+		for (const CompressedLevel& level : image.levels) {
+			texture.levels.push_back({ level.width, level.height, level.data.size(), level.data });
+		}
+		return texture;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextureCompressor.h"
+
+namespace textures {
+
+	// the subset of VkFormat values we know how to upload or transcode
+	enum Ktx2VkFormat : uint32_t {
+		kVkFormatUndefined = 0, // basis universal payloads
+		kVkFormatR8G8B8A8Unorm = 37,
+		kVkFormatR8G8B8A8Srgb = 43,
+		kVkFormatBC1RgbUnorm = 131,
+		kVkFormatBC1RgbSrgb = 132,
+		kVkFormatBC1RgbaUnorm = 133,
+		kVkFormatBC3Unorm = 137,
+		kVkFormatBC3Srgb = 138,
+		kVkFormatBC4Unorm = 139,
+		kVkFormatBC5Unorm = 141,
+		kVkFormatBC7Unorm = 145,
+		kVkFormatBC7Srgb = 146
+	};
+
+	enum Ktx2Supercompression : uint32_t {
+		kSupercompressionNone = 0,
+		kSupercompressionBasisLZ = 1,
+		kSupercompressionZstd = 2,
+		kSupercompressionZlib = 3
+	};
+
+	// what the level data holds once any supercompression has been undone
+	enum class Ktx2Payload {
+		BlockCompressed,
+		RGBA8,
+		BasisETC1S,
+		BasisUASTC,
+		Unsupported
+	};
+
+	struct Ktx2Level {
+		int width;
+		int height;
+		// bytes of one image (one layer of one face) at this level
+		size_t imageSize;
+		// every layer and face of the level, layer-major then face
+		std::vector<uint8_t> data;
+	};
+
+	struct Ktx2Texture {
+		uint32_t vkFormat = kVkFormatUndefined;
+		uint32_t supercompression = kSupercompressionNone;
+		uint8_t colorModel = 0;
+		int width = 0;
+		int height = 0;
+		int layerCount = 1;
+		int faceCount = 1;
+		// from the data format descriptor, only filled in for Basis payloads whose format doesn't say
+		bool hasAlpha = false;
+		std::vector<Ktx2Level> levels{ };
+		// the whole file for Basis payloads, which the basisu transcoder reads itself; empty otherwise
+		std::vector<uint8_t> basisFile{ };
+
+		Ktx2Payload GetPayload() const;
+		// only meaningful when the payload is BlockCompressed
+		BlockFormat GetBlockFormat() const;
+		const uint8_t* GetImage(size_t level, int layer, int face) const;
+		uint8_t* GetImage(size_t level, int layer, int face);
+	};
+
+	/*
+	 * Parses a KTX2 file already in memory. Zlib and Zstandard supercompressed
+	 * levels are inflated here. Basis payloads are kept as-is, along with the
+	 * file for the transcoder, and reported through GetPayload(). Returns
+	 * false and fills error on malformed input.
+	 */
+	bool ReadKtx2(const uint8_t* bytes, size_t size, Ktx2Texture& texture, std::string& error);
+	bool ReadKtx2File(const std::string& filepath, Ktx2Texture& texture, std::string& error);
+
+	// serializes a 2D texture, zlib supercompressing the levels when that saves space
+	std::vector<uint8_t> WriteKtx2(const Ktx2Texture& texture, bool zlib);
+	Ktx2Texture MakeKtx2Texture(const CompressedImage& image);
+	uint32_t GetKtx2VkFormat(BlockFormat format);
+}
@@ -0,0 +1,180 @@
+#include "Ktx2Transcoder.h"
+#include "../threading/ThreadPool.h"
+#include <atomic>
+#include <mutex>
+// basisu_transcoder.cpp and its headers go in dependencies/include/basisu, next to zstd so its Zstandard include resolves
+#if __has_include(<basisu/basisu_transcoder.h>)
+#define TEXTURES_BASISU 1
+#include <basisu/basisu_transcoder.h>
+#endif
+
+namespace textures {
+
+	bool HasBasisTranscoder() {
+#ifdef TEXTURES_BASISU
+		return true;
+#else
+		return false;
+#endif
+	}
+
+#ifdef TEXTURES_BASISU
+	// larger transcoded levels than this are a corrupt header, the same limit ReadKtx2 puts on inflated levels
+	static const uint64_t kMaxTranscodedLevelSize = 1u << 30;
+	// BasisLZ codes runs of repeated blocks in a few bits, so a real file can expand far more than zlib's 1032:1, but not without limit
+	static const uint64_t kMaxTranscodeRatio = 1u << 16;
+
+	static basist::transcoder_texture_format GetBasisFormat(TranscodeTarget target, BlockFormat blockFormat) {
+		if (target == TranscodeTarget::RGBA8) {
+			return basist::transcoder_texture_format::cTFRGBA32;
+		}
+		switch (blockFormat) {
+		case BlockFormat::BC1: return basist::transcoder_texture_format::cTFBC1_RGB;
+		case BlockFormat::BC3: return basist::transcoder_texture_format::cTFBC3_RGBA;
+		case BlockFormat::BC4: return basist::transcoder_texture_format::cTFBC4_R;
+		case BlockFormat::BC5: return basist::transcoder_texture_format::cTFBC5_RG;
+		default: return basist::transcoder_texture_format::cTFBC7_RGBA;
+		}
+	}
+
+	// ETC1S and UASTC straight to the target, without going through RGBA8 like the BCn encoders do
+	static bool TranscodeBasis(Ktx2Texture& texture, TranscodeTarget target, BlockFormat blockFormat, ThreadPool* pool, std::string& error) {
+		static std::once_flag initialized;
+		std::call_once(initialized, basist::basisu_transcoder_init);
+
+		basist::ktx2_transcoder transcoder;
+		if (!transcoder.init(texture.basisFile.data(), static_cast<uint32_t>(texture.basisFile.size())) || !transcoder.start_transcoding()) {
+			error = "the Basis Universal transcoder rejected the file";
+			return false;
+		}
+		basist::transcoder_texture_format format = GetBasisFormat(target, blockFormat);
+
+		// the sizes come from the header, so they're checked before anything is allocated for them
+		uint64_t imageCount = static_cast<uint64_t>(texture.layerCount) * texture.faceCount;
+		std::vector<size_t> imageSizes(texture.levels.size());
+		uint64_t total = 0;
+		for (size_t i = 0; i < texture.levels.size(); i++) {
+			const Ktx2Level& level = texture.levels[i];
+			uint64_t texels = static_cast<uint64_t>(level.width) * level.height;
+			uint64_t imageSize = target == TranscodeTarget::RGBA8 ? texels * 4 : GetCompressedSize(blockFormat, level.width, level.height);
+			if (texels > kMaxTranscodedLevelSize || imageSize > kMaxTranscodedLevelSize / imageCount) {
+				error = "level " + std::to_string(i) + " is implausibly large";
+				return false;
+			}
+			imageSizes[i] = static_cast<size_t>(imageSize);
+			total += imageSize * imageCount;
+		}
+		if (total > texture.basisFile.size() * kMaxTranscodeRatio) {
+			error = std::to_string(total) + " transcoded bytes is implausibly many for a " + std::to_string(texture.basisFile.size()) + " byte file";
+			return false;
+		}
+
+		struct Image {
+			size_t level;
+			int layer;
+			int face;
+		};
+		std::vector<Image> images{ };
+		for (size_t i = 0; i < texture.levels.size(); i++) {
+			Ktx2Level& level = texture.levels[i];
+			level.data.assign(static_cast<size_t>(imageSizes[i] * imageCount), 0);
+			level.imageSize = imageSizes[i];
+			for (int layer = 0; layer < texture.layerCount; layer++) {
+				for (int face = 0; face < texture.faceCount; face++) {
+					images.push_back({ i, layer, face });
+				}
+			}
+		}
+
+		// every image transcodes on its own, each chunk of them with its own state
+		std::atomic<bool> failed{ false };
+		auto transcode = [&](size_t begin, size_t end) {
+			basist::ktx2_transcoder_state state;
+			for (size_t i = begin; i < end; i++) {
+				const Image& image = images[i];
+				Ktx2Level& level = texture.levels[image.level];
+				uint32_t capacity = static_cast<uint32_t>(level.imageSize / basist::basis_get_bytes_per_block_or_pixel(format));
+				if (!transcoder.transcode_image_level(static_cast<uint32_t>(image.level), static_cast<uint32_t>(image.layer), static_cast<uint32_t>(image.face),
+					texture.GetImage(image.level, image.layer, image.face), capacity, format, 0, 0, 0, -1, -1, &state)) {
+					failed = true;
+				}
+			}
+		};
+		if (pool != nullptr) {
+			pool->ParallelFor(images.size(), transcode);
+		}
+		else {
+			transcode(0, images.size());
+		}
+		if (failed) {
+			error = "the Basis Universal transcoder failed on a level";
+			return false;
+		}
+		return true;
+	}
+#endif
+
+	bool TranscodeKtx2(Ktx2Texture& texture, TranscodeTarget target, BlockFormat blockFormat, CompressionQuality quality, ThreadPool* pool, std::string& error) {
+		Ktx2Payload payload = texture.GetPayload();
+		switch (payload) {
+		case Ktx2Payload::BasisETC1S:
+		case Ktx2Payload::BasisUASTC: {
+#ifdef TEXTURES_BASISU
+			if (!TranscodeBasis(texture, target, blockFormat, pool, error)) {
+				return false;
+			}
+			texture.vkFormat = target == TranscodeTarget::RGBA8 ? kVkFormatR8G8B8A8Unorm : GetKtx2VkFormat(blockFormat);
+			texture.colorModel = 0;
+			texture.supercompression = kSupercompressionNone;
+			texture.basisFile.clear();
+			texture.basisFile.shrink_to_fit();
+			return true;
+#else
+			error = payload == Ktx2Payload::BasisETC1S ? "ETC1S/BasisLZ" : "UASTC";
+			error += " payloads need the Basis Universal transcoder, which wasn't found in dependencies/include/basisu when this was built";
+			return false;
+#endif
+		}
+		case Ktx2Payload::Unsupported:
+			error = "unsupported vkFormat " + std::to_string(texture.vkFormat) + " or supercompression scheme " + std::to_string(texture.supercompression);
+			return false;
+		default:
+			break;
+		}
+
+		if ((payload == Ktx2Payload::BlockCompressed) == (target == TranscodeTarget::BlockCompressed)) {
+			// already in the right shape
+			return true;
+		}
+
+		int images = texture.layerCount * texture.faceCount;
+		if (target == TranscodeTarget::RGBA8) {
+			BlockFormat source = texture.GetBlockFormat();
+			for (Ktx2Level& level : texture.levels) {
+				size_t imageSize = static_cast<size_t>(level.width) * level.height * 4;
+				std::vector<uint8_t> rgba(imageSize * images);
+				for (int i = 0; i < images; i++) {
+					DecompressLevel(level.data.data() + i * level.imageSize, level.width, level.height, source, rgba.data() + i * imageSize, pool);
+				}
+				level.data = std::move(rgba);
+				level.imageSize = imageSize;
+			}
+			texture.vkFormat = kVkFormatR8G8B8A8Unorm;
+		}
+		else {
+			for (Ktx2Level& level : texture.levels) {
+				size_t imageSize = GetCompressedSize(blockFormat, level.width, level.height);
+				std::vector<uint8_t> blocks(imageSize * images);
+				for (int i = 0; i < images; i++) {
+					CompressLevel(level.data.data() + i * level.imageSize, level.width, level.height, blockFormat, quality, blocks.data() + i * imageSize, pool);
+				}
+				level.data = std::move(blocks);
+				level.imageSize = imageSize;
+			}
+			texture.vkFormat = GetKtx2VkFormat(blockFormat);
+		}
+		// whatever was inflated is now raw
+		texture.supercompression = kSupercompressionNone;
+		return true;
+	}
+}
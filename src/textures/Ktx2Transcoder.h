@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include "Ktx2.h"
+
+class ThreadPool;
+
+namespace textures {
+
+	enum class TranscodeTarget {
+		BlockCompressed, // keep or produce BCn so the GPU samples it directly
+		RGBA8            // expand to plain texels for drivers without the block format
+	};
+
+	/*
+	 * Converts the level data of texture in place so it holds target.
+	 * RGBA8 payloads are encoded to blockFormat, BCn payloads are decoded to RGBA8.
+	 * Rows of each image are spread over pool.
+	 *
+	 * Basis Universal payloads (ETC1S/BasisLZ and UASTC) go straight to
+	 * blockFormat or RGBA8 through the basisu transcoder, one image per job.
+	 * Builds without it fail those with an error.
+	 */
+	bool TranscodeKtx2(Ktx2Texture& texture, TranscodeTarget target, BlockFormat blockFormat, CompressionQuality quality, ThreadPool* pool, std::string& error);
+	// whether the basisu transcoder was compiled in
+	bool HasBasisTranscoder();
+}
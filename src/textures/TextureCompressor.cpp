@@ -0,0 +1,833 @@
+#include "TextureCompressor.h"
+#include "../threading/ThreadPool.h"
+#include "../math/mathutil.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURES_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace textures {
+
+	// one 4x4 block in planar float layout so the distance search can run 4 pixels per SSE op
+	struct BlockPixels {
+		alignas(16) float c[4][16];
+	};
+
+	static const int kBC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	const char* FormatToName(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return "BC1";
+		case BlockFormat::BC3: return "BC3";
+		case BlockFormat::BC4: return "BC4";
+		case BlockFormat::BC5: return "BC5";
+		case BlockFormat::BC7: return "BC7";
+		default: return "unknown";
+		}
+	}
+
+	const char* QualityToName(CompressionQuality quality) {
+		switch (quality) {
+		case CompressionQuality::Fast: return "fast";
+		case CompressionQuality::Normal: return "normal";
+		case CompressionQuality::High: return "high";
+		default: return "unknown";
+		}
+	}
+
+	size_t GetBlockSize(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1:
+		case BlockFormat::BC4:
+			return 8;
+		default:
+			return 16;
+		}
+	}
+
+	size_t GetCompressedSize(BlockFormat format, int width, int height) {
+		size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+		size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+		return blocksX * blocksY * GetBlockSize(format);
+	}
+
+	BlockFormat ChooseBlockFormat(int channels, CompressionQuality quality) {
+		switch (channels) {
+		case 1: return BlockFormat::BC4;
+		case 2: return BlockFormat::BC5;
+		case 3: return BlockFormat::BC1;
+		default: return quality == CompressionQuality::High ? BlockFormat::BC7 : BlockFormat::BC3;
+		}
+	}
+
+	static void LoadBlock(const uint8_t* rgba, int width, int height, int bx, int by, BlockPixels& px) {
+		for (int y = 0; y < 4; y++) {
+			// replicate the last row/column for blocks hanging off the edge
+			int sy = std::min(by * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++) {
+				int sx = std::min(bx * 4 + x, width - 1);
+				const uint8_t* p = rgba + (static_cast<size_t>(sy) * width + sx) * 4;
+				for (int ch = 0; ch < 4; ch++) {
+					px.c[ch][y * 4 + x] = p[ch];
+				}
+			}
+		}
+	}
+
+	/*
+	 * For each of the 16 pixels, picks the palette entry with the smallest squared
+	 * distance over the given channel planes. Returns the summed error.
+	 */
+	static float FindNearestIndices(const float* const* planes, int channels, const float (*palette)[4], int paletteSize, uint8_t* indices) {
+#ifdef TEXTURES_USE_SSE2
+		__m128 total = _mm_setzero_ps();
+		for (int g = 0; g < 16; g += 4) {
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+			for (int p = 0; p < paletteSize; p++) {
+				__m128 dist = _mm_setzero_ps();
+				for (int ch = 0; ch < channels; ch++) {
+					__m128 diff = _mm_sub_ps(_mm_load_ps(planes[ch] + g), _mm_set1_ps(palette[p][ch]));
+					dist = _mm_add_ps(dist, _mm_mul_ps(diff, diff));
+				}
+				__m128 less = _mm_cmplt_ps(dist, best);
+				best = _mm_min_ps(dist, best);
+				bestIndex = _mm_or_ps(_mm_and_ps(less, _mm_set1_ps(static_cast<float>(p))), _mm_andnot_ps(less, bestIndex));
+			}
+			total = _mm_add_ps(total, best);
+			__m128i idx = _mm_cvttps_epi32(bestIndex);
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(lanes), idx);
+			for (int i = 0; i < 4; i++) {
+				indices[g + i] = static_cast<uint8_t>(lanes[i]);
+			}
+		}
+		alignas(16) float sums[4];
+		_mm_store_ps(sums, total);
+		return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+		float total = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float best = FLT_MAX;
+			int bestIndex = 0;
+			for (int p = 0; p < paletteSize; p++) {
+				float dist = 0.0f;
+				for (int ch = 0; ch < channels; ch++) {
+					float diff = planes[ch][i] - palette[p][ch];
+					dist += diff * diff;
+				}
+				if (dist < best) {
+					best = dist;
+					bestIndex = p;
+				}
+			}
+			indices[i] = static_cast<uint8_t>(bestIndex);
+			total += best;
+		}
+		return total;
+#endif
+	}
+
+	static void ComputeBoundingBox(const float* const* planes, int channels, float* lo, float* hi) {
+		for (int ch = 0; ch < channels; ch++) {
+			lo[ch] = 255.0f;
+			hi[ch] = 0.0f;
+			for (int i = 0; i < 16; i++) {
+				lo[ch] = std::min(lo[ch], planes[ch][i]);
+				hi[ch] = std::max(hi[ch], planes[ch][i]);
+			}
+			// pull the box in a little, the extreme texels are rarely worth an exact endpoint
+			float inset = (hi[ch] - lo[ch]) / 16.0f;
+			lo[ch] += inset;
+			hi[ch] -= inset;
+		}
+	}
+
+	// endpoints along the dominant direction of the block's colour distribution
+	static void ComputePrincipalEndpoints(const float* const* planes, int channels, float* e0, float* e1) {
+		float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int ch = 0; ch < channels; ch++) {
+			for (int i = 0; i < 16; i++) {
+				mean[ch] += planes[ch][i];
+			}
+			mean[ch] /= 16.0f;
+		}
+
+		float cov[4][4] = { };
+		for (int i = 0; i < 16; i++) {
+			for (int a = 0; a < channels; a++) {
+				float da = planes[a][i] - mean[a];
+				for (int b = a; b < channels; b++) {
+					cov[a][b] += da * (planes[b][i] - mean[b]);
+				}
+			}
+		}
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < a; b++) {
+				cov[a][b] = cov[b][a];
+			}
+		}
+
+		// power iteration, starting from the bounding box diagonal
+		float lo[4], hi[4];
+		ComputeBoundingBox(planes, channels, lo, hi);
+		float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int ch = 0; ch < channels; ch++) {
+			axis[ch] = hi[ch] - lo[ch] + 1e-3f;
+		}
+		for (int iter = 0; iter < 8; iter++) {
+			float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float length = 0.0f;
+			for (int a = 0; a < channels; a++) {
+				for (int b = 0; b < channels; b++) {
+					next[a] += cov[a][b] * axis[b];
+				}
+				length = std::max(length, std::fabs(next[a]));
+			}
+			if (length < 1e-6f) {
+				break;
+			}
+			for (int a = 0; a < channels; a++) {
+				axis[a] = next[a] / length;
+			}
+		}
+		float axisLengthSq = 0.0f;
+		for (int ch = 0; ch < channels; ch++) {
+			axisLengthSq += axis[ch] * axis[ch];
+		}
+		if (axisLengthSq < 1e-12f) {
+			for (int ch = 0; ch < channels; ch++) {
+				e0[ch] = e1[ch] = mean[ch];
+			}
+			return;
+		}
+
+		float tMin = FLT_MAX;
+		float tMax = -FLT_MAX;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int ch = 0; ch < channels; ch++) {
+				t += (planes[ch][i] - mean[ch]) * axis[ch];
+			}
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+		tMin /= axisLengthSq;
+		tMax /= axisLengthSq;
+		float inset = (tMax - tMin) / 16.0f;
+		tMin += inset;
+		tMax -= inset;
+		for (int ch = 0; ch < channels; ch++) {
+			e0[ch] = clip(mean[ch] + tMax * axis[ch], 0.0f, 255.0f);
+			e1[ch] = clip(mean[ch] + tMin * axis[ch], 0.0f, 255.0f);
+		}
+	}
+
+	/*
+	 * Solves for the two endpoints that best reproduce the block given the
+	 * current index assignment. weights[i] is how far index i sits toward e1.
+	 */
+	static bool RefineEndpoints(const float* const* planes, int channels, const uint8_t* indices, const float* weights, float* e0, float* e1) {
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = { }, bx[4] = { };
+		for (int i = 0; i < 16; i++) {
+			float w = weights[indices[i]];
+			float a = 1.0f - w;
+			aa += a * a;
+			ab += a * w;
+			bb += w * w;
+			for (int ch = 0; ch < channels; ch++) {
+				ax[ch] += a * planes[ch][i];
+				bx[ch] += w * planes[ch][i];
+			}
+		}
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f) {
+			return false;
+		}
+		float invDet = 1.0f / det;
+		for (int ch = 0; ch < channels; ch++) {
+			e0[ch] = clip((ax[ch] * bb - bx[ch] * ab) * invDet, 0.0f, 255.0f);
+			e1[ch] = clip((bx[ch] * aa - ax[ch] * ab) * invDet, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	/* BC1 */
+
+	static uint16_t PackColor565(const float* c) {
+		int r = static_cast<int>(c[0] * 31.0f / 255.0f + 0.5f);
+		int g = static_cast<int>(c[1] * 63.0f / 255.0f + 0.5f);
+		int b = static_cast<int>(c[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((clip(r, 0, 31) << 11) | (clip(g, 0, 63) << 5) | clip(b, 0, 31));
+	}
+
+	static void UnpackColor565(uint16_t c, int* out) {
+		int r = (c >> 11) & 31;
+		int g = (c >> 5) & 63;
+		int b = c & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	static void BuildBC1Palette(uint16_t c0, uint16_t c1, float (*palette)[4]) {
+		int a[3], b[3];
+		UnpackColor565(c0, a);
+		UnpackColor565(c1, b);
+		for (int ch = 0; ch < 3; ch++) {
+			palette[0][ch] = static_cast<float>(a[ch]);
+			palette[1][ch] = static_cast<float>(b[ch]);
+			palette[2][ch] = static_cast<float>((2 * a[ch] + b[ch]) / 3);
+			palette[3][ch] = static_cast<float>((a[ch] + 2 * b[ch]) / 3);
+		}
+	}
+
+	static float EncodeBC1Endpoints(const float* const* planes, const float* e0, const float* e1, uint16_t& c0, uint16_t& c1, uint8_t* indices) {
+		c0 = PackColor565(e0);
+		c1 = PackColor565(e1);
+		// four colour mode needs c0 > c1
+		if (c0 < c1) {
+			std::swap(c0, c1);
+		}
+		float palette[4][4];
+		BuildBC1Palette(c0, c1, palette);
+		if (c0 == c1) {
+			// equal endpoints read back as three colour mode; index 0 is still c0
+			std::fill(indices, indices + 16, static_cast<uint8_t>(0));
+			float err = 0.0f;
+			for (int i = 0; i < 16; i++) {
+				for (int ch = 0; ch < 3; ch++) {
+					float d = planes[ch][i] - palette[0][ch];
+					err += d * d;
+				}
+			}
+			return err;
+		}
+		return FindNearestIndices(planes, 3, palette, 4, indices);
+	}
+
+	static void WriteBC1Block(uint16_t c0, uint16_t c1, const uint8_t* indices, uint8_t* out) {
+		uint32_t bits = 0;
+		for (int i = 0; i < 16; i++) {
+			bits |= static_cast<uint32_t>(indices[i] & 3) << (2 * i);
+		}
+		out[0] = static_cast<uint8_t>(c0);
+		out[1] = static_cast<uint8_t>(c0 >> 8);
+		out[2] = static_cast<uint8_t>(c1);
+		out[3] = static_cast<uint8_t>(c1 >> 8);
+		out[4] = static_cast<uint8_t>(bits);
+		out[5] = static_cast<uint8_t>(bits >> 8);
+		out[6] = static_cast<uint8_t>(bits >> 16);
+		out[7] = static_cast<uint8_t>(bits >> 24);
+	}
+
+	static void CompressBC1Block(const BlockPixels& px, CompressionQuality quality, uint8_t* out) {
+		static const float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+		const float* planes[3] = { px.c[0], px.c[1], px.c[2] };
+		float e0[4], e1[4];
+		if (quality == CompressionQuality::Fast) {
+			ComputeBoundingBox(planes, 3, e1, e0);
+		}
+		else {
+			ComputePrincipalEndpoints(planes, 3, e0, e1);
+		}
+
+		uint16_t c0, c1;
+		uint8_t indices[16];
+		float err = EncodeBC1Endpoints(planes, e0, e1, c0, c1, indices);
+
+		if (quality == CompressionQuality::High) {
+			for (int iter = 0; iter < 2 && err > 0.0f; iter++) {
+				// indices are relative to the swapped endpoints, so refine against those
+				float r0[4], r1[4];
+				int a[3], b[3];
+				UnpackColor565(c0, a);
+				UnpackColor565(c1, b);
+				for (int ch = 0; ch < 3; ch++) {
+					r0[ch] = static_cast<float>(a[ch]);
+					r1[ch] = static_cast<float>(b[ch]);
+				}
+				if (!RefineEndpoints(planes, 3, indices, kWeights, r0, r1)) {
+					break;
+				}
+				uint16_t n0, n1;
+				uint8_t nIndices[16];
+				float nErr = EncodeBC1Endpoints(planes, r0, r1, n0, n1, nIndices);
+				if (nErr >= err) {
+					break;
+				}
+				err = nErr;
+				c0 = n0;
+				c1 = n1;
+				std::memcpy(indices, nIndices, sizeof(indices));
+			}
+		}
+		WriteBC1Block(c0, c1, indices, out);
+	}
+
+	/* BC4 (also the alpha half of BC3 and both halves of BC5) */
+
+	static void BuildBC4Palette(int a0, int a1, float (*palette)[4]) {
+		palette[0][0] = static_cast<float>(a0);
+		palette[1][0] = static_cast<float>(a1);
+		if (a0 > a1) {
+			for (int i = 1; i < 7; i++) {
+				palette[i + 1][0] = static_cast<float>(((7 - i) * a0 + i * a1) / 7);
+			}
+		}
+		else {
+			for (int i = 1; i < 5; i++) {
+				palette[i + 1][0] = static_cast<float>(((5 - i) * a0 + i * a1) / 5);
+			}
+			palette[6][0] = 0.0f;
+			palette[7][0] = 255.0f;
+		}
+	}
+
+	static float EncodeBC4Endpoints(const float* plane, int a0, int a1, uint8_t* indices) {
+		float palette[8][4];
+		BuildBC4Palette(a0, a1, palette);
+		return FindNearestIndices(&plane, 1, palette, 8, indices);
+	}
+
+	static void WriteBC4Block(int a0, int a1, const uint8_t* indices, uint8_t* out) {
+		out[0] = static_cast<uint8_t>(a0);
+		out[1] = static_cast<uint8_t>(a1);
+		uint64_t bits = 0;
+		for (int i = 0; i < 16; i++) {
+			bits |= static_cast<uint64_t>(indices[i] & 7) << (3 * i);
+		}
+		for (int i = 0; i < 6; i++) {
+			out[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+		}
+	}
+
+	static void CompressBC4Block(const float* plane, CompressionQuality quality, uint8_t* out) {
+		float lo = 255.0f, hi = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			lo = std::min(lo, plane[i]);
+			hi = std::max(hi, plane[i]);
+		}
+		int a0 = static_cast<int>(hi);
+		int a1 = static_cast<int>(lo);
+		uint8_t indices[16];
+		if (a0 == a1) {
+			std::fill(indices, indices + 16, static_cast<uint8_t>(0));
+			WriteBC4Block(a0, a1, indices, out);
+			return;
+		}
+
+		float err = EncodeBC4Endpoints(plane, a0, a1, indices);
+		if (quality == CompressionQuality::High) {
+			// six value mode has exact 0 and 255, so the interpolated range only
+			// needs to cover the texels in between
+			int innerLo = 255, innerHi = 0;
+			for (int i = 0; i < 16; i++) {
+				int v = static_cast<int>(plane[i]);
+				if (v != 0 && v != 255) {
+					innerLo = std::min(innerLo, v);
+					innerHi = std::max(innerHi, v);
+				}
+			}
+			if (innerLo <= innerHi) {
+				uint8_t altIndices[16];
+				float altErr = EncodeBC4Endpoints(plane, innerLo, innerHi, altIndices);
+				if (altErr < err) {
+					err = altErr;
+					a0 = innerLo;
+					a1 = innerHi;
+					std::memcpy(indices, altIndices, sizeof(indices));
+				}
+			}
+			// and try shrinking the eight value range by a step on either side
+			for (int shrink = 1; shrink <= 2 && err > 0.0f; shrink++) {
+				int n0 = static_cast<int>(hi) - shrink;
+				int n1 = static_cast<int>(lo) + shrink;
+				if (n0 <= n1) {
+					break;
+				}
+				uint8_t altIndices[16];
+				float altErr = EncodeBC4Endpoints(plane, n0, n1, altIndices);
+				if (altErr < err) {
+					err = altErr;
+					a0 = n0;
+					a1 = n1;
+					std::memcpy(indices, altIndices, sizeof(indices));
+				}
+			}
+		}
+		WriteBC4Block(a0, a1, indices, out);
+	}
+
+	/* BC7, mode 6 only: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4 bit indices */
+
+	static void QuantizeBC7Endpoint(const float* e, int pbit, int* q) {
+		for (int ch = 0; ch < 4; ch++) {
+			int v = static_cast<int>((e[ch] - pbit) / 2.0f + 0.5f);
+			q[ch] = clip(v, 0, 127);
+		}
+	}
+
+	static float EncodeBC7Endpoints(const float* const* planes, const float* e0, const float* e1, int p0, int p1, int* q0, int* q1, uint8_t* indices) {
+		QuantizeBC7Endpoint(e0, p0, q0);
+		QuantizeBC7Endpoint(e1, p1, q1);
+		float palette[16][4];
+		for (int ch = 0; ch < 4; ch++) {
+			int a = (q0[ch] << 1) | p0;
+			int b = (q1[ch] << 1) | p1;
+			for (int i = 0; i < 16; i++) {
+				palette[i][ch] = static_cast<float>(((64 - kBC7Weights4[i]) * a + kBC7Weights4[i] * b + 32) >> 6);
+			}
+		}
+		return FindNearestIndices(planes, 4, palette, 16, indices);
+	}
+
+	struct BitWriter {
+		uint8_t* out;
+		int position = 0;
+
+		void Write(uint32_t value, int bitCount) {
+			for (int i = 0; i < bitCount; i++) {
+				if ((value >> i) & 1) {
+					out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+				}
+				position++;
+			}
+		}
+	};
+
+	static void CompressBC7Block(const BlockPixels& px, CompressionQuality quality, uint8_t* out) {
+		float weights[16];
+		for (int i = 0; i < 16; i++) {
+			weights[i] = kBC7Weights4[i] / 64.0f;
+		}
+
+		const float* planes[4] = { px.c[0], px.c[1], px.c[2], px.c[3] };
+		float e0[4], e1[4];
+		if (quality == CompressionQuality::Fast) {
+			ComputeBoundingBox(planes, 4, e0, e1);
+		}
+		else {
+			ComputePrincipalEndpoints(planes, 4, e0, e1);
+		}
+
+		int q0[4], q1[4];
+		int p0 = 0, p1 = 0;
+		uint8_t indices[16];
+		float err = FLT_MAX;
+		// fast only tries matching p-bits, the others try all four combinations
+		int pbitCombos = quality == CompressionQuality::Fast ? 2 : 4;
+		for (int combo = 0; combo < pbitCombos; combo++) {
+			int cp0 = quality == CompressionQuality::Fast ? combo : (combo & 1);
+			int cp1 = quality == CompressionQuality::Fast ? combo : (combo >> 1);
+			int t0[4], t1[4];
+			uint8_t tIndices[16];
+			float tErr = EncodeBC7Endpoints(planes, e0, e1, cp0, cp1, t0, t1, tIndices);
+			if (tErr < err) {
+				err = tErr;
+				p0 = cp0;
+				p1 = cp1;
+				std::memcpy(q0, t0, sizeof(q0));
+				std::memcpy(q1, t1, sizeof(q1));
+				std::memcpy(indices, tIndices, sizeof(indices));
+			}
+		}
+
+		if (quality == CompressionQuality::High) {
+			for (int iter = 0; iter < 2 && err > 0.0f; iter++) {
+				float r0[4], r1[4];
+				if (!RefineEndpoints(planes, 4, indices, weights, r0, r1)) {
+					break;
+				}
+				bool improved = false;
+				for (int combo = 0; combo < 4; combo++) {
+					int t0[4], t1[4];
+					uint8_t tIndices[16];
+					float tErr = EncodeBC7Endpoints(planes, r0, r1, combo & 1, combo >> 1, t0, t1, tIndices);
+					if (tErr < err) {
+						err = tErr;
+						p0 = combo & 1;
+						p1 = combo >> 1;
+						std::memcpy(q0, t0, sizeof(q0));
+						std::memcpy(q1, t1, sizeof(q1));
+						std::memcpy(indices, tIndices, sizeof(indices));
+						improved = true;
+					}
+				}
+				if (!improved) {
+					break;
+				}
+			}
+		}
+
+		// the anchor (first) index is stored without its top bit, so it must be < 8
+		if (indices[0] >= 8) {
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (int i = 0; i < 16; i++) {
+				indices[i] = static_cast<uint8_t>(15 - indices[i]);
+			}
+		}
+
+		std::memset(out, 0, 16);
+		BitWriter writer{ out };
+		writer.Write(1 << 6, 7); // mode 6
+		for (int ch = 0; ch < 4; ch++) {
+			writer.Write(static_cast<uint32_t>(q0[ch]), 7);
+			writer.Write(static_cast<uint32_t>(q1[ch]), 7);
+		}
+		writer.Write(static_cast<uint32_t>(p0), 1);
+		writer.Write(static_cast<uint32_t>(p1), 1);
+		writer.Write(indices[0], 3);
+		for (int i = 1; i < 16; i++) {
+			writer.Write(indices[i], 4);
+		}
+	}
+
+	static void CompressBlock(const BlockPixels& px, BlockFormat format, CompressionQuality quality, uint8_t* out) {
+		switch (format) {
+		case BlockFormat::BC1:
+			CompressBC1Block(px, quality, out);
+			break;
+		case BlockFormat::BC3:
+			CompressBC4Block(px.c[3], quality, out);
+			CompressBC1Block(px, quality, out + 8);
+			break;
+		case BlockFormat::BC4:
+			CompressBC4Block(px.c[0], quality, out);
+			break;
+		case BlockFormat::BC5:
+			CompressBC4Block(px.c[0], quality, out);
+			CompressBC4Block(px.c[1], quality, out + 8);
+			break;
+		case BlockFormat::BC7:
+			CompressBC7Block(px, quality, out);
+			break;
+		}
+	}
+
+	void CompressLevel(const uint8_t* rgba, int width, int height, BlockFormat format, CompressionQuality quality, uint8_t* out, ThreadPool* pool) {
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		size_t blockSize = GetBlockSize(format);
+
+		auto compressRows = [&](size_t begin, size_t end) {
+			BlockPixels px;
+			for (size_t by = begin; by < end; by++) {
+				uint8_t* rowOut = out + by * blocksX * blockSize;
+				for (int bx = 0; bx < blocksX; bx++) {
+					LoadBlock(rgba, width, height, bx, static_cast<int>(by), px);
+					CompressBlock(px, format, quality, rowOut + bx * blockSize);
+				}
+			}
+		};
+
+		if (pool != nullptr) {
+			pool->ParallelFor(static_cast<size_t>(blocksY), compressRows);
+		}
+		else {
+			compressRows(0, static_cast<size_t>(blocksY));
+		}
+	}
+
+	std::vector<uint8_t> DownsampleRGBA(const uint8_t* rgba, int width, int height, int& outWidth, int& outHeight) {
+		outWidth = std::max(1, width / 2);
+		outHeight = std::max(1, height / 2);
+		std::vector<uint8_t> result(static_cast<size_t>(outWidth) * outHeight * 4);
+		for (int y = 0; y < outHeight; y++) {
+			int y0 = std::min(y * 2, height - 1);
+			int y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < outWidth; x++) {
+				int x0 = std::min(x * 2, width - 1);
+				int x1 = std::min(x * 2 + 1, width - 1);
+				const uint8_t* a = rgba + (static_cast<size_t>(y0) * width + x0) * 4;
+				const uint8_t* b = rgba + (static_cast<size_t>(y0) * width + x1) * 4;
+				const uint8_t* c = rgba + (static_cast<size_t>(y1) * width + x0) * 4;
+				const uint8_t* d = rgba + (static_cast<size_t>(y1) * width + x1) * 4;
+				uint8_t* o = result.data() + (static_cast<size_t>(y) * outWidth + x) * 4;
+				for (int ch = 0; ch < 4; ch++) {
+					o[ch] = static_cast<uint8_t>((a[ch] + b[ch] + c[ch] + d[ch] + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	CompressedImage CompressImage(const uint8_t* rgba, int width, int height, BlockFormat format, CompressionQuality quality, bool generateMips, ThreadPool* pool) {
+		CompressedImage image{ };
+		image.format = format;
+		image.width = width;
+		image.height = height;
+
+		// glGenerateMipmap can't build mips for compressed textures, so the chain is made here
+		std::vector<uint8_t> mipData{ };
+		const uint8_t* levelData = rgba;
+		int levelWidth = width;
+		int levelHeight = height;
+		while (true) {
+			CompressedLevel level{ levelWidth, levelHeight, std::vector<uint8_t>(GetCompressedSize(format, levelWidth, levelHeight)) };
+			CompressLevel(levelData, levelWidth, levelHeight, format, quality, level.data.data(), pool);
+			image.levels.push_back(std::move(level));
+
+			if (!generateMips || (levelWidth == 1 && levelHeight == 1)) {
+				break;
+			}
+			int nextWidth, nextHeight;
+			mipData = DownsampleRGBA(levelData, levelWidth, levelHeight, nextWidth, nextHeight);
+			levelData = mipData.data();
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+		return image;
+	}
+
+	/* decoding */
+
+	static void DecodeBC1Block(const uint8_t* block, uint8_t (*texels)[4], bool forceFourColor) {
+		uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+		uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+		int a[3], b[3];
+		UnpackColor565(c0, a);
+		UnpackColor565(c1, b);
+		uint8_t palette[4][4];
+		for (int ch = 0; ch < 3; ch++) {
+			palette[0][ch] = static_cast<uint8_t>(a[ch]);
+			palette[1][ch] = static_cast<uint8_t>(b[ch]);
+			if (c0 > c1 || forceFourColor) {
+				palette[2][ch] = static_cast<uint8_t>((2 * a[ch] + b[ch]) / 3);
+				palette[3][ch] = static_cast<uint8_t>((a[ch] + 2 * b[ch]) / 3);
+			}
+			else {
+				palette[2][ch] = static_cast<uint8_t>((a[ch] + b[ch]) / 2);
+				palette[3][ch] = 0;
+			}
+		}
+		palette[0][3] = palette[1][3] = palette[2][3] = 255;
+		palette[3][3] = (c0 > c1 || forceFourColor) ? 255 : 0;
+
+		uint32_t bits = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+		for (int i = 0; i < 16; i++) {
+			std::memcpy(texels[i], palette[(bits >> (2 * i)) & 3], 4);
+		}
+	}
+
+	static void DecodeBC4Block(const uint8_t* block, uint8_t (*texels)[4], int channel) {
+		float palette[8][4];
+		BuildBC4Palette(block[0], block[1], palette);
+		uint64_t bits = 0;
+		for (int i = 0; i < 6; i++) {
+			bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+		}
+		for (int i = 0; i < 16; i++) {
+			texels[i][channel] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7][0]);
+		}
+	}
+
+	static void DecodeBC7Block(const uint8_t* block, uint8_t (*texels)[4]) {
+		auto readBits = [block](int& position, int count) {
+			uint32_t value = 0;
+			for (int i = 0; i < count; i++, position++) {
+				value |= static_cast<uint32_t>((block[position >> 3] >> (position & 7)) & 1) << i;
+			}
+			return value;
+		};
+
+		// low seven bits hold the mode as a unary code, mode 6 is 0b1000000
+		if ((block[0] & 0x7F) != (1 << 6)) {
+			for (int i = 0; i < 16; i++) {
+				texels[i][0] = 255;
+				texels[i][1] = 0;
+				texels[i][2] = 255;
+				texels[i][3] = 255;
+			}
+			return;
+		}
+
+		int position = 7;
+		int q[2][4];
+		for (int ch = 0; ch < 4; ch++) {
+			q[0][ch] = static_cast<int>(readBits(position, 7));
+			q[1][ch] = static_cast<int>(readBits(position, 7));
+		}
+		int p0 = static_cast<int>(readBits(position, 1));
+		int p1 = static_cast<int>(readBits(position, 1));
+		for (int i = 0; i < 16; i++) {
+			int index = static_cast<int>(readBits(position, i == 0 ? 3 : 4));
+			int w = kBC7Weights4[index];
+			for (int ch = 0; ch < 4; ch++) {
+				int a = (q[0][ch] << 1) | p0;
+				int b = (q[1][ch] << 1) | p1;
+				texels[i][ch] = static_cast<uint8_t>(((64 - w) * a + w * b + 32) >> 6);
+			}
+		}
+	}
+
+	void DecompressLevel(const uint8_t* blocks, int width, int height, BlockFormat format, uint8_t* rgba, ThreadPool* pool) {
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		size_t blockSize = GetBlockSize(format);
+
+		auto decodeRows = [&](size_t begin, size_t end) {
+			uint8_t texels[16][4];
+			for (size_t by = begin; by < end; by++) {
+				for (int bx = 0; bx < blocksX; bx++) {
+					const uint8_t* block = blocks + (by * blocksX + bx) * blockSize;
+					switch (format) {
+					case BlockFormat::BC1:
+						DecodeBC1Block(block, texels, false);
+						break;
+					case BlockFormat::BC3:
+						DecodeBC1Block(block + 8, texels, true);
+						DecodeBC4Block(block, texels, 3);
+						break;
+					case BlockFormat::BC4:
+						DecodeBC4Block(block, texels, 0);
+						for (int i = 0; i < 16; i++) {
+							texels[i][1] = texels[i][2] = texels[i][0];
+							texels[i][3] = 255;
+						}
+						break;
+					case BlockFormat::BC5:
+						DecodeBC4Block(block, texels, 0);
+						DecodeBC4Block(block + 8, texels, 1);
+						for (int i = 0; i < 16; i++) {
+							texels[i][2] = 0;
+							texels[i][3] = 255;
+						}
+						break;
+					case BlockFormat::BC7:
+						DecodeBC7Block(block, texels);
+						break;
+					}
+
+					for (int y = 0; y < 4; y++) {
+						int py = static_cast<int>(by) * 4 + y;
+						if (py >= height) {
+							break;
+						}
+						for (int x = 0; x < 4; x++) {
+							int px = bx * 4 + x;
+							if (px >= width) {
+								break;
+							}
+							std::memcpy(rgba + (static_cast<size_t>(py) * width + px) * 4, texels[y * 4 + x], 4);
+						}
+					}
+				}
+			}
+		};
+
+		if (pool != nullptr) {
+			pool->ParallelFor(static_cast<size_t>(blocksY), decodeRows);
+		}
+		else {
+			decodeRows(0, static_cast<size_t>(blocksY));
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+namespace textures {
+
+	enum class BlockFormat {
+		BC1, // rgb, 4 bpp
+		BC3, // rgba (bc4 alpha + bc1 color), 8 bpp
+		BC4, // single channel, 4 bpp
+		BC5, // two channels, 8 bpp
+		BC7  // rgba, 8 bpp (only mode 6 is emitted)
+	};
+
+	enum class CompressionQuality {
+		Fast,   // bounding box endpoints
+		Normal, // principal axis endpoints
+		High    // principal axis + least squares refinement, tries more encodings
+	};
+
+	struct CompressedLevel {
+		int width;
+		int height;
+		std::vector<uint8_t> data;
+	};
+
+	struct CompressedImage {
+		BlockFormat format = BlockFormat::BC1;
+		int width = 0;
+		int height = 0;
+		std::vector<CompressedLevel> levels{ };
+	};
+
+	const char* FormatToName(BlockFormat format);
+	const char* QualityToName(CompressionQuality quality);
+	// bytes per 4x4 block
+	size_t GetBlockSize(BlockFormat format);
+	size_t GetCompressedSize(BlockFormat format, int width, int height);
+	// picks the smallest format that keeps every channel stb_image reported
+	BlockFormat ChooseBlockFormat(int channels, CompressionQuality quality);
+
+	/*
+	 * Compresses one RGBA8 image (tightly packed, 4 channels regardless of format).
+	 * out must hold GetCompressedSize(format, width, height) bytes.
+	 * Rows of blocks are spread over pool if one is given.
+	 */
+	void CompressLevel(const uint8_t* rgba, int width, int height, BlockFormat format, CompressionQuality quality, uint8_t* out, ThreadPool* pool);
+	CompressedImage CompressImage(const uint8_t* rgba, int width, int height, BlockFormat format, CompressionQuality quality, bool generateMips, ThreadPool* pool);
+
+	// CPU fallback for drivers without S3TC/BPTC. Writes RGBA8.
+	// BC7 blocks in modes other than 6 are not decoded and come out magenta.
+	void DecompressLevel(const uint8_t* blocks, int width, int height, BlockFormat format, uint8_t* rgba, ThreadPool* pool);
+
+	// 2x2 box filter down to the next mip level
+	std::vector<uint8_t> DownsampleRGBA(const uint8_t* rgba, int width, int height, int& outWidth, int& outHeight);
+}
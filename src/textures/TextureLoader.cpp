@@ -0,0 +1,592 @@
+#include "TextureLoader.h"
+#include "Ktx2Transcoder.h"
+#include "../gl/GLExtensions.h"
+#include "../stb/stb_image.h"
+#include "../threading/ThreadPool.h"
+#include "../vfs/FileSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace textures {
+
+	unsigned int GetGLFormat(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BlockFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+		case BlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+		case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+		default: return 0;
+		}
+	}
+
+	bool IsFormatSupported(BlockFormat format) {
+		switch (format) {
+		case BlockFormat::BC1:
+		case BlockFormat::BC3:
+			return gl_ext::SupportsS3TC();
+		case BlockFormat::BC4:
+		case BlockFormat::BC5:
+			// RGTC is core since 3.0
+			return true;
+		case BlockFormat::BC7:
+			return gl_ext::SupportsBPTC();
+		default:
+			return false;
+		}
+	}
+
+	static void SetDefaultSampling(bool hasMips) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, hasMips ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	size_t UploadCompressedLevel(GLenum target, int mip, BlockFormat format, const CompressedLevel& level, ThreadPool* pool) {
+		if (IsFormatSupported(format)) {
+			glCompressedTexImage2D(target, mip, GetGLFormat(format), level.width, level.height, 0,
+				static_cast<GLsizei>(level.data.size()), level.data.data());
+			return level.data.size();
+		}
+		std::vector<uint8_t> rgba(static_cast<size_t>(level.width) * level.height * 4);
+		DecompressLevel(level.data.data(), level.width, level.height, format, rgba.data(), pool);
+		glTexImage2D(target, mip, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+		return rgba.size();
+	}
+
+	unsigned int UploadCompressedImage(const CompressedImage& image, size_t* gpuBytes, ThreadPool* pool) {
+		if (image.levels.empty()) {
+			return 0;
+		}
+
+		unsigned int id;
+		glGenTextures(1, &id);
+		glBindTexture(GL_TEXTURE_2D, id);
+		SetDefaultSampling(image.levels.size() > 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+
+		size_t bytes = 0;
+		if (!IsFormatSupported(image.format)) {
+			std::cout << "Driver can't sample " << FormatToName(image.format) << ", decompressing on the CPU" << std::endl;
+		}
+		for (size_t i = 0; i < image.levels.size(); i++) {
+			bytes += UploadCompressedLevel(GL_TEXTURE_2D, static_cast<int>(i), image.format, image.levels[i], pool);
+		}
+
+		if (gpuBytes != nullptr) {
+			*gpuBytes = bytes;
+		}
+		return id;
+	}
+
+	LoadedTexture UploadKtx2Texture(const Ktx2Texture& ktx) {
+		LoadedTexture texture{ };
+		texture.width = ktx.width;
+		texture.height = ktx.height;
+		texture.channels = 4;
+		Ktx2Payload payload = ktx.GetPayload();
+		if (payload != Ktx2Payload::BlockCompressed && payload != Ktx2Payload::RGBA8) {
+			std::cerr << "KTX2 level data must be transcoded before upload" << std::endl;
+			return texture;
+		}
+		if (ktx.faceCount == 6 && ktx.layerCount > 1) {
+			std::cerr << "Cube map arrays need GL 4.0, skipping" << std::endl;
+			return texture;
+		}
+
+		bool compressed = payload == Ktx2Payload::BlockCompressed;
+		GLenum internalFormat = compressed ? GetGLFormat(ktx.GetBlockFormat()) : GL_RGBA8;
+		texture.target = ktx.faceCount == 6 ? GL_TEXTURE_CUBE_MAP : (ktx.layerCount > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+		texture.compressed = compressed;
+
+		glGenTextures(1, &texture.id);
+		glBindTexture(texture.target, texture.id);
+		glTexParameteri(texture.target, GL_TEXTURE_WRAP_S, texture.target == GL_TEXTURE_CUBE_MAP ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTexParameteri(texture.target, GL_TEXTURE_WRAP_T, texture.target == GL_TEXTURE_CUBE_MAP ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, ktx.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(texture.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(ktx.levels.size() - 1));
+
+		for (size_t i = 0; i < ktx.levels.size(); i++) {
+			const Ktx2Level& level = ktx.levels[i];
+			GLint mip = static_cast<GLint>(i);
+			GLsizei imageSize = static_cast<GLsizei>(level.imageSize);
+			if (texture.target == GL_TEXTURE_2D_ARRAY) {
+				// every layer of a level is contiguous, so the whole level goes up in one call
+				if (compressed) {
+					glCompressedTexImage3D(texture.target, mip, internalFormat, level.width, level.height, ktx.layerCount, 0,
+						static_cast<GLsizei>(level.data.size()), level.data.data());
+				}
+				else {
+					glTexImage3D(texture.target, mip, internalFormat, level.width, level.height, ktx.layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data.data());
+				}
+			}
+			else {
+				for (int face = 0; face < ktx.faceCount; face++) {
+					GLenum faceTarget = texture.target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+					const uint8_t* image = ktx.GetImage(i, 0, face);
+					if (compressed) {
+						glCompressedTexImage2D(faceTarget, mip, internalFormat, level.width, level.height, 0, imageSize, image);
+					}
+					else {
+						glTexImage2D(faceTarget, mip, internalFormat, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+					}
+				}
+			}
+			texture.gpuBytes += level.data.size();
+		}
+		return texture;
+	}
+
+	BlockFormat ChooseKtx2BlockFormat(const Ktx2Texture& ktx, CompressionQuality quality) {
+		switch (ktx.GetPayload()) {
+		case Ktx2Payload::BlockCompressed:
+			return ktx.GetBlockFormat();
+		case Ktx2Payload::BasisUASTC:
+			// UASTC blocks map onto BC7 almost one to one
+			if (IsFormatSupported(BlockFormat::BC7)) {
+				return BlockFormat::BC7;
+			}
+			return ktx.hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+		case Ktx2Payload::BasisETC1S:
+			// ETC1S endpoints and selectors map onto BC1 without a search
+			if (IsFormatSupported(BlockFormat::BC1)) {
+				return ktx.hasAlpha ? BlockFormat::BC3 : BlockFormat::BC1;
+			}
+			return BlockFormat::BC7;
+		default:
+			return ChooseBlockFormat(4, quality);
+		}
+	}
+
+	// into whatever UploadKtx2Texture should get; stays block compressed whenever the driver can sample the format
+	static bool TranscodeForUpload(Ktx2Texture& ktx, const TextureLoadOptions& options, ThreadPool* pool, std::string& error) {
+		TranscodeTarget target = TranscodeTarget::BlockCompressed;
+		BlockFormat format = ChooseKtx2BlockFormat(ktx, options.quality);
+		if (!IsFormatSupported(format) || !options.compress) {
+			target = TranscodeTarget::RGBA8;
+		}
+		return TranscodeKtx2(ktx, target, format, options.quality, pool, error);
+	}
+
+	LoadedTexture LoadKtx2Texture(const std::string& filepath, const TextureLoadOptions& options) {
+		Ktx2Texture ktx{ };
+		std::string error;
+		if (!ReadKtx2File(filepath, ktx, error)) {
+			std::cerr << "Failed to read KTX2 file " << filepath << ": " << error << std::endl;
+			return LoadedTexture{ };
+		}
+		if (!TranscodeForUpload(ktx, options, &ThreadPool::Shared(), error)) {
+			std::cerr << "Failed to transcode " << filepath << ": " << error << std::endl;
+			return LoadedTexture{ };
+		}
+		return UploadKtx2Texture(ktx);
+	}
+
+	static void DecodeParallelFor(void* user, int count, void (*job)(void* jobUser, int index), void* jobUser) {
+		static_cast<ThreadPool*>(user)->ParallelFor(static_cast<size_t>(count), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				job(jobUser, static_cast<int>(i));
+			}
+		});
+	}
+
+	void SetImageDecodePool(ThreadPool* pool) {
+		stbi_set_parallel_for(pool ? DecodeParallelFor : nullptr, pool);
+	}
+
+	static std::vector<uint8_t> ReadWholeFile(const std::string& filepath) {
+		std::ifstream stream(filepath, std::ios_base::in | std::ios_base::binary);
+		return std::vector<uint8_t>{ std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+	}
+
+	unsigned char* LoadImageFile(const std::string& filepath, int* width, int* height, int* channels, int desiredChannels) {
+		vfs::FileData file = vfs::FileSystem::Shared().Read(filepath);
+		if (!file || file.GetSize() == 0) {
+			// let stb_image report the missing file the way stbi_load would
+			return stbi_load(filepath.c_str(), width, height, channels, desiredChannels);
+		}
+		return stbi_load_from_memory(file.GetBytes().data(), static_cast<int>(file.GetSize()), width, height, channels, desiredChannels);
+	}
+
+	LoadedTexture LoadTexture(const std::string& filepath, const TextureLoadOptions& options) {
+		if (std::filesystem::path(filepath).extension() == ".ktx2") {
+			return LoadKtx2Texture(filepath, options);
+		}
+
+		LoadedTexture texture{ };
+		int channels;
+		// the compressor always wants 4 channels, the plain path keeps whatever the file has
+		unsigned char* data = LoadImageFile(filepath, &texture.width, &texture.height, &channels, options.compress ? 4 : 0);
+		if (data == nullptr) {
+			std::cerr << "Failed to load image at " << filepath << ": " << stbi_failure_reason() << std::endl;
+			return texture;
+		}
+		texture.channels = channels;
+
+		if (options.compress) {
+			BlockFormat format = ChooseBlockFormat(channels, options.quality);
+			CompressedImage image = CompressImage(data, texture.width, texture.height, format, options.quality, options.generateMips, &ThreadPool::Shared());
+			texture.id = UploadCompressedImage(image, &texture.gpuBytes, &ThreadPool::Shared());
+			texture.compressed = IsFormatSupported(format);
+		}
+		else {
+			GLenum format = channels == 1 ? GL_RED : channels == 2 ? GL_RG : channels == 3 ? GL_RGB : GL_RGBA;
+			glGenTextures(1, &texture.id);
+			glBindTexture(GL_TEXTURE_2D, texture.id);
+			SetDefaultSampling(options.generateMips);
+			// rows of 1-3 channel images aren't necessarily 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, texture.width, texture.height, 0, format, GL_UNSIGNED_BYTE, data);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			texture.gpuBytes = static_cast<size_t>(texture.width) * texture.height * 4;
+			if (options.generateMips) {
+				glGenerateMipmap(GL_TEXTURE_2D);
+				texture.gpuBytes = texture.gpuBytes * 4 / 3;
+			}
+		}
+
+		stbi_image_free(data);
+		return texture;
+	}
+
+	static double ComputePSNR(const uint8_t* a, const uint8_t* b, size_t texels, int channels) {
+		double sum = 0.0;
+		for (size_t i = 0; i < texels; i++) {
+			for (int ch = 0; ch < channels; ch++) {
+				double d = static_cast<double>(a[i * 4 + ch]) - b[i * 4 + ch];
+				sum += d * d;
+			}
+		}
+		double mse = sum / (static_cast<double>(texels) * channels);
+		return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	}
+
+	void PrintCompressionReport(const std::string& directory, ThreadPool* pool) {
+		namespace fs = std::filesystem;
+		std::error_code error;
+		fs::directory_iterator it{ directory, error };
+		if (error) {
+			std::cerr << "Can't open texture directory " << directory << ": " << error.message() << std::endl;
+			return;
+		}
+
+		std::cout << "Texture compression report for " << directory << " (" << (pool ? pool->GetThreadCount() + 1 : 1) << " threads)" << std::endl;
+		std::cout << std::left << std::setw(20) << "file" << std::setw(11) << "size" << std::setw(6) << "fmt" << std::setw(8) << "preset"
+			<< std::right << std::setw(12) << "rgba8 KiB" << std::setw(12) << "bcn KiB" << std::setw(9) << "saved"
+			<< std::setw(8) << "bpp" << std::setw(10) << "ms" << std::setw(10) << "MPix/s" << std::setw(9) << "PSNR" << std::endl;
+
+		for (const fs::directory_entry& entry : it) {
+			if (!entry.is_regular_file()) {
+				continue;
+			}
+			std::string path = entry.path().string();
+			int width, height, channels;
+			unsigned char* data = LoadImageFile(path, &width, &height, &channels, 4);
+			if (data == nullptr) {
+				continue;
+			}
+
+			// GPUs pad RGB8 to 4 bytes per texel, so RGBA8 is the honest baseline
+			size_t rawBytes = 0;
+			size_t mipTexels = 0;
+			for (int w = width, h = height; ; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+				mipTexels += static_cast<size_t>(w) * h;
+				if (w == 1 && h == 1) {
+					break;
+				}
+			}
+			rawBytes = mipTexels * 4;
+
+			std::vector<BlockFormat> formats{ ChooseBlockFormat(channels, CompressionQuality::Normal) };
+			if (channels == 4) {
+				formats.push_back(BlockFormat::BC7);
+			}
+			for (BlockFormat format : formats) {
+				for (CompressionQuality quality : { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High }) {
+					auto start = std::chrono::steady_clock::now();
+					CompressedImage image = CompressImage(data, width, height, format, quality, true, pool);
+					double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+					size_t compressedBytes = 0;
+					for (const CompressedLevel& level : image.levels) {
+						compressedBytes += level.data.size();
+					}
+					std::vector<uint8_t> decoded(static_cast<size_t>(width) * height * 4);
+					DecompressLevel(image.levels[0].data.data(), width, height, format, decoded.data(), pool);
+					int errorChannels = format == BlockFormat::BC4 ? 1 : format == BlockFormat::BC5 ? 2 : format == BlockFormat::BC1 ? 3 : 4;
+
+					std::cout << std::left << std::setw(20) << entry.path().filename().string()
+						<< std::setw(11) << (std::to_string(width) + "x" + std::to_string(height))
+						<< std::setw(6) << FormatToName(format) << std::setw(8) << QualityToName(quality)
+						<< std::right << std::fixed << std::setprecision(1)
+						<< std::setw(12) << rawBytes / 1024.0 << std::setw(12) << compressedBytes / 1024.0
+						<< std::setw(8) << 100.0 * (1.0 - static_cast<double>(compressedBytes) / rawBytes) << "%"
+						<< std::setw(8) << 8.0 * compressedBytes / mipTexels
+						<< std::setw(10) << ms << std::setw(10) << (mipTexels / 1e6) / (ms / 1000.0)
+						<< std::setw(9) << std::setprecision(2) << ComputePSNR(data, decoded.data(), static_cast<size_t>(width) * height, errorChannels)
+						<< std::endl;
+				}
+			}
+			stbi_image_free(data);
+		}
+		std::cout << "bpp is bits fetched per texel sample (rgba8 = 32), so it doubles as the bandwidth ratio" << std::endl;
+	}
+
+	static const char* SupercompressionToName(uint32_t supercompression) {
+		switch (supercompression) {
+		case kSupercompressionNone: return "none";
+		case kSupercompressionBasisLZ: return "basislz";
+		case kSupercompressionZstd: return "zstd";
+		case kSupercompressionZlib: return "zlib";
+		default: return "?";
+		}
+	}
+
+	// read time (which includes inflating zlib and zstd levels) of every .ktx2 in directory, and how fast Basis payloads transcode to each target
+	static void PrintBasisReport(const std::string& directory, ThreadPool* pool) {
+		namespace fs = std::filesystem;
+		using Clock = std::chrono::steady_clock;
+		const BlockFormat kTargets[] = { BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7 };
+
+		std::error_code error;
+		fs::directory_iterator it{ directory, error };
+		if (error) {
+			return;
+		}
+		std::cout << "KTX2 files in " << directory << (HasBasisTranscoder() ? "" : " (built without the Basis Universal transcoder)") << std::endl;
+		std::cout << std::left << std::setw(20) << "file" << std::setw(8) << "payload" << std::setw(9) << "scheme" << std::right
+			<< std::setw(11) << "KiB" << std::setw(10) << "read ms" << std::setw(12) << "BC1 MP/s" << std::setw(12) << "BC3 MP/s"
+			<< std::setw(12) << "BC7 MP/s" << std::setw(13) << "RGBA8 MP/s" << std::endl;
+
+		size_t files = 0;
+		for (const fs::directory_entry& entry : it) {
+			if (!entry.is_regular_file() || entry.path().extension() != ".ktx2") {
+				continue;
+			}
+			files++;
+			std::vector<uint8_t> fileBytes = ReadWholeFile(entry.path().string());
+			auto start = Clock::now();
+			Ktx2Texture loaded{ };
+			std::string readError;
+			bool ok = ReadKtx2(fileBytes.data(), fileBytes.size(), loaded, readError);
+			double readMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if (!ok) {
+				std::cerr << "Can't read " << entry.path().string() << ": " << readError << std::endl;
+				continue;
+			}
+
+			Ktx2Payload payload = loaded.GetPayload();
+			bool basis = payload == Ktx2Payload::BasisETC1S || payload == Ktx2Payload::BasisUASTC;
+			const char* payloadName = payload == Ktx2Payload::BasisETC1S ? "etc1s" : payload == Ktx2Payload::BasisUASTC ? "uastc"
+				: payload == Ktx2Payload::BlockCompressed ? FormatToName(loaded.GetBlockFormat()) : payload == Ktx2Payload::RGBA8 ? "rgba8" : "?";
+			std::cout << std::left << std::setw(20) << entry.path().filename().string() << std::setw(8) << payloadName
+				<< std::setw(9) << SupercompressionToName(loaded.supercompression) << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(11) << fileBytes.size() / 1024.0 << std::setw(10) << readMs;
+
+			size_t texels = 0;
+			for (const Ktx2Level& level : loaded.levels) {
+				texels += static_cast<size_t>(level.width) * level.height * loaded.layerCount * loaded.faceCount;
+			}
+			// each target transcodes a fresh copy, since transcoding replaces the payload
+			auto throughput = [&](TranscodeTarget target, BlockFormat format) {
+				Ktx2Texture copy = loaded;
+				std::string transcodeError;
+				auto begin = Clock::now();
+				bool transcoded = TranscodeKtx2(copy, target, format, CompressionQuality::Fast, pool, transcodeError);
+				double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+				return transcoded ? (texels / 1e6) / (ms / 1000.0) : 0.0;
+			};
+			if (basis && HasBasisTranscoder()) {
+				for (BlockFormat format : kTargets) {
+					std::cout << std::setw(12) << throughput(TranscodeTarget::BlockCompressed, format);
+				}
+				std::cout << std::setw(13) << throughput(TranscodeTarget::RGBA8, BlockFormat::BC1);
+			}
+			std::cout << std::endl;
+		}
+		if (files == 0) {
+			std::cout << "no .ktx2 files; Basis ones made with toktx or basisu go there to be timed" << std::endl;
+		}
+	}
+
+	void PrintKtx2Report(const std::string& directory, ThreadPool* pool) {
+		namespace fs = std::filesystem;
+		using Clock = std::chrono::steady_clock;
+		auto msSince = [](Clock::time_point start) {
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		};
+
+		std::error_code error;
+		fs::directory_iterator it{ directory, error };
+		if (error) {
+			std::cerr << "Can't open texture directory " << directory << ": " << error.message() << std::endl;
+			return;
+		}
+		fs::path outDir = fs::temp_directory_path(error) / "learnOpenGL-ktx2";
+		fs::create_directories(outDir, error);
+
+		std::cout << "KTX2 vs stb_image for " << directory << " (KTX2 files written to " << outDir.string() << ")" << std::endl;
+		std::cout << std::left << std::setw(20) << "file" << std::setw(6) << "fmt" << std::right
+			<< std::setw(11) << "src KiB" << std::setw(11) << "ktx2 KiB" << std::setw(13) << "raw ktx2 KiB"
+			<< std::setw(14) << "stb+enc ms" << std::setw(10) << "ktx2 ms" << std::setw(14) << "bc->rgba MP/s" << std::setw(14) << "rgba->bc MP/s" << std::endl;
+
+		for (const fs::directory_entry& entry : it) {
+			std::string extension = entry.path().extension().string();
+			if (!entry.is_regular_file() || extension == ".ktx2") {
+				continue;
+			}
+			std::string path = entry.path().string();
+
+			// stb path: file -> RGBA8 -> BCn with mips, which is what LoadTexture does today
+			auto start = Clock::now();
+			int width, height, channels;
+			unsigned char* data = LoadImageFile(path, &width, &height, &channels, 4);
+			if (data == nullptr) {
+				continue;
+			}
+			BlockFormat format = ChooseBlockFormat(channels, CompressionQuality::Normal);
+			CompressedImage image = CompressImage(data, width, height, format, CompressionQuality::Normal, true, pool);
+			double stbMs = msSince(start);
+
+			Ktx2Texture ktx = MakeKtx2Texture(image);
+			std::vector<uint8_t> packed = WriteKtx2(ktx, true);
+			std::vector<uint8_t> raw = WriteKtx2(ktx, false);
+			fs::path outPath = outDir / entry.path().filename().replace_extension(".ktx2");
+			{
+				std::ofstream out(outPath, std::ios_base::out | std::ios_base::binary);
+				out.write(reinterpret_cast<const char*>(packed.data()), static_cast<std::streamsize>(packed.size()));
+			}
+
+			// ktx2 path: file -> GPU-ready blocks, the same steps LoadKtx2Texture takes before uploading
+			start = Clock::now();
+			Ktx2Texture loaded{ };
+			std::string readError;
+			std::vector<uint8_t> fileBytes = ReadWholeFile(outPath.string());
+			bool ok = ReadKtx2(fileBytes.data(), fileBytes.size(), loaded, readError) && TranscodeForUpload(loaded, TextureLoadOptions{ }, pool, readError);
+			double ktxMs = msSince(start);
+			if (!ok) {
+				std::cerr << "Round trip of " << outPath.string() << " failed: " << readError << std::endl;
+				stbi_image_free(data);
+				continue;
+			}
+
+			size_t texels = 0;
+			for (const Ktx2Level& level : loaded.levels) {
+				texels += static_cast<size_t>(level.width) * level.height;
+			}
+			// from what was written rather than what was loaded, which may have been expanded for the driver
+			Ktx2Texture expanded = ktx;
+			start = Clock::now();
+			TranscodeKtx2(expanded, TranscodeTarget::RGBA8, format, CompressionQuality::Normal, pool, readError);
+			double decodeMs = msSince(start);
+			start = Clock::now();
+			TranscodeKtx2(expanded, TranscodeTarget::BlockCompressed, format, CompressionQuality::Fast, pool, readError);
+			double encodeMs = msSince(start);
+
+			std::cout << std::left << std::setw(20) << entry.path().filename().string() << std::setw(6) << FormatToName(format)
+				<< std::right << std::fixed << std::setprecision(1)
+				<< std::setw(11) << entry.file_size() / 1024.0 << std::setw(11) << packed.size() / 1024.0 << std::setw(13) << raw.size() / 1024.0
+				<< std::setw(14) << stbMs << std::setw(10) << ktxMs
+				<< std::setw(14) << (texels / 1e6) / (decodeMs / 1000.0) << std::setw(14) << (texels / 1e6) / (encodeMs / 1000.0) << std::endl;
+			stbi_image_free(data);
+		}
+
+		PrintBasisReport(directory, pool);
+	}
+
+	// runs every job on the calling thread, the one thread point of the curve
+	static void InlineParallelFor(void*, int count, void (*job)(void* jobUser, int index), void* jobUser) {
+		for (int i = 0; i < count; i++) {
+			job(jobUser, i);
+		}
+	}
+
+	void PrintJpegDecodeReport(const std::string& directory) {
+		namespace fs = std::filesystem;
+		using Clock = std::chrono::steady_clock;
+		const int kRuns = 10;
+
+		std::error_code error;
+		fs::directory_iterator it{ directory, error };
+		if (error) {
+			std::cerr << "Can't open texture directory " << directory << ": " << error.message() << std::endl;
+			return;
+		}
+		unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::unique_ptr<ThreadPool>> pools(maxThreads + 1);
+		for (unsigned int threads = 2; threads <= maxThreads; threads++) {
+			pools[threads] = std::make_unique<ThreadPool>(threads - 1);
+		}
+
+		// best of kRuns, decoding from memory so file IO stays out of the numbers
+		auto decode = [&](const std::vector<uint8_t>& bytes, std::vector<uint8_t>& pixels) {
+			double best = 0.0;
+			for (int run = 0; run < kRuns; run++) {
+				int width, height, channels;
+				auto start = Clock::now();
+				unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, 4);
+				double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				if (data == nullptr) {
+					return -1.0;
+				}
+				best = run == 0 ? ms : std::min(best, ms);
+				pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+				stbi_image_free(data);
+			}
+			return best;
+		};
+
+		std::cout << "JPEG decode scaling for " << directory << " (best of " << kRuns << ", up to " << maxThreads << " threads)" << std::endl;
+		std::cout << std::left << std::setw(20) << "file" << std::setw(11) << "size" << std::right << std::setw(11) << "serial ms";
+		for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+			std::cout << std::setw(10) << (std::to_string(threads) + "T ms") << std::setw(8) << "x";
+		}
+		std::cout << std::endl;
+
+		for (const fs::directory_entry& entry : it) {
+			std::string extension = entry.path().extension().string();
+			if (!entry.is_regular_file() || (extension != ".jpg" && extension != ".jpeg")) {
+				continue;
+			}
+			std::vector<uint8_t> bytes = ReadWholeFile(entry.path().string());
+			int width = 0, height = 0, channels = 0;
+			stbi_info_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels);
+
+			std::vector<uint8_t> reference, pixels;
+			stbi_set_parallel_for(nullptr, nullptr);
+			double serialMs = decode(bytes, reference);
+			if (serialMs < 0.0) {
+				std::cerr << "Failed to decode " << entry.path().string() << ": " << stbi_failure_reason() << std::endl;
+				continue;
+			}
+			std::cout << std::left << std::setw(20) << entry.path().filename().string()
+				<< std::setw(11) << (std::to_string(width) + "x" + std::to_string(height))
+				<< std::right << std::fixed << std::setprecision(2) << std::setw(11) << serialMs;
+			bool identical = true;
+			for (unsigned int threads = 1; threads <= maxThreads; threads++) {
+				if (threads == 1) {
+					stbi_set_parallel_for(InlineParallelFor, nullptr);
+				}
+				else {
+					SetImageDecodePool(pools[threads].get());
+				}
+				double ms = decode(bytes, pixels);
+				identical = identical && ms >= 0.0 && pixels == reference;
+				std::cout << std::setw(10) << ms << std::setw(7) << serialMs / ms << "x";
+			}
+			std::cout << (identical ? "" : "  MISMATCH") << std::endl;
+		}
+		// back to whatever the loader uses
+		SetImageDecodePool(&ThreadPool::Shared());
+	}
+}
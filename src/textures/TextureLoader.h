@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <glad/glad.h>
+#include "TextureCompressor.h"
+#include "Ktx2.h"
+
+class ThreadPool;
+
+namespace textures {
+
+	struct TextureLoadOptions {
+		bool compress = true;
+		CompressionQuality quality = CompressionQuality::Normal;
+		bool generateMips = true;
+	};
+
+	struct LoadedTexture {
+		unsigned int id = 0;
+		// GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP
+		GLenum target = GL_TEXTURE_2D;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+		size_t gpuBytes = 0;
+		bool compressed = false;
+	};
+
+	// GL internal format for a block format, 0 if there is none
+	unsigned int GetGLFormat(BlockFormat format);
+	// whether the current context can sample the format directly
+	bool IsFormatSupported(BlockFormat format);
+
+	// uploads one level of the bound texture, decompressing first if the driver can't sample format; returns GPU bytes
+	size_t UploadCompressedLevel(GLenum target, int mip, BlockFormat format, const CompressedLevel& level, ThreadPool* pool);
+	/*
+	 * Uploads every level of image to a new texture bound to GL_TEXTURE_2D.
+	 * If the driver can't sample the block format, the levels are decompressed
+	 * on the CPU and uploaded as RGBA8 instead.
+	 */
+	unsigned int UploadCompressedImage(const CompressedImage& image, size_t* gpuBytes, ThreadPool* pool);
+	/*
+	 * Uploads a KTX2 texture as a 2D texture, 2D array or cube map depending on
+	 * its layer and face counts. Level data must already be BCn or RGBA8.
+	 */
+	LoadedTexture UploadKtx2Texture(const Ktx2Texture& texture);
+	/*
+	 * The block format a KTX2 texture should end up in: its own for BCn
+	 * payloads, the one a Basis payload transcodes to most directly among
+	 * those the driver samples, and the encoder's pick for RGBA8.
+	 */
+	BlockFormat ChooseKtx2BlockFormat(const Ktx2Texture& texture, CompressionQuality quality);
+	// reads a .ktx2 file and transcodes it on the shared pool into whatever the driver can sample
+	LoadedTexture LoadKtx2Texture(const std::string& filepath, const TextureLoadOptions& options);
+	// lets stb_image spread JPEG decoding over pool, nullptr decodes on the calling thread
+	void SetImageDecodePool(ThreadPool* pool);
+	/*
+	 * stbi_load for a file read into memory through the vfs. stb_image can
+	 * only split a JPEG at its restart markers when it sees the whole stream,
+	 * so this is the load that benefits from SetImageDecodePool. Free with
+	 * stbi_image_free.
+	 */
+	unsigned char* LoadImageFile(const std::string& filepath, int* width, int* height, int* channels, int desiredChannels);
+	// loads an image through stb_image (or the KTX2 reader for .ktx2 files) and uploads it
+	LoadedTexture LoadTexture(const std::string& filepath, const TextureLoadOptions& options);
+
+	// prints memory, bandwidth and encode throughput for every image in directory, no GL needed
+	void PrintCompressionReport(const std::string& directory, ThreadPool* pool);
+	// compares disk size, load time and transcode throughput of KTX2 against the stb_image path, then times any .ktx2 files (Basis ones included) already there
+	void PrintKtx2Report(const std::string& directory, ThreadPool* pool);
+	// times every JPEG in directory decoded serially and on 1..N threads, checking the pixels match
+	void PrintJpegDecodeReport(const std::string& directory);
+}
@@ -0,0 +1,303 @@
+#include "TextureStreamer.h"
+#include "Ktx2Transcoder.h"
+#include "../stb/stb_image.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/MemoryTags.h"
+#include "../threading/ThreadPool.h"
+#include "../vfs/AsyncReader.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+namespace textures {
+
+	// levels this size and below go up as soon as a texture has loaded and are never evicted
+	static const int kTailSize = 64;
+
+	struct TextureStreamer::LoadQueue {
+		std::mutex mutex;
+		std::vector<std::pair<Handle, std::shared_ptr<CompressedImage>>> finished{ };
+	};
+
+	// runs on a pool thread once the file is read; streaming always needs a block compressed chain with mips, whatever options says
+	static std::shared_ptr<CompressedImage> LoadSource(const std::string& filepath, const vfs::FileData& file, const TextureLoadOptions& options) {
+		auto image = std::make_shared<CompressedImage>();
+		if (std::filesystem::path(filepath).extension() == ".ktx2") {
+			Ktx2Texture ktx{ };
+			std::string error;
+			if (!ReadKtx2(file.GetBytes().data(), file.GetSize(), ktx, error)) {
+				std::cerr << "Failed to read KTX2 file " << filepath << ": " << error << std::endl;
+				return nullptr;
+			}
+			if (ktx.layerCount != 1 || ktx.faceCount != 1) {
+				std::cerr << "Can't stream " << filepath << ": only plain 2D textures are streamed" << std::endl;
+				return nullptr;
+			}
+			BlockFormat format = ChooseKtx2BlockFormat(ktx, options.quality);
+			if (!TranscodeKtx2(ktx, TranscodeTarget::BlockCompressed, format, options.quality, &ThreadPool::Shared(), error)) {
+				std::cerr << "Failed to transcode " << filepath << ": " << error << std::endl;
+				return nullptr;
+			}
+			image->format = ktx.GetBlockFormat();
+			image->width = ktx.width;
+			image->height = ktx.height;
+			for (Ktx2Level& level : ktx.levels) {
+				image->levels.push_back(CompressedLevel{ level.width, level.height, std::move(level.data) });
+			}
+			return image;
+		}
+
+		int width, height, channels;
+		unsigned char* data = stbi_load_from_memory(file.GetBytes().data(), static_cast<int>(file.GetSize()), &width, &height, &channels, 4);
+		if (data == nullptr) {
+			std::cerr << "Failed to load image at " << filepath << ": " << stbi_failure_reason() << std::endl;
+			return nullptr;
+		}
+		BlockFormat format = ChooseBlockFormat(channels, options.quality);
+		*image = CompressImage(data, width, height, format, options.quality, true, &ThreadPool::Shared());
+		stbi_image_free(data);
+		return image;
+	}
+
+	TextureStreamer::TextureStreamer(size_t budgetBytes, size_t uploadBytesPerFrame)
+		: loadQueue(std::make_shared<LoadQueue>()), reader(std::make_unique<vfs::AsyncReader>(ThreadPool::Shared())), uploadBytesPerFrame(uploadBytesPerFrame) {
+		stats.budgetBytes = budgetBytes;
+	}
+
+	TextureStreamer::~TextureStreamer() {
+		// loads still in flight only touch loadQueue, which they keep alive themselves
+		for (const Entry& entry : entries) {
+			glDeleteTextures(1, &entry.id);
+		}
+	}
+
+	TextureStreamer::Handle TextureStreamer::Request(const std::string& filepath, const TextureLoadOptions& options) {
+		MEMORY_TAG(profiling::MemoryTag::Assets);
+		Handle handle = entries.size();
+		Entry entry{ };
+		entry.path = filepath;
+		entry.options = options;
+
+		// a 1x1 grey level 0 keeps the texture complete until real data arrives
+		const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+		glGenTextures(1, &entry.id);
+		glBindTexture(GL_TEXTURE_2D, entry.id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		entries.push_back(std::move(entry));
+
+		// goes out with the other requests of this frame on the next Update
+		pendingReads[reader->Read(filepath)] = handle;
+		return handle;
+	}
+
+	unsigned int TextureStreamer::GetTextureId(Handle handle) const {
+		return entries[handle].id;
+	}
+
+	void TextureStreamer::SetBounds(Handle handle, const glm::vec3& center, float radius) {
+		entries[handle].center = center;
+		entries[handle].radius = radius;
+	}
+
+	void TextureStreamer::SetBudget(size_t budgetBytes) {
+		stats.budgetBytes = budgetBytes;
+	}
+
+	const StreamingStats& TextureStreamer::GetStats() const {
+		return stats;
+	}
+
+	void TextureStreamer::ApplyLevelRange(const Entry& entry) {
+		// levels below the base are ignored for completeness, so evicted ones don't need to match
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.residentBase);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(entry.levelBytes.size()) - 1);
+	}
+
+	void TextureStreamer::UploadLevel(Entry& entry, int level) {
+		glBindTexture(GL_TEXTURE_2D, entry.id);
+		UploadCompressedLevel(GL_TEXTURE_2D, level, entry.source->format, entry.source->levels[level], &ThreadPool::Shared());
+		entry.residentBase = level;
+		stats.residentBytes += entry.levelBytes[level];
+		stats.uploadsThisFrame++;
+		ApplyLevelRange(entry);
+	}
+
+	void TextureStreamer::EvictLevel(Entry& entry) {
+		int level = entry.residentBase;
+		glBindTexture(GL_TEXTURE_2D, entry.id);
+		// respecifying as 0x0 lets the driver release the storage of that level
+		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		entry.residentBase = level + 1;
+		stats.residentBytes -= entry.levelBytes[level];
+		stats.evictionsThisFrame++;
+		ApplyLevelRange(entry);
+	}
+
+	void TextureStreamer::BeginResidency(Entry& entry) {
+		const CompressedImage& image = *entry.source;
+		bool native = IsFormatSupported(image.format);
+		int levelCount = static_cast<int>(image.levels.size());
+		entry.levelBytes.resize(levelCount);
+		entry.tailBase = levelCount - 1;
+		for (int i = levelCount - 1; i >= 0; i--) {
+			const CompressedLevel& level = image.levels[i];
+			entry.levelBytes[i] = native ? level.data.size() : static_cast<size_t>(level.width) * level.height * 4;
+			if (std::max(level.width, level.height) <= kTailSize) {
+				entry.tailBase = i;
+			}
+		}
+		entry.residentBase = levelCount;
+		entry.requestedBase = entry.tailBase;
+
+		// smallest first, so there is something sharper than the placeholder to sample right away
+		for (int i = levelCount - 1; i >= entry.tailBase; i--) {
+			UploadLevel(entry, i);
+		}
+	}
+
+	bool TextureStreamer::MakeRoom(size_t bytes, const std::vector<Entry*>& byPriority, const Entry* keep) {
+		auto fits = [&]() { return stats.residentBytes + bytes <= stats.budgetBytes; };
+		if (fits()) {
+			return true;
+		}
+
+		// don't throw anything away unless it actually makes enough room
+		size_t evictable = 0;
+		bool belowKeep = keep == nullptr;
+		for (const Entry* entry : byPriority) {
+			for (int i = entry->residentBase; i < entry->tailBase; i++) {
+				if (entry != keep && (belowKeep || i < entry->requestedBase)) {
+					evictable += entry->levelBytes[i];
+				}
+			}
+			belowKeep = belowKeep || entry == keep;
+		}
+		if (stats.residentBytes - evictable + bytes > stats.budgetBytes) {
+			return false;
+		}
+
+		// surplus levels first: anything finer than its texture needs at the current distance
+		for (auto it = byPriority.rbegin(); it != byPriority.rend() && !fits(); ++it) {
+			Entry& entry = **it;
+			while (&entry != keep && entry.residentBase < entry.requestedBase && !fits()) {
+				EvictLevel(entry);
+			}
+		}
+		// then levels that are wanted, starting with the least visible texture
+		for (auto it = byPriority.rbegin(); it != byPriority.rend() && !fits() && *it != keep; ++it) {
+			Entry& entry = **it;
+			while (entry.residentBase < entry.tailBase && !fits()) {
+				EvictLevel(entry);
+			}
+		}
+		return fits();
+	}
+
+	void TextureStreamer::Update(const glm::vec3& cameraPosition, float verticalFovRadians, int viewportHeight) {
+		PROFILE_SCOPE("TextureStreamer::Update");
+		MEMORY_TAG(profiling::MemoryTag::Assets);
+		stats.uploadsThisFrame = 0;
+		stats.evictionsThisFrame = 0;
+
+		// file reads that came back are decoded and encoded on the pool
+		reader->Flush();
+		std::vector<vfs::AsyncReadResult> reads{ };
+		reader->Drain(reads);
+		for (vfs::AsyncReadResult& read : reads) {
+			Handle handle = pendingReads[read.ticket];
+			pendingReads.erase(read.ticket);
+			if (!read.data) {
+				std::cerr << "Failed to read " << read.path << ": " << read.error << std::endl;
+				entries[handle].failed = true;
+				continue;
+			}
+			ThreadPool::Shared().Submit([queue = loadQueue, handle, read = std::move(read), options = entries[handle].options]() {
+				std::shared_ptr<CompressedImage> image = LoadSource(read.path, read.data, options);
+				std::lock_guard<std::mutex> lock(queue->mutex);
+				queue->finished.emplace_back(handle, std::move(image));
+			});
+		}
+
+		std::vector<std::pair<Handle, std::shared_ptr<CompressedImage>>> finished{ };
+		{
+			std::lock_guard<std::mutex> lock(loadQueue->mutex);
+			finished.swap(loadQueue->finished);
+		}
+		for (auto& [handle, image] : finished) {
+			Entry& entry = entries[handle];
+			if (image == nullptr || image->levels.empty()) {
+				entry.failed = true;
+				continue;
+			}
+			entry.source = std::move(image);
+			BeginResidency(entry);
+		}
+
+		// pixels covered by one world unit at distance one
+		float pixelsPerUnit = viewportHeight / (2.0f * std::tan(verticalFovRadians * 0.5f));
+		std::vector<Entry*> active{ };
+		stats.pendingLoads = 0;
+		for (Entry& entry : entries) {
+			if (entry.source == nullptr) {
+				stats.pendingLoads += entry.failed ? 0 : 1;
+				continue;
+			}
+			float distance = std::max(glm::length(cameraPosition - entry.center) - entry.radius, 1e-3f);
+			entry.screenSize = 2.0f * entry.radius / distance * pixelsPerUnit;
+			float texels = static_cast<float>(std::max(entry.source->width, entry.source->height));
+			int level = entry.screenSize >= texels ? 0 : static_cast<int>(std::floor(std::log2(texels / entry.screenSize)));
+			entry.requestedBase = std::clamp(level, 0, entry.tailBase);
+			active.push_back(&entry);
+		}
+		std::sort(active.begin(), active.end(), [](const Entry* a, const Entry* b) { return a->screenSize > b->screenSize; });
+
+		// one level per texture per pass so the most visible textures don't starve the rest
+		size_t uploadLeft = uploadBytesPerFrame;
+		bool progress = true;
+		while (progress) {
+			progress = false;
+			for (Entry* entry : active) {
+				if (entry->residentBase <= entry->requestedBase) {
+					continue;
+				}
+				int level = entry->residentBase - 1;
+				size_t bytes = entry->levelBytes[level];
+				// a level larger than the whole frame allowance still goes up if it's the first this frame
+				if (bytes > uploadLeft && stats.uploadsThisFrame > 0) {
+					continue;
+				}
+				if (!MakeRoom(bytes, active, entry)) {
+					continue;
+				}
+				UploadLevel(*entry, level);
+				uploadLeft -= std::min(bytes, uploadLeft);
+				progress = true;
+			}
+		}
+		// the budget may have shrunk since last frame
+		MakeRoom(0, active, nullptr);
+
+		stats.residentTexels = 0;
+		stats.requestedTexels = 0;
+		for (const Entry* entry : active) {
+			for (size_t i = 0; i < entry->levelBytes.size(); i++) {
+				size_t texels = static_cast<size_t>(entry->source->levels[i].width) * entry->source->levels[i].height;
+				if (static_cast<int>(i) >= entry->residentBase) {
+					stats.residentTexels += texels;
+				}
+				if (static_cast<int>(i) >= entry->requestedBase) {
+					stats.requestedTexels += texels;
+				}
+			}
+		}
+	}
+}
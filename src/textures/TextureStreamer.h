@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "TextureLoader.h"
+#include "../vfs/AsyncReader.h"
+
+namespace textures {
+
+	struct StreamingStats {
+		// texels of every level currently uploaded, summed over all textures
+		size_t residentTexels = 0;
+		// texels the textures would have resident if the budget were unlimited
+		size_t requestedTexels = 0;
+		size_t residentBytes = 0;
+		size_t budgetBytes = 0;
+		int pendingLoads = 0;
+		int uploadsThisFrame = 0;
+		int evictionsThisFrame = 0;
+	};
+
+	/*
+	 * Keeps the full block compressed mip chain of each texture in system memory
+	 * and decides every frame which levels should live on the GPU.
+	 *
+	 * Files are read asynchronously, the requests of one frame in one batch,
+	 * then decoded and encoded on the shared thread pool. Once a texture is
+	 * ready, the small tail of its chain goes up straight away and larger levels
+	 * follow one at a time, most visible texture first, within a per-frame upload
+	 * limit. When the resident set goes over the VRAM budget, the largest levels
+	 * of the least visible textures are dropped again. GL_TEXTURE_BASE_LEVEL is
+	 * clamped to the finest resident level so the texture always stays complete.
+	 */
+	class TextureStreamer {
+	public:
+		using Handle = size_t;
+
+		explicit TextureStreamer(size_t budgetBytes, size_t uploadBytesPerFrame = 4 * 1024 * 1024);
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// starts loading filepath in the background; the texture id is valid immediately and shows a placeholder until then
+		Handle Request(const std::string& filepath, const TextureLoadOptions& options);
+		unsigned int GetTextureId(Handle handle) const;
+		// world space bounding sphere of whatever the texture is drawn on, used to estimate its size on screen
+		void SetBounds(Handle handle, const glm::vec3& center, float radius);
+		void SetBudget(size_t budgetBytes);
+
+		// picks up finished loads, then uploads or evicts levels; call once per frame on the GL thread
+		void Update(const glm::vec3& cameraPosition, float verticalFovRadians, int viewportHeight);
+		const StreamingStats& GetStats() const;
+
+	private:
+		struct Entry {
+			std::string path;
+			TextureLoadOptions options{ };
+			unsigned int id = 0;
+			glm::vec3 center{ 0.0f };
+			float radius = 1.0f;
+			// null until the background load has finished
+			std::shared_ptr<CompressedImage> source{ };
+			// GPU bytes of each level, differs from the source when the driver needs RGBA8
+			std::vector<size_t> levelBytes{ };
+			// finest level uploaded, levelBytes.size() while nothing is
+			int residentBase = 0;
+			// finest level worth having at the current on-screen size
+			int requestedBase = 0;
+			// first level of the tail that is never evicted
+			int tailBase = 0;
+			float screenSize = 0.0f;
+			bool failed = false;
+		};
+		struct LoadQueue;
+
+		std::vector<Entry> entries{ };
+		std::shared_ptr<LoadQueue> loadQueue;
+		std::unique_ptr<vfs::AsyncReader> reader;
+		// reads in flight and the texture each one is for
+		std::unordered_map<vfs::AsyncReader::Ticket, Handle> pendingReads{ };
+		size_t uploadBytesPerFrame;
+		StreamingStats stats{ };
+
+		void BeginResidency(Entry& entry);
+		void UploadLevel(Entry& entry, int level);
+		void EvictLevel(Entry& entry);
+		void ApplyLevelRange(const Entry& entry);
+		bool MakeRoom(size_t bytes, const std::vector<Entry*>& byPriority, const Entry* keep);
+	};
+}
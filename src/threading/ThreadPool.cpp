@@ -0,0 +1,132 @@
+#include "ThreadPool.h"
+#include "../profiling/Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+	if (threadCount == 0) {
+		unsigned int hw = std::thread::hardware_concurrency();
+		threadCount = hw > 1 ? hw - 1 : 1;
+	}
+	workers.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(Job{ std::move(job), profiling::CurrentMemoryTag() });
+	}
+	jobAvailable.notify_one();
+}
+
+bool ThreadPool::RunOneJob(std::unique_lock<std::mutex>& lock) {
+	if (jobs.empty()) {
+		return false;
+	}
+	Job job = std::move(jobs.front());
+	jobs.pop_front();
+	activeJobs++;
+	lock.unlock();
+	{
+		PROFILE_SCOPE("ThreadPool job");
+		MEMORY_TAG(job.memoryTag);
+		job.run();
+	}
+	lock.lock();
+	activeJobs--;
+	if (jobs.empty() && activeJobs == 0) {
+		jobsDone.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::WorkerLoop() {
+	PROFILE_THREAD("thread pool");
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+		if (stopping && jobs.empty()) {
+			return;
+		}
+		RunOneJob(lock);
+	}
+}
+
+void ThreadPool::WaitIdle() {
+	std::unique_lock<std::mutex> lock(mutex);
+	// help drain the queue instead of just sleeping on it
+	while (RunOneJob(lock)) {}
+	jobsDone.wait(lock, [this] { return jobs.empty() && activeJobs == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn, size_t grainSize) {
+	if (count == 0) {
+		return;
+	}
+	grainSize = std::max<size_t>(grainSize, 1);
+	size_t maxChunks = static_cast<size_t>(workers.size() + 1) * 4;
+	size_t chunkSize = std::max(grainSize, (count + maxChunks - 1) / maxChunks);
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount == 1) {
+		fn(0, count);
+		return;
+	}
+
+	// chunks are claimed through a shared counter so the caller and the workers
+	// split the range dynamically. The state is shared-owned because a helper that
+	// only gets scheduled after the caller returned must still find valid counters.
+	struct ForState {
+		std::atomic<size_t> nextChunk{ 0 };
+		std::atomic<size_t> chunksLeft{ 0 };
+		std::mutex doneMutex;
+		std::condition_variable doneCondition;
+	};
+	auto state = std::make_shared<ForState>();
+	state->chunksLeft = chunkCount;
+	const auto* body = &fn;
+
+	auto runChunks = [state, body, chunkCount, chunkSize, count]() {
+		size_t chunk;
+		while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount) {
+			size_t begin = chunk * chunkSize;
+			(*body)(begin, std::min(count, begin + chunkSize));
+			if (state->chunksLeft.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> lock(state->doneMutex);
+				state->doneCondition.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = std::min(chunkCount - 1, workers.size());
+	for (size_t i = 0; i < helpers; i++) {
+		Submit(runChunks);
+	}
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(state->doneMutex);
+	state->doneCondition.wait(lock, [&] { return state->chunksLeft.load() == 0; });
+}
+
+unsigned int ThreadPool::GetThreadCount() const {
+	return static_cast<unsigned int>(workers.size());
+}
+
+ThreadPool& ThreadPool::Shared() {
+	static ThreadPool pool{};
+	return pool;
+}
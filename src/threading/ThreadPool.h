@@ -0,0 +1,49 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../profiling/MemoryTags.h"
+
+/*
+ * Fixed-size pool of worker threads fed from a single FIFO job queue.
+ * ParallelFor lets the calling thread help out, so it is safe to use from
+ * the main thread without leaving a core idle.
+ */
+class ThreadPool {
+	struct Job {
+		std::function<void()> run;
+		// of the thread that submitted it, so its allocations are counted against the same subsystem
+		profiling::MemoryTag memoryTag;
+	};
+
+	std::vector<std::thread> workers;
+	std::deque<Job> jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsDone;
+	size_t activeJobs = 0;
+	bool stopping = false;
+
+	void WorkerLoop();
+	bool RunOneJob(std::unique_lock<std::mutex>& lock);
+public:
+	// threadCount of 0 picks hardware_concurrency - 1 (the caller is the extra thread)
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> job);
+	// blocks until every queued and running job has finished
+	void WaitIdle();
+	// splits [0, count) into chunks of at least grainSize and blocks until all are done
+	void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn, size_t grainSize = 1);
+	unsigned int GetThreadCount() const;
+
+	// lazily created pool shared by asset loading, texture encoding, etc.
+	static ThreadPool& Shared();
+};
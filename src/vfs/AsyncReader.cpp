@@ -0,0 +1,719 @@
+#include "AsyncReader.h"
+#include "../threading/ThreadPool.h"
+#include "../profiling/Profiler.h"
+#include "../profiling/MemoryTags.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VFS_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace vfs {
+
+	// direct reads need buffer, offset and length aligned to the logical block size, a page covers every disk
+	static const size_t kDirectAlignment = 4096;
+	// one read call never asks for more than this, some systems refuse larger counts
+	static const size_t kMaxReadBytes = 1u << 30;
+
+	static size_t RoundUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static std::shared_ptr<uint8_t> AllocateBuffer(size_t size, bool direct) {
+		if (!direct) {
+			return std::shared_ptr<uint8_t>(new uint8_t[std::max<size_t>(size, 1)], std::default_delete<uint8_t[]>());
+		}
+		size_t capacity = std::max(RoundUp(size, kDirectAlignment), kDirectAlignment);
+		auto* data = static_cast<uint8_t*>(::operator new(capacity, std::align_val_t(kDirectAlignment)));
+		return std::shared_ptr<uint8_t>(data, [](uint8_t* p) { ::operator delete(p, std::align_val_t(kDirectAlignment)); });
+	}
+
+	static std::string SystemError(int code) {
+#ifdef _WIN32
+		return "error " + std::to_string(code);
+#else
+		return std::strerror(code);
+#endif
+	}
+
+	// what the pool backend does for a loose file: open, one or more preads, close, all blocking
+	static FileData ReadBlocking(const std::string& path, size_t directMinBytes, std::string& error) {
+		std::error_code sizeError;
+		uintmax_t size = std::filesystem::file_size(path, sizeError);
+		if (sizeError) {
+			error = "can't stat " + path + ": " + sizeError.message();
+			return FileData{ };
+		}
+		bool direct = directMinBytes != 0 && size >= directMinBytes;
+		std::shared_ptr<uint8_t> buffer;
+		size_t done = 0;
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | (direct ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN), nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			error = "can't open " + path + ": " + SystemError(static_cast<int>(GetLastError()));
+			return FileData{ };
+		}
+		buffer = AllocateBuffer(static_cast<size_t>(size), direct);
+		while (done < size) {
+			size_t length = std::min<size_t>(direct ? RoundUp(size - done, kDirectAlignment) : size - done, kMaxReadBytes);
+			OVERLAPPED at{ };
+			at.Offset = static_cast<DWORD>(done);
+			at.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(done) >> 32);
+			DWORD read = 0;
+			if (!ReadFile(file, buffer.get() + done, static_cast<DWORD>(length), &read, &at) && GetLastError() != ERROR_HANDLE_EOF) {
+				error = "can't read " + path + ": " + SystemError(static_cast<int>(GetLastError()));
+				CloseHandle(file);
+				return FileData{ };
+			}
+			if (read == 0) {
+				break;
+			}
+			done = std::min<size_t>(done + read, size);
+		}
+		CloseHandle(file);
+#else
+		int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+		flags |= direct ? O_DIRECT : 0;
+#else
+		direct = false;
+#endif
+		int fd = open(path.c_str(), flags);
+		if (fd < 0 && direct && errno == EINVAL) {
+			// tmpfs and friends don't do direct I/O
+			direct = false;
+			fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		}
+		if (fd < 0) {
+			error = "can't open " + path + ": " + SystemError(errno);
+			return FileData{ };
+		}
+		buffer = AllocateBuffer(static_cast<size_t>(size), direct);
+		while (done < size) {
+			size_t length = std::min<size_t>(direct ? RoundUp(size - done, kDirectAlignment) : size - done, kMaxReadBytes);
+			ssize_t read = pread(fd, buffer.get() + done, length, static_cast<off_t>(done));
+			if (read < 0 && errno == EINTR) {
+				continue;
+			}
+			if (read < 0) {
+				error = "can't read " + path + ": " + SystemError(errno);
+				close(fd);
+				return FileData{ };
+			}
+			if (read == 0) {
+				break;
+			}
+			done = std::min<size_t>(done + static_cast<size_t>(read), size);
+		}
+		close(fd);
+#endif
+		// a file that shrank in the meantime comes back as what was there
+		return FileData{ buffer, std::span<const uint8_t>(buffer.get(), done) };
+	}
+
+	// shared with pool jobs, which may outlive a read that's abandoned
+	struct AsyncReader::Completions {
+		std::mutex mutex;
+		std::condition_variable allDone;
+		std::vector<AsyncReadResult> finished{ };
+		size_t inFlight = 0;
+
+		void Push(AsyncReadResult result) {
+			std::lock_guard<std::mutex> lock(mutex);
+			finished.push_back(std::move(result));
+			inFlight--;
+			allDone.notify_all();
+		}
+	};
+
+	static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+#ifdef VFS_IO_URING
+
+	/*
+	 * Every read walks statx -> openat -> read (repeated for short reads), one
+	 * ring operation at a time, with the read itself as user_data. The worker
+	 * thread owns the ring; Flush hands it new reads and pokes an eventfd the
+	 * ring always has a read pending on, which wakes it from io_uring_enter.
+	 */
+	struct AsyncReader::Ring {
+		enum class Step {
+			Stat,
+			Open,
+			Read
+		};
+		struct Read {
+			Request request;
+			std::shared_ptr<Completions> completions;
+			Step step = Step::Stat;
+			struct statx info { };
+			int fd = -1;
+			bool direct = false;
+			size_t size = 0;
+			size_t done = 0;
+			std::shared_ptr<uint8_t> buffer{ };
+		};
+
+		size_t directMinBytes = 0;
+		int ringFd = -1;
+		int wakeFd = -1;
+		uint64_t wakeValue = 0;
+		unsigned int sqEntries = 0;
+		void* sqRing = nullptr;
+		size_t sqRingSize = 0;
+		void* cqRing = nullptr;
+		size_t cqRingSize = 0;
+		io_uring_sqe* sqes = nullptr;
+		size_t sqesSize = 0;
+		unsigned* sqTail = nullptr;
+		unsigned* sqMask = nullptr;
+		unsigned* sqArray = nullptr;
+		unsigned* cqHead = nullptr;
+		unsigned* cqTail = nullptr;
+		unsigned* cqMask = nullptr;
+		io_uring_cqe* cqes = nullptr;
+		unsigned int unsubmitted = 0;
+
+		std::thread worker{ };
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Read>> incoming{ };
+		bool stopping = false;
+		// only touched by the worker
+		std::deque<std::unique_ptr<Read>> waiting{ };
+		size_t active = 0;
+
+		~Ring() {
+			if (worker.joinable()) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				Wake();
+				worker.join();
+			}
+			if (sqes != nullptr) {
+				munmap(sqes, sqesSize);
+			}
+			if (cqRing != nullptr && cqRing != sqRing) {
+				munmap(cqRing, cqRingSize);
+			}
+			if (sqRing != nullptr) {
+				munmap(sqRing, sqRingSize);
+			}
+			if (ringFd >= 0) {
+				close(ringFd);
+			}
+			if (wakeFd >= 0) {
+				close(wakeFd);
+			}
+		}
+
+		bool Start(unsigned int queueDepth, std::string& error) {
+			io_uring_params params{ };
+			ringFd = static_cast<int>(syscall(__NR_io_uring_setup, std::max(queueDepth, 2u), &params));
+			if (ringFd < 0) {
+				error = std::string("io_uring_setup failed: ") + SystemError(errno);
+				return false;
+			}
+			const uint8_t requiredOps[] = { IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ };
+			std::vector<uint8_t> probeStorage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+			auto* probe = reinterpret_cast<io_uring_probe*>(probeStorage.data());
+			if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+				error = std::string("io_uring can't be probed: ") + SystemError(errno);
+				return false;
+			}
+			for (uint8_t op : requiredOps) {
+				if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+					error = "io_uring is missing operation " + std::to_string(op);
+					return false;
+				}
+			}
+
+			sqEntries = params.sq_entries;
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMmap) {
+				sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+			}
+			sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+			if (sqRing == MAP_FAILED) {
+				sqRing = nullptr;
+				error = std::string("can't map the submission ring: ") + SystemError(errno);
+				return false;
+			}
+			cqRing = singleMmap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+			if (cqRing == MAP_FAILED) {
+				cqRing = nullptr;
+				error = std::string("can't map the completion ring: ") + SystemError(errno);
+				return false;
+			}
+			sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* mappedSqes = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+			if (mappedSqes == MAP_FAILED) {
+				error = std::string("can't map the submission entries: ") + SystemError(errno);
+				return false;
+			}
+			sqes = static_cast<io_uring_sqe*>(mappedSqes);
+			auto* sq = static_cast<uint8_t*>(sqRing);
+			auto* cq = static_cast<uint8_t*>(cqRing);
+			sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			wakeFd = eventfd(0, EFD_CLOEXEC);
+			if (wakeFd < 0) {
+				error = std::string("eventfd failed: ") + SystemError(errno);
+				return false;
+			}
+			worker = std::thread(&Ring::Run, this);
+			return true;
+		}
+
+		void Submit(std::vector<std::unique_ptr<Read>>& reads) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (std::unique_ptr<Read>& read : reads) {
+					incoming.push_back(std::move(read));
+				}
+			}
+			Wake();
+		}
+
+		void Wake() {
+			uint64_t one = 1;
+			// can only fail if the counter is about to overflow, and then the worker is awake anyway
+			(void)!write(wakeFd, &one, sizeof(one));
+		}
+
+		// the caller fills in the rest; the ring never has more operations than entries, so there's always a slot
+		io_uring_sqe* NextSqe(uint8_t opcode, int fd, uint64_t userData) {
+			unsigned tail = *sqTail;
+			unsigned index = tail & *sqMask;
+			io_uring_sqe* sqe = &sqes[index];
+			std::memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = opcode;
+			sqe->fd = fd;
+			sqe->user_data = userData;
+			sqArray[index] = index;
+			__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+			unsubmitted++;
+			return sqe;
+		}
+
+		void ArmWake() {
+			io_uring_sqe* sqe = NextSqe(IORING_OP_READ, wakeFd, 0);
+			sqe->addr = reinterpret_cast<uint64_t>(&wakeValue);
+			sqe->len = sizeof(wakeValue);
+		}
+
+		void PrepareStep(Read& read) {
+			uint64_t userData = reinterpret_cast<uint64_t>(&read);
+			switch (read.step) {
+			case Step::Stat: {
+				io_uring_sqe* sqe = NextSqe(IORING_OP_STATX, AT_FDCWD, userData);
+				sqe->addr = reinterpret_cast<uint64_t>(read.request.loosePath.c_str());
+				sqe->len = STATX_SIZE;
+				sqe->off = reinterpret_cast<uint64_t>(&read.info);
+				break;
+			}
+			case Step::Open: {
+				io_uring_sqe* sqe = NextSqe(IORING_OP_OPENAT, AT_FDCWD, userData);
+				sqe->addr = reinterpret_cast<uint64_t>(read.request.loosePath.c_str());
+				sqe->open_flags = O_RDONLY | O_CLOEXEC | (read.direct ? O_DIRECT : 0);
+				break;
+			}
+			case Step::Read: {
+				size_t length = std::min(read.direct ? RoundUp(read.size - read.done, kDirectAlignment) : read.size - read.done, kMaxReadBytes);
+				io_uring_sqe* sqe = NextSqe(IORING_OP_READ, read.fd, userData);
+				sqe->addr = reinterpret_cast<uint64_t>(read.buffer.get() + read.done);
+				sqe->len = static_cast<uint32_t>(length);
+				sqe->off = read.done;
+				break;
+			}
+			}
+		}
+
+		void Finish(std::unique_ptr<Read> read, const std::string& error) {
+			if (read->fd >= 0) {
+				close(read->fd);
+			}
+			active--;
+			AsyncReadResult result{ read->request.ticket, std::move(read->request.path) };
+			if (error.empty()) {
+				result.data = FileData{ read->buffer, std::span<const uint8_t>(read->buffer.get(), read->done) };
+			}
+			else {
+				result.error = error;
+			}
+			result.ms = MillisecondsSince(read->request.flushed);
+			read->completions->Push(std::move(result));
+		}
+
+		// moves a read to its next step after the current one completed with res
+		void Advance(std::unique_ptr<Read> read, int res) {
+			const std::string& path = read->request.loosePath;
+			if (res == -EINTR || res == -EAGAIN) {
+				PrepareStep(*read);
+				read.release();
+				return;
+			}
+			switch (read->step) {
+			case Step::Stat:
+				if (res < 0) {
+					return Finish(std::move(read), "can't stat " + path + ": " + SystemError(-res));
+				}
+				read->size = static_cast<size_t>(read->info.stx_size);
+				read->direct = directMinBytes != 0 && read->size >= directMinBytes;
+				read->step = Step::Open;
+				break;
+			case Step::Open:
+				if (res == -EINVAL && read->direct) {
+					// tmpfs and friends don't do direct I/O
+					read->direct = false;
+					break;
+				}
+				if (res < 0) {
+					return Finish(std::move(read), "can't open " + path + ": " + SystemError(-res));
+				}
+				read->fd = res;
+				read->buffer = AllocateBuffer(read->size, read->direct);
+				if (read->size == 0) {
+					return Finish(std::move(read), "");
+				}
+				read->step = Step::Read;
+				break;
+			case Step::Read:
+				if (res < 0) {
+					return Finish(std::move(read), "can't read " + path + ": " + SystemError(-res));
+				}
+				read->done = std::min(read->done + static_cast<size_t>(res), read->size);
+				// res == 0 means the file shrank in the meantime, which leaves what was there
+				if (res == 0 || read->done == read->size) {
+					return Finish(std::move(read), "");
+				}
+				break;
+			}
+			PrepareStep(*read);
+			read.release();
+		}
+
+		void Run() {
+			PROFILE_THREAD("io_uring reader");
+			MEMORY_TAG(profiling::MemoryTag::Assets);
+			ArmWake();
+			for (;;) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					for (std::unique_ptr<Read>& read : incoming) {
+						waiting.push_back(std::move(read));
+					}
+					incoming.clear();
+					if (stopping && waiting.empty() && active == 0) {
+						break;
+					}
+				}
+				// one operation per active read plus the eventfd read
+				while (!waiting.empty() && active + 1 < sqEntries) {
+					PrepareStep(*waiting.front());
+					waiting.front().release();
+					waiting.pop_front();
+					active++;
+				}
+
+				long submitted = syscall(__NR_io_uring_enter, ringFd, unsubmitted, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (submitted < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+					std::cerr << "io_uring_enter failed: " << SystemError(errno) << std::endl;
+					break;
+				}
+				if (submitted > 0) {
+					unsubmitted -= static_cast<unsigned int>(submitted);
+				}
+
+				unsigned head = *cqHead;
+				unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+				for (; head != tail; head++) {
+					const io_uring_cqe& cqe = cqes[head & *cqMask];
+					if (cqe.user_data == 0) {
+						ArmWake();
+					}
+					else {
+						Advance(std::unique_ptr<Read>(reinterpret_cast<Read*>(cqe.user_data)), cqe.res);
+					}
+				}
+				__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+			}
+		}
+	};
+
+#else
+
+	// never started without io_uring, only here so the reader can hold one
+	struct AsyncReader::Ring {
+		struct Read {
+			Request request;
+			std::shared_ptr<Completions> completions;
+		};
+
+		bool Start(unsigned int, std::string& error) {
+			error = "io_uring is Linux only";
+			return false;
+		}
+
+		void Submit(std::vector<std::unique_ptr<Read>>&) {
+		}
+	};
+
+#endif
+
+	AsyncReader::AsyncReader(ThreadPool& pool, const AsyncReadOptions& options)
+		: pool(pool), options(options), completions(std::make_shared<Completions>()) {
+#ifdef VFS_IO_URING
+		if (options.useIoUring) {
+			ring = std::make_unique<Ring>();
+			ring->directMinBytes = options.directMinBytes;
+			std::string error;
+			if (!ring->Start(options.queueDepth, error)) {
+				std::cout << "Reading files on the thread pool, " << error << std::endl;
+				ring.reset();
+			}
+		}
+#endif
+	}
+
+	AsyncReader::~AsyncReader() {
+		Wait();
+		// joins the worker, which has nothing left to do
+		ring.reset();
+	}
+
+	AsyncReader::Ticket AsyncReader::Read(const std::string& path) {
+		Ticket ticket = nextTicket++;
+		queued.push_back(Request{ ticket, path });
+		return ticket;
+	}
+
+	void AsyncReader::Flush() {
+		if (queued.empty()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(completions->mutex);
+			completions->inFlight += queued.size();
+		}
+		auto now = std::chrono::steady_clock::now();
+		std::vector<std::unique_ptr<Ring::Read>> ringReads{ };
+		for (Request& request : queued) {
+			request.flushed = now;
+			request.loosePath = FileSystem::Shared().GetLoosePath(request.path);
+			if (ring && !request.loosePath.empty()) {
+				ringReads.push_back(std::make_unique<Ring::Read>(Ring::Read{ std::move(request), completions }));
+				continue;
+			}
+			pool.Submit([request = std::move(request), queue = completions, directMinBytes = options.directMinBytes]() {
+				AsyncReadResult result{ request.ticket, request.path };
+				if (request.loosePath.empty()) {
+					// a pack entry, or nothing at all
+					result.data = FileSystem::Shared().Read(request.path);
+					if (!result.data) {
+						result.error = "can't find " + request.path;
+					}
+				}
+				else {
+					result.data = ReadBlocking(request.loosePath, directMinBytes, result.error);
+				}
+				result.ms = MillisecondsSince(request.flushed);
+				queue->Push(std::move(result));
+			});
+		}
+		queued.clear();
+		if (!ringReads.empty()) {
+			ring->Submit(ringReads);
+		}
+	}
+
+	size_t AsyncReader::Drain(std::vector<AsyncReadResult>& results) {
+		std::vector<AsyncReadResult> finished{ };
+		{
+			std::lock_guard<std::mutex> lock(completions->mutex);
+			finished.swap(completions->finished);
+		}
+		for (AsyncReadResult& result : finished) {
+			results.push_back(std::move(result));
+		}
+		return finished.size();
+	}
+
+	void AsyncReader::Wait() {
+		std::unique_lock<std::mutex> lock(completions->mutex);
+		completions->allDone.wait(lock, [&]() { return completions->inFlight == 0; });
+	}
+
+	size_t AsyncReader::GetPendingCount() const {
+		std::lock_guard<std::mutex> lock(completions->mutex);
+		return queued.size() + completions->inFlight;
+	}
+
+	AsyncReader::Backend AsyncReader::GetBackend() const {
+		return ring ? Backend::IoUring : Backend::ThreadPool;
+	}
+
+	const char* AsyncReader::GetBackendName() const {
+		return ring ? "io_uring" : "thread pool";
+	}
+
+	// byte i of generated file index, so every backend's result can be checked without keeping copies
+	static uint8_t GeneratedByte(size_t index, size_t i) {
+		return static_cast<uint8_t>(index * 131 + i * 7 + (i >> 12));
+	}
+
+	// drops the files from the page cache so the next read has to go to the disk; false where that isn't possible
+	static bool EvictFromCache(const std::vector<std::string>& paths) {
+#if defined(__linux__)
+		for (const std::string& path : paths) {
+			int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				return false;
+			}
+			fdatasync(fd);
+			int result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+			close(fd);
+			if (result != 0) {
+				return false;
+			}
+		}
+		return true;
+#else
+		(void)paths;
+		return false;
+#endif
+	}
+
+	void PrintAsyncReadReport(size_t count, ThreadPool* pool) {
+		// mostly small assets with a large one every now and then, like shaders and textures
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / "learnOpenGL-io-report";
+		std::filesystem::create_directories(directory);
+		std::vector<std::string> paths{ };
+		std::vector<size_t> sizes{ };
+		uint32_t random = 0x9E3779B9u;
+		size_t totalBytes = 0;
+		for (size_t i = 0; i < count; i++) {
+			random = random * 1664525u + 1013904223u;
+			size_t size = i % 16 == 15 ? 256 * 1024 + random % (2 * 1024 * 1024) : 1024 + random % (64 * 1024);
+			std::string path = (directory / ("asset" + std::to_string(i) + ".bin")).string();
+			std::error_code error;
+			if (std::filesystem::file_size(path, error) != size || error) {
+				std::vector<uint8_t> contents(size);
+				for (size_t j = 0; j < size; j++) {
+					contents[j] = GeneratedByte(i, j);
+				}
+				std::ofstream(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc)
+					.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(size));
+			}
+			paths.push_back(path);
+			sizes.push_back(size);
+			totalBytes += size;
+		}
+		std::cout << count << " files, " << totalBytes / (1024 * 1024) << " MiB in " << directory.string() << std::endl;
+
+		auto check = [&](size_t index, const FileData& data) {
+			if (!data || data.GetSize() != sizes[index]) {
+				return false;
+			}
+			std::span<const uint8_t> bytes = data.GetBytes();
+			for (size_t j = 0; j < bytes.size(); j++) {
+				if (bytes[j] != GeneratedByte(index, j)) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		struct Run {
+			const char* name;
+			bool async;
+			AsyncReadOptions options;
+		};
+		const size_t kDirectMin = 256 * 1024;
+		const Run runs[] = {
+			{ "blocking", false, { } },
+			{ "pool pread", true, { false, 0 } },
+			{ "pool pread + direct", true, { false, kDirectMin } },
+			{ "io_uring", true, { true, 0 } },
+			{ "io_uring + direct", true, { true, kDirectMin } }
+		};
+		bool cold = true;
+		std::cout << std::fixed << std::setprecision(1);
+		for (const Run& run : runs) {
+			cold = EvictFromCache(paths) && cold;
+			std::vector<FileData> results(paths.size());
+			std::string backend = "calling thread";
+			auto start = std::chrono::steady_clock::now();
+			if (!run.async) {
+				for (size_t i = 0; i < paths.size(); i++) {
+					results[i] = FileSystem::Shared().Read(paths[i]);
+				}
+			}
+			else {
+				AsyncReader reader(*pool, run.options);
+				backend = reader.GetBackendName();
+				for (const std::string& path : paths) {
+					reader.Read(path);
+				}
+				reader.Flush();
+				reader.Wait();
+				std::vector<AsyncReadResult> finished{ };
+				reader.Drain(finished);
+				for (AsyncReadResult& result : finished) {
+					results[result.ticket - 1] = std::move(result.data);
+				}
+			}
+			double ms = MillisecondsSince(start);
+			size_t failed = 0;
+			for (size_t i = 0; i < results.size(); i++) {
+				failed += check(i, results[i]) ? 0 : 1;
+			}
+			std::cout << "  " << std::left << std::setw(22) << run.name << std::setw(16) << backend << std::right
+				<< std::setw(9) << ms << " ms " << std::setw(8) << totalBytes / (1024.0 * 1024.0) / (ms / 1000.0) << " MiB/s "
+				<< std::setw(9) << paths.size() / (ms / 1000.0) << " files/s";
+			if (failed != 0) {
+				std::cout << " (" << failed << " wrong)";
+			}
+			std::cout << std::endl;
+		}
+		std::cout << std::defaultfloat;
+		if (!cold) {
+			std::cout << "  page cache couldn't be dropped, numbers are warm cache" << std::endl;
+		}
+	}
+}
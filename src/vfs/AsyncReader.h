@@ -0,0 +1,92 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FileSystem.h"
+
+class ThreadPool;
+
+namespace vfs {
+	struct AsyncReadOptions {
+		// io_uring where the kernel has it, blocking reads on the pool everywhere else
+		bool useIoUring = true;
+		// loose files at least this big bypass the page cache (O_DIRECT, FILE_FLAG_NO_BUFFERING); 0 never does
+		size_t directMinBytes = 0;
+		// reads the ring works on at once, the rest wait their turn
+		unsigned int queueDepth = 128;
+	};
+
+	struct AsyncReadResult {
+		uint64_t ticket = 0;
+		std::string path{ };
+		// false if the read failed, with the reason in error
+		FileData data{ };
+		std::string error{ };
+		// from Flush to completion
+		double ms = 0.0;
+	};
+
+	/*
+	 * Reads files without blocking the caller. Reads are queued with Read,
+	 * go out together on Flush and come back through Drain, which the frame
+	 * loop calls to pick up whatever finished since the last frame.
+	 *
+	 * Loose files go through io_uring on Linux: one ring with a worker thread
+	 * that stats, opens and reads every file as a chain of ring operations, so
+	 * thousands of reads are in flight with a single thread waiting on them.
+	 * Without io_uring, each read is a blocking pread on the thread pool.
+	 * Entries of mounted packs are already mapped and come from the pool either
+	 * way. Direct reads land in page aligned buffers.
+	 */
+	class AsyncReader {
+	public:
+		using Ticket = uint64_t;
+		enum class Backend {
+			IoUring,
+			ThreadPool
+		};
+
+		explicit AsyncReader(ThreadPool& pool, const AsyncReadOptions& options = {});
+		// waits for reads still in flight
+		~AsyncReader();
+		AsyncReader(const AsyncReader&) = delete;
+		AsyncReader& operator=(const AsyncReader&) = delete;
+
+		// queues path, resolved through FileSystem::Shared(); nothing is read before the next Flush
+		Ticket Read(const std::string& path);
+		// hands everything queued since the last Flush to the backend as one batch
+		void Flush();
+		// moves finished reads into results without blocking and returns how many there were
+		size_t Drain(std::vector<AsyncReadResult>& results);
+		// blocks until every flushed read has finished; the results still have to be drained
+		void Wait();
+		// queued plus in flight, drained results don't count
+		size_t GetPendingCount() const;
+		Backend GetBackend() const;
+		const char* GetBackendName() const;
+
+	private:
+		struct Request {
+			Ticket ticket = 0;
+			std::string path{ };
+			// filled in by Flush, like flushed
+			std::string loosePath{ };
+			std::chrono::steady_clock::time_point flushed{ };
+		};
+		struct Completions;
+		struct Ring;
+
+		ThreadPool& pool;
+		AsyncReadOptions options;
+		std::shared_ptr<Completions> completions;
+		std::unique_ptr<Ring> ring{ };
+		std::vector<Request> queued{ };
+		Ticket nextTicket = 1;
+	};
+
+	// cold cache load time of count generated files, blocking reads against each backend
+	void PrintAsyncReadReport(size_t count, ThreadPool* pool);
+}
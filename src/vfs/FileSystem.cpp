@@ -0,0 +1,244 @@
+#include "FileSystem.h"
+#include "../threading/ThreadPool.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace vfs {
+
+	FileData::FileData(std::shared_ptr<const void> owner, std::span<const uint8_t> bytes)
+		: owner(std::move(owner)), bytes(bytes) {
+	}
+
+	std::span<const uint8_t> FileData::GetBytes() const {
+		return bytes;
+	}
+
+	std::string_view FileData::GetText() const {
+		return std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	size_t FileData::GetSize() const {
+		return bytes.size();
+	}
+
+	FileData::operator bool() const {
+		return owner != nullptr;
+	}
+
+	std::string FileSystem::NormalizePath(const std::string& path) {
+		std::error_code error;
+		std::filesystem::path absolute = std::filesystem::absolute(path, error);
+		if (error) {
+			return std::filesystem::path(path).lexically_normal().generic_string();
+		}
+		absolute = absolute.lexically_normal();
+		std::filesystem::path relative = absolute.lexically_relative(std::filesystem::current_path(error));
+		// outside the working directory there's no pack entry to match, so it stays absolute
+		if (error || relative.empty() || *relative.begin() == "..") {
+			return absolute.generic_string();
+		}
+		return relative.generic_string();
+	}
+
+	bool FileSystem::Mount(const std::string& path) {
+		auto mount = std::make_shared<MountPoint>();
+		std::error_code error;
+		if (std::filesystem::is_directory(path, error)) {
+			mount->directory = std::filesystem::absolute(path, error).lexically_normal();
+		}
+		else {
+			mount->pack = std::make_unique<Pack>();
+			std::string packError;
+			if (!mount->pack->Open(path, packError)) {
+				std::cerr << "Can't mount " << path << ": " << packError << std::endl;
+				return false;
+			}
+			std::cout << "Mounted " << path << " (" << mount->pack->GetEntryCount() << " files)" << std::endl;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		mounts.push_back(std::move(mount));
+		return true;
+	}
+
+	std::vector<std::shared_ptr<const FileSystem::MountPoint>> FileSystem::GetMounts() const {
+		std::lock_guard<std::mutex> lock(mutex);
+		return mounts;
+	}
+
+	FileData FileSystem::ReadFrom(const MountPoint& mount, const std::string& normalized, std::string& error) {
+		if (mount.pack) {
+			int index = mount.pack->Find(normalized);
+			if (index < 0) {
+				return FileData{ };
+			}
+			const Pack::Entry& entry = mount.pack->GetEntry(index);
+			if (entry.compression == kPackStored) {
+				return FileData{ mount.pack->GetMapping(), mount.pack->GetStoredBytes(index) };
+			}
+			auto buffer = std::make_shared<std::vector<uint8_t>>(entry.size);
+			if (!mount.pack->Decompress(index, buffer->data())) {
+				error = "can't decompress " + normalized + " from its pack";
+				return FileData{ };
+			}
+			return FileData{ buffer, *buffer };
+		}
+
+		std::filesystem::path path = mount.directory / normalized;
+		std::error_code fileError;
+		uintmax_t size = std::filesystem::file_size(path, fileError);
+		if (fileError || !std::filesystem::is_regular_file(path, fileError)) {
+			return FileData{ };
+		}
+		std::ifstream stream(path, std::ios_base::in | std::ios_base::binary);
+		if (!stream.is_open()) {
+			error = "can't open " + path.string();
+			return FileData{ };
+		}
+		// one read of the whole file instead of going through it character by character
+		auto buffer = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(size));
+		stream.read(reinterpret_cast<char*>(buffer->data()), static_cast<std::streamsize>(size));
+		if (stream.bad() || stream.gcount() != static_cast<std::streamsize>(size)) {
+			std::cerr << "Error while reading file at " << path.string() << std::endl;
+			error = "error while reading " + path.string();
+			return FileData{ };
+		}
+		return FileData{ buffer, *buffer };
+	}
+
+	FileData FileSystem::Read(const std::string& path) const {
+		std::string error;
+		return Read(path, error);
+	}
+
+	FileData FileSystem::Read(const std::string& path, std::string& error) const {
+		std::string normalized = NormalizePath(path);
+		std::vector<std::shared_ptr<const MountPoint>> current = GetMounts();
+		error.clear();
+		for (auto mount = current.rbegin(); mount != current.rend(); ++mount) {
+			FileData data = ReadFrom(**mount, normalized, error);
+			if (data) {
+				return data;
+			}
+		}
+		if (error.empty()) {
+			error = normalized + " isn't in any mount";
+		}
+		return FileData{ };
+	}
+
+	std::vector<FileData> FileSystem::ReadMany(const std::vector<std::string>& paths, ThreadPool* pool) const {
+		std::vector<FileData> results(paths.size());
+		auto readRange = [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				results[i] = Read(paths[i]);
+			}
+		};
+		if (pool != nullptr) {
+			pool->ParallelFor(paths.size(), readRange);
+		}
+		else {
+			readRange(0, paths.size());
+		}
+		return results;
+	}
+
+	bool FileSystem::Exists(const std::string& path) const {
+		std::string normalized = NormalizePath(path);
+		for (const std::shared_ptr<const MountPoint>& mount : GetMounts()) {
+			std::error_code error;
+			if (mount->pack ? mount->pack->Find(normalized) >= 0 : std::filesystem::is_regular_file(mount->directory / normalized, error)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string FileSystem::GetLoosePath(const std::string& path) const {
+		std::string normalized = NormalizePath(path);
+		std::vector<std::shared_ptr<const MountPoint>> current = GetMounts();
+		for (auto mount = current.rbegin(); mount != current.rend(); ++mount) {
+			if ((*mount)->pack) {
+				if ((*mount)->pack->Find(normalized) >= 0) {
+					return "";
+				}
+				continue;
+			}
+			std::error_code error;
+			std::filesystem::path loose = (*mount)->directory / normalized;
+			if (std::filesystem::is_regular_file(loose, error)) {
+				return loose.string();
+			}
+		}
+		return "";
+	}
+
+	FileSystem& FileSystem::Shared() {
+		static FileSystem fileSystem{ };
+		static const bool workingDirectoryMounted = fileSystem.Mount(".");
+		(void)workingDirectoryMounted;
+		return fileSystem;
+	}
+
+	static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void PrintPackReport(const std::string& packPath, ThreadPool* pool) {
+		Pack pack{ };
+		std::string error;
+		if (!pack.Open(packPath, error)) {
+			std::cerr << "Can't open " << packPath << ": " << error << std::endl;
+			return;
+		}
+		std::vector<std::string> paths{ };
+		uint64_t storedBytes = 0;
+		uint64_t totalBytes = 0;
+		size_t lz4Entries = 0;
+		size_t zlibEntries = 0;
+		for (size_t i = 0; i < pack.GetEntryCount(); i++) {
+			const Pack::Entry& entry = pack.GetEntry(static_cast<int>(i));
+			paths.push_back(entry.path);
+			storedBytes += entry.storedSize;
+			totalBytes += entry.size;
+			lz4Entries += entry.compression == kPackLz4 ? 1 : 0;
+			zlibEntries += entry.compression == kPackZlib ? 1 : 0;
+		}
+		std::cout << packPath << ": " << paths.size() << " files, " << lz4Entries << " LZ4, " << zlibEntries << " zlib, "
+			<< totalBytes / 1024 << " KiB stored in " << storedBytes / 1024 << " KiB" << std::endl;
+
+		FileSystem loose{ };
+		loose.Mount(".");
+		FileSystem packed{ };
+		packed.Mount(packPath);
+		struct Run {
+			const char* name;
+			const FileSystem* fileSystem;
+			ThreadPool* pool;
+		};
+		const Run runs[] = {
+			{ "loose, one by one", &loose, nullptr },
+			{ "loose, ReadMany", &loose, pool },
+			{ "pack, one by one", &packed, nullptr },
+			{ "pack, ReadMany", &packed, pool }
+		};
+		std::cout << std::fixed << std::setprecision(2);
+		for (const Run& run : runs) {
+			auto start = std::chrono::steady_clock::now();
+			std::vector<FileData> files = run.fileSystem->ReadMany(paths, run.pool);
+			double ms = MillisecondsSince(start);
+			size_t missing = 0;
+			for (const FileData& file : files) {
+				missing += file ? 0 : 1;
+			}
+			std::cout << "  " << std::left << std::setw(20) << run.name << std::right << std::setw(9) << ms << " ms, "
+				<< std::setw(8) << (ms > 0.0 ? totalBytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0) << " MiB/s";
+			if (missing != 0) {
+				std::cout << " (" << missing << " missing)";
+			}
+			std::cout << std::endl;
+		}
+		std::cout << std::defaultfloat;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Pack.h"
+
+class ThreadPool;
+
+namespace vfs {
+	/*
+	 * Contents of a file read through the FileSystem. Copies share the same
+	 * bytes, which stay valid for as long as any copy is around: a view into
+	 * a pack mapping for stored entries, a buffer of its own otherwise.
+	 */
+	class FileData {
+	public:
+		FileData() = default;
+		FileData(std::shared_ptr<const void> owner, std::span<const uint8_t> bytes);
+
+		std::span<const uint8_t> GetBytes() const;
+		std::string_view GetText() const;
+		size_t GetSize() const;
+		// false if the file wasn't found or couldn't be read; an empty file is still true
+		explicit operator bool() const;
+
+	private:
+		std::shared_ptr<const void> owner{ };
+		std::span<const uint8_t> bytes{ };
+	};
+
+	/*
+	 * Where asset reads go. Mounts are searched newest first: a directory
+	 * serves loose files below it, which is what development runs on, a .pak
+	 * serves its entries out of a memory mapping. Paths are normalized the same
+	 * way for both, relative to the working directory when they're inside it,
+	 * so "resources/shaders/x.glsl" finds the loose file and the pack entry
+	 * alike. Safe to use from several threads.
+	 */
+	class FileSystem {
+	public:
+		// false (and a message on stderr) if path is neither a directory nor a readable pack
+		bool Mount(const std::string& path);
+
+		FileData Read(const std::string& path) const;
+		// same, with why it failed in error
+		FileData Read(const std::string& path, std::string& error) const;
+		// reads, and decompresses, every path on pool; nullptr reads on the calling thread
+		std::vector<FileData> ReadMany(const std::vector<std::string>& paths, ThreadPool* pool) const;
+		bool Exists(const std::string& path) const;
+		// where a loose mount would read path from disk; empty if a pack serves it or nothing has it
+		std::string GetLoosePath(const std::string& path) const;
+
+		// lexically normal, '/' separated, relative to the working directory if it's inside it
+		static std::string NormalizePath(const std::string& path);
+		// the file system assets are loaded through, starting out with the working directory mounted
+		static FileSystem& Shared();
+
+	private:
+		struct MountPoint {
+			std::filesystem::path directory{ };
+			std::unique_ptr<Pack> pack{ };
+		};
+
+		mutable std::mutex mutex;
+		std::vector<std::shared_ptr<const MountPoint>> mounts{ };
+
+		std::vector<std::shared_ptr<const MountPoint>> GetMounts() const;
+		// error is only set when the mount has the file but it can't be read
+		static FileData ReadFrom(const MountPoint& mount, const std::string& normalized, std::string& error);
+	};
+
+	// times reading every entry of a pack one by one and with ReadMany on pool, against the same files loose
+	void PrintPackReport(const std::string& packPath, ThreadPool* pool);
+}
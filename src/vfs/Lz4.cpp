@@ -0,0 +1,161 @@
+#include "Lz4.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vfs {
+
+	static const size_t kMinMatch = 4;
+	// the format wants the last five bytes as literals, and no match starting in the last twelve
+	static const size_t kLastLiterals = 5;
+	static const size_t kMatchFindLimit = 12;
+	static const size_t kMaxOffset = 65535;
+	static const int kHashBits = 14;
+	// after this many misses in a row the search starts skipping ahead, so incompressible data goes by quickly
+	static const int kSkipShift = 6;
+
+	static uint32_t Read32(const uint8_t* bytes) {
+		uint32_t value;
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	static uint32_t Hash(uint32_t sequence) {
+		return (sequence * 2654435761u) >> (32 - kHashBits);
+	}
+
+	// 15 in the token, then 255s and the remainder
+	static void WriteLength(std::vector<uint8_t>& out, size_t length) {
+		for (; length >= 255; length -= 255) {
+			out.push_back(255);
+		}
+		out.push_back(static_cast<uint8_t>(length));
+	}
+
+	static bool ReadLength(const uint8_t* in, size_t inSize, size_t& position, size_t& length) {
+		uint8_t byte;
+		do {
+			if (position >= inSize) {
+				return false;
+			}
+			byte = in[position++];
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	static void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength) {
+		size_t matchCode = matchLength - kMinMatch;
+		out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+		if (literalCount >= 15) {
+			WriteLength(out, literalCount - 15);
+		}
+		out.insert(out.end(), literals, literals + literalCount);
+		out.push_back(static_cast<uint8_t>(offset));
+		out.push_back(static_cast<uint8_t>(offset >> 8));
+		if (matchCode >= 15) {
+			WriteLength(out, matchCode - 15);
+		}
+	}
+
+	std::vector<uint8_t> Lz4Compress(const uint8_t* data, size_t size) {
+		std::vector<uint8_t> out;
+		out.reserve(size + size / 255 + 16);
+		size_t anchor = 0;
+		if (size > kMatchFindLimit) {
+			// positions plus one, so zero is an empty slot
+			std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+			size_t matchLimit = size - kLastLiterals;
+			size_t searchLimit = size - kMatchFindLimit;
+			size_t position = 0;
+			size_t misses = 0;
+			while (position <= searchLimit) {
+				uint32_t sequence = Read32(data + position);
+				uint32_t& slot = table[Hash(sequence)];
+				size_t candidate = slot;
+				slot = static_cast<uint32_t>(position + 1);
+				if (candidate == 0 || position - (candidate - 1) > kMaxOffset || Read32(data + candidate - 1) != sequence) {
+					position += 1 + (misses++ >> kSkipShift);
+					continue;
+				}
+				misses = 0;
+				size_t match = candidate - 1;
+				// the bytes before may match too, as long as they haven't been emitted yet
+				while (position > anchor && match > 0 && data[position - 1] == data[match - 1]) {
+					position--;
+					match--;
+				}
+				size_t length = kMinMatch;
+				while (position + length < matchLimit && data[position + length] == data[match + length]) {
+					length++;
+				}
+				WriteSequence(out, data + anchor, position - anchor, position - match, length);
+				position += length;
+				anchor = position;
+				// what the match skipped over is a likely candidate for what follows
+				if (position <= searchLimit) {
+					table[Hash(Read32(data + position - 2))] = static_cast<uint32_t>(position - 2 + 1);
+				}
+			}
+		}
+
+		// the last sequence is literals only
+		size_t literalCount = size - anchor;
+		out.push_back(static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4));
+		if (literalCount >= 15) {
+			WriteLength(out, literalCount - 15);
+		}
+		out.insert(out.end(), data + anchor, data + size);
+		return out;
+	}
+
+	bool Lz4Decompress(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+		size_t inPosition = 0;
+		size_t outPosition = 0;
+		while (true) {
+			if (inPosition >= inSize) {
+				return false;
+			}
+			uint8_t token = in[inPosition++];
+			size_t literalCount = token >> 4;
+			if (literalCount == 15 && !ReadLength(in, inSize, inPosition, literalCount)) {
+				return false;
+			}
+			if (literalCount > inSize - inPosition || literalCount > outSize - outPosition) {
+				return false;
+			}
+			std::memcpy(out + outPosition, in + inPosition, literalCount);
+			inPosition += literalCount;
+			outPosition += literalCount;
+			if (inPosition == inSize) {
+				break;
+			}
+
+			if (inSize - inPosition < 2) {
+				return false;
+			}
+			size_t offset = in[inPosition] | (static_cast<size_t>(in[inPosition + 1]) << 8);
+			inPosition += 2;
+			size_t length = token & 15;
+			if (length == 15 && !ReadLength(in, inSize, inPosition, length)) {
+				return false;
+			}
+			length += kMinMatch;
+			if (offset == 0 || offset > outPosition || length > outSize - outPosition) {
+				return false;
+			}
+			uint8_t* target = out + outPosition;
+			const uint8_t* source = target - offset;
+			if (offset >= length) {
+				std::memcpy(target, source, length);
+			}
+			else {
+				// overlapping, so each byte may be one this match has just written
+				for (size_t i = 0; i < length; i++) {
+					target[i] = source[i];
+				}
+			}
+			outPosition += length;
+		}
+		return outPosition == outSize;
+	}
+}
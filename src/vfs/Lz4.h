@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vfs {
+	/*
+	 * LZ4 block format (lz4.org, doc/lz4_Block_format.md) without the frame
+	 * around it: the sizes live in the pack's table of contents instead.
+	 * Greedy matching over a single hash table, like LZ4's default level.
+	 * It compresses worse than zlib but decodes several times faster, which
+	 * is what reading a pack at startup waits on.
+	 */
+	std::vector<uint8_t> Lz4Compress(const uint8_t* data, size_t size);
+	// false unless in decodes to exactly outSize bytes; never reads or writes out of bounds on malformed input
+	bool Lz4Decompress(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize);
+}
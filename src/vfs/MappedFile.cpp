@@ -0,0 +1,115 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace vfs {
+
+	MappedFile::~MappedFile() {
+		Close();
+	}
+
+	std::span<const uint8_t> MappedFile::GetBytes() const {
+		return { data, size };
+	}
+
+#ifdef _WIN32
+
+	bool MappedFile::Open(const std::string& path, std::string& error) {
+		Close();
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			file = nullptr;
+			error = "can't open " + path + " (error " + std::to_string(GetLastError()) + ")";
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			error = "can't get the size of " + path + " (error " + std::to_string(GetLastError()) + ")";
+			Close();
+			return false;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+		if (size == 0) {
+			// an empty file can't be mapped, but there's nothing to map either
+			return true;
+		}
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr) {
+			data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+		if (data == nullptr) {
+			error = "can't map " + path + " (error " + std::to_string(GetLastError()) + ")";
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (data != nullptr) {
+			UnmapViewOfFile(data);
+		}
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		if (file != nullptr) {
+			CloseHandle(file);
+		}
+		data = nullptr;
+		size = 0;
+		mapping = nullptr;
+		file = nullptr;
+	}
+
+#else
+
+	bool MappedFile::Open(const std::string& path, std::string& error) {
+		Close();
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			error = "can't open " + path + ": " + std::strerror(errno);
+			return false;
+		}
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			error = "can't stat " + path + ": " + std::strerror(errno);
+			close(fd);
+			return false;
+		}
+		size = static_cast<size_t>(info.st_size);
+		if (size == 0) {
+			close(fd);
+			return true;
+		}
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// the mapping keeps its own reference to the file
+		close(fd);
+		if (mapped == MAP_FAILED) {
+			error = "can't map " + path + ": " + std::strerror(errno);
+			size = 0;
+			return false;
+		}
+		data = static_cast<const uint8_t*>(mapped);
+		return true;
+	}
+
+	void MappedFile::Close() {
+		if (data != nullptr) {
+			munmap(const_cast<uint8_t*>(data), size);
+		}
+		data = nullptr;
+		size = 0;
+	}
+
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace vfs {
+	/*
+	 * Read-only memory mapping of a whole file. Pages are faulted in by the OS
+	 * as they're touched, so opening a big pack costs next to nothing and the
+	 * bytes can be handed out without copying.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// false if the file can't be opened or mapped, with the reason in error
+		bool Open(const std::string& path, std::string& error);
+		std::span<const uint8_t> GetBytes() const;
+
+	private:
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#ifdef _WIN32
+		void* file = nullptr;
+		void* mapping = nullptr;
+#endif
+		void Close();
+	};
+}
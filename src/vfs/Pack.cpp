@@ -0,0 +1,265 @@
+#include "Pack.h"
+#include "Lz4.h"
+#include "../textures/Deflate.h"
+#include "../threading/ThreadPool.h"
+#include "../stb/stb_image.h"
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace vfs {
+
+	static const char kPackMagic[4] = { 'L', 'O', 'P', 'K' };
+	// version 2 added LZ4 entries, version 1 packs still read fine
+	static const uint32_t kPackVersion = 2;
+	static const uint32_t kMinPackVersion = 1;
+	// entry data starts on this boundary, so views into the mapping are aligned for anything
+	static const uint64_t kPackAlignment = 16;
+	// longer paths mean a broken table of contents, not a real file
+	static const uint32_t kMaxPackPathLength = 4096;
+	// deflate can't do better than 258 bytes out of a length and distance code of two bits or so
+	static const uint64_t kMaxInflateRatio = 1032;
+	// an LZ4 length byte stands for at most 255 bytes out
+	static const uint64_t kMaxLz4Ratio = 255;
+
+	struct PackHeader {
+		char magic[4];
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t tocCompression;
+		uint64_t tocOffset;
+		uint64_t tocStoredSize;
+		uint64_t tocSize;
+	};
+
+	// one per entry at the start of the table of contents, followed by all paths back to back
+	struct PackTocEntry {
+		uint64_t offset;
+		uint64_t storedSize;
+		uint64_t size;
+		uint32_t compression;
+		uint32_t pathLength;
+	};
+
+	static bool Inflate(const uint8_t* in, uint64_t inSize, uint8_t* out, uint64_t outSize) {
+		if (inSize > INT_MAX || outSize > INT_MAX) {
+			return false;
+		}
+		int written = stbi_zlib_decode_buffer(reinterpret_cast<char*>(out), static_cast<int>(outSize),
+			reinterpret_cast<const char*>(in), static_cast<int>(inSize));
+		return written >= 0 && static_cast<uint64_t>(written) == outSize;
+	}
+
+	bool Pack::Open(const std::string& path, std::string& error) {
+		this->path = path;
+		entries.clear();
+		lookup.clear();
+		mapping = std::make_shared<MappedFile>();
+		if (!mapping->Open(path, error)) {
+			return false;
+		}
+		std::span<const uint8_t> bytes = mapping->GetBytes();
+
+		PackHeader header;
+		if (bytes.size() < sizeof(header)) {
+			error = path + " is too small to be a pack";
+			return false;
+		}
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		if (std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) != 0 || header.version < kMinPackVersion || header.version > kPackVersion) {
+			error = path + " isn't a version " + std::to_string(kMinPackVersion) + " to " + std::to_string(kPackVersion) + " pack";
+			return false;
+		}
+		if (header.tocOffset > bytes.size() || header.tocStoredSize > bytes.size() - header.tocOffset) {
+			error = path + " is truncated";
+			return false;
+		}
+
+		// the sizes come from the file, so they're bounded before anything is allocated for them
+		uint64_t minTocSize = static_cast<uint64_t>(header.entryCount) * sizeof(PackTocEntry);
+		uint64_t maxTocSize = static_cast<uint64_t>(header.entryCount) * (sizeof(PackTocEntry) + kMaxPackPathLength);
+		uint64_t maxInflatedSize = header.tocCompression == kPackZlib ? header.tocStoredSize * kMaxInflateRatio : header.tocStoredSize;
+		if (header.tocSize < minTocSize || header.tocSize > maxTocSize || header.tocSize > maxInflatedSize) {
+			error = path + " has a table of contents of impossible size " + std::to_string(header.tocSize);
+			return false;
+		}
+
+		std::vector<uint8_t> toc(header.tocSize);
+		const uint8_t* storedToc = bytes.data() + header.tocOffset;
+		if (header.tocCompression == kPackZlib) {
+			if (!Inflate(storedToc, header.tocStoredSize, toc.data(), toc.size())) {
+				error = "can't decompress the table of contents of " + path;
+				return false;
+			}
+		}
+		else if (header.tocCompression == kPackStored && header.tocStoredSize == header.tocSize) {
+			std::memcpy(toc.data(), storedToc, toc.size());
+		}
+		else {
+			error = path + " has an unknown table of contents compression";
+			return false;
+		}
+
+		uint64_t pathsOffset = minTocSize;
+		entries.reserve(header.entryCount);
+		for (uint32_t i = 0; i < header.entryCount; i++) {
+			PackTocEntry tocEntry;
+			std::memcpy(&tocEntry, toc.data() + i * sizeof(PackTocEntry), sizeof(tocEntry));
+			bool fits = tocEntry.offset <= header.tocOffset && tocEntry.storedSize <= header.tocOffset - tocEntry.offset
+				&& tocEntry.pathLength <= kMaxPackPathLength && tocEntry.pathLength <= toc.size() - pathsOffset
+				&& ((tocEntry.compression == kPackZlib && tocEntry.size <= tocEntry.storedSize * kMaxInflateRatio)
+					|| (tocEntry.compression == kPackLz4 && tocEntry.size <= tocEntry.storedSize * kMaxLz4Ratio)
+					|| (tocEntry.compression == kPackStored && tocEntry.storedSize == tocEntry.size));
+			if (!fits) {
+				error = path + " has a broken entry " + std::to_string(i);
+				entries.clear();
+				return false;
+			}
+			std::string entryPath(reinterpret_cast<const char*>(toc.data() + pathsOffset), tocEntry.pathLength);
+			pathsOffset += tocEntry.pathLength;
+			lookup[entryPath] = static_cast<int>(entries.size());
+			entries.push_back(Entry{ std::move(entryPath), tocEntry.offset, tocEntry.storedSize, tocEntry.size, tocEntry.compression });
+		}
+		return true;
+	}
+
+	int Pack::Find(const std::string& path) const {
+		auto found = lookup.find(path);
+		return found != lookup.end() ? found->second : -1;
+	}
+
+	const Pack::Entry& Pack::GetEntry(int index) const {
+		return entries[index];
+	}
+
+	size_t Pack::GetEntryCount() const {
+		return entries.size();
+	}
+
+	std::span<const uint8_t> Pack::GetStoredBytes(int index) const {
+		const Entry& entry = entries[index];
+		return mapping->GetBytes().subspan(entry.offset, entry.storedSize);
+	}
+
+	bool Pack::Decompress(int index, uint8_t* out) const {
+		const Entry& entry = entries[index];
+		std::span<const uint8_t> stored = GetStoredBytes(index);
+		if (entry.compression == kPackStored) {
+			std::memcpy(out, stored.data(), stored.size());
+			return true;
+		}
+		bool decoded = entry.compression == kPackLz4 ? Lz4Decompress(stored.data(), stored.size(), out, entry.size)
+			: Inflate(stored.data(), stored.size(), out, entry.size);
+		if (!decoded) {
+			std::cerr << "Can't decompress " << entry.path << " from " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	const std::shared_ptr<MappedFile>& Pack::GetMapping() const {
+		return mapping;
+	}
+
+	// already compressed formats barely shrink, and a stored entry is a free view into the mapping
+	static bool PaysOff(size_t compressedSize, size_t size) {
+		return compressedSize < size - size / 8;
+	}
+
+	bool WritePack(const std::string& packPath, const std::vector<std::string>& files, int level, std::string& error) {
+		struct Pending {
+			std::vector<uint8_t> contents;
+			std::vector<uint8_t> compressed;
+			uint32_t compression;
+			bool readFailed;
+		};
+		std::vector<Pending> pending(files.size());
+		ThreadPool::Shared().ParallelFor(files.size(), [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				std::ifstream stream(files[i], std::ios_base::in | std::ios_base::binary);
+				pending[i].readFailed = !stream.is_open();
+				pending[i].contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+				const std::vector<uint8_t>& contents = pending[i].contents;
+				std::vector<uint8_t> compressed = Lz4Compress(contents.data(), contents.size());
+				uint32_t compression = kPackLz4;
+				// zlib's entropy coding still shrinks some of what LZ4's byte matching can't
+				if (!PaysOff(compressed.size(), contents.size())) {
+					compressed = textures::ZlibCompress(contents.data(), contents.size(), level);
+					compression = kPackZlib;
+				}
+				pending[i].compression = kPackStored;
+				if (PaysOff(compressed.size(), contents.size())) {
+					pending[i].compressed = std::move(compressed);
+					pending[i].compression = compression;
+				}
+			}
+		});
+
+		for (size_t i = 0; i < files.size(); i++) {
+			if (pending[i].readFailed) {
+				error = "can't read " + files[i];
+				return false;
+			}
+		}
+
+		std::string tempPath = packPath + ".tmp";
+		std::ofstream stream(tempPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (!stream.is_open()) {
+			error = "can't create " + tempPath;
+			return false;
+		}
+		PackHeader header{ };
+		std::memcpy(header.magic, kPackMagic, sizeof(kPackMagic));
+		header.version = kPackVersion;
+		header.entryCount = static_cast<uint32_t>(files.size());
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<uint8_t> toc(files.size() * sizeof(PackTocEntry));
+		uint64_t offset = sizeof(header);
+		uint64_t totalSize = 0;
+		for (size_t i = 0; i < files.size(); i++) {
+			static const char kPadding[kPackAlignment] = { };
+			uint64_t padding = (kPackAlignment - offset % kPackAlignment) % kPackAlignment;
+			stream.write(kPadding, static_cast<std::streamsize>(padding));
+			offset += padding;
+
+			const std::vector<uint8_t>& stored = pending[i].compression != kPackStored ? pending[i].compressed : pending[i].contents;
+			PackTocEntry tocEntry{ offset, stored.size(), pending[i].contents.size(), pending[i].compression, static_cast<uint32_t>(files[i].size()) };
+			std::memcpy(toc.data() + i * sizeof(PackTocEntry), &tocEntry, sizeof(tocEntry));
+			toc.insert(toc.end(), files[i].begin(), files[i].end());
+			stream.write(reinterpret_cast<const char*>(stored.data()), static_cast<std::streamsize>(stored.size()));
+			offset += stored.size();
+			totalSize += pending[i].contents.size();
+		}
+
+		std::vector<uint8_t> storedToc = textures::ZlibCompress(toc.data(), toc.size(), level);
+		header.tocCompression = kPackZlib;
+		header.tocOffset = offset;
+		header.tocStoredSize = storedToc.size();
+		header.tocSize = toc.size();
+		stream.write(reinterpret_cast<const char*>(storedToc.data()), static_cast<std::streamsize>(storedToc.size()));
+		stream.seekp(0);
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.close();
+		// a half written pack mustn't be left next to the real one
+		std::error_code removeError;
+		if (!stream) {
+			error = "failed writing " + tempPath;
+			std::filesystem::remove(tempPath, removeError);
+			return false;
+		}
+
+		std::error_code renameError;
+		std::filesystem::rename(tempPath, packPath, renameError);
+		if (renameError) {
+			error = "can't replace " + packPath + ": " + renameError.message();
+			std::filesystem::remove(tempPath, removeError);
+			return false;
+		}
+		std::cout << "Packed " << files.size() << " files, " << totalSize / 1024 << " KiB into " << packPath << " ("
+			<< (offset + storedToc.size()) / 1024 << " KiB)" << std::endl;
+		return true;
+	}
+}
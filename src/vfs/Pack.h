@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+
+namespace vfs {
+	enum PackCompression : uint32_t {
+		kPackStored = 0,
+		kPackZlib = 1,
+		kPackLz4 = 2
+	};
+
+	/*
+	 * Read side of a .pak archive, memory mapped as a whole.
+	 *
+	 * Layout: a fixed header, the entry data, then the table of contents,
+	 * compressed as one zlib block. Each entry is compressed on its own with
+	 * LZ4, which decodes several times faster than inflate, or with zlib
+	 * where only zlib pays off. Entries neither shrinks enough (PNGs, JPEGs,
+	 * zlib'd KTX2s) are stored as-is and handed out straight from the
+	 * mapping.
+	 */
+	class Pack {
+	public:
+		struct Entry {
+			std::string path;
+			uint64_t offset;
+			uint64_t storedSize;
+			uint64_t size;
+			uint32_t compression;
+		};
+
+		// false for a missing or malformed pack, with the reason in error
+		bool Open(const std::string& path, std::string& error);
+
+		// entry index for a normalized path, -1 if the pack doesn't have it
+		int Find(const std::string& path) const;
+		const Entry& GetEntry(int index) const;
+		size_t GetEntryCount() const;
+		// the entry's bytes as they are in the file, compressed or not
+		std::span<const uint8_t> GetStoredBytes(int index) const;
+		// out has to hold GetEntry(index).size bytes
+		bool Decompress(int index, uint8_t* out) const;
+		// keeps the mapping alive for views into it
+		const std::shared_ptr<MappedFile>& GetMapping() const;
+
+	private:
+		std::string path;
+		std::shared_ptr<MappedFile> mapping{ };
+		std::vector<Entry> entries{ };
+		std::unordered_map<std::string, int> lookup{ };
+	};
+
+	// packs files (normalized paths, read through the regular file system) into packPath; level as for ZlibCompress
+	bool WritePack(const std::string& packPath, const std::vector<std::string>& files, int level, std::string& error);
+}